@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Results of Steroids.QueryWithProtocol, protocol 1. Values are in host
+ * byte order and every section starts on an 8-byte boundary:
+ *
+ * header = [4 bytes for the protocol,
+ *           4 bytes for number of columns]
+ *
+ * block  = [8 bytes for number of rows,
+ *           for each column:
+ *             rows x 4 bytes for types
+ *             rows x 4 bytes for offsets in the column data
+ *             8 bytes for size of the column data
+ *             column data]
+ *
+ * Integers and booleans are stored as int64, doubles as double and
+ * any other value as a NUL-terminated string. Unbound values take
+ * no space in the column data.
+ */
+class Tracker.Bus.ColumnarCursor : Tracker.Sparql.Cursor {
+	const ulong HEADER_SIZE = 8;
+
+	internal char* buffer;
+	internal ulong buffer_index;
+	internal ulong buffer_size;
+
+	internal int _n_columns;
+	internal string[] variable_names;
+
+	internal int64 n_rows;
+	internal int64 row;
+
+	/* Positions in buffer of the sections of the current block */
+	internal ulong[] types;
+	internal ulong[] offsets;
+	internal ulong[] data;
+
+	/* Numbers of the current row converted with get_string() */
+	internal string?[] strings;
+
+	public ColumnarCursor (char* buffer, ulong buffer_size, string[] variable_names) {
+		this.buffer = buffer;
+		this.buffer_size = buffer_size;
+		this.variable_names = variable_names;
+		_n_columns = variable_names.length;
+
+		types = new ulong[_n_columns];
+		offsets = new ulong[_n_columns];
+		data = new ulong[_n_columns];
+		strings = new string?[_n_columns];
+
+		buffer_index = HEADER_SIZE;
+	}
+
+	~ColumnarCursor () {
+		free (buffer);
+	}
+
+	inline int64 buffer_read_int64 () {
+		int64 v = *((int64*) (buffer + buffer_index));
+
+		buffer_index += 8;
+
+		return v;
+	}
+
+	// Formats like SQLite does for REAL values, e.g. 1.0 for 1
+	static string double_to_string (double value) {
+		char[] buf = new char[double.DTOSTR_BUF_SIZE];
+		string str = value.format (buf, "%.15g");
+
+		if (value.is_finite () && str.index_of_char ('.') < 0 && str.index_of_char ('e') < 0) {
+			str += ".0";
+		}
+
+		return str;
+	}
+
+	inline char* cell_data (int column) {
+		int32 offset = *((int32*) (buffer + offsets[column] + row * 4));
+
+		return buffer + data[column] + offset;
+	}
+
+	public override int n_columns {
+		get { return _n_columns; }
+	}
+
+	public override Sparql.ValueType get_value_type (int column)
+	requires (column < n_columns && row < n_rows) {
+		/* Cast from int to enum */
+		return (Sparql.ValueType) (*((int32*) (buffer + types[column] + row * 4)));
+	}
+
+	public override unowned string? get_variable_name (int column)
+	requires (variable_names != null) {
+		return variable_names[column];
+	}
+
+	public override unowned string? get_string (int column, out long length = null)
+	requires (column < n_columns && row < n_rows) {
+		unowned string str;
+
+		switch (get_value_type (column)) {
+		case Sparql.ValueType.UNBOUND:
+			// return null instead of empty string for unbound values
+			length = 0;
+			return null;
+		case Sparql.ValueType.INTEGER:
+			if (strings[column] == null) {
+				strings[column] = (*((int64*) cell_data (column))).to_string ();
+			}
+			str = strings[column];
+			break;
+		case Sparql.ValueType.BOOLEAN:
+			str = *((int64*) cell_data (column)) != 0 ? "true" : "false";
+			break;
+		case Sparql.ValueType.DOUBLE:
+			if (strings[column] == null) {
+				strings[column] = double_to_string (*((double*) cell_data (column)));
+			}
+			str = strings[column];
+			break;
+		default:
+			str = (string) cell_data (column);
+			break;
+		}
+
+		length = str.length;
+
+		return str;
+	}
+
+	public override int64 get_integer (int column)
+	requires (column < n_columns && row < n_rows) {
+		if (get_value_type (column) == Sparql.ValueType.INTEGER) {
+			return *((int64*) cell_data (column));
+		}
+
+		return base.get_integer (column);
+	}
+
+	public override double get_double (int column)
+	requires (column < n_columns && row < n_rows) {
+		if (get_value_type (column) == Sparql.ValueType.DOUBLE) {
+			return *((double*) cell_data (column));
+		}
+
+		return base.get_double (column);
+	}
+
+	public override bool get_boolean (int column)
+	requires (column < n_columns && row < n_rows) {
+		if (get_value_type (column) == Sparql.ValueType.BOOLEAN) {
+			return *((int64*) cell_data (column)) != 0;
+		}
+
+		return base.get_boolean (column);
+	}
+
+	/* Moves to the next row of the current block, if any */
+	internal bool next_in_block (Cancellable? cancellable) throws GLib.Error {
+		if (cancellable != null && cancellable.is_cancelled ()) {
+			throw new IOError.CANCELLED ("Operation was cancelled");
+		}
+
+		for (int i = 0; i < _n_columns; i++) {
+			strings[i] = null;
+		}
+
+		if (row + 1 < n_rows) {
+			row++;
+			return true;
+		}
+
+		return false;
+	}
+
+	public override bool next (Cancellable? cancellable = null) throws GLib.Error {
+		if (next_in_block (cancellable)) {
+			return true;
+		}
+
+		if (buffer_index >= buffer_size) {
+			row = n_rows;
+			return false;
+		}
+
+		return load_block ();
+	}
+
+	/* Reads the block at buffer_index and moves to its first row */
+	internal bool load_block () {
+		n_rows = buffer_read_int64 ();
+
+		for (int i = 0; i < _n_columns; i++) {
+			types[i] = buffer_index;
+			buffer_index += (ulong) n_rows * 4;
+
+			offsets[i] = buffer_index;
+			buffer_index += (ulong) n_rows * 4;
+
+			int64 data_size = buffer_read_int64 ();
+
+			data[i] = buffer_index;
+			buffer_index += (ulong) data_size;
+		}
+
+		row = 0;
+
+		return n_rows > 0;
+	}
+
+	public override async bool next_async (Cancellable? cancellable = null) throws GLib.Error {
+		// next never blocks
+		return next (cancellable);
+	}
+
+	public override void rewind () {
+		buffer_index = HEADER_SIZE;
+		n_rows = 0;
+		row = 0;
+	}
+}
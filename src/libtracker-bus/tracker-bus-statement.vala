@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+// Parameter values travel separately from the query text through
+// Steroids.QueryStatement, so the store always sees the same query
+// string and can reuse its SQL translation.
+public class Tracker.Bus.Statement : Tracker.Sparql.Statement {
+	public Statement (Connection conn, string sparql) {
+		Object (connection: conn, sparql: sparql);
+	}
+
+	public override Sparql.Cursor execute (Cancellable? cancellable) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError {
+		// use separate main context for sync operation
+		var context = new MainContext ();
+		var loop = new MainLoop (context, false);
+		context.push_thread_default ();
+		AsyncResult async_res = null;
+		execute_async.begin (cancellable, (o, res) => {
+			async_res = res;
+			loop.quit ();
+		});
+		loop.run ();
+		context.pop_thread_default ();
+		return execute_async.end (async_res);
+	}
+
+	public async override Sparql.Cursor execute_async (Cancellable? cancellable) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError {
+		var conn = (Connection) connection;
+		return yield conn.query_with_parameters_async (sparql, get_bindings (), cancellable);
+	}
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/* Reply of a query whose results are still being read from the pipe */
+class Tracker.Bus.QueryReply : Object {
+	DBusConnection bus;
+	AsyncResult? result;
+	SourceFunc? waiter;
+	MainContext context;
+
+	public QueryReply (DBusConnection bus) {
+		this.bus = bus;
+		context = MainContext.ref_thread_default ();
+	}
+
+	public void received (Object? source, AsyncResult res) {
+		result = res;
+
+		if (waiter != null) {
+			waiter ();
+		}
+	}
+
+	public async DBusMessage wait () throws GLib.Error {
+		if (result == null) {
+			waiter = wait.callback;
+			yield;
+			waiter = null;
+		}
+
+		return bus.send_message_with_reply.end (result);
+	}
+
+	public DBusMessage wait_sync () throws GLib.Error {
+		while (result == null) {
+			context.iteration (true);
+		}
+
+		return bus.send_message_with_reply.end (result);
+	}
+}
+
+/* Results of Steroids.QueryWithProtocol, protocol 2. The stream uses
+ * the blocks of protocol 1 (see ColumnarCursor) with a different
+ * framing:
+ *
+ * header = [4 bytes for the protocol,
+ *           4 bytes for number of columns,
+ *           for each column:
+ *             4 bytes for length of the variable name
+ *             NUL-terminated variable name
+ *           padding to 8 bytes]
+ *
+ * block  = [8 bytes for size of the block,
+ *           block of protocol 1]
+ *
+ * Only the current block is held in memory. The D-Bus reply is sent
+ * after the last block, so errors are reported at the end of the
+ * stream.
+ */
+class Tracker.Bus.StreamCursor : ColumnarCursor {
+	InputStream input;
+	QueryReply reply;
+	uint8[] block;
+	bool finished;
+
+	public StreamCursor (InputStream input, string[] variable_names, QueryReply reply) {
+		base (null, 0, variable_names);
+
+		this.input = input;
+		this.reply = reply;
+	}
+
+	~StreamCursor () {
+		// owned by block
+		buffer = null;
+	}
+
+	void finish (DBusMessage message) throws Sparql.Error, IOError, DBusError {
+		finished = true;
+		row = n_rows;
+
+		Connection.handle_error_reply (message);
+	}
+
+	bool start_block (size_t block_size) {
+		buffer = (char*) block;
+		buffer_index = 0;
+		buffer_size = (ulong) block_size;
+
+		return load_block ();
+	}
+
+	int64 read_block_size () {
+		return *((int64*) block);
+	}
+
+	void ensure_block (int64 size) {
+		if (block.length < size) {
+			block = new uint8[size];
+			buffer = (char*) block;
+		}
+	}
+
+	public override bool next (Cancellable? cancellable = null) throws GLib.Error {
+		if (next_in_block (cancellable)) {
+			return true;
+		} else if (finished) {
+			return false;
+		}
+
+		size_t bytes_read;
+
+		ensure_block (8);
+		input.read_all (block[0:8], out bytes_read, cancellable);
+
+		if (bytes_read == 8) {
+			int64 block_size = read_block_size ();
+
+			ensure_block (block_size);
+			input.read_all (block[0:(int) block_size], out bytes_read, cancellable);
+
+			if (bytes_read == block_size) {
+				return start_block (bytes_read);
+			}
+		}
+
+		finish (reply.wait_sync ());
+
+		if (bytes_read > 0) {
+			throw new Sparql.Error.INTERNAL ("Incomplete query results");
+		}
+
+		return false;
+	}
+
+	public override async bool next_async (Cancellable? cancellable = null) throws GLib.Error {
+		if (next_in_block (cancellable)) {
+			return true;
+		} else if (finished) {
+			return false;
+		}
+
+		ensure_block (8);
+		size_t bytes_read = yield Connection.read_fully_async (input, block[0:8], cancellable);
+
+		if (bytes_read == 8) {
+			int64 block_size = read_block_size ();
+
+			ensure_block (block_size);
+			bytes_read = yield Connection.read_fully_async (input, block[0:(int) block_size], cancellable);
+
+			if (bytes_read == block_size) {
+				return start_block (bytes_read);
+			}
+		}
+
+		finish (yield reply.wait ());
+
+		if (bytes_read > 0) {
+			throw new Sparql.Error.INTERNAL ("Incomplete query results");
+		}
+
+		return false;
+	}
+
+	public override void rewind () {
+		warning ("Streamed cursors cannot be rewound");
+	}
+}
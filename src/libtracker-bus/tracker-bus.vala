@@ -18,7 +18,14 @@
  */
 
 public class Tracker.Bus.Connection : Tracker.Sparql.Connection {
+	// Result protocols of Steroids.QueryWithProtocol, see ColumnarCursor
+	// and StreamCursor
+	const uint PROTOCOL_ROWS = 0;
+	const uint PROTOCOL_COLUMNAR = 1;
+	const uint PROTOCOL_STREAMING = 2;
+
 	DBusConnection bus;
+	bool columnar_unsupported;
 
 	public Connection () throws Sparql.Error, IOError, DBusError {
 		bus = GLib.Bus.get_sync (Tracker.IPC.bus ());
@@ -36,7 +43,7 @@ public class Tracker.Bus.Connection : Tracker.Sparql.Connection {
 		output = new UnixOutputStream (pipefd[1], true);
 	}
 
-	void handle_error_reply (DBusMessage message) throws Sparql.Error, IOError, DBusError {
+	internal static void handle_error_reply (DBusMessage message) throws Sparql.Error, IOError, DBusError {
 		try {
 			message.to_gerror ();
 		} catch (IOError e_io) {
@@ -50,10 +57,22 @@ public class Tracker.Bus.Connection : Tracker.Sparql.Connection {
 		}
 	}
 
-	void send_query (string sparql, UnixOutputStream output, Cancellable? cancellable, AsyncReadyCallback? callback) throws GLib.IOError, GLib.Error {
-		var message = new DBusMessage.method_call (Tracker.DBUS_SERVICE, Tracker.DBUS_OBJECT_STEROIDS, Tracker.DBUS_INTERFACE_STEROIDS, "Query");
+	void send_query (string sparql, Variant? parameters, uint protocol, UnixOutputStream output, Cancellable? cancellable, AsyncReadyCallback? callback) throws GLib.IOError, GLib.Error {
+		DBusMessage message;
 		var fd_list = new UnixFDList ();
-		message.set_body (new Variant ("(sh)", sparql, fd_list.append (output.fd)));
+		if (protocol != PROTOCOL_ROWS) {
+			if (parameters == null) {
+				parameters = new Variant.array (new VariantType ("{sv}"), {});
+			}
+			message = new DBusMessage.method_call (Tracker.DBUS_SERVICE, Tracker.DBUS_OBJECT_STEROIDS, Tracker.DBUS_INTERFACE_STEROIDS, "QueryWithProtocol");
+			message.set_body (new Variant.tuple ({ new Variant.string (sparql), parameters, new Variant.uint32 (protocol), new Variant.handle (fd_list.append (output.fd)) }));
+		} else if (parameters == null) {
+			message = new DBusMessage.method_call (Tracker.DBUS_SERVICE, Tracker.DBUS_OBJECT_STEROIDS, Tracker.DBUS_INTERFACE_STEROIDS, "Query");
+			message.set_body (new Variant ("(sh)", sparql, fd_list.append (output.fd)));
+		} else {
+			message = new DBusMessage.method_call (Tracker.DBUS_SERVICE, Tracker.DBUS_OBJECT_STEROIDS, Tracker.DBUS_INTERFACE_STEROIDS, "QueryStatement");
+			message.set_body (new Variant.tuple ({ new Variant.string (sparql), parameters, new Variant.handle (fd_list.append (output.fd)) }));
+		}
 		message.set_unix_fd_list (fd_list);
 
 		bus.send_message_with_reply.begin (message, DBusSendMessageFlags.NONE, int.MAX, null, cancellable, callback);
@@ -75,6 +94,23 @@ public class Tracker.Bus.Connection : Tracker.Sparql.Connection {
 	}
 
 	public async override Sparql.Cursor query_async (string sparql, Cancellable? cancellable = null) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError {
+		return yield query_with_parameters_async (sparql, null, cancellable);
+	}
+
+	internal async Sparql.Cursor query_with_parameters_async (string sparql, Variant? parameters, Cancellable? cancellable) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError {
+		if (!columnar_unsupported) {
+			try {
+				return yield send_query_async (sparql, parameters, PROTOCOL_COLUMNAR, cancellable);
+			} catch (DBusError.UNKNOWN_METHOD e) {
+				// older store, fall back to the row protocol
+				columnar_unsupported = true;
+			}
+		}
+
+		return yield send_query_async (sparql, parameters, PROTOCOL_ROWS, cancellable);
+	}
+
+	async Sparql.Cursor send_query_async (string sparql, Variant? parameters, uint protocol, Cancellable? cancellable) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError {
 		UnixInputStream input;
 		UnixOutputStream output;
 		pipe (out input, out output);
@@ -82,10 +118,10 @@ public class Tracker.Bus.Connection : Tracker.Sparql.Connection {
 		// send D-Bus request
 		AsyncResult dbus_res = null;
 		bool received_result = false;
-		send_query (sparql, output, cancellable, (o, res) => {
+		send_query (sparql, parameters, protocol, output, cancellable, (o, res) => {
 			dbus_res = res;
 			if (received_result) {
-				query_async.callback ();
+				send_query_async.callback ();
 			}
 		});
 
@@ -107,11 +143,116 @@ public class Tracker.Bus.Connection : Tracker.Sparql.Connection {
 		var reply = bus.send_message_with_reply.end (dbus_res);
 		handle_error_reply (reply);
 
-		string[] variable_names = (string[]) reply.get_body ().get_child_value (0);
+		var body = reply.get_body ();
+		string[] variable_names = (string[]) body.get_child_value (0);
 		mem_stream.close ();
+
+		if (protocol != PROTOCOL_ROWS && body.get_child_value (1).get_uint32 () == PROTOCOL_COLUMNAR) {
+			return new ColumnarCursor (mem_stream.steal_data (), mem_stream.data_size, variable_names);
+		}
+
 		return new FDCursor (mem_stream.steal_data (), mem_stream.data_size, variable_names);
 	}
 
+	internal static async size_t read_fully_async (InputStream input, uint8[] buffer, Cancellable? cancellable) throws GLib.IOError {
+		size_t total = 0;
+
+		while (total < buffer.length) {
+			ssize_t bytes_read = yield input.read_async (buffer[total:buffer.length], Priority.DEFAULT, cancellable);
+
+			if (bytes_read == 0) {
+				break;
+			}
+
+			total += bytes_read;
+		}
+
+		return total;
+	}
+
+	public async override Sparql.Cursor query_stream_async (string sparql, Cancellable? cancellable = null) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError {
+		if (columnar_unsupported) {
+			return yield query_async (sparql, cancellable);
+		}
+
+		UnixInputStream input;
+		UnixOutputStream output;
+		pipe (out input, out output);
+
+		var reply = new QueryReply (bus);
+		send_query (sparql, null, PROTOCOL_STREAMING, output, cancellable, reply.received);
+
+		output = null;
+
+		// the header tells which protocol the store chose
+		uint8[] header = new uint8[8];
+
+		if ((yield read_fully_async (input, header, cancellable)) < header.length) {
+			// no results, the reply tells why
+			try {
+				handle_error_reply (yield reply.wait ());
+			} catch (DBusError.UNKNOWN_METHOD e) {
+				// older store
+				columnar_unsupported = true;
+				return yield query_async (sparql, cancellable);
+			}
+
+			throw new Sparql.Error.INTERNAL ("Incomplete query results");
+		}
+
+		int protocol = *((int32*) header);
+		int n_columns = *((int32*) ((uint8*) header + 4));
+
+		if (protocol != PROTOCOL_STREAMING) {
+			// store without streaming, receive the whole result
+			size_t bytes_written;
+			var mem_stream = new MemoryOutputStream (null, GLib.realloc, GLib.free);
+			mem_stream.write_all (header, out bytes_written);
+
+			yield mem_stream.splice_async (input, OutputStreamSpliceFlags.CLOSE_SOURCE | OutputStreamSpliceFlags.CLOSE_TARGET, Priority.DEFAULT, cancellable);
+
+			var message = yield reply.wait ();
+			handle_error_reply (message);
+
+			string[] variable_names = (string[]) message.get_body ().get_child_value (0);
+			return new ColumnarCursor (mem_stream.steal_data (), mem_stream.data_size, variable_names);
+		}
+
+		// variable names follow the header, padded to 8 bytes
+		var variable_names = new string[n_columns];
+		size_t header_size = header.length;
+
+		for (int i = 0; i < n_columns; i++) {
+			uint8[] length = new uint8[4];
+
+			if ((yield read_fully_async (input, length, cancellable)) < length.length) {
+				handle_error_reply (yield reply.wait ());
+				throw new Sparql.Error.INTERNAL ("Incomplete query results");
+			}
+
+			uint8[] name = new uint8[*((int32*) length) + 1];
+
+			if ((yield read_fully_async (input, name, cancellable)) < name.length) {
+				handle_error_reply (yield reply.wait ());
+				throw new Sparql.Error.INTERNAL ("Incomplete query results");
+			}
+
+			variable_names[i] = (string) name;
+			header_size += length.length + name.length;
+		}
+
+		if (header_size % 8 != 0) {
+			uint8[] padding = new uint8[8 - header_size % 8];
+			yield read_fully_async (input, padding, cancellable);
+		}
+
+		return new StreamCursor (input, variable_names, reply);
+	}
+
+	public override Sparql.Statement? query_statement (string sparql, Cancellable? cancellable = null) throws Sparql.Error {
+		return new Tracker.Bus.Statement (this, sparql);
+	}
+
 	void send_update (string method, UnixInputStream input, Cancellable? cancellable, AsyncReadyCallback? callback) throws GLib.Error, GLib.IOError {
 		var message = new DBusMessage.method_call (Tracker.DBUS_SERVICE, Tracker.DBUS_OBJECT_STEROIDS, Tracker.DBUS_INTERFACE_STEROIDS, method);
 		var fd_list = new UnixFDList ();
@@ -68,6 +68,10 @@ struct _TrackerClassPrivate {
 			GArray *obj_graph_ids;
 		} ready;
 	} inserts;
+
+	/* lengths of the pending arrays at the last savepoint */
+	guint savepoint_deletes;
+	guint savepoint_inserts;
 };
 
 static void class_finalize     (GObject      *object);
@@ -670,6 +674,40 @@ tracker_class_transact_events (TrackerClass *class)
 
 }
 
+void
+tracker_class_savepoint_events (TrackerClass *class)
+{
+	TrackerClassPrivate *priv;
+
+	g_return_if_fail (TRACKER_IS_CLASS (class));
+
+	priv = GET_PRIV (class);
+
+	priv->savepoint_deletes = priv->deletes.pending.sub_pred_ids->len;
+	priv->savepoint_inserts = priv->inserts.pending.sub_pred_ids->len;
+}
+
+void
+tracker_class_rollback_events (TrackerClass *class)
+{
+	TrackerClassPrivate *priv;
+
+	g_return_if_fail (TRACKER_IS_CLASS (class));
+
+	priv = GET_PRIV (class);
+
+	/* Pending events may have been reset since the savepoint */
+	if (priv->deletes.pending.sub_pred_ids->len > priv->savepoint_deletes) {
+		g_array_set_size (priv->deletes.pending.sub_pred_ids, priv->savepoint_deletes);
+		g_array_set_size (priv->deletes.pending.obj_graph_ids, priv->savepoint_deletes);
+	}
+
+	if (priv->inserts.pending.sub_pred_ids->len > priv->savepoint_inserts) {
+		g_array_set_size (priv->inserts.pending.sub_pred_ids, priv->savepoint_inserts);
+		g_array_set_size (priv->inserts.pending.obj_graph_ids, priv->savepoint_inserts);
+	}
+}
+
 static void
 insert_vals_into_arrays (GArray *sub_pred_ids,
                          GArray *obj_graph_ids,
@@ -678,8 +716,6 @@ insert_vals_into_arrays (GArray *sub_pred_ids,
                          gint    pred_id,
                          gint    object_id)
 {
-	gint i, j, k;
-	gint64 tmp;
 	gint64 sub_pred_id;
 	gint64 obj_graph_id;
 
@@ -688,23 +724,11 @@ insert_vals_into_arrays (GArray *sub_pred_ids,
 	obj_graph_id = (gint64) object_id;
 	obj_graph_id = obj_graph_id << 32 | graph_id;
 
-	i = 0;
-	j = sub_pred_ids->len - 1;
-
-	while (j - i > 0) {
-		k = (i + j) / 2;
-		tmp = g_array_index (sub_pred_ids, gint64, k);
-		if (tmp == sub_pred_id) {
-			i = k + 1;
-			break;
-		} else if (tmp > sub_pred_id)
-			j = k;
-		else
-			i = k + 1;
-	}
-
-	g_array_insert_val (sub_pred_ids, i, sub_pred_id);
-	g_array_insert_val (obj_graph_ids, i, obj_graph_id);
+	/* Appended in statement order, so that rolling back to a
+	 * savepoint is truncating the arrays. Consumers sort on their own.
+	 */
+	g_array_append_val (sub_pred_ids, sub_pred_id);
+	g_array_append_val (obj_graph_ids, obj_graph_id);
 }
 
 void
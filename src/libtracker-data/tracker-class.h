@@ -104,6 +104,8 @@ gboolean          tracker_class_has_delete_events      (TrackerClass        *cla
 void              tracker_class_reset_ready_events     (TrackerClass        *class);
 void              tracker_class_reset_pending_events   (TrackerClass        *class);
 void              tracker_class_transact_events        (TrackerClass        *class);
+void              tracker_class_savepoint_events       (TrackerClass        *class);
+void              tracker_class_rollback_events        (TrackerClass        *class);
 void              tracker_class_add_delete_event       (TrackerClass        *class,
                                                         gint                 graph_id,
                                                         gint                 subject_id,
@@ -65,6 +65,9 @@
 
 #define ZLIBBUFSIZ 8192
 
+/* Resource IDs covered by each step of a background FTS reindex */
+#define FTS_REINDEX_CHUNK_SIZE 5000
+
 static gchar    *ontologies_dir;
 static gboolean  initialized;
 static gboolean  reloading = FALSE;
@@ -3654,7 +3657,109 @@ rebuild_fts_tokens (TrackerDBInterface *iface)
 	/* Update the stamp file */
 	tracker_db_manager_tokenizer_update ();
 }
+
+static void
+start_fts_reindex (TrackerDBInterface *iface)
+{
+	GHashTable *fts_props, *multivalued;
+	GError *error = NULL;
+
+	ontology_get_fts_properties (FALSE, &fts_props, &multivalued);
+	tracker_db_interface_sqlite_fts_reindex_start (iface, fts_props, &error);
+	g_hash_table_unref (fts_props);
+	g_hash_table_unref (multivalued);
+
+	if (error) {
+		g_warning ("Could not start FTS reindex: %s", error->message);
+		g_error_free (error);
+		rebuild_fts_tokens (iface);
+		return;
+	}
+
+	g_debug ("Rebuilding FTS tokens in the background");
+
+	/* The progress is in the database from now on, a tokenizer
+	 * change after this point starts over */
+	tracker_db_manager_tokenizer_update ();
+}
+
+static void
+finish_fts_reindex (TrackerDBInterface *iface)
+{
+	GError *error = NULL;
+
+	while (!tracker_db_interface_sqlite_fts_reindex_step (iface, FTS_REINDEX_CHUNK_SIZE, &error)) {
+		if (error) {
+			g_warning ("Could not rebuild FTS tokens: %s", error->message);
+			g_clear_error (&error);
+			rebuild_fts_tokens (iface);
+			return;
+		}
+	}
+}
+#endif
+
+/**
+ * tracker_data_manager_fts_reindex_pending:
+ *
+ * Returns: %TRUE if FTS tokens are being rebuilt in the background,
+ * see tracker_data_manager_fts_reindex_step().
+ */
+gboolean
+tracker_data_manager_fts_reindex_pending (void)
+{
+#if HAVE_TRACKER_FTS
+	return tracker_db_interface_sqlite_fts_reindex_pending ();
+#else
+	return FALSE;
+#endif
+}
+
+/**
+ * tracker_data_manager_get_schema_generation:
+ *
+ * Returns: a number that changes whenever SQL generated for queries
+ * may have become stale without an ontology change, for instance
+ * when an FTS reindex starts or completes.
+ */
+guint
+tracker_data_manager_get_schema_generation (void)
+{
+	return tracker_db_interface_sqlite_get_schema_generation ();
+}
+
+/**
+ * tracker_data_manager_fts_reindex_step:
+ * @error: return location for errors
+ *
+ * Rebuilds the FTS tokens of the next range of resources, in its own
+ * transaction. Must be called from the thread doing updates, with
+ * no transaction in progress.
+ *
+ * Returns: %TRUE if there is more to do.
+ */
+gboolean
+tracker_data_manager_fts_reindex_step (GError **error)
+{
+#if HAVE_TRACKER_FTS
+	TrackerDBInterface *iface;
+
+	if (!tracker_db_interface_sqlite_fts_reindex_pending ()) {
+		return FALSE;
+	}
+
+	iface = tracker_db_manager_get_db_interface ();
+
+	if (tracker_db_interface_sqlite_fts_reindex_step (iface, FTS_REINDEX_CHUNK_SIZE, error)) {
+		g_message ("FTS tokens rebuilt");
+		return FALSE;
+	}
+
+	return tracker_db_interface_sqlite_fts_reindex_pending ();
+#else
+	return FALSE;
 #endif
+}
 
 gboolean
 tracker_data_manager_init_fts (TrackerDBInterface *iface,
@@ -4600,6 +4705,11 @@ tracker_data_manager_init (TrackerDBManagerFlags   flags,
 
 		g_hash_table_unref (uri_id_map);
 	}
+
+	/* Indexes left dropped by a journal replay that was interrupted */
+	if (!read_only) {
+		tracker_data_replay_restore_indexes ();
+	}
 #endif /* DISABLE_JOURNAL */
 
 	/* If locale changed, re-create indexes */
@@ -4638,7 +4748,18 @@ tracker_data_manager_init (TrackerDBManagerFlags   flags,
 #if HAVE_TRACKER_FTS
 		rebuild_fts_tokens (iface);
 	} else if (!read_only && tracker_db_manager_get_tokenizer_changed ()) {
-		rebuild_fts_tokens (iface);
+		/* Rebuilding is quick on a new database, otherwise
+		 * let the caller do it while serving queries */
+		if (!is_first_time_index &&
+		    (flags & TRACKER_DB_MANAGER_FTS_REINDEX_IN_BACKGROUND) != 0) {
+			start_fts_reindex (iface);
+		} else {
+			rebuild_fts_tokens (iface);
+		}
+	} else if (!read_only && tracker_db_interface_sqlite_fts_reindex_resume (iface)) {
+		if ((flags & TRACKER_DB_MANAGER_FTS_REINDEX_IN_BACKGROUND) == 0) {
+			finish_fts_reindex (iface);
+		}
 #endif
 	}
 
@@ -66,6 +66,10 @@ gboolean tracker_data_manager_reload                 (TrackerBusyCallback     bu
 gboolean tracker_data_manager_init_fts               (TrackerDBInterface     *interface,
 						      gboolean                create);
 
+gboolean tracker_data_manager_fts_reindex_pending    (void);
+gboolean tracker_data_manager_fts_reindex_step       (GError                **error);
+guint    tracker_data_manager_get_schema_generation  (void);
+
 G_END_DECLS
 
 #endif /* __LIBTRACKER_DATA_MANAGER_H__ */
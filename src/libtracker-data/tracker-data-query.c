@@ -31,6 +31,7 @@
 #include "tracker-db-interface-sqlite.h"
 #include "tracker-db-manager.h"
 #include "tracker-ontologies.h"
+#include "tracker-resource-cache.h"
 #include "tracker-sparql-query.h"
 
 GPtrArray*
@@ -101,6 +102,14 @@ tracker_data_query_resource_id (const gchar *uri)
 
 	g_return_val_if_fail (uri != NULL, 0);
 
+	/* Only committed resources are cached, misses are left to the
+	 * update path to fill in on commit.
+	 */
+	id = tracker_resource_cache_lookup (uri);
+	if (id != 0) {
+		return id;
+	}
+
 	iface = tracker_db_manager_get_db_interface ();
 
 	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_SELECT, &error,
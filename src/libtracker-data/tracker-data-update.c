@@ -36,6 +36,7 @@
 #include "tracker-db-manager.h"
 #include "tracker-db-journal.h"
 #include "tracker-ontologies.h"
+#include "tracker-resource-cache.h"
 #include "tracker-property.h"
 #include "tracker-sparql-query.h"
 
@@ -47,6 +48,13 @@ typedef struct _TrackerDataUpdateBufferTable TrackerDataUpdateBufferTable;
 typedef struct _TrackerDataBlankBuffer TrackerDataBlankBuffer;
 typedef struct _TrackerStatementDelegate TrackerStatementDelegate;
 typedef struct _TrackerCommitDelegate TrackerCommitDelegate;
+typedef struct _TrackerSavepointDelegate TrackerSavepointDelegate;
+
+/* Resource buffers are carved out of UPDATE_BUFFER_ARENA_BLOCK_SIZE
+ * blocks and released all at once when the update buffer is emptied.
+ */
+#define UPDATE_BUFFER_ARENA_BLOCK_SIZE (64 * 1024)
+#define UPDATE_BUFFER_ARENA_ALIGN      8
 
 struct _TrackerDataUpdateBuffer {
 	/* string -> integer */
@@ -59,6 +67,15 @@ struct _TrackerDataUpdateBuffer {
 	/* the following two fields are valid per sqlite transaction, not just for same subject */
 	/* TrackerClass -> integer */
 	GHashTable *class_counts;
+	/* TrackerClass -> integer, changes since the last savepoint */
+	GHashTable *savepoint_class_counts;
+
+	/* arena backing resources, tables, properties and subjects,
+	 * only the first block is kept across resets */
+	GPtrArray *arena_blocks;
+	/* allocations too large for an arena block */
+	GPtrArray *arena_large;
+	gsize arena_used;
 
 #if HAVE_TRACKER_FTS
 	gboolean fts_ever_updated;
@@ -70,10 +87,10 @@ struct _TrackerDataUpdateBufferResource {
 	gint id;
 	gboolean create;
 	gboolean modified;
-	/* TrackerProperty -> GArray */
-	GHashTable *predicates;
-	/* string -> TrackerDataUpdateBufferTable */
-	GHashTable *tables;
+	TrackerDataUpdateBufferPredicate *predicates;
+	/* in order of first modification */
+	TrackerDataUpdateBufferTable *tables;
+	TrackerDataUpdateBufferTable *last_table;
 	/* TrackerClass */
 	GPtrArray *types;
 
@@ -82,25 +99,50 @@ struct _TrackerDataUpdateBufferResource {
 #endif
 };
 
+struct _TrackerDataUpdateBufferPredicate {
+	TrackerProperty *property;
+	/* GValue */
+	GArray *values;
+	TrackerDataUpdateBufferPredicate *next;
+};
+
 struct _TrackerDataUpdateBufferProperty {
 	const gchar *name;
-	GValue value;
+	/* G_TYPE_STRING, G_TYPE_INT64, G_TYPE_DOUBLE or TRACKER_TYPE_DATE_TIME */
+	GType type;
+	union {
+		/* arena allocated */
+		const gchar *string_value;
+		gint64 int_value;
+		gdouble double_value;
+		struct {
+			gdouble time;
+			gint local_date;
+			gint local_time;
+		} date_value;
+	} value;
 	gint graph;
 	gboolean date_time : 1;
 
 #if HAVE_TRACKER_FTS
 	gboolean fts : 1;
 #endif
+
+	TrackerDataUpdateBufferProperty *next;
 };
 
 struct _TrackerDataUpdateBufferTable {
+	/* arena allocated */
+	const gchar *name;
 	gboolean insert;
 	gboolean delete_row;
 	gboolean delete_value;
 	gboolean multiple_values;
 	TrackerClass *class;
-	/* TrackerDataUpdateBufferProperty */
-	GArray *properties;
+	/* in insertion order */
+	TrackerDataUpdateBufferProperty *properties;
+	TrackerDataUpdateBufferProperty *last_property;
+	TrackerDataUpdateBufferTable *next;
 };
 
 /* buffer for anonymous blank nodes
@@ -126,6 +168,11 @@ struct _TrackerCommitDelegate {
 	gpointer user_data;
 };
 
+struct _TrackerSavepointDelegate {
+	TrackerSavepointCallback callback;
+	gpointer user_data;
+};
+
 typedef struct {
 	gchar *graph;
 	gchar *subject;
@@ -149,6 +196,7 @@ static GPtrArray *insert_callbacks = NULL;
 static GPtrArray *delete_callbacks = NULL;
 static GPtrArray *commit_callbacks = NULL;
 static GPtrArray *rollback_callbacks = NULL;
+static GPtrArray *savepoint_callbacks = NULL;
 static gint max_service_id = 0;
 static gint max_ontology_id = 0;
 
@@ -157,7 +205,7 @@ static gint         ensure_resource_id         (const gchar      *uri,
 static void         cache_insert_value         (const gchar      *table_name,
                                                 const gchar      *field_name,
                                                 gboolean          transient,
-                                                GValue           *value,
+                                                const GValue     *value,
                                                 gint              graph,
                                                 gboolean          multiple_values,
                                                 gboolean          fts,
@@ -259,6 +307,48 @@ tracker_data_remove_rollback_statement_callback (TrackerCommitCallback callback,
 	}
 }
 
+void
+tracker_data_add_savepoint_callback (TrackerSavepointCallback callback,
+                                     gpointer                 user_data)
+{
+	TrackerSavepointDelegate *delegate = g_new0 (TrackerSavepointDelegate, 1);
+
+	if (!savepoint_callbacks) {
+		savepoint_callbacks = g_ptr_array_new ();
+	}
+
+	delegate->callback = callback;
+	delegate->user_data = user_data;
+
+	g_ptr_array_add (savepoint_callbacks, delegate);
+}
+
+void
+tracker_data_remove_savepoint_callback (TrackerSavepointCallback callback,
+                                        gpointer                 user_data)
+{
+	TrackerSavepointDelegate *delegate;
+	guint i;
+	gboolean found = FALSE;
+
+	if (!savepoint_callbacks) {
+		return;
+	}
+
+	for (i = 0; i < savepoint_callbacks->len; i++) {
+		delegate = g_ptr_array_index (savepoint_callbacks, i);
+		if (delegate->callback == callback && delegate->user_data == user_data) {
+			found = TRUE;
+			break;
+		}
+	}
+
+	if (found) {
+		g_free (delegate);
+		g_ptr_array_remove_index (savepoint_callbacks, i);
+	}
+}
+
 void
 tracker_data_add_insert_statement_callback (TrackerStatementCallback callback,
                                             gpointer                 user_data)
@@ -455,6 +545,8 @@ tracker_data_update_shutdown (void)
 	max_service_id = 0;
 	max_ontology_id = 0;
 	transaction_modseq = 0;
+
+	tracker_resource_cache_clear ();
 }
 
 static gint
@@ -472,31 +564,153 @@ get_transaction_modseq (void)
 	return transaction_modseq;
 }
 
+static gpointer
+update_buffer_alloc (gsize size)
+{
+	gpointer mem;
+
+	size = (size + UPDATE_BUFFER_ARENA_ALIGN - 1) & ~((gsize) UPDATE_BUFFER_ARENA_ALIGN - 1);
+
+	if (size > UPDATE_BUFFER_ARENA_BLOCK_SIZE / 4) {
+		mem = g_malloc0 (size);
+		g_ptr_array_add (update_buffer.arena_large, mem);
+		return mem;
+	}
+
+	if (update_buffer.arena_blocks->len == 0 ||
+	    update_buffer.arena_used + size > UPDATE_BUFFER_ARENA_BLOCK_SIZE) {
+		g_ptr_array_add (update_buffer.arena_blocks, g_malloc (UPDATE_BUFFER_ARENA_BLOCK_SIZE));
+		update_buffer.arena_used = 0;
+	}
+
+	mem = (gchar *) g_ptr_array_index (update_buffer.arena_blocks, update_buffer.arena_blocks->len - 1) +
+	      update_buffer.arena_used;
+	update_buffer.arena_used += size;
+
+	memset (mem, 0, size);
+
+	return mem;
+}
+
+static const gchar *
+update_buffer_strdup (const gchar *str)
+{
+	gsize len;
+	gchar *copy;
+
+	if (str == NULL) {
+		return NULL;
+	}
+
+	len = strlen (str) + 1;
+	copy = update_buffer_alloc (len);
+	memcpy (copy, str, len);
+
+	return copy;
+}
+
+static void
+update_buffer_arena_reset (void)
+{
+	/* nothing may point into the arena anymore */
+	if (update_buffer.arena_blocks == NULL ||
+	    g_hash_table_size (update_buffer.resources) > 0 ||
+	    g_hash_table_size (update_buffer.resources_by_id) > 0) {
+		return;
+	}
+
+	if (update_buffer.arena_blocks->len > 1) {
+		g_ptr_array_remove_range (update_buffer.arena_blocks, 1,
+		                          update_buffer.arena_blocks->len - 1);
+	}
+
+	g_ptr_array_set_size (update_buffer.arena_large, 0);
+	update_buffer.arena_used = 0;
+}
+
 static TrackerDataUpdateBufferTable *
-cache_table_new (gboolean multiple_values)
+cache_table_new (const gchar *table_name,
+                 gboolean     multiple_values)
 {
 	TrackerDataUpdateBufferTable *table;
 
-	table = g_slice_new0 (TrackerDataUpdateBufferTable);
+	table = update_buffer_alloc (sizeof (TrackerDataUpdateBufferTable));
+	table->name = update_buffer_strdup (table_name);
 	table->multiple_values = multiple_values;
-	table->properties = g_array_sized_new (FALSE, FALSE, sizeof (TrackerDataUpdateBufferProperty), 4);
 
 	return table;
 }
 
+static TrackerDataUpdateBufferTable *
+cache_lookup_table (const gchar *table_name)
+{
+	TrackerDataUpdateBufferTable *table;
+
+	/* resources rarely touch more than a handful of tables */
+	for (table = resource_buffer->tables; table != NULL; table = table->next) {
+		if (strcmp (table->name, table_name) == 0) {
+			return table;
+		}
+	}
+
+	return NULL;
+}
+
 static void
-cache_table_free (TrackerDataUpdateBufferTable *table)
+cache_property_set_value (TrackerDataUpdateBufferProperty *property,
+                          const GValue                    *value)
+{
+	GType type;
+
+	type = G_VALUE_TYPE (value);
+	property->type = type;
+
+	switch (type) {
+	case G_TYPE_STRING:
+		property->value.string_value = update_buffer_strdup (g_value_get_string (value));
+		break;
+	case G_TYPE_INT64:
+		property->value.int_value = g_value_get_int64 (value);
+		break;
+	case G_TYPE_DOUBLE:
+		property->value.double_value = g_value_get_double (value);
+		break;
+	default:
+		if (type == TRACKER_TYPE_DATE_TIME) {
+			property->value.date_value.time = tracker_date_time_get_time (value);
+			property->value.date_value.local_date = tracker_date_time_get_local_date (value);
+			property->value.date_value.local_time = tracker_date_time_get_local_time (value);
+		} else {
+			g_warning ("Unknown type for binding: %s\n", G_VALUE_TYPE_NAME (value));
+		}
+		break;
+	}
+}
+
+static TrackerDataUpdateBufferProperty *
+cache_table_add_property (TrackerDataUpdateBufferTable *table,
+                          const gchar                  *field_name,
+                          const GValue                 *value)
 {
 	TrackerDataUpdateBufferProperty *property;
-	gint                            i;
 
-	for (i = 0; i < table->properties->len; i++) {
-		property = &g_array_index (table->properties, TrackerDataUpdateBufferProperty, i);
-		g_value_unset (&property->value);
+	property = update_buffer_alloc (sizeof (TrackerDataUpdateBufferProperty));
+
+	/* No need to strdup here, the incoming string is either always static, or
+	 * long-standing as tracker_property_get_name return value. */
+	property->name = field_name;
+
+	/* @value stays owned by the caller, it is flattened into the arena */
+	cache_property_set_value (property, value);
+
+	if (table->last_property) {
+		table->last_property->next = property;
+	} else {
+		table->properties = property;
 	}
+	table->last_property = property;
 
-	g_array_free (table->properties, TRUE);
-	g_slice_free (TrackerDataUpdateBufferTable, table);
+	return property;
 }
 
 static TrackerDataUpdateBufferTable *
@@ -520,11 +734,17 @@ cache_ensure_table (const gchar *table_name,
 		                    FALSE, FALSE, FALSE);
 	}
 
-	table = g_hash_table_lookup (resource_buffer->tables, table_name);
+	table = cache_lookup_table (table_name);
 	if (table == NULL) {
-		table = cache_table_new (multiple_values);
-		g_hash_table_insert (resource_buffer->tables, g_strdup (table_name), table);
+		table = cache_table_new (table_name, multiple_values);
 		table->insert = multiple_values;
+
+		if (resource_buffer->last_table) {
+			resource_buffer->last_table->next = table;
+		} else {
+			resource_buffer->tables = table;
+		}
+		resource_buffer->last_table = table;
 	}
 
 	return table;
@@ -544,28 +764,23 @@ static void
 cache_insert_value (const gchar            *table_name,
                     const gchar            *field_name,
                     gboolean                transient,
-                    GValue                 *value,
+                    const GValue           *value,
                     gint                    graph,
                     gboolean                multiple_values,
                     gboolean                fts,
                     gboolean                date_time)
 {
 	TrackerDataUpdateBufferTable    *table;
-	TrackerDataUpdateBufferProperty  property;
+	TrackerDataUpdateBufferProperty *property;
 
-	/* No need to strdup here, the incoming string is either always static, or
-	 * long-standing as tracker_property_get_name return value. */
-	property.name = field_name;
+	table = cache_ensure_table (table_name, multiple_values, transient);
 
-	property.value = *value;
-	property.graph = graph;
+	property = cache_table_add_property (table, field_name, value);
+	property->graph = graph;
 #if HAVE_TRACKER_FTS
-	property.fts = fts;
+	property->fts = fts;
 #endif
-	property.date_time = date_time;
-
-	table = cache_ensure_table (table_name, multiple_values, transient);
-	g_array_append_val (table->properties, property);
+	property->date_time = date_time;
 }
 
 static void
@@ -582,27 +797,29 @@ static void
 cache_delete_value (const gchar            *table_name,
                     const gchar            *field_name,
                     gboolean                transient,
-                    GValue                 *value,
+                    const GValue           *value,
                     gboolean                multiple_values,
                     gboolean                fts,
                     gboolean                date_time)
 {
 	TrackerDataUpdateBufferTable    *table;
-	TrackerDataUpdateBufferProperty  property;
-
-	property.name = field_name;
-	property.value = *value;
-	property.graph = 0;
-#if HAVE_TRACKER_FTS
-	property.fts = fts;
-#endif
-	property.date_time = date_time;
+	TrackerDataUpdateBufferProperty *property;
 
 	table = cache_ensure_table (table_name, multiple_values, transient);
 	table->delete_value = TRUE;
-	g_array_append_val (table->properties, property);
+
+	property = cache_table_add_property (table, field_name, value);
+	property->graph = 0;
+#if HAVE_TRACKER_FTS
+	property->fts = fts;
+#endif
+	property->date_time = date_time;
 }
 
+/* update_buffer.resource_cache holds the IDs used in the current
+ * transaction, they only move to the shared resource cache once
+ * committed.
+ */
 static gint
 query_resource_id (const gchar *uri)
 {
@@ -668,30 +885,28 @@ ensure_resource_id (const gchar *uri,
 }
 
 static void
-statement_bind_gvalue (TrackerDBStatement *stmt,
-                       gint               *idx,
-                       const GValue       *value)
+statement_bind_property (TrackerDBStatement              *stmt,
+                         gint                            *idx,
+                         TrackerDataUpdateBufferProperty *property)
 {
-	GType type;
-
-	type = G_VALUE_TYPE (value);
-	switch (type) {
+	switch (property->type) {
 	case G_TYPE_STRING:
-		tracker_db_statement_bind_text (stmt, (*idx)++, g_value_get_string (value));
+		tracker_db_statement_bind_text (stmt, (*idx)++, property->value.string_value);
 		break;
 	case G_TYPE_INT64:
-		tracker_db_statement_bind_int (stmt, (*idx)++, g_value_get_int64 (value));
+		tracker_db_statement_bind_int (stmt, (*idx)++, property->value.int_value);
 		break;
 	case G_TYPE_DOUBLE:
-		tracker_db_statement_bind_double (stmt, (*idx)++, g_value_get_double (value));
+		tracker_db_statement_bind_double (stmt, (*idx)++, property->value.double_value);
 		break;
 	default:
-		if (type == TRACKER_TYPE_DATE_TIME) {
-			tracker_db_statement_bind_double (stmt, (*idx)++, tracker_date_time_get_time (value));
-			tracker_db_statement_bind_int (stmt, (*idx)++, tracker_date_time_get_local_date (value));
-			tracker_db_statement_bind_int (stmt, (*idx)++, tracker_date_time_get_local_time (value));
+		if (property->type == TRACKER_TYPE_DATE_TIME) {
+			tracker_db_statement_bind_double (stmt, (*idx)++, property->value.date_value.time);
+			tracker_db_statement_bind_int (stmt, (*idx)++, property->value.date_value.local_date);
+			tracker_db_statement_bind_int (stmt, (*idx)++, property->value.date_value.local_time);
 		} else {
-			g_warning ("Unknown type for binding: %s\n", G_VALUE_TYPE_NAME (value));
+			/* already warned about when buffering, keep the parameter count right */
+			tracker_db_statement_bind_null (stmt, (*idx)++);
 		}
 		break;
 	}
@@ -713,6 +928,12 @@ add_class_count (TrackerClass *class,
 	old_count_entry = GPOINTER_TO_INT (g_hash_table_lookup (update_buffer.class_counts, class));
 	g_hash_table_insert (update_buffer.class_counts, class,
 	                     GINT_TO_POINTER (old_count_entry + count));
+
+	if (update_buffer.savepoint_class_counts) {
+		old_count_entry = GPOINTER_TO_INT (g_hash_table_lookup (update_buffer.savepoint_class_counts, class));
+		g_hash_table_insert (update_buffer.savepoint_class_counts, class,
+		                     GINT_TO_POINTER (old_count_entry + count));
+	}
 }
 
 static void
@@ -722,19 +943,17 @@ tracker_data_resource_buffer_flush (GError **error)
 	TrackerDBStatement             *stmt;
 	TrackerDataUpdateBufferTable    *table;
 	TrackerDataUpdateBufferProperty *property;
-	GHashTableIter                  iter;
 	const gchar                    *table_name;
-	gint                            i, param;
+	gint                            param;
 	GError                         *actual_error = NULL;
 
 	iface = tracker_db_manager_get_db_interface ();
 
-	g_hash_table_iter_init (&iter, resource_buffer->tables);
-	while (g_hash_table_iter_next (&iter, (gpointer*) &table_name, (gpointer*) &table)) {
-		if (table->multiple_values) {
-			for (i = 0; i < table->properties->len; i++) {
-				property = &g_array_index (table->properties, TrackerDataUpdateBufferProperty, i);
+	for (table = resource_buffer->tables; table != NULL; table = table->next) {
+		table_name = table->name;
 
+		if (table->multiple_values) {
+			for (property = table->properties; property != NULL; property = property->next) {
 				if (table->delete_value) {
 					/* delete rows for multiple value properties */
 					stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE, &actual_error,
@@ -765,7 +984,7 @@ tracker_data_resource_buffer_flush (GError **error)
 				param = 0;
 
 				tracker_db_statement_bind_int (stmt, param++, resource_buffer->id);
-				statement_bind_gvalue (stmt, &param, &property->value);
+				statement_bind_property (stmt, &param, property);
 
 				if (property->graph != 0) {
 					tracker_db_statement_bind_int (stmt, param++, property->graph);
@@ -845,8 +1064,7 @@ tracker_data_resource_buffer_flush (GError **error)
 				g_string_append (sql, "\" SET ");
 			}
 
-			for (i = 0; i < table->properties->len; i++) {
-				property = &g_array_index (table->properties, TrackerDataUpdateBufferProperty, i);
+			for (property = table->properties; property != NULL; property = property->next) {
 				if (table->insert) {
 					g_string_append_printf (sql, ", \"%s\"", property->name);
 					g_string_append (values_sql, ", ?");
@@ -860,7 +1078,7 @@ tracker_data_resource_buffer_flush (GError **error)
 					g_string_append_printf (sql, ", \"%s:graph\"", property->name);
 					g_string_append (values_sql, ", ?");
 				} else {
-					if (i > 0) {
+					if (property != table->properties) {
 						g_string_append (sql, ", ");
 					}
 					g_string_append_printf (sql, "\"%s\" = ?", property->name);
@@ -910,8 +1128,7 @@ tracker_data_resource_buffer_flush (GError **error)
 				param = 0;
 			}
 
-			for (i = 0; i < table->properties->len; i++) {
-				property = &g_array_index (table->properties, TrackerDataUpdateBufferProperty, i);
+			for (property = table->properties; property != NULL; property = property->next) {
 				if (table->delete_value) {
 					/* just set value to NULL for single value properties */
 					tracker_db_statement_bind_null (stmt, param++);
@@ -921,7 +1138,7 @@ tracker_data_resource_buffer_flush (GError **error)
 						tracker_db_statement_bind_null (stmt, param++);
 					}
 				} else {
-					statement_bind_gvalue (stmt, &param, &property->value);
+					statement_bind_property (stmt, &param, property);
 				}
 				if (property->graph != 0) {
 					tracker_db_statement_bind_int (stmt, param++, property->graph);
@@ -946,13 +1163,17 @@ tracker_data_resource_buffer_flush (GError **error)
 
 #if HAVE_TRACKER_FTS
 	if (resource_buffer->fts_updated) {
+		TrackerDataUpdateBufferPredicate *predicate;
 		TrackerProperty *prop;
 		GArray *values;
 		GPtrArray *properties, *text;
+		gint i;
 
 		properties = text = NULL;
-		g_hash_table_iter_init (&iter, resource_buffer->predicates);
-		while (g_hash_table_iter_next (&iter, (gpointer*) &prop, (gpointer*) &values)) {
+		for (predicate = resource_buffer->predicates; predicate != NULL; predicate = predicate->next) {
+			prop = predicate->property;
+			values = predicate->values;
+
 			if (tracker_property_get_fulltext_indexed (prop)) {
 				GString *fts;
 
@@ -989,16 +1210,21 @@ tracker_data_resource_buffer_flush (GError **error)
 #endif
 }
 
+/* The resource itself, its subject, tables and properties live in the
+ * arena and go away with update_buffer_arena_reset().
+ */
 static void resource_buffer_free (TrackerDataUpdateBufferResource *resource)
 {
-	g_hash_table_unref (resource->predicates);
-	g_hash_table_unref (resource->tables);
-	resource->subject = NULL;
+	TrackerDataUpdateBufferPredicate *predicate;
+
+	for (predicate = resource->predicates; predicate != NULL; predicate = predicate->next) {
+		g_object_unref (predicate->property);
+		g_array_unref (predicate->values);
+	}
+	resource->predicates = NULL;
 
 	g_ptr_array_free (resource->types, TRUE);
 	resource->types = NULL;
-
-	g_slice_free (TrackerDataUpdateBufferResource, resource);
 }
 
 void
@@ -1031,6 +1257,8 @@ tracker_data_update_buffer_flush (GError **error)
 		g_hash_table_remove_all (update_buffer.resources);
 	}
 	resource_buffer = NULL;
+
+	update_buffer_arena_reset ();
 }
 
 void
@@ -1051,6 +1279,8 @@ tracker_data_update_buffer_clear (void)
 	g_hash_table_remove_all (update_buffer.resource_cache);
 	resource_buffer = NULL;
 
+	update_buffer_arena_reset ();
+
 #if HAVE_TRACKER_FTS
 	update_buffer.fts_ever_updated = FALSE;
 #endif
@@ -1232,7 +1462,6 @@ cache_create_service_decomposed (TrackerClass *cl,
 		if (old_values &&
 		    old_values->len > 0) {
 			GValue *v;
-			GValue gvalue_copy = { 0 };
 
 			/* Don't expect several values for property which is a domain index */
 			g_assert_cmpint (old_values->len, ==, 1);
@@ -1243,13 +1472,11 @@ cache_create_service_decomposed (TrackerClass *cl,
 			         tracker_class_get_name (cl));
 
 			v = &g_array_index (old_values, GValue, 0);
-			g_value_init (&gvalue_copy, G_VALUE_TYPE (v));
-			g_value_copy (v, &gvalue_copy);
 
 			cache_insert_value (tracker_class_get_name (cl),
 			                    tracker_property_get_name (*domain_indexes),
 			                    tracker_property_get_transient (*domain_indexes),
-			                    &gvalue_copy,
+			                    v,
 			                    graph != NULL ? ensure_resource_id (graph, NULL) : graph_id,
 			                    tracker_property_get_multiple_values (*domain_indexes),
 			                    tracker_property_get_fulltext_indexed (*domain_indexes),
@@ -1352,6 +1579,49 @@ check_property_domain (TrackerProperty *property)
 	return FALSE;
 }
 
+static TrackerDataUpdateBufferPredicate *
+cache_lookup_predicate (TrackerProperty *property)
+{
+	TrackerDataUpdateBufferPredicate *predicate;
+
+	for (predicate = resource_buffer->predicates; predicate != NULL; predicate = predicate->next) {
+		if (predicate->property == property) {
+			return predicate;
+		}
+	}
+
+	return NULL;
+}
+
+static GArray *
+lookup_old_property_values (TrackerProperty *property)
+{
+	TrackerDataUpdateBufferPredicate *predicate;
+
+	predicate = cache_lookup_predicate (property);
+
+	return predicate ? predicate->values : NULL;
+}
+
+static void
+cache_set_old_property_values (TrackerProperty *property,
+                               GArray          *old_values)
+{
+	TrackerDataUpdateBufferPredicate *predicate;
+
+	predicate = cache_lookup_predicate (property);
+	if (predicate) {
+		g_array_unref (predicate->values);
+	} else {
+		predicate = update_buffer_alloc (sizeof (TrackerDataUpdateBufferPredicate));
+		predicate->property = g_object_ref (property);
+		predicate->next = resource_buffer->predicates;
+		resource_buffer->predicates = predicate;
+	}
+
+	predicate->values = old_values;
+}
+
 static GArray *
 get_property_values (TrackerProperty *property)
 {
@@ -1362,7 +1632,7 @@ get_property_values (TrackerProperty *property)
 
 	old_values = g_array_sized_new (FALSE, TRUE, sizeof (GValue), multiple_values ? 4 : 1);
 	g_array_set_clear_func (old_values, (GDestroyNotify) g_value_unset);
-	g_hash_table_insert (resource_buffer->predicates, g_object_ref (property), old_values);
+	cache_set_old_property_values (property, old_values);
 
 	if (!resource_buffer->create) {
 		TrackerDBInterface *iface;
@@ -1430,7 +1700,7 @@ get_old_property_values (TrackerProperty  *property,
 	GArray *old_values;
 
 	/* read existing property values */
-	old_values = g_hash_table_lookup (resource_buffer->predicates, property);
+	old_values = lookup_old_property_values (property);
 	if (old_values == NULL) {
 		if (!check_property_domain (property)) {
 			g_set_error (error, TRACKER_SPARQL_ERROR, TRACKER_SPARQL_ERROR_CONSTRAINT,
@@ -1487,7 +1757,7 @@ get_old_property_values (TrackerProperty  *property,
 
 				update_buffer.fts_ever_updated = TRUE;
 
-				old_values = g_hash_table_lookup (resource_buffer->predicates, property);
+				old_values = lookup_old_property_values (property);
 			} else {
 				old_values = get_property_values (property);
 			}
@@ -1616,15 +1886,10 @@ process_domain_indexes (TrackerProperty *property,
 	domain_index_classes = tracker_property_get_domain_indexes (property);
 	while (*domain_index_classes) {
 		if (resource_in_domain_index_class (*domain_index_classes)) {
-			GValue gvalue_copy = { 0 };
-
-			g_value_init (&gvalue_copy, G_VALUE_TYPE (gvalue));
-			g_value_copy (gvalue, &gvalue_copy);
-
 			cache_insert_value (tracker_class_get_name (*domain_index_classes),
 			                    field_name,
 			                    tracker_property_get_transient (property),
-			                    &gvalue_copy,
+			                    gvalue,
 			                    graph != NULL ? ensure_resource_id (graph, NULL) : graph_id,
 			                    FALSE,
 			                    tracker_property_get_fulltext_indexed (property),
@@ -1745,6 +2010,8 @@ cache_insert_metadata_decomposed (TrackerProperty  *property,
 			process_domain_indexes (property, &gvalue, field_name, graph, graph_id);
 		}
 
+		g_value_unset (&gvalue);
+
 		change = TRUE;
 	}
 
@@ -1953,6 +2220,8 @@ cache_update_metadata_decomposed (TrackerProperty  *property,
 		process_domain_indexes (property, &gvalue, field_name, graph, graph_id);
 	}
 
+	g_value_unset (&gvalue);
+
 	return TRUE;
 }
 
@@ -2011,13 +2280,10 @@ delete_metadata_decomposed (TrackerProperty  *property,
 
 			while (*domain_index_classes) {
 				if (resource_in_domain_index_class (*domain_index_classes)) {
-					GValue gvalue_copy = { 0 };
-					g_value_init (&gvalue_copy, G_VALUE_TYPE (&gvalue));
-					g_value_copy (&gvalue, &gvalue_copy);
 					cache_delete_value (tracker_class_get_name (*domain_index_classes),
 					                    field_name,
 					                    tracker_property_get_transient (property),
-					                    &gvalue_copy, multiple_values,
+					                    &gvalue, multiple_values,
 					                    tracker_property_get_fulltext_indexed (property),
 					                    tracker_property_get_data_type (property) == TRACKER_PROPERTY_TYPE_DATETIME);
 				}
@@ -2025,6 +2291,8 @@ delete_metadata_decomposed (TrackerProperty  *property,
 			}
 		}
 
+		g_value_unset (&gvalue);
+
 		change = TRUE;
 	}
 
@@ -2082,7 +2350,7 @@ cache_delete_resource_type_full (TrackerClass *class,
 
 	if (!single_type) {
 		if (strcmp (tracker_class_get_uri (class), TRACKER_PREFIX_RDFS "Resource") == 0 &&
-		    g_hash_table_size (resource_buffer->tables) == 0) {
+		    resource_buffer->tables == NULL) {
 #if HAVE_TRACKER_FTS
 			tracker_db_interface_sqlite_fts_delete_id (iface, resource_buffer->id);
 #endif
@@ -2150,7 +2418,7 @@ cache_delete_resource_type_full (TrackerClass *class,
 	}
 
 	/* bypass buffer if possible */
-	direct_delete = g_hash_table_size (resource_buffer->tables) == 0;
+	direct_delete = resource_buffer->tables == NULL;
 
 	/* delete all property values */
 
@@ -2205,13 +2473,10 @@ cache_delete_resource_type_full (TrackerClass *class,
 				domain_index_classes = tracker_property_get_domain_indexes (prop);
 				while (*domain_index_classes) {
 					if (resource_in_domain_index_class (*domain_index_classes)) {
-						GValue gvalue_copy = { 0 };
-						g_value_init (&gvalue_copy, G_VALUE_TYPE (&gvalue));
-						g_value_copy (&gvalue, &gvalue_copy);
 						cache_delete_value (tracker_class_get_name (*domain_index_classes),
 						                    field_name,
 						                    tracker_property_get_transient (prop),
-						                    &gvalue_copy, multiple_values,
+						                    &gvalue, multiple_values,
 						                    tracker_property_get_fulltext_indexed (prop),
 						                    tracker_property_get_data_type (prop) == TRACKER_PROPERTY_TYPE_DATETIME);
 					}
@@ -2219,6 +2484,7 @@ cache_delete_resource_type_full (TrackerClass *class,
 				}
 			}
 
+			g_value_unset (&gvalue);
 		}
 	}
 
@@ -2303,7 +2569,7 @@ resource_buffer_switch (const gchar *graph,
 	}
 
 	if (resource_buffer == NULL) {
-		gchar *subject_dup = NULL;
+		const gchar *subject_dup = NULL;
 
 		/* large INSERTs with thousands of resources could lead to
 		   high peak memory usage due to the update buffer
@@ -2311,9 +2577,9 @@ resource_buffer_switch (const gchar *graph,
 		tracker_data_update_buffer_might_flush (NULL);
 
 		/* subject not yet in cache, retrieve or create ID */
-		resource_buffer = g_slice_new0 (TrackerDataUpdateBufferResource);
+		resource_buffer = update_buffer_alloc (sizeof (TrackerDataUpdateBufferResource));
 		if (subject != NULL) {
-			subject_dup = g_strdup (subject);
+			subject_dup = update_buffer_strdup (subject);
 			resource_buffer->subject = subject_dup;
 		}
 		if (subject_id > 0) {
@@ -2329,13 +2595,11 @@ resource_buffer_switch (const gchar *graph,
 		} else {
 			resource_buffer->types = tracker_data_query_rdf_type (resource_buffer->id);
 		}
-		resource_buffer->predicates = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, (GDestroyNotify) g_array_unref);
-		resource_buffer->tables = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) cache_table_free);
 
 		if (in_journal_replay) {
 			g_hash_table_insert (update_buffer.resources_by_id, GINT_TO_POINTER (subject_id), resource_buffer);
 		} else {
-			g_hash_table_insert (update_buffer.resources, subject_dup, resource_buffer);
+			g_hash_table_insert (update_buffer.resources, (gpointer) subject_dup, resource_buffer);
 
 			/* Ensure the graph gets an ID */
 			if (graph != NULL) {
@@ -3293,9 +3557,12 @@ tracker_data_begin_transaction (GError **error)
 	if (update_buffer.resource_cache == NULL) {
 		update_buffer.resource_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 		/* used for normal transactions */
-		update_buffer.resources = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) resource_buffer_free);
+		update_buffer.resources = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) resource_buffer_free);
 		/* used for journal replay */
 		update_buffer.resources_by_id = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) resource_buffer_free);
+		/* backs the buffered resources */
+		update_buffer.arena_blocks = g_ptr_array_new_with_free_func (g_free);
+		update_buffer.arena_large = g_ptr_array_new_with_free_func (g_free);
 	}
 
 	resource_buffer = NULL;
@@ -3351,6 +3618,8 @@ tracker_data_commit_transaction (GError **error)
 {
 	TrackerDBInterface *iface;
 	GError *actual_error = NULL;
+	GHashTableIter iter;
+	gpointer uri, id_ptr;
 
 	g_return_if_fail (in_transaction);
 
@@ -3414,9 +3683,15 @@ tracker_data_commit_transaction (GError **error)
 
 	tracker_db_interface_execute_query (iface, NULL, "PRAGMA cache_size = %d", TRACKER_DB_CACHE_SIZE_DEFAULT);
 
+	g_hash_table_iter_init (&iter, update_buffer.resource_cache);
+	while (g_hash_table_iter_next (&iter, &uri, &id_ptr)) {
+		tracker_resource_cache_insert (uri, GPOINTER_TO_INT (id_ptr));
+	}
+
 	g_hash_table_remove_all (update_buffer.resources);
 	g_hash_table_remove_all (update_buffer.resources_by_id);
 	g_hash_table_remove_all (update_buffer.resource_cache);
+	update_buffer_arena_reset ();
 
 	in_journal_replay = FALSE;
 }
@@ -3485,25 +3760,20 @@ tracker_data_rollback_transaction (void)
 }
 
 static GVariant *
-update_sparql (const gchar  *update,
-               gboolean      blank,
-               GError      **error)
+update_sparql_query (TrackerSparqlQuery  *sparql_query,
+                     gboolean             blank,
+                     GError             **error)
 {
 	GError *actual_error = NULL;
-	TrackerSparqlQuery *sparql_query;
 	GVariant *blank_nodes;
 
-	g_return_val_if_fail (update != NULL, NULL);
-
 	tracker_data_begin_transaction (&actual_error);
 	if (actual_error) {
 		g_propagate_error (error, actual_error);
 		return NULL;
 	}
 
-	sparql_query = tracker_sparql_query_new_update (update);
 	blank_nodes = tracker_sparql_query_execute_update (sparql_query, blank, &actual_error);
-	g_object_unref (sparql_query);
 
 	if (actual_error) {
 		tracker_data_rollback_transaction ();
@@ -3520,314 +3790,948 @@ update_sparql (const gchar  *update,
 	return blank_nodes;
 }
 
-void
-tracker_data_update_sparql (const gchar  *update,
-                            GError      **error)
+static GVariant *
+update_sparql (const gchar  *update,
+               gboolean      blank,
+               GError      **error)
 {
-	update_sparql (update, FALSE, error);
-}
+	TrackerSparqlQuery *sparql_query;
+	GVariant *blank_nodes;
 
-GVariant *
-tracker_data_update_sparql_blank (const gchar  *update,
-                                  GError      **error)
-{
-	return update_sparql (update, TRUE, error);
+	g_return_val_if_fail (update != NULL, NULL);
+
+	sparql_query = tracker_sparql_query_new_update (update);
+	blank_nodes = update_sparql_query (sparql_query, blank, error);
+	g_object_unref (sparql_query);
+
+	return blank_nodes;
 }
 
-void
-tracker_data_load_turtle_file (GFile   *file,
-                               GError **error)
+static void
+notify_savepoint (TrackerDataSavepointAction action)
 {
-	gchar *path;
+	guint n;
 
-	g_return_if_fail (G_IS_FILE (file) && g_file_is_native (file));
+	if (!savepoint_callbacks) {
+		return;
+	}
 
-	path = g_file_get_path (file);
-	tracker_turtle_reader_load (path, error);
-	g_free (path);
+	for (n = 0; n < savepoint_callbacks->len; n++) {
+		TrackerSavepointDelegate *delegate;
+
+		delegate = g_ptr_array_index (savepoint_callbacks, n);
+		delegate->callback (action, delegate->user_data);
+	}
 }
 
-void
-tracker_data_sync (void)
+static void
+batch_item_begin (TrackerDBInterface  *iface,
+                  GError             **error)
 {
-#ifndef DISABLE_JOURNAL
-	tracker_db_journal_fsync ();
-#endif
-}
+	GError *actual_error = NULL;
+
+	tracker_db_interface_execute_query (iface, &actual_error, "SAVEPOINT batch_item");
+	if (actual_error) {
+		g_propagate_error (error, actual_error);
+		return;
+	}
 
 #ifndef DISABLE_JOURNAL
+	tracker_db_journal_savepoint ();
+#endif /* DISABLE_JOURNAL */
 
-void
-tracker_data_replay_journal (TrackerBusyCallback   busy_callback,
-                             gpointer              busy_user_data,
-                             const gchar          *busy_status,
-                             GError              **error)
+	notify_savepoint (TRACKER_DATA_SAVEPOINT_BEGIN);
+}
+
+static void
+batch_item_rollback (TrackerDBInterface *iface)
 {
-	GError *journal_error = NULL;
-	TrackerProperty *rdf_type = NULL;
-	gint last_operation_type = 0;
-	const gchar *uri;
-	GError *n_error = NULL;
+	GHashTableIter iter;
+	TrackerClass *class;
+	gpointer count_ptr;
 
+	/* drop what the update left in the buffer, the database part
+	 * goes with the savepoint */
+	g_hash_table_remove_all (update_buffer.resources);
+	g_hash_table_remove_all (update_buffer.resource_cache);
+	resource_buffer = NULL;
+	update_buffer_arena_reset ();
 
-	rdf_type = tracker_ontologies_get_rdf_type ();
+	g_hash_table_iter_init (&iter, update_buffer.savepoint_class_counts);
+	while (g_hash_table_iter_next (&iter, (gpointer*) &class, &count_ptr)) {
+		gint count, old_count_entry;
 
-	tracker_db_journal_reader_init (NULL, &n_error);
-	if (n_error) {
-		/* This is fatal (doesn't happen when file doesn't exist, does happen
-		 * when for some other reason the reader can't be created) */
-		g_propagate_error (error, n_error);
-		return;
+		count = GPOINTER_TO_INT (count_ptr);
+		tracker_class_set_count (class, tracker_class_get_count (class) - count);
+
+		old_count_entry = GPOINTER_TO_INT (g_hash_table_lookup (update_buffer.class_counts, class));
+		g_hash_table_insert (update_buffer.class_counts, class,
+		                     GINT_TO_POINTER (old_count_entry - count));
 	}
 
-	while (tracker_db_journal_reader_next (&journal_error)) {
-		TrackerDBJournalEntryType type;
-		const gchar *object;
-		gint graph_id, subject_id, predicate_id, object_id;
+	g_hash_table_remove_all (update_buffer.savepoint_class_counts);
 
-		type = tracker_db_journal_reader_get_type ();
-		if (type == TRACKER_DB_JOURNAL_RESOURCE) {
-			GError *new_error = NULL;
-			TrackerDBInterface *iface;
-			TrackerDBStatement *stmt;
-			gint id;
+	tracker_db_interface_execute_query (iface, NULL, "ROLLBACK TO SAVEPOINT batch_item");
+	tracker_db_interface_execute_query (iface, NULL, "RELEASE SAVEPOINT batch_item");
 
-			tracker_db_journal_reader_get_resource (&id, &uri);
+#ifndef DISABLE_JOURNAL
+	tracker_db_journal_rollback_to_savepoint ();
+#endif /* DISABLE_JOURNAL */
 
-			iface = tracker_db_manager_get_db_interface ();
+	/* insert and delete callbacks already ran for the statements
+	 * of this item, let them drop what they queued */
+	notify_savepoint (TRACKER_DATA_SAVEPOINT_ROLLBACK);
+}
 
-			stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE, &new_error,
-			                                              "INSERT INTO Resource (ID, Uri) VALUES (?, ?)");
+static void
+batch_item_release (TrackerDBInterface  *iface,
+                    GError             **error)
+{
+	g_hash_table_remove_all (update_buffer.savepoint_class_counts);
 
-			if (stmt) {
-				tracker_db_statement_bind_int (stmt, 0, id);
-				tracker_db_statement_bind_text (stmt, 1, uri);
-				tracker_db_statement_execute (stmt, &new_error);
-				g_object_unref (stmt);
-			}
+	tracker_db_interface_execute_query (iface, error, "RELEASE SAVEPOINT batch_item");
 
-			if (new_error) {
-				g_warning ("Journal replay error: '%s'", new_error->message);
-				g_error_free (new_error);
+	notify_savepoint (TRACKER_DATA_SAVEPOINT_RELEASE);
+}
+
+static void
+error_free_or_null (GError *error)
+{
+	if (error) {
+		g_error_free (error);
+	}
+}
+
+/**
+ * tracker_data_update_sparql_batch:
+ * @updates: array of SPARQL updates
+ * @n_updates: length of @updates
+ * @prepared: (allow-none): array of @n_updates queries, with the
+ *     updates already parsed by tracker_sparql_query_prepare_update(),
+ *     or %NULL. Elements may be %NULL for updates that were not prepared.
+ * @error: return location for errors affecting the whole batch
+ *
+ * Applies @updates in a single transaction, with a single journal
+ * commit. Each update runs in its own savepoint, so an update that
+ * fails is reverted without affecting the others.
+ *
+ * Returns: an array of @n_updates elements, each either %NULL or the
+ * error of the corresponding update. Free with g_ptr_array_unref().
+ **/
+GPtrArray *
+tracker_data_update_sparql_batch (gchar               **updates,
+                                  gint                  n_updates,
+                                  TrackerSparqlQuery  **prepared,
+                                  GError              **error)
+{
+	GError *actual_error = NULL;
+	TrackerDBInterface *iface;
+	GPtrArray *errors;
+	gint i;
+
+	tracker_data_begin_transaction (&actual_error);
+	if (actual_error) {
+		g_propagate_error (error, actual_error);
+		return NULL;
+	}
+
+	iface = tracker_db_manager_get_db_interface ();
+	errors = g_ptr_array_new_full (n_updates, (GDestroyNotify) error_free_or_null);
+	update_buffer.savepoint_class_counts = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	for (i = 0; i < n_updates; i++) {
+		TrackerSparqlQuery *sparql_query;
+		GError *item_error = NULL;
+
+		batch_item_begin (iface, &actual_error);
+		if (actual_error) {
+			break;
+		}
+
+		if (prepared && prepared[i]) {
+			sparql_query = g_object_ref (prepared[i]);
+		} else {
+			sparql_query = tracker_sparql_query_new_update (updates[i]);
+		}
+
+		tracker_sparql_query_execute_update (sparql_query, FALSE, &item_error);
+		g_object_unref (sparql_query);
+
+		/* constraint violations only show up when the buffer is
+		 * written to the database */
+		if (!item_error) {
+			tracker_data_update_buffer_flush (&item_error);
+		}
+
+		if (item_error) {
+			batch_item_rollback (iface);
+		} else {
+			batch_item_release (iface, &actual_error);
+			if (actual_error) {
+				break;
 			}
+		}
 
-		} else if (type == TRACKER_DB_JOURNAL_START_TRANSACTION) {
-			tracker_data_begin_transaction_for_replay (tracker_db_journal_reader_get_time (), NULL);
-		} else if (type == TRACKER_DB_JOURNAL_END_TRANSACTION) {
-			GError *new_error = NULL;
-			tracker_data_update_buffer_might_flush (&new_error);
+		g_ptr_array_add (errors, item_error);
+	}
 
-			tracker_data_commit_transaction (&new_error);
-			if (new_error) {
-				/* Out of disk is an unrecoverable fatal error */
-				if (g_error_matches (new_error, TRACKER_DB_INTERFACE_ERROR, TRACKER_DB_NO_SPACE)) {
-					g_propagate_error (error, new_error);
-					return;
-				} else {
-					g_warning ("Journal replay error: '%s'", new_error->message);
-					g_clear_error (&new_error);
-				}
+	g_hash_table_unref (update_buffer.savepoint_class_counts);
+	update_buffer.savepoint_class_counts = NULL;
+
+	if (actual_error) {
+		tracker_data_rollback_transaction ();
+		g_ptr_array_unref (errors);
+		g_propagate_error (error, actual_error);
+		return NULL;
+	}
+
+	tracker_data_commit_transaction (&actual_error);
+	if (actual_error) {
+		g_ptr_array_unref (errors);
+		g_propagate_error (error, actual_error);
+		return NULL;
+	}
+
+	return errors;
+}
+
+void
+tracker_data_update_sparql (const gchar  *update,
+                            GError      **error)
+{
+	update_sparql (update, FALSE, error);
+}
+
+/**
+ * tracker_data_update_prepared:
+ * @sparql_query: an update query
+ * @error: return location for errors
+ *
+ * Runs an update query in its own transaction, it is typically
+ * parsed ahead of time with tracker_sparql_query_prepare_update().
+ **/
+void
+tracker_data_update_prepared (TrackerSparqlQuery  *sparql_query,
+                              GError             **error)
+{
+	update_sparql_query (sparql_query, FALSE, error);
+}
+
+GVariant *
+tracker_data_update_sparql_blank (const gchar  *update,
+                                  GError      **error)
+{
+	return update_sparql (update, TRUE, error);
+}
+
+void
+tracker_data_load_turtle_file (GFile   *file,
+                               GError **error)
+{
+	gchar *path;
+
+	g_return_if_fail (G_IS_FILE (file) && g_file_is_native (file));
+
+	path = g_file_get_path (file);
+	tracker_turtle_reader_load (path, error);
+	g_free (path);
+}
+
+void
+tracker_data_sync (void)
+{
+#ifndef DISABLE_JOURNAL
+	tracker_db_journal_fsync ();
+#endif
+}
+
+#ifndef DISABLE_JOURNAL
+
+/* Journal replay is pipelined: a decode thread reads and checks the
+ * journal and resolves predicates and classes against the ontology,
+ * which is not modified during replay. The calling thread applies the
+ * decoded operations, several journal transactions per SQLite
+ * transaction.
+ */
+
+/* Decoded batches in flight between both threads */
+#define REPLAY_QUEUE_LENGTH 4
+
+/* Journal entries per decoded batch */
+#define REPLAY_BATCH_SIZE 4096
+
+/* Operations applied before the SQLite transaction is committed */
+#define REPLAY_TRANSACTION_SIZE 50000
+
+typedef enum {
+	REPLAY_OP_RESOURCE,
+	REPLAY_OP_BEGIN,
+	REPLAY_OP_END,
+	REPLAY_OP_INSERT,
+	REPLAY_OP_UPDATE,
+	REPLAY_OP_DELETE,
+	REPLAY_OP_CREATE_TYPE,
+	REPLAY_OP_DELETE_TYPE
+} ReplayOpType;
+
+typedef struct {
+	ReplayOpType type;
+	gint graph_id;
+	gint subject_id;
+	gint object_id;
+	TrackerProperty *property;
+	TrackerClass *class;
+	const gchar *object;
+	time_t time;
+} ReplayOp;
+
+typedef struct {
+	GArray *ops;
+	GStringChunk *strings;
+	gdouble progress;
+	gboolean last;
+	GError *error;
+} ReplayBatch;
+
+typedef struct {
+	GAsyncQueue *free_batches;
+	GAsyncQueue *full_batches;
+	gint cancelled;
+} ReplayPipeline;
+
+static ReplayBatch *
+replay_batch_new (void)
+{
+	ReplayBatch *batch;
+
+	batch = g_slice_new0 (ReplayBatch);
+	batch->ops = g_array_sized_new (FALSE, FALSE, sizeof (ReplayOp), REPLAY_BATCH_SIZE);
+	batch->strings = g_string_chunk_new (64 * 1024);
+
+	return batch;
+}
+
+static void
+replay_batch_free (ReplayBatch *batch)
+{
+	g_array_free (batch->ops, TRUE);
+	g_string_chunk_free (batch->strings);
+	g_clear_error (&batch->error);
+	g_slice_free (ReplayBatch, batch);
+}
+
+static void
+replay_batch_recycle (ReplayPipeline *pipeline,
+                      ReplayBatch    *batch)
+{
+	g_array_set_size (batch->ops, 0);
+	g_string_chunk_clear (batch->strings);
+	g_async_queue_push (pipeline->free_batches, batch);
+}
+
+static TrackerProperty *
+replay_lookup_property (gint predicate_id)
+{
+	TrackerProperty *property = NULL;
+	const gchar *uri;
+
+	uri = tracker_ontologies_get_uri_by_id (predicate_id);
+	if (uri) {
+		property = tracker_ontologies_get_property_by_uri (uri);
+	}
+
+	if (!property) {
+		g_warning ("Journal replay error: 'property with ID %d doesn't exist'", predicate_id);
+	}
+
+	return property;
+}
+
+static TrackerClass *
+replay_lookup_class (gint class_id)
+{
+	TrackerClass *class = NULL;
+	const gchar *uri;
+
+	uri = tracker_ontologies_get_uri_by_id (class_id);
+	if (uri) {
+		class = tracker_ontologies_get_class_by_uri (uri);
+	}
+
+	if (!class) {
+		g_warning ("Journal replay error: 'class with ID %d not found in the ontology'", class_id);
+	}
+
+	return class;
+}
+
+/* Turns the current journal entry into an operation, entries that can
+ * not be applied are reported and skipped here.
+ */
+static void
+replay_decode_entry (ReplayBatch     *batch,
+                     TrackerProperty *rdf_type)
+{
+	TrackerDBJournalEntryType type;
+	ReplayOp op = { 0 };
+	const gchar *object;
+	gint predicate_id;
+
+	type = tracker_db_journal_reader_get_type ();
+
+	switch (type) {
+	case TRACKER_DB_JOURNAL_RESOURCE:
+		op.type = REPLAY_OP_RESOURCE;
+		tracker_db_journal_reader_get_resource (&op.subject_id, &object);
+		op.object = g_string_chunk_insert (batch->strings, object);
+		break;
+	case TRACKER_DB_JOURNAL_START_TRANSACTION:
+		op.type = REPLAY_OP_BEGIN;
+		op.time = tracker_db_journal_reader_get_time ();
+		break;
+	case TRACKER_DB_JOURNAL_END_TRANSACTION:
+		op.type = REPLAY_OP_END;
+		break;
+	case TRACKER_DB_JOURNAL_INSERT_STATEMENT:
+	case TRACKER_DB_JOURNAL_UPDATE_STATEMENT:
+		op.type = (type == TRACKER_DB_JOURNAL_UPDATE_STATEMENT) ?
+			REPLAY_OP_UPDATE : REPLAY_OP_INSERT;
+		tracker_db_journal_reader_get_statement (&op.graph_id, &op.subject_id, &predicate_id, &object);
+
+		op.property = replay_lookup_property (predicate_id);
+		if (!op.property) {
+			return;
+		}
+
+		op.object = g_string_chunk_insert (batch->strings, object);
+		break;
+	case TRACKER_DB_JOURNAL_INSERT_STATEMENT_ID:
+	case TRACKER_DB_JOURNAL_UPDATE_STATEMENT_ID:
+		op.type = (type == TRACKER_DB_JOURNAL_UPDATE_STATEMENT_ID) ?
+			REPLAY_OP_UPDATE : REPLAY_OP_INSERT;
+		tracker_db_journal_reader_get_statement_id (&op.graph_id, &op.subject_id, &predicate_id, &op.object_id);
+
+		op.property = replay_lookup_property (predicate_id);
+		if (!op.property) {
+			return;
+		}
+
+		if (tracker_property_get_data_type (op.property) != TRACKER_PROPERTY_TYPE_RESOURCE) {
+			g_warning ("Journal replay error: 'property with ID %d does not account URIs'", predicate_id);
+			return;
+		}
+
+		if (op.property == rdf_type) {
+			op.type = REPLAY_OP_CREATE_TYPE;
+			op.class = replay_lookup_class (op.object_id);
+			if (!op.class) {
+				return;
 			}
-		} else if (type == TRACKER_DB_JOURNAL_INSERT_STATEMENT ||
-		           type == TRACKER_DB_JOURNAL_UPDATE_STATEMENT) {
-			GError *new_error = NULL;
-			TrackerProperty *property = NULL;
+		}
+		break;
+	case TRACKER_DB_JOURNAL_DELETE_STATEMENT:
+		op.type = REPLAY_OP_DELETE;
+		tracker_db_journal_reader_get_statement (&op.graph_id, &op.subject_id, &predicate_id, &object);
 
-			tracker_db_journal_reader_get_statement (&graph_id, &subject_id, &predicate_id, &object);
+		op.property = replay_lookup_property (predicate_id);
+		if (!op.property) {
+			return;
+		}
 
-			if (last_operation_type == -1) {
-				tracker_data_update_buffer_flush (&new_error);
-				if (new_error) {
-					g_warning ("Journal replay error: '%s'", new_error->message);
-					g_clear_error (&new_error);
-				}
+		if (object && op.property == rdf_type) {
+			op.type = REPLAY_OP_DELETE_TYPE;
+			op.class = tracker_ontologies_get_class_by_uri (object);
+			if (!op.class) {
+				g_warning ("Journal replay error: 'class with '%s' not found in the ontology'", object);
+				return;
 			}
-			last_operation_type = 1;
+		} else if (object) {
+			op.object = g_string_chunk_insert (batch->strings, object);
+		}
+		break;
+	case TRACKER_DB_JOURNAL_DELETE_STATEMENT_ID:
+		op.type = REPLAY_OP_DELETE;
+		tracker_db_journal_reader_get_statement_id (&op.graph_id, &op.subject_id, &predicate_id, &op.object_id);
 
-			uri = tracker_ontologies_get_uri_by_id (predicate_id);
-			if (uri) {
-				property = tracker_ontologies_get_property_by_uri (uri);
+		op.property = replay_lookup_property (predicate_id);
+		if (!op.property) {
+			return;
+		}
+
+		if (op.property == rdf_type) {
+			op.type = REPLAY_OP_DELETE_TYPE;
+			op.class = replay_lookup_class (op.object_id);
+			if (!op.class) {
+				return;
 			}
+		}
+		break;
+	default:
+		return;
+	}
 
-			if (property) {
-				resource_buffer_switch (NULL, NULL, subject_id);
+	g_array_append_val (batch->ops, op);
+}
 
-				if (type == TRACKER_DB_JOURNAL_UPDATE_STATEMENT) {
-					cache_update_metadata_decomposed (property, object, 0, NULL, graph_id, &new_error);
-				} else {
-					cache_insert_metadata_decomposed (property, object, 0, NULL, graph_id, &new_error);
-				}
-				if (new_error) {
-					g_warning ("Journal replay error: '%s'", new_error->message);
-					g_clear_error (&new_error);
-				}
+static gpointer
+replay_decode_thread (gpointer user_data)
+{
+	ReplayPipeline *pipeline = user_data;
+	TrackerProperty *rdf_type;
+	gboolean more = TRUE;
 
-			} else {
-				g_warning ("Journal replay error: 'property with ID %d doesn't exist'", predicate_id);
-			}
+	rdf_type = tracker_ontologies_get_rdf_type ();
 
-		} else if (type == TRACKER_DB_JOURNAL_INSERT_STATEMENT_ID ||
-		           type == TRACKER_DB_JOURNAL_UPDATE_STATEMENT_ID) {
-			GError *new_error = NULL;
-			TrackerClass *class = NULL;
-			TrackerProperty *property = NULL;
+	while (more) {
+		ReplayBatch *batch;
+		guint n_entries = 0;
 
-			tracker_db_journal_reader_get_statement_id (&graph_id, &subject_id, &predicate_id, &object_id);
+		batch = g_async_queue_pop (pipeline->free_batches);
 
-			if (last_operation_type == -1) {
-				tracker_data_update_buffer_flush (&new_error);
-				if (new_error) {
-					g_warning ("Journal replay error: '%s'", new_error->message);
-					g_clear_error (&new_error);
-				}
-			}
-			last_operation_type = 1;
+		if (g_atomic_int_get (&pipeline->cancelled)) {
+			batch->last = TRUE;
+			g_async_queue_push (pipeline->full_batches, batch);
+			break;
+		}
 
-			uri = tracker_ontologies_get_uri_by_id (predicate_id);
-			if (uri) {
-				property = tracker_ontologies_get_property_by_uri (uri);
+		while (n_entries < REPLAY_BATCH_SIZE) {
+			if (!tracker_db_journal_reader_next (&batch->error)) {
+				more = FALSE;
+				break;
 			}
 
-			if (property) {
-				if (tracker_property_get_data_type (property) != TRACKER_PROPERTY_TYPE_RESOURCE) {
-					g_warning ("Journal replay error: 'property with ID %d does not account URIs'", predicate_id);
-				} else {
-					resource_buffer_switch (NULL, NULL, subject_id);
+			replay_decode_entry (batch, rdf_type);
+			n_entries++;
+		}
 
-					if (property == rdf_type) {
-						uri = tracker_ontologies_get_uri_by_id (object_id);
-						if (uri) {
-							class = tracker_ontologies_get_class_by_uri (uri);
-						}
-						if (class) {
-							cache_create_service_decomposed (class, NULL, graph_id);
-						} else {
-							g_warning ("Journal replay error: 'class with ID %d not found in the ontology'", object_id);
-						}
-					} else {
-						GError *new_error = NULL;
+		batch->progress = tracker_db_journal_reader_get_progress ();
+		batch->last = !more;
+		g_async_queue_push (pipeline->full_batches, batch);
+	}
 
-						/* add value to metadata database */
-						if (type == TRACKER_DB_JOURNAL_UPDATE_STATEMENT_ID) {
-							cache_update_metadata_decomposed (property, NULL, object_id, NULL, graph_id, &new_error);
-						} else {
-							cache_insert_metadata_decomposed (property, NULL, object_id, NULL, graph_id, &new_error);
-						}
+	return NULL;
+}
 
-						if (new_error) {
-							g_warning ("Journal replay error: '%s'", new_error->message);
-							g_error_free (new_error);
-						}
-					}
-				}
-			} else {
-				g_warning ("Journal replay error: 'property with ID %d doesn't exist'", predicate_id);
-			}
+/* Drops the plain indexes on class tables, they are not needed to
+ * apply the journal and are cheaper to build once at the end. Unique
+ * indexes and the ones on multi-valued property tables stay, replay
+ * relies on them.
+ *
+ * The dropped indexes are kept in ReplayDeferredIndex, in the same
+ * transaction, so they are recreated on the next start if replay does
+ * not get to the end, see tracker_data_replay_restore_indexes().
+ */
+static void
+replay_defer_indexes (TrackerDBInterface *iface)
+{
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor = NULL;
+	TrackerClass **classes;
+	GHashTable *class_tables;
+	GPtrArray *indexes;
+	GError *error = NULL;
+	guint i, n_classes;
 
-		} else if (type == TRACKER_DB_JOURNAL_DELETE_STATEMENT) {
-			GError *new_error = NULL;
-			TrackerProperty *property = NULL;
+	indexes = g_ptr_array_new_with_free_func (g_free);
 
-			tracker_db_journal_reader_get_statement (&graph_id, &subject_id, &predicate_id, &object);
+	/* sqlite_master reports table names, i.e. "nfo:Document",
+	 * not class URIs.
+	 */
+	class_tables = g_hash_table_new (g_str_hash, g_str_equal);
+	classes = tracker_ontologies_get_classes (&n_classes);
 
-			if (last_operation_type == 1) {
-				tracker_data_update_buffer_flush (&new_error);
-				if (new_error) {
-					g_warning ("Journal replay error: '%s'", new_error->message);
-					g_clear_error (&new_error);
-				}
-			}
-			last_operation_type = -1;
+	for (i = 0; i < n_classes; i++) {
+		g_hash_table_add (class_tables, (gpointer) tracker_class_get_name (classes[i]));
+	}
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, &error,
+	                                              "SELECT name, tbl_name, sql FROM sqlite_master "
+	                                              "WHERE type = 'index' AND sql IS NOT NULL "
+	                                              "AND sql NOT LIKE 'CREATE UNIQUE %%'");
+
+	if (stmt) {
+		cursor = tracker_db_statement_start_cursor (stmt, &error);
+		g_object_unref (stmt);
+	}
 
-			resource_buffer_switch (NULL, NULL, subject_id);
+	if (cursor) {
+		while (tracker_db_cursor_iter_next (cursor, NULL, &error)) {
+			const gchar *table;
 
-			uri = tracker_ontologies_get_uri_by_id (predicate_id);
-			if (uri) {
-				property = tracker_ontologies_get_property_by_uri (uri);
+			table = tracker_db_cursor_get_string (cursor, 1, NULL);
+			if (!table || !g_hash_table_contains (class_tables, table)) {
+				continue;
 			}
 
-			if (property) {
-				GError *new_error = NULL;
+			g_ptr_array_add (indexes, g_strdup (tracker_db_cursor_get_string (cursor, 0, NULL)));
+			g_ptr_array_add (indexes, g_strdup (tracker_db_cursor_get_string (cursor, 2, NULL)));
+		}
 
-				if (object && rdf_type == property) {
-					TrackerClass *class;
+		g_object_unref (cursor);
+	}
 
-					class = tracker_ontologies_get_class_by_uri (object);
-					if (class != NULL) {
-						cache_delete_resource_type (class, NULL, graph_id);
-					} else {
-						g_warning ("Journal replay error: 'class with '%s' not found in the ontology'", object);
-					}
-				} else {
-					delete_metadata_decomposed (property, object, 0, &new_error);
-				}
+	g_hash_table_unref (class_tables);
 
-				if (new_error) {
-					g_warning ("Journal replay error: '%s'", new_error->message);
-					g_error_free (new_error);
-				}
+	if (error || indexes->len == 0) {
+		if (error) {
+			g_warning ("Could not look up indexes to defer during journal replay: %s",
+			           error->message);
+			g_error_free (error);
+		}
+		g_ptr_array_unref (indexes);
+		return;
+	}
 
-			} else {
-				g_warning ("Journal replay error: 'property with ID %d doesn't exist'", predicate_id);
-			}
+	if (!tracker_db_interface_start_transaction (iface)) {
+		g_warning ("Could not start transaction to defer indexes during journal replay");
+		g_ptr_array_unref (indexes);
+		return;
+	}
 
-		} else if (type == TRACKER_DB_JOURNAL_DELETE_STATEMENT_ID) {
-			GError *new_error = NULL;
-			TrackerClass *class = NULL;
-			TrackerProperty *property = NULL;
+	tracker_db_interface_execute_query (iface, &error,
+	                                    "CREATE TABLE IF NOT EXISTS ReplayDeferredIndex "
+	                                    "(Name TEXT PRIMARY KEY, Sql TEXT NOT NULL)");
 
-			tracker_db_journal_reader_get_statement_id (&graph_id, &subject_id, &predicate_id, &object_id);
+	for (i = 0; i < indexes->len && !error; i += 2) {
+		stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, &error,
+		                                              "INSERT OR REPLACE INTO ReplayDeferredIndex (Name, Sql) "
+		                                              "VALUES (?, ?)");
 
-			if (last_operation_type == 1) {
-				tracker_data_update_buffer_flush (&new_error);
-				if (new_error) {
-					g_warning ("Journal replay error: '%s'", new_error->message);
-					g_clear_error (&new_error);
-				}
+		if (stmt) {
+			tracker_db_statement_bind_text (stmt, 0, g_ptr_array_index (indexes, i));
+			tracker_db_statement_bind_text (stmt, 1, g_ptr_array_index (indexes, i + 1));
+			tracker_db_statement_execute (stmt, &error);
+			g_object_unref (stmt);
+		}
+
+		if (!error) {
+			tracker_db_interface_execute_query (iface, &error,
+			                                    "DROP INDEX IF EXISTS \"%s\"",
+			                                    (gchar *) g_ptr_array_index (indexes, i));
+		}
+	}
+
+	if (!error) {
+		tracker_db_interface_end_db_transaction (iface, &error);
+	}
+
+	if (error) {
+		/* Replay goes on with all indexes in place */
+		g_warning ("Could not defer indexes during journal replay: %s",
+		           error->message);
+		g_error_free (error);
+		tracker_db_interface_execute_query (iface, NULL, "ROLLBACK");
+	}
+
+	g_ptr_array_unref (indexes);
+}
+
+/**
+ * tracker_data_replay_restore_indexes:
+ *
+ * Recreates the indexes dropped for a journal replay, including those
+ * of a replay that was interrupted. Indexes that can't be recreated
+ * are tried again on the next call.
+ */
+void
+tracker_data_replay_restore_indexes (void)
+{
+	TrackerDBInterface *iface;
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor = NULL;
+	GPtrArray *indexes;
+	GError *error = NULL;
+	guint i, n_restored = 0;
+
+	iface = tracker_db_manager_get_db_interface ();
+
+	/* Fails if there is no ReplayDeferredIndex table */
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, NULL,
+	                                              "SELECT Name, Sql FROM ReplayDeferredIndex");
+
+	if (!stmt) {
+		return;
+	}
+
+	cursor = tracker_db_statement_start_cursor (stmt, NULL);
+	g_object_unref (stmt);
+
+	if (!cursor) {
+		return;
+	}
+
+	indexes = g_ptr_array_new_with_free_func (g_free);
+
+	while (tracker_db_cursor_iter_next (cursor, NULL, NULL)) {
+		g_ptr_array_add (indexes, g_strdup (tracker_db_cursor_get_string (cursor, 0, NULL)));
+		g_ptr_array_add (indexes, g_strdup (tracker_db_cursor_get_string (cursor, 1, NULL)));
+	}
+
+	g_object_unref (cursor);
+
+	for (i = 0; i < indexes->len; i += 2) {
+		const gchar *name = g_ptr_array_index (indexes, i);
+		const gchar *sql = g_ptr_array_index (indexes, i + 1);
+
+		/* The index may be there already if a previous attempt
+		 * was interrupted before forgetting about it */
+		if (g_str_has_prefix (sql, "CREATE INDEX ")) {
+			tracker_db_interface_execute_query (iface, &error,
+			                                    "CREATE INDEX IF NOT EXISTS %s",
+			                                    sql + strlen ("CREATE INDEX "));
+		} else {
+			tracker_db_interface_execute_query (iface, &error, "%s", sql);
+		}
+
+		if (!error) {
+			stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, &error,
+			                                              "DELETE FROM ReplayDeferredIndex WHERE Name = ?");
+
+			if (stmt) {
+				tracker_db_statement_bind_text (stmt, 0, name);
+				tracker_db_statement_execute (stmt, &error);
+				g_object_unref (stmt);
 			}
-			last_operation_type = -1;
+		}
+
+		if (error) {
+			g_warning ("Could not recreate index '%s' after journal replay: %s",
+			           name, error->message);
+			g_clear_error (&error);
+		} else {
+			n_restored++;
+		}
+	}
+
+	if (n_restored == indexes->len / 2) {
+		tracker_db_interface_execute_query (iface, NULL,
+		                                    "DROP TABLE IF EXISTS ReplayDeferredIndex");
+	}
+
+	g_ptr_array_unref (indexes);
+}
+
+/* Ends a journal transaction applied in a SQLite transaction shared
+ * with the previous ones, keeps modification times and modseqs as if
+ * it had been committed on its own.
+ */
+static void
+replay_transaction_boundary (time_t time)
+{
+	GError *error = NULL;
+
+	tracker_data_update_buffer_flush (&error);
+	if (error) {
+		g_warning ("Journal replay error: '%s'", error->message);
+		g_clear_error (&error);
+	}
+
+	get_transaction_modseq ();
+	if (has_persistent) {
+		transaction_modseq++;
+	}
+
+	has_persistent = FALSE;
+	resource_time = time;
+}
+
+static gboolean
+replay_commit (GError **error)
+{
+	GError *new_error = NULL;
+
+	tracker_data_commit_transaction (&new_error);
+	if (new_error) {
+		/* Out of disk is an unrecoverable fatal error */
+		if (g_error_matches (new_error, TRACKER_DB_INTERFACE_ERROR, TRACKER_DB_NO_SPACE)) {
+			g_propagate_error (error, new_error);
+			return FALSE;
+		} else {
+			g_warning ("Journal replay error: '%s'", new_error->message);
+			g_clear_error (&new_error);
+		}
+	}
+
+	return TRUE;
+}
+
+static void
+replay_apply_op (const ReplayOp *op,
+                 gint           *last_operation_type)
+{
+	GError *new_error = NULL;
+	gint operation_type;
+
+	switch (op->type) {
+	case REPLAY_OP_RESOURCE: {
+		TrackerDBInterface *iface;
+		TrackerDBStatement *stmt;
+
+		iface = tracker_db_manager_get_db_interface ();
 
-			uri = tracker_ontologies_get_uri_by_id (predicate_id);
-			if (uri) {
-				property = tracker_ontologies_get_property_by_uri (uri);
+		stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE, &new_error,
+		                                              "INSERT INTO Resource (ID, Uri) VALUES (?, ?)");
+
+		if (stmt) {
+			tracker_db_statement_bind_int (stmt, 0, op->subject_id);
+			tracker_db_statement_bind_text (stmt, 1, op->object);
+			tracker_db_statement_execute (stmt, &new_error);
+			g_object_unref (stmt);
+		}
+		break;
+	}
+	case REPLAY_OP_INSERT:
+	case REPLAY_OP_UPDATE:
+	case REPLAY_OP_CREATE_TYPE:
+	case REPLAY_OP_DELETE:
+	case REPLAY_OP_DELETE_TYPE:
+		operation_type = (op->type == REPLAY_OP_DELETE ||
+		                  op->type == REPLAY_OP_DELETE_TYPE) ? -1 : 1;
+
+		if (*last_operation_type == -operation_type) {
+			tracker_data_update_buffer_flush (&new_error);
+			if (new_error) {
+				g_warning ("Journal replay error: '%s'", new_error->message);
+				g_clear_error (&new_error);
 			}
+		}
+		*last_operation_type = operation_type;
+
+		resource_buffer_switch (NULL, NULL, op->subject_id);
+
+		if (op->type == REPLAY_OP_INSERT) {
+			cache_insert_metadata_decomposed (op->property, op->object, op->object_id,
+			                                  NULL, op->graph_id, &new_error);
+		} else if (op->type == REPLAY_OP_UPDATE) {
+			cache_update_metadata_decomposed (op->property, op->object, op->object_id,
+			                                  NULL, op->graph_id, &new_error);
+		} else if (op->type == REPLAY_OP_CREATE_TYPE) {
+			cache_create_service_decomposed (op->class, NULL, op->graph_id);
+		} else if (op->type == REPLAY_OP_DELETE) {
+			delete_metadata_decomposed (op->property, op->object, op->object_id, &new_error);
+		} else {
+			cache_delete_resource_type (op->class, NULL, op->graph_id);
+		}
+		break;
+	default:
+		g_assert_not_reached ();
+	}
 
-			if (property) {
+	if (new_error) {
+		g_warning ("Journal replay error: '%s'", new_error->message);
+		g_error_free (new_error);
+	}
+}
 
-				resource_buffer_switch (NULL, NULL, subject_id);
+void
+tracker_data_replay_journal (TrackerBusyCallback   busy_callback,
+                             gpointer              busy_user_data,
+                             const gchar          *busy_status,
+                             GError              **error)
+{
+	GError *journal_error = NULL;
+	GError *n_error = NULL;
+	ReplayPipeline pipeline = { 0 };
+	TrackerDBInterface *iface;
+	GThread *decoder;
+	GTimer *timer;
+	gint last_operation_type = 0;
+	guint64 n_applied = 0;
+	guint n_in_transaction = 0;
+	gboolean done = FALSE;
+	guint i;
 
-				if (property == rdf_type) {
-					uri = tracker_ontologies_get_uri_by_id (object_id);
-					if (uri) {
-						class = tracker_ontologies_get_class_by_uri (uri);
-					}
-					if (class) {
-						cache_delete_resource_type (class, NULL, graph_id);
-					} else {
-						g_warning ("Journal replay error: 'class with ID %d not found in the ontology'", object_id);
-					}
+	tracker_db_journal_reader_init (NULL, &n_error);
+	if (n_error) {
+		/* This is fatal (doesn't happen when file doesn't exist, does happen
+		 * when for some other reason the reader can't be created) */
+		g_propagate_error (error, n_error);
+		return;
+	}
+
+	iface = tracker_db_manager_get_db_interface ();
+	replay_defer_indexes (iface);
+
+	pipeline.free_batches = g_async_queue_new_full ((GDestroyNotify) replay_batch_free);
+	pipeline.full_batches = g_async_queue_new_full ((GDestroyNotify) replay_batch_free);
+
+	for (i = 0; i < REPLAY_QUEUE_LENGTH; i++) {
+		g_async_queue_push (pipeline.free_batches, replay_batch_new ());
+	}
+
+	timer = g_timer_new ();
+	decoder = g_thread_new ("journal replay", replay_decode_thread, &pipeline);
+
+	while (!done) {
+		ReplayBatch *batch;
+
+		batch = g_async_queue_pop (pipeline.full_batches);
+
+		for (i = 0; i < batch->ops->len && !pipeline.cancelled; i++) {
+			const ReplayOp *op = &g_array_index (batch->ops, ReplayOp, i);
+
+			if (op->type == REPLAY_OP_BEGIN) {
+				if (in_transaction) {
+					replay_transaction_boundary (op->time);
 				} else {
-					GError *new_error = NULL;
+					tracker_data_begin_transaction_for_replay (op->time, NULL);
+				}
+			} else if (op->type == REPLAY_OP_END) {
+				tracker_data_update_buffer_might_flush (NULL);
 
-					delete_metadata_decomposed (property, NULL, object_id, &new_error);
+				if (n_in_transaction >= REPLAY_TRANSACTION_SIZE) {
+					n_in_transaction = 0;
 
-					if (new_error) {
-						g_warning ("Journal replay error: '%s'", new_error->message);
-						g_error_free (new_error);
+					if (!replay_commit (error)) {
+						g_atomic_int_set (&pipeline.cancelled, TRUE);
 					}
 				}
 			} else {
-				g_warning ("Journal replay error: 'property with ID %d doesn't exist'", predicate_id);
+				replay_apply_op (op, &last_operation_type);
+				n_in_transaction++;
+				n_applied++;
 			}
 		}
 
-		if (busy_callback) {
-			busy_callback (busy_status,
-			               tracker_db_journal_reader_get_progress (),
-			               busy_user_data);
+		done = batch->last;
+
+		if (done && batch->error) {
+			journal_error = batch->error;
+			batch->error = NULL;
+		}
+
+		/* Report how far the applied data got, not the decoder */
+		if (busy_callback && !pipeline.cancelled) {
+			busy_callback (busy_status, batch->progress, busy_user_data);
 		}
+
+		replay_batch_recycle (&pipeline, batch);
+	}
+
+	g_thread_join (decoder);
+
+	g_debug ("Replayed %" G_GUINT64_FORMAT " journal operations in %.1f seconds",
+	         n_applied, g_timer_elapsed (timer, NULL));
+	g_timer_destroy (timer);
+
+	g_async_queue_unref (pipeline.free_batches);
+	g_async_queue_unref (pipeline.full_batches);
+
+	if (pipeline.cancelled) {
+		/* The database is dropped after a fatal error, if it is
+		 * kept the indexes are recreated on the next start. */
+		g_clear_error (&journal_error);
+		tracker_db_journal_reader_shutdown ();
+		return;
+	}
+
+	if (in_transaction && !replay_commit (error)) {
+		g_clear_error (&journal_error);
+		tracker_db_journal_reader_shutdown ();
+		return;
 	}
 
+	tracker_data_replay_restore_indexes ();
 
 	if (journal_error) {
 		GError *n_error = NULL;
@@ -40,6 +40,15 @@ typedef enum {
 	TRACKER_DATA_COMMIT_BATCH_LAST
 } TrackerDataCommitType;
 
+typedef enum {
+	TRACKER_DATA_SAVEPOINT_BEGIN,
+	TRACKER_DATA_SAVEPOINT_RELEASE,
+	TRACKER_DATA_SAVEPOINT_ROLLBACK
+} TrackerDataSavepointAction;
+
+/* defined in the Vala generated tracker-sparql-query.h */
+struct _TrackerSparqlQuery;
+
 typedef void (*TrackerStatementCallback) (gint                  graph_id,
                                           const gchar          *graph,
                                           gint                  subject_id,
@@ -51,6 +60,8 @@ typedef void (*TrackerStatementCallback) (gint                  graph_id,
                                           gpointer              user_data);
 typedef void (*TrackerCommitCallback)    (TrackerDataCommitType commit_type,
                                           gpointer              user_data);
+typedef void (*TrackerSavepointCallback) (TrackerDataSavepointAction action,
+                                          gpointer                   user_data);
 
 GQuark   tracker_data_error_quark                   (void);
 
@@ -92,6 +103,13 @@ void     tracker_data_update_sparql                 (const gchar               *
 GVariant *
          tracker_data_update_sparql_blank           (const gchar               *update,
                                                      GError                   **error);
+GPtrArray *
+         tracker_data_update_sparql_batch           (gchar                    **updates,
+                                                     gint                       n_updates,
+                                                     struct _TrackerSparqlQuery **prepared,
+                                                     GError                   **error);
+void     tracker_data_update_prepared               (struct _TrackerSparqlQuery *sparql_query,
+                                                     GError                   **error);
 void     tracker_data_update_buffer_flush           (GError                   **error);
 void     tracker_data_update_buffer_might_flush     (GError                   **error);
 void     tracker_data_load_turtle_file              (GFile                     *file,
@@ -102,6 +120,7 @@ void     tracker_data_replay_journal                (TrackerBusyCallback
                                                      gpointer                   busy_user_data,
                                                      const gchar               *busy_status,
                                                      GError                   **error);
+void     tracker_data_replay_restore_indexes        (void);
 
 /* Calling back */
 void     tracker_data_add_insert_statement_callback      (TrackerStatementCallback   callback,
@@ -112,6 +131,8 @@ void     tracker_data_add_commit_statement_callback      (TrackerCommitCallback
                                                           gpointer                   user_data);
 void     tracker_data_add_rollback_statement_callback    (TrackerCommitCallback      callback,
                                                           gpointer                   user_data);
+void     tracker_data_add_savepoint_callback             (TrackerSavepointCallback   callback,
+                                                          gpointer                   user_data);
 void     tracker_data_remove_insert_statement_callback   (TrackerStatementCallback   callback,
                                                           gpointer                   user_data);
 void     tracker_data_remove_delete_statement_callback   (TrackerStatementCallback   callback,
@@ -120,6 +141,8 @@ void     tracker_data_remove_commit_statement_callback   (TrackerCommitCallback
                                                           gpointer                   user_data);
 void     tracker_data_remove_rollback_statement_callback (TrackerCommitCallback      callback,
                                                           gpointer                   user_data);
+void     tracker_data_remove_savepoint_callback          (TrackerSavepointCallback   callback,
+                                                          gpointer                   user_data);
 
 void     tracker_data_update_shutdown                 (void);
 #define  tracker_data_update_init                     tracker_data_update_shutdown
@@ -39,6 +39,8 @@
 /* Default values */
 #define DEFAULT_JOURNAL_CHUNK_SIZE           50
 #define DEFAULT_JOURNAL_ROTATE_DESTINATION   ""
+#define DEFAULT_JOURNAL_COMPRESSION          FALSE
+#define DEFAULT_RESOURCE_CACHE_SIZE          10000
 
 static void config_set_property (GObject      *object,
                                  guint         param_id,
@@ -56,7 +58,11 @@ enum {
 
 	/* Journal */
 	PROP_JOURNAL_CHUNK_SIZE,
-	PROP_JOURNAL_ROTATE_DESTINATION
+	PROP_JOURNAL_ROTATE_DESTINATION,
+	PROP_JOURNAL_COMPRESSION,
+
+	/* Cache */
+	PROP_RESOURCE_CACHE_SIZE
 };
 
 G_DEFINE_TYPE (TrackerDBConfig, tracker_db_config, G_TYPE_SETTINGS);
@@ -89,6 +95,24 @@ tracker_db_config_class_init (TrackerDBConfigClass *klass)
 	                                                      DEFAULT_JOURNAL_ROTATE_DESTINATION,
 	                                                      G_PARAM_READWRITE));
 
+	g_object_class_install_property (object_class,
+	                                 PROP_JOURNAL_COMPRESSION,
+	                                 g_param_spec_boolean ("journal-compression",
+	                                                       "Journal compression",
+	                                                       " Compress transactions in new journal files",
+	                                                       DEFAULT_JOURNAL_COMPRESSION,
+	                                                       G_PARAM_READWRITE));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_RESOURCE_CACHE_SIZE,
+	                                 g_param_spec_int ("resource-cache-size",
+	                                                   "Resource cache size",
+	                                                   " Number of resource URI to ID mappings kept in memory. Use 0 to disable the cache",
+	                                                   0,
+	                                                   10000000,
+	                                                   DEFAULT_RESOURCE_CACHE_SIZE,
+	                                                   G_PARAM_READWRITE));
+
 }
 
 static void
@@ -112,6 +136,16 @@ config_set_property (GObject      *object,
 		tracker_db_config_set_journal_rotate_destination (TRACKER_DB_CONFIG (object),
 		                                                  g_value_get_string(value));
 		break;
+	case PROP_JOURNAL_COMPRESSION:
+		tracker_db_config_set_journal_compression (TRACKER_DB_CONFIG (object),
+		                                           g_value_get_boolean(value));
+		break;
+
+		/* Cache */
+	case PROP_RESOURCE_CACHE_SIZE:
+		tracker_db_config_set_resource_cache_size (TRACKER_DB_CONFIG (object),
+		                                           g_value_get_int(value));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
 		break;
@@ -133,6 +167,12 @@ config_get_property (GObject    *object,
 	case PROP_JOURNAL_ROTATE_DESTINATION:
 		g_value_take_string (value, tracker_db_config_get_journal_rotate_destination (config));
 		break;
+	case PROP_JOURNAL_COMPRESSION:
+		g_value_set_boolean (value, tracker_db_config_get_journal_compression (config));
+		break;
+	case PROP_RESOURCE_CACHE_SIZE:
+		g_value_set_int (value, tracker_db_config_get_resource_cache_size (config));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
 		break;
@@ -160,6 +200,8 @@ config_constructed (GObject *object)
 
 	g_settings_bind (settings, "journal-chunk-size", object, "journal-chunk-size", G_SETTINGS_BIND_GET | G_SETTINGS_BIND_GET_NO_CHANGES);
 	g_settings_bind (settings, "journal-rotate-destination", object, "journal-rotate-destination", G_SETTINGS_BIND_GET | G_SETTINGS_BIND_GET_NO_CHANGES);
+	g_settings_bind (settings, "journal-compression", object, "journal-compression", G_SETTINGS_BIND_GET | G_SETTINGS_BIND_GET_NO_CHANGES);
+	g_settings_bind (settings, "resource-cache-size", object, "resource-cache-size", G_SETTINGS_BIND_GET | G_SETTINGS_BIND_GET_NO_CHANGES);
 }
 
 TrackerDBConfig *
@@ -229,6 +271,22 @@ tracker_db_config_get_journal_rotate_destination (TrackerDBConfig *config)
 	return g_settings_get_string (G_SETTINGS (config), "journal-rotate-destination");
 }
 
+gboolean
+tracker_db_config_get_journal_compression (TrackerDBConfig *config)
+{
+	g_return_val_if_fail (TRACKER_IS_DB_CONFIG (config), DEFAULT_JOURNAL_COMPRESSION);
+
+	return g_settings_get_boolean (G_SETTINGS (config), "journal-compression");
+}
+
+gint
+tracker_db_config_get_resource_cache_size (TrackerDBConfig *config)
+{
+	g_return_val_if_fail (TRACKER_IS_DB_CONFIG (config), DEFAULT_RESOURCE_CACHE_SIZE);
+
+	return g_settings_get_int (G_SETTINGS (config), "resource-cache-size");
+}
+
 void
 tracker_db_config_set_journal_chunk_size (TrackerDBConfig *config,
                                           gint             value)
@@ -248,3 +306,23 @@ tracker_db_config_set_journal_rotate_destination (TrackerDBConfig *config,
 	g_settings_set_string (G_SETTINGS (config), "journal-rotate-destination", value);
 	g_object_notify (G_OBJECT (config), "journal-rotate-destination");
 }
+
+void
+tracker_db_config_set_journal_compression (TrackerDBConfig *config,
+                                           gboolean         value)
+{
+	g_return_if_fail (TRACKER_IS_DB_CONFIG (config));
+
+	g_settings_set_boolean (G_SETTINGS (config), "journal-compression", value);
+	g_object_notify (G_OBJECT (config), "journal-compression");
+}
+
+void
+tracker_db_config_set_resource_cache_size (TrackerDBConfig *config,
+                                           gint             value)
+{
+	g_return_if_fail (TRACKER_IS_DB_CONFIG (config));
+
+	g_settings_set_int (G_SETTINGS (config), "resource-cache-size", value);
+	g_object_notify (G_OBJECT (config), "resource-cache-size");
+}
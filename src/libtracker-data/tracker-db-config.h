@@ -56,11 +56,17 @@ gboolean         tracker_db_config_save                           (TrackerDBConf
 
 gint             tracker_db_config_get_journal_chunk_size         (TrackerDBConfig *config);
 gchar *          tracker_db_config_get_journal_rotate_destination (TrackerDBConfig *config);
+gboolean         tracker_db_config_get_journal_compression        (TrackerDBConfig *config);
+gint             tracker_db_config_get_resource_cache_size        (TrackerDBConfig *config);
 
 void             tracker_db_config_set_journal_chunk_size         (TrackerDBConfig *config,
                                                                    gint             value);
 void             tracker_db_config_set_journal_rotate_destination (TrackerDBConfig *config,
                                                                    const gchar     *value);
+void             tracker_db_config_set_journal_compression        (TrackerDBConfig *config,
+                                                                   gboolean         value);
+void             tracker_db_config_set_resource_cache_size        (TrackerDBConfig *config,
+                                                                   gint             value);
 
 G_END_DECLS
 
@@ -98,6 +98,9 @@ struct TrackerDBInterface {
 	/* Used if TRACKER_DB_MANAGER_ENABLE_MUTEXES is set */
 	GMutex mutex;
 	guint use_mutex;
+
+	/* Schema generation the cached statements were prepared for */
+	guint schema_generation;
 };
 
 struct TrackerDBInterfaceClass {
@@ -153,6 +156,11 @@ enum {
 	PROP_RO
 };
 
+/* Bumped when tables that cached statements and SQL translations may
+ * refer to come or go without an ontology change, e.g. FtsReindexStale.
+ */
+static gint schema_generation;
+
 enum {
 	TRACKER_DB_CURSOR_PROP_0,
 	TRACKER_DB_CURSOR_PROP_N_COLUMNS
@@ -1653,6 +1661,10 @@ tracker_db_interface_sqlite_fts_alter_table (TrackerDBInterface  *db_interface,
 					     GHashTable          *properties,
 					     GHashTable          *multivalued)
 {
+	/* The reindex table would miss the new columns, alter_table()
+	 * builds the tokens from scratch anyway */
+	tracker_db_interface_sqlite_fts_reindex_cancel (db_interface);
+
 	if (!tracker_fts_alter_table (db_interface->db, "fts5", properties, multivalued)) {
 		g_critical ("Failed to update FTS columns");
 	}
@@ -1660,17 +1672,19 @@ tracker_db_interface_sqlite_fts_alter_table (TrackerDBInterface  *db_interface,
 
 static gchar *
 tracker_db_interface_sqlite_fts_create_query (TrackerDBInterface  *db_interface,
+                                              const gchar         *table,
                                               gboolean             delete,
                                               const gchar        **properties)
 {
 	GString *insert_str, *values_str;
 	gint i;
 
-	insert_str = g_string_new ("INSERT INTO fts5 (");
+	insert_str = g_string_new (NULL);
+	g_string_append_printf (insert_str, "INSERT INTO %s (", table);
 	values_str = g_string_new (NULL);
 
 	if (delete) {
-		g_string_append (insert_str, "fts5,");
+		g_string_append_printf (insert_str, "%s,", table);
 		g_string_append (values_str, "'delete',");
 	}
 
@@ -1689,32 +1703,35 @@ tracker_db_interface_sqlite_fts_create_query (TrackerDBInterface  *db_interface,
 }
 
 static gchar *
-tracker_db_interface_sqlite_fts_create_delete_all_query (TrackerDBInterface *db_interface)
+tracker_db_interface_sqlite_fts_create_delete_all_query (TrackerDBInterface *db_interface,
+                                                         const gchar        *table)
 {
 	GString *insert_str;
 
 	insert_str = g_string_new (NULL);
 	g_string_append_printf (insert_str,
-	                        "INSERT INTO fts5 (fts5, rowid %s) "
+	                        "INSERT INTO %s (%s, rowid %s) "
 	                        "SELECT 'delete', rowid %s FROM fts_view "
 	                        "WHERE rowid = ?",
+	                        table, table,
 	                        db_interface->fts_properties,
 	                        db_interface->fts_properties);
 	return g_string_free (insert_str, FALSE);
 }
 
-gboolean
-tracker_db_interface_sqlite_fts_update_text (TrackerDBInterface  *db_interface,
-                                             int                  id,
-                                             const gchar        **properties,
-                                             const gchar        **text)
+static gboolean
+fts_update_text (TrackerDBInterface  *db_interface,
+                 const gchar         *table,
+                 int                  id,
+                 const gchar        **properties,
+                 const gchar        **text)
 {
 	TrackerDBStatement *stmt;
 	GError *error = NULL;
 	gchar *query;
 	gint i;
 
-	query = tracker_db_interface_sqlite_fts_create_query (db_interface,
+	query = tracker_db_interface_sqlite_fts_create_query (db_interface, table,
 	                                                      FALSE, properties);
 	stmt = tracker_db_interface_create_statement (db_interface,
 	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE,
@@ -1748,18 +1765,19 @@ tracker_db_interface_sqlite_fts_update_text (TrackerDBInterface  *db_interface,
         return TRUE;
 }
 
-gboolean
-tracker_db_interface_sqlite_fts_delete_text (TrackerDBInterface  *db_interface,
-                                             int                  rowid,
-                                             const gchar         *property,
-                                             const gchar         *old_text)
+static gboolean
+fts_delete_text (TrackerDBInterface  *db_interface,
+                 const gchar         *table,
+                 int                  rowid,
+                 const gchar         *property,
+                 const gchar         *old_text)
 {
 	TrackerDBStatement *stmt;
 	GError *error = NULL;
 	const gchar *properties[] = { property, NULL };
 	gchar *query;
 
-	query = tracker_db_interface_sqlite_fts_create_query (db_interface,
+	query = tracker_db_interface_sqlite_fts_create_query (db_interface, table,
 	                                                      TRUE, properties);
 	stmt = tracker_db_interface_create_statement (db_interface,
 	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE,
@@ -1788,15 +1806,16 @@ tracker_db_interface_sqlite_fts_delete_text (TrackerDBInterface  *db_interface,
 	return TRUE;
 }
 
-gboolean
-tracker_db_interface_sqlite_fts_delete_id (TrackerDBInterface *db_interface,
-                                           int                 id)
+static gboolean
+fts_delete_id (TrackerDBInterface *db_interface,
+               const gchar        *table,
+               int                 id)
 {
 	TrackerDBStatement *stmt;
 	GError *error = NULL;
 	gchar *query;
 
-	query = tracker_db_interface_sqlite_fts_create_delete_all_query (db_interface);
+	query = tracker_db_interface_sqlite_fts_create_delete_all_query (db_interface, table);
 	stmt = tracker_db_interface_create_statement (db_interface,
 	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE,
 	                                              &error,
@@ -1825,12 +1844,364 @@ tracker_db_interface_sqlite_fts_delete_id (TrackerDBInterface *db_interface,
 	return TRUE;
 }
 
+static void
+schema_changed (void)
+{
+	g_atomic_int_inc (&schema_generation);
+}
+
+/* Last resource ID already in fts5_reindex, -1 if no reindex is in
+ * progress. Only the writer connection touches it.
+ */
+static gint fts_reindex_last_id = -1;
+
+static inline gboolean
+fts_reindexed (int id)
+{
+	return fts_reindex_last_id >= 0 && id <= fts_reindex_last_id;
+}
+
+/* The tokens in fts5 came from the tokenizer before the change, FTS5
+ * 'delete' commands tokenize the old text with the current one, which
+ * would remove tokens that were never there and corrupt the index.
+ * Instead, deletes skip fts5 while a reindex is in progress and the
+ * resources whose old tokens are left behind are kept in
+ * FtsReindexStale, queries leave them out until fts5_reindex takes over.
+ */
+static gboolean
+fts_mark_stale (TrackerDBInterface *db_interface,
+                int                 id)
+{
+	TrackerDBStatement *stmt;
+	GError *error = NULL;
+
+	stmt = tracker_db_interface_create_statement (db_interface,
+	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE,
+	                                              &error,
+	                                              "INSERT OR IGNORE INTO FtsReindexStale (ID) VALUES (?)");
+
+	if (stmt) {
+		tracker_db_statement_bind_int (stmt, 0, id);
+		tracker_db_statement_execute (stmt, &error);
+		g_object_unref (stmt);
+	}
+
+	if (error) {
+		g_warning ("Could not mark FTS text as stale: %s", error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Changes to resources the reindex went past must go to both tables.
+ * New text can go to fts5 too, it is tokenized the same way queries are.
+ */
+gboolean
+tracker_db_interface_sqlite_fts_update_text (TrackerDBInterface  *db_interface,
+                                             int                  id,
+                                             const gchar        **properties,
+                                             const gchar        **text)
+{
+	if (!fts_update_text (db_interface, "fts5", id, properties, text))
+		return FALSE;
+
+	if (fts_reindexed (id))
+		return fts_update_text (db_interface, "fts5_reindex", id, properties, text);
+
+	return TRUE;
+}
+
+gboolean
+tracker_db_interface_sqlite_fts_delete_text (TrackerDBInterface  *db_interface,
+                                             int                  rowid,
+                                             const gchar         *property,
+                                             const gchar         *old_text)
+{
+	if (fts_reindex_last_id >= 0) {
+		if (!fts_mark_stale (db_interface, rowid))
+			return FALSE;
+	} else if (!fts_delete_text (db_interface, "fts5", rowid, property, old_text)) {
+		return FALSE;
+	}
+
+	if (fts_reindexed (rowid))
+		return fts_delete_text (db_interface, "fts5_reindex", rowid, property, old_text);
+
+	return TRUE;
+}
+
+gboolean
+tracker_db_interface_sqlite_fts_delete_id (TrackerDBInterface *db_interface,
+                                           int                 id)
+{
+	if (fts_reindex_last_id >= 0) {
+		if (!fts_mark_stale (db_interface, id))
+			return FALSE;
+	} else if (!fts_delete_id (db_interface, "fts5", id)) {
+		return FALSE;
+	}
+
+	if (fts_reindexed (id))
+		return fts_delete_id (db_interface, "fts5_reindex", id);
+
+	return TRUE;
+}
+
 void
 tracker_db_interface_sqlite_fts_rebuild_tokens (TrackerDBInterface *interface)
 {
+	tracker_db_interface_sqlite_fts_reindex_cancel (interface);
 	tracker_fts_rebuild_tokens (interface->db, "fts5");
 }
 
+/**
+ * tracker_db_interface_sqlite_fts_reindex_start:
+ * @interface: the writer connection
+ * @properties: FTS properties, as given to tracker_db_interface_sqlite_fts_init()
+ *
+ * Starts rebuilding the FTS tokens into a separate table, in chunks
+ * done by tracker_db_interface_sqlite_fts_reindex_step(). Queries use
+ * the current tokens until the reindex is complete. The progress is
+ * stored in the database, see tracker_db_interface_sqlite_fts_reindex_resume().
+ */
+gboolean
+tracker_db_interface_sqlite_fts_reindex_start (TrackerDBInterface  *interface,
+                                               GHashTable          *properties,
+                                               GError             **error)
+{
+	GError *internal_error = NULL;
+
+	if (!interface->fts_properties) {
+		/* No FTS table to rebuild */
+		return TRUE;
+	}
+
+	if (!tracker_db_interface_start_transaction (interface)) {
+		g_set_error (error, TRACKER_DB_INTERFACE_ERROR, TRACKER_DB_QUERY_ERROR,
+		             "Could not start FTS reindex transaction");
+		return FALSE;
+	}
+
+	if (!tracker_fts_create_reindex_table (interface->db, "fts5", properties)) {
+		g_set_error (error, TRACKER_DB_INTERFACE_ERROR, TRACKER_DB_QUERY_ERROR,
+		             "Could not create FTS reindex table: %s",
+		             sqlite3_errmsg (interface->db));
+		tracker_db_interface_execute_query (interface, NULL, "ROLLBACK");
+		return FALSE;
+	}
+
+	tracker_db_interface_execute_query (interface, &internal_error,
+	                                    "DROP TABLE IF EXISTS FtsReindex");
+
+	if (!internal_error) {
+		tracker_db_interface_execute_query (interface, &internal_error,
+		                                    "DROP TABLE IF EXISTS FtsReindexStale");
+	}
+
+	if (!internal_error) {
+		tracker_db_interface_execute_query (interface, &internal_error,
+		                                    "CREATE TABLE FtsReindex (LastID INTEGER NOT NULL)");
+	}
+
+	if (!internal_error) {
+		tracker_db_interface_execute_query (interface, &internal_error,
+		                                    "CREATE TABLE FtsReindexStale (ID INTEGER PRIMARY KEY)");
+	}
+
+	if (!internal_error) {
+		tracker_db_interface_execute_query (interface, &internal_error,
+		                                    "INSERT INTO FtsReindex (LastID) VALUES (0)");
+	}
+
+	if (!internal_error) {
+		tracker_db_interface_end_db_transaction (interface, &internal_error);
+	}
+
+	if (internal_error) {
+		tracker_db_interface_execute_query (interface, NULL, "ROLLBACK");
+		g_propagate_error (error, internal_error);
+		return FALSE;
+	}
+
+	fts_reindex_last_id = 0;
+	schema_changed ();
+
+	return TRUE;
+}
+
+/**
+ * tracker_db_interface_sqlite_fts_reindex_resume:
+ * @interface: the writer connection
+ *
+ * Picks up a reindex left unfinished by a previous run.
+ *
+ * Returns: %TRUE if there is a reindex in progress.
+ */
+gboolean
+tracker_db_interface_sqlite_fts_reindex_resume (TrackerDBInterface *interface)
+{
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor = NULL;
+
+	fts_reindex_last_id = -1;
+
+	/* Fails if there is no FtsReindex table */
+	stmt = tracker_db_interface_create_statement (interface,
+	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_NONE,
+	                                              NULL,
+	                                              "SELECT LastID FROM FtsReindex");
+
+	if (stmt) {
+		cursor = tracker_db_statement_start_cursor (stmt, NULL);
+		g_object_unref (stmt);
+	}
+
+	if (cursor) {
+		if (tracker_db_cursor_iter_next (cursor, NULL, NULL)) {
+			fts_reindex_last_id = tracker_db_cursor_get_int (cursor, 0);
+		}
+
+		g_object_unref (cursor);
+	}
+
+	if (fts_reindex_last_id >= 0) {
+		g_message ("Resuming FTS reindex after resource ID %d",
+		           fts_reindex_last_id);
+		tracker_db_interface_execute_query (interface, NULL,
+		                                    "CREATE TABLE IF NOT EXISTS FtsReindexStale (ID INTEGER PRIMARY KEY)");
+		schema_changed ();
+	}
+
+	return fts_reindex_last_id >= 0;
+}
+
+gboolean
+tracker_db_interface_sqlite_fts_reindex_pending (void)
+{
+	return fts_reindex_last_id >= 0;
+}
+
+/**
+ * tracker_db_interface_sqlite_fts_reindex_step:
+ * @interface: the writer connection
+ * @n_ids: number of resource IDs to cover in this step
+ * @error: return location for errors
+ *
+ * Indexes the next @n_ids resource IDs in its own transaction, with
+ * the progress. Once past the last resource, the new table replaces
+ * the current one.
+ *
+ * Returns: %TRUE if the reindex is complete.
+ */
+gboolean
+tracker_db_interface_sqlite_fts_reindex_step (TrackerDBInterface  *interface,
+                                              gint                 n_ids,
+                                              GError             **error)
+{
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor = NULL;
+	GError *internal_error = NULL;
+	gint max_id = 0, last_id;
+	gboolean done;
+
+	g_return_val_if_fail (fts_reindex_last_id >= 0, TRUE);
+
+	if (!tracker_db_interface_start_transaction (interface)) {
+		g_set_error (error, TRACKER_DB_INTERFACE_ERROR, TRACKER_DB_QUERY_ERROR,
+		             "Could not start FTS reindex transaction");
+		return FALSE;
+	}
+
+	stmt = tracker_db_interface_create_statement (interface,
+	                                              TRACKER_DB_STATEMENT_CACHE_TYPE_SELECT,
+	                                              &internal_error,
+	                                              "SELECT MAX(ID) FROM Resource");
+
+	if (stmt) {
+		cursor = tracker_db_statement_start_cursor (stmt, &internal_error);
+		g_object_unref (stmt);
+	}
+
+	if (cursor) {
+		if (tracker_db_cursor_iter_next (cursor, NULL, &internal_error)) {
+			max_id = tracker_db_cursor_get_int (cursor, 0);
+		}
+
+		g_object_unref (cursor);
+	}
+
+	last_id = fts_reindex_last_id + n_ids;
+	done = (last_id >= max_id);
+
+	if (!internal_error) {
+		/* Tokenizing happens here, resources added in the meantime
+		 * only went to fts5, they are picked up by later steps. */
+		tracker_db_interface_execute_query (interface, &internal_error,
+		                                    "INSERT INTO fts5_reindex (rowid %s) "
+		                                    "SELECT rowid %s FROM fts_view "
+		                                    "WHERE rowid > %d AND rowid <= %d",
+		                                    interface->fts_properties,
+		                                    interface->fts_properties,
+		                                    fts_reindex_last_id, last_id);
+	}
+
+	if (!internal_error && done) {
+		if (!tracker_fts_switch_reindex_table (interface->db, "fts5")) {
+			g_set_error (&internal_error, TRACKER_DB_INTERFACE_ERROR, TRACKER_DB_QUERY_ERROR,
+			             "Could not switch to the new FTS table: %s",
+			             sqlite3_errmsg (interface->db));
+		}
+
+		if (!internal_error) {
+			tracker_db_interface_execute_query (interface, &internal_error,
+			                                    "DROP TABLE FtsReindex");
+		}
+
+		if (!internal_error) {
+			tracker_db_interface_execute_query (interface, &internal_error,
+			                                    "DROP TABLE IF EXISTS FtsReindexStale");
+		}
+	} else if (!internal_error) {
+		tracker_db_interface_execute_query (interface, &internal_error,
+		                                    "UPDATE FtsReindex SET LastID = %d",
+		                                    last_id);
+	}
+
+	if (!internal_error) {
+		tracker_db_interface_end_db_transaction (interface, &internal_error);
+	}
+
+	if (internal_error) {
+		tracker_db_interface_execute_query (interface, NULL, "ROLLBACK");
+		g_propagate_error (error, internal_error);
+		return FALSE;
+	}
+
+	fts_reindex_last_id = done ? -1 : last_id;
+
+	if (done)
+		schema_changed ();
+
+	return done;
+}
+
+void
+tracker_db_interface_sqlite_fts_reindex_cancel (TrackerDBInterface *interface)
+{
+	tracker_fts_drop_reindex_table (interface->db, "fts5");
+	tracker_db_interface_execute_query (interface, NULL,
+	                                    "DROP TABLE IF EXISTS FtsReindex");
+	tracker_db_interface_execute_query (interface, NULL,
+	                                    "DROP TABLE IF EXISTS FtsReindexStale");
+
+	if (fts_reindex_last_id >= 0)
+		schema_changed ();
+
+	fts_reindex_last_id = -1;
+}
+
 #endif
 
 void
@@ -1869,6 +2240,18 @@ tracker_db_interface_sqlite_wal_hook (TrackerDBInterface   *interface,
 	sqlite3_wal_hook (interface->db, wal_hook, callback);
 }
 
+/**
+ * tracker_db_interface_sqlite_get_schema_generation:
+ *
+ * Returns a number that changes whenever tables outside the ontology
+ * are created or dropped, SQL generated before that may be stale.
+ */
+guint
+tracker_db_interface_sqlite_get_schema_generation (void)
+{
+	return (guint) g_atomic_int_get (&schema_generation);
+}
+
 
 static void
 tracker_db_interface_sqlite_finalize (GObject *object)
@@ -1928,6 +2311,7 @@ tracker_db_interface_init (TrackerDBInterface *db_interface)
 	db_interface->ro = FALSE;
 	db_interface->use_mutex = (tracker_db_manager_get_flags (NULL, NULL) &
 	                           TRACKER_DB_MANAGER_ENABLE_MUTEXES) != 0;
+	db_interface->schema_generation = tracker_db_interface_sqlite_get_schema_generation ();
 
 	prepare_database (db_interface);
 }
@@ -2152,6 +2536,18 @@ tracker_db_interface_lru_update (TrackerDBInterface          *db_interface,
 	 * ring, so in this case we do nothing of course */
 }
 
+/* Drops all cached statements, those in use are freed once done */
+static void
+tracker_db_interface_clear_stmt_caches (TrackerDBInterface *db_interface)
+{
+	g_hash_table_remove_all (db_interface->dynamic_statements);
+
+	db_interface->select_stmt_lru.head = db_interface->select_stmt_lru.tail = NULL;
+	db_interface->select_stmt_lru.size = 0;
+	db_interface->update_stmt_lru.head = db_interface->update_stmt_lru.tail = NULL;
+	db_interface->update_stmt_lru.size = 0;
+}
+
 TrackerDBStatement *
 tracker_db_interface_create_statement (TrackerDBInterface           *db_interface,
                                        TrackerDBStatementCacheType   cache_type,
@@ -2172,6 +2568,11 @@ tracker_db_interface_create_statement (TrackerDBInterface           *db_interfac
 
 	tracker_db_interface_lock (db_interface);
 
+	if (db_interface->schema_generation != tracker_db_interface_sqlite_get_schema_generation ()) {
+		tracker_db_interface_clear_stmt_caches (db_interface);
+		db_interface->schema_generation = tracker_db_interface_sqlite_get_schema_generation ();
+	}
+
 	if (cache_type != TRACKER_DB_STATEMENT_CACHE_TYPE_NONE) {
 		stmt = tracker_db_interface_lru_lookup (db_interface, &cache_type,
 		                                        full_query);
@@ -46,6 +46,7 @@ void                tracker_db_interface_sqlite_fts_init               (TrackerD
 void                tracker_db_interface_sqlite_reset_collator         (TrackerDBInterface       *interface);
 void                tracker_db_interface_sqlite_wal_hook               (TrackerDBInterface       *interface,
                                                                         TrackerDBWalCallback      callback);
+guint               tracker_db_interface_sqlite_get_schema_generation  (void);
 
 #if HAVE_TRACKER_FTS
 void                tracker_db_interface_sqlite_fts_alter_table        (TrackerDBInterface       *interface,
@@ -67,6 +68,16 @@ void                tracker_db_interface_sqlite_fts_update_rollback    (TrackerD
 
 void                tracker_db_interface_sqlite_fts_rebuild_tokens     (TrackerDBInterface       *interface);
 
+gboolean            tracker_db_interface_sqlite_fts_reindex_start      (TrackerDBInterface       *interface,
+                                                                        GHashTable               *properties,
+                                                                        GError                  **error);
+gboolean            tracker_db_interface_sqlite_fts_reindex_resume     (TrackerDBInterface       *interface);
+gboolean            tracker_db_interface_sqlite_fts_reindex_pending    (void);
+gboolean            tracker_db_interface_sqlite_fts_reindex_step       (TrackerDBInterface       *interface,
+                                                                        gint                      n_ids,
+                                                                        GError                  **error);
+void                tracker_db_interface_sqlite_fts_reindex_cancel     (TrackerDBInterface       *interface);
+
 #endif
 
 G_END_DECLS
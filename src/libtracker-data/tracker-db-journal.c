@@ -31,6 +31,12 @@
 #include <fcntl.h>
 #include <stdlib.h>
 
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
+#include <zlib.h>
+
 #include <glib/gstdio.h>
 
 #ifndef O_LARGEFILE
@@ -44,6 +50,26 @@
 
 #define MIN_BLOCK_SIZE    1024
 
+/* Growth step of the buffer compressed chunks are inflated into */
+#define INFLATE_BLOCK_SIZE (256 * 1024)
+
+/* Transactions with less data than this are never compressed */
+#define COMPRESS_MIN_PAYLOAD 256
+
+/* Data of the previous transactions used as preset dictionary for
+ * compressing the next one, this is the deflate window size.
+ */
+#define DICTIONARY_SIZE 32768
+
+/*
+ * Journal versions:
+ * 00003: no UPDATE operations
+ * 00004: UPDATE operations
+ * 00005: transactions may be compressed, see TRANSACTION_FORMAT_COMPRESSED
+ */
+#define JOURNAL_HEADER_V4 "trlog\00004"
+#define JOURNAL_HEADER_V5 "trlog\00005"
+
 /*
  * data_format:
  * #... 0000 0000 (total size is 4 bytes)
@@ -66,14 +92,33 @@ typedef enum {
 	TRANSACTION_FORMAT_NONE      = 0,
 	TRANSACTION_FORMAT_DATA      = 1 << 0,
 	TRANSACTION_FORMAT_ONTOLOGY  = 1 << 1,
+	/* data after the format is [uncompressed size][raw deflate data] */
+	TRANSACTION_FORMAT_COMPRESSED = 1 << 2,
+	/* the deflate data uses the previous transactions as dictionary */
+	TRANSACTION_FORMAT_DICTIONARY = 1 << 3
 } TransactionFormat;
 
+/* Sliding window over the uncompressed data of the transactions in a
+ * journal file, writer and reader keep it in sync.
+ */
+typedef struct {
+	gchar data[DICTIONARY_SIZE];
+	guint len;
+} JournalDictionary;
+
+/* A journal chunk loaded ahead of time by the prefetch thread */
 typedef struct {
 	gchar *filename;
-	GDataInputStream *stream;
-	GInputStream *underlying_stream;
-	GFileInfo *underlying_stream_info;
 	GMappedFile *file;
+	GBytes *inflated;
+	GError *error;
+} JournalChunk;
+
+typedef struct {
+	gchar *filename;
+	GMappedFile *file;
+	GBytes *inflated;
+	GThread *prefetch;
 	const gchar *current;
 	const gchar *end;
 	const gchar *entry_begin;
@@ -83,14 +128,26 @@ typedef struct {
 	guint32 amount_of_triples;
 	gint64 time;
 	TrackerDBJournalEntryType type;
-	gchar *uri;
+	const gchar *uri;
 	gint g_id;
 	gint s_id;
 	gint p_id;
 	gint o_id;
-	gchar *object;
+	const gchar *object;
 	guint current_file;
 	gchar *rotate_to;
+	gboolean compressed_format;
+	JournalDictionary *dictionary;
+	const gchar *payload_begin;
+	const gchar *packed;
+	guint32 packed_len;
+	guint32 payload_len;
+	gboolean packed_dictionary;
+	gchar *payload;
+	guint32 payload_alloc;
+	const gchar *resume;
+	const gchar *resume_end;
+	z_stream *inflater;
 } JournalReader;
 
 typedef struct {
@@ -102,6 +159,9 @@ typedef struct {
 	gchar *cur_block;
 	guint cur_entry_amount;
 	guint cur_pos;
+	gboolean compress;
+	JournalDictionary *dictionary;
+	z_stream *deflater;
 } JournalWriter;
 
 static struct {
@@ -111,45 +171,27 @@ static struct {
 	gboolean rotate_progress_flag;
 } rotating_settings = {0};
 
+static gboolean compress_new_files = FALSE;
+
 static JournalReader reader = {0};
 static JournalWriter writer = {0};
 static JournalWriter ontology_writer = {0};
 
 static TransactionFormat current_transaction_format;
 
-static gboolean tracker_db_journal_rotate (GError **error);
-
-#ifndef HAVE_STRNLEN
-
-size_t
-strnlen (const char *str, size_t max)
-{
-	const char *end = memchr (str, 0, max);
-	return end ? (size_t)(end - str) : max;
-}
+/* position in the current data transaction to roll back to */
+static struct {
+	guint cur_block_len;
+	guint cur_entry_amount;
+	guint cur_pos;
+} savepoint;
 
-#endif /* HAVE_STRNLEN */
+static gboolean tracker_db_journal_rotate (GError **error);
 
 static gboolean
 journal_eof (JournalReader *jreader)
 {
-	if (jreader->stream) {
-		GBufferedInputStream *bstream;
-
-		bstream = G_BUFFERED_INPUT_STREAM (jreader->stream);
-
-		if (g_buffered_input_stream_get_available (bstream) == 0) {
-			if (g_buffered_input_stream_fill (bstream, -1, NULL, NULL) == 0) {
-				return TRUE;
-			}
-		}
-	} else {
-		if (jreader->current >= jreader->end) {
-			return TRUE;
-		}
-	}
-
-	return FALSE;
+	return jreader->current >= jreader->end;
 }
 
 static guint32
@@ -167,156 +209,107 @@ journal_read_uint32 (JournalReader  *jreader,
 {
 	guint32 result;
 
-	if (jreader->stream) {
-		result = g_data_input_stream_read_uint32 (jreader->stream, NULL, error);
-	} else {
-		if (jreader->end - jreader->current < sizeof (guint32)) {
-			/* damaged journal entry */
-			g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
-			             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
-			             "Damaged journal entry, %d < sizeof(guint32)",
-			             (gint) (jreader->end - jreader->current));
-			return 0;
-		}
-
-		result = read_uint32 (jreader->current);
-		jreader->current += 4;
-	}
-
-	return result;
-}
-
-/* based on GDataInputStream code */
-static gssize
-scan_for_nul (GBufferedInputStream *stream,
-              gsize                *checked_out)
-{
-	const gchar *buffer;
-	gsize start, end, peeked;
-	gint i;
-	gsize available, checked;
-
-	checked = *checked_out;
-
-	start = checked;
-	buffer = (const gchar *) g_buffered_input_stream_peek_buffer (stream, &available) + start;
-	end = available;
-	peeked = end - start;
-
-	for (i = 0; checked < available && i < peeked; i++) {
-		if (buffer[i] == '\0') {
-			return (start + i);
-		}
+	if (jreader->end - jreader->current < sizeof (guint32)) {
+		/* damaged journal entry */
+		g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
+		             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
+		             "Damaged journal entry, %d < sizeof(guint32)",
+		             (gint) (jreader->end - jreader->current));
+		return 0;
 	}
 
-	checked = end;
+	result = read_uint32 ((const guint8 *) jreader->current);
+	jreader->current += 4;
 
-	*checked_out = checked;
-	return -1;
+	return result;
 }
 
-static gchar *
+/* The returned string points into the chunk, it stays valid until the
+ * reader moves to the next entry.
+ */
+static const gchar *
 journal_read_string (JournalReader  *jreader,
                      GError        **error)
 {
-	gchar *result;
-
-	if (jreader->stream) {
-		/* based on GDataInputStream code */
-
-		GBufferedInputStream *bstream;
-		gsize checked;
-		gssize found_pos;
-
-		bstream = G_BUFFERED_INPUT_STREAM (jreader->stream);
-
-		checked = 0;
-
-		while ((found_pos = scan_for_nul (bstream, &checked)) == -1) {
-			if (g_buffered_input_stream_get_available (bstream) == g_buffered_input_stream_get_buffer_size (bstream)) {
-				g_buffered_input_stream_set_buffer_size (bstream, 2 * g_buffered_input_stream_get_buffer_size (bstream));
-			}
-
-			if (g_buffered_input_stream_fill (bstream, -1, NULL, error) <= 0) {
-				/* error or end of stream */
-				g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
-				             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
-				             "Damaged journal entry, no terminating zero found");
-				return NULL;
-			}
-		}
-
-		result = g_malloc (found_pos + 1);
-
-		if (g_input_stream_read (G_INPUT_STREAM (bstream), result, found_pos + 1, NULL, error) < 0)
-			return NULL;
-	} else {
-		gsize str_length;
-
-		str_length = strnlen (jreader->current, jreader->end - jreader->current);
-		if (str_length == jreader->end - jreader->current) {
-			/* damaged journal entry (no terminating '\0' character) */
-			g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
-			             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
-			             "Damaged journal entry, no terminating zero found");
-			return NULL;
-
-		}
+	const gchar *result, *nul;
 
-		result = g_strdup (jreader->current);
+	result = jreader->current;
+	nul = memchr (result, '\0', jreader->end - result);
 
-		jreader->current += str_length + 1;
+	if (!nul) {
+		/* damaged journal entry (no terminating '\0' character) */
+		g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
+		             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
+		             "Damaged journal entry, no terminating zero found");
+		return NULL;
 	}
 
-	if (!g_utf8_validate (result, -1, NULL)) {
+	if (!g_utf8_validate (result, nul - result, NULL)) {
 		/* damaged journal entry (invalid UTF-8) */
 		g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
 		             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
 		             "Damaged journal entry, invalid UTF-8");
-		g_free (result);
 		return NULL;
 	}
 
+	jreader->current = nul + 1;
+
 	return result;
 }
 
 static gboolean
 journal_verify_header (JournalReader *jreader)
 {
-	gchar header[8];
-	gint i;
-	GError *error = NULL;
-
 	/* Version 00003 is identical, it just has no UPDATE operations */
 
-	if (jreader->stream) {
-		for (i = 0; i < sizeof (header); i++) {
-			header[i] = g_data_input_stream_read_byte (jreader->stream, NULL, &error);
-			if (error) {
-				g_clear_error (&error);
-				return FALSE;
-			}
-		}
+	/* verify journal file header */
+	if (jreader->end - jreader->current < 8) {
+		return FALSE;
+	}
 
-		if (memcmp (header, "trlog\00004", 8) && memcmp (header, "trlog\00003", 8)) {
-			return FALSE;
-		}
+	if (memcmp (jreader->current, JOURNAL_HEADER_V5, 8) == 0) {
+		jreader->compressed_format = TRUE;
+	} else if (memcmp (jreader->current, JOURNAL_HEADER_V4, 8) == 0 ||
+	           memcmp (jreader->current, "trlog\00003", 8) == 0) {
+		jreader->compressed_format = FALSE;
 	} else {
-		/* verify journal file header */
-		if (jreader->end - jreader->current < 8) {
-			return FALSE;
-		}
+		return FALSE;
+	}
 
-		if (memcmp (jreader->current, "trlog\00004", 8) && memcmp (jreader->current, "trlog\00003", 8)) {
-			return FALSE;
-		}
+	jreader->current += 8;
 
-		jreader->current += 8;
+	if (jreader->dictionary) {
+		/* The dictionary does not span journal files */
+		jreader->dictionary->len = 0;
 	}
 
 	return TRUE;
 }
 
+static void
+journal_dictionary_append (JournalDictionary *dictionary,
+                           const gchar       *data,
+                           gsize              len)
+{
+	if (len >= DICTIONARY_SIZE) {
+		memcpy (dictionary->data, data + len - DICTIONARY_SIZE, DICTIONARY_SIZE);
+		dictionary->len = DICTIONARY_SIZE;
+		return;
+	}
+
+	if (dictionary->len + len > DICTIONARY_SIZE) {
+		guint keep = DICTIONARY_SIZE - len;
+
+		memmove (dictionary->data,
+		         dictionary->data + dictionary->len - keep,
+		         keep);
+		dictionary->len = keep;
+	}
+
+	memcpy (dictionary->data + dictionary->len, data, len);
+	dictionary->len += len;
+}
+
 void
 tracker_db_journal_get_rotating (gboolean *do_rotating,
                                  gsize    *chunk_size,
@@ -346,6 +339,12 @@ tracker_db_journal_set_rotating (gboolean     do_rotating,
 	}
 }
 
+void
+tracker_db_journal_set_compression (gboolean compress)
+{
+	compress_new_files = compress;
+}
+
 static gint
 nearest_pow (gint num)
 {
@@ -464,7 +463,7 @@ db_journal_init_file (JournalWriter  *jwriter,
 	jwriter->cur_block = NULL;
 
 	mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
-	flags = O_WRONLY | O_APPEND | O_CREAT | O_LARGEFILE;
+	flags = O_RDWR | O_APPEND | O_CREAT | O_LARGEFILE;
 	if (truncate) {
 		/* existing journal contents are invalid: reindex where journal
 		 * does not even contain a single valid entry
@@ -500,9 +499,11 @@ db_journal_init_file (JournalWriter  *jwriter,
 		jwriter->cur_block[2] = 'l';
 		jwriter->cur_block[3] = 'o';
 		jwriter->cur_block[4] = 'g';
-		jwriter->cur_block[5] = '\0';
-		jwriter->cur_block[6] = '0';
-		jwriter->cur_block[7] = '4';
+		if (compress_new_files) {
+			memcpy (jwriter->cur_block, JOURNAL_HEADER_V5, 8);
+		} else {
+			memcpy (jwriter->cur_block, JOURNAL_HEADER_V4, 8);
+		}
 
 		if (!write_all_data (jwriter->journal, jwriter->cur_block, 8, error)) {
 			cur_block_kill (jwriter);
@@ -515,6 +516,24 @@ db_journal_init_file (JournalWriter  *jwriter,
 
 		jwriter->cur_size += 8;
 		cur_block_kill (jwriter);
+
+		jwriter->compress = compress_new_files;
+	} else {
+		gchar header[8];
+
+		/* Keep writing in the format the file was started with */
+		jwriter->compress = (compress_new_files &&
+		                     pread (jwriter->journal, header, 8, 0) == 8 &&
+		                     memcmp (header, JOURNAL_HEADER_V5, 8) == 0);
+	}
+
+	if (jwriter->compress && !jwriter->dictionary) {
+		jwriter->dictionary = g_new (JournalDictionary, 1);
+	}
+
+	if (jwriter->dictionary) {
+		/* Data already in the file is not used as dictionary */
+		jwriter->dictionary->len = 0;
 	}
 
 	return TRUE;
@@ -630,6 +649,15 @@ db_journal_writer_shutdown (JournalWriter  *jwriter,
 	g_free (jwriter->journal_filename);
 	jwriter->journal_filename = NULL;
 
+	if (jwriter->deflater) {
+		deflateEnd (jwriter->deflater);
+		g_free (jwriter->deflater);
+		jwriter->deflater = NULL;
+	}
+
+	g_free (jwriter->dictionary);
+	jwriter->dictionary = NULL;
+
 	if (jwriter->journal == 0) {
 		return TRUE;
 	}
@@ -1139,6 +1167,29 @@ tracker_db_journal_rollback_transaction (GError **error)
 	return TRUE;
 }
 
+void
+tracker_db_journal_savepoint (void)
+{
+	g_return_if_fail (current_transaction_format == TRANSACTION_FORMAT_DATA);
+
+	savepoint.cur_block_len = writer.cur_block_len;
+	savepoint.cur_entry_amount = writer.cur_entry_amount;
+	savepoint.cur_pos = writer.cur_pos;
+}
+
+void
+tracker_db_journal_rollback_to_savepoint (void)
+{
+	g_return_if_fail (current_transaction_format == TRANSACTION_FORMAT_DATA);
+	g_return_if_fail (savepoint.cur_block_len <= writer.cur_block_len);
+
+	/* entries after the savepoint are simply dropped from the block,
+	 * size and CRC are only computed on commit */
+	writer.cur_block_len = savepoint.cur_block_len;
+	writer.cur_entry_amount = savepoint.cur_entry_amount;
+	writer.cur_pos = savepoint.cur_pos;
+}
+
 gboolean
 tracker_db_journal_truncate (gsize new_size)
 {
@@ -1147,6 +1198,91 @@ tracker_db_journal_truncate (gsize new_size)
 	return (ftruncate (writer.journal, new_size) != -1);
 }
 
+/* Replaces the transaction data after the format field with its
+ * deflated form if that is smaller, and feeds it to the dictionary.
+ */
+static void
+db_journal_writer_compress (JournalWriter *jwriter)
+{
+	const guint header = sizeof (guint32) * 5;
+	gchar *payload, *block = NULL;
+	guint payload_len;
+	uLong bound = 0;
+	gboolean with_dictionary, compressed = FALSE;
+	guint32 kind;
+	guint pos;
+
+	payload = jwriter->cur_block + header;
+	payload_len = jwriter->cur_block_len - header;
+
+	/* Without the flag, the reader starts over with an empty
+	 * dictionary as well.
+	 */
+	with_dictionary = jwriter->dictionary->len > 0;
+
+	if (payload_len >= COMPRESS_MIN_PAYLOAD && !jwriter->deflater) {
+		jwriter->deflater = g_new0 (z_stream, 1);
+
+		/* Raw deflate, the entry has its own size and CRC */
+		if (deflateInit2 (jwriter->deflater, Z_BEST_SPEED, Z_DEFLATED,
+		                  -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			g_free (jwriter->deflater);
+			jwriter->deflater = NULL;
+		}
+	}
+
+	if (payload_len >= COMPRESS_MIN_PAYLOAD && jwriter->deflater) {
+		deflateReset (jwriter->deflater);
+
+		if (with_dictionary) {
+			deflateSetDictionary (jwriter->deflater,
+			                      (const Bytef *) jwriter->dictionary->data,
+			                      jwriter->dictionary->len);
+		}
+
+		bound = deflateBound (jwriter->deflater, payload_len);
+		block = g_malloc (header + sizeof (guint32) * 2 + bound);
+
+		jwriter->deflater->next_in = (Bytef *) payload;
+		jwriter->deflater->avail_in = payload_len;
+		jwriter->deflater->next_out = (Bytef *) block + header + sizeof (guint32);
+		jwriter->deflater->avail_out = bound;
+
+		compressed = (deflate (jwriter->deflater, Z_FINISH) == Z_STREAM_END &&
+		              jwriter->deflater->total_out + sizeof (guint32) < payload_len);
+	}
+
+	journal_dictionary_append (jwriter->dictionary, payload, payload_len);
+
+	kind = read_uint32 ((const guint8 *) jwriter->cur_block + sizeof (guint32) * 4);
+	if (with_dictionary) {
+		kind |= TRANSACTION_FORMAT_DICTIONARY;
+	}
+
+	if (!compressed) {
+		/* Not worth it, keep the data as is */
+		g_free (block);
+
+		pos = sizeof (guint32) * 4;
+		cur_setnum (jwriter->cur_block, &pos, kind);
+		return;
+	}
+
+	kind |= TRANSACTION_FORMAT_COMPRESSED;
+
+	/* Header up to the time is copied, the format is rewritten */
+	memcpy (block, jwriter->cur_block, sizeof (guint32) * 4);
+	pos = sizeof (guint32) * 4;
+	cur_setnum (block, &pos, kind);
+	cur_setnum (block, &pos, payload_len);
+
+	g_free (jwriter->cur_block);
+	jwriter->cur_block = block;
+	jwriter->cur_block_len = pos + jwriter->deflater->total_out;
+	jwriter->cur_block_alloc = header + sizeof (guint32) * 2 + bound;
+	jwriter->cur_pos = jwriter->cur_block_len;
+}
+
 static gboolean
 db_journal_writer_commit_db_transaction (JournalWriter  *jwriter,
                                          GError        **error)
@@ -1158,6 +1294,10 @@ db_journal_writer_commit_db_transaction (JournalWriter  *jwriter,
 
 	g_return_val_if_fail (jwriter->journal > 0, FALSE);
 
+	if (jwriter->compress) {
+		db_journal_writer_compress (jwriter);
+	}
+
 	begin_pos = 0;
 	size = sizeof (guint32);
 	offset = sizeof (guint32) * 3;
@@ -1183,6 +1323,11 @@ db_journal_writer_commit_db_transaction (JournalWriter  *jwriter,
 	cur_setnum (jwriter->cur_block, &begin_pos, crc);
 
 	if (!write_all_data (jwriter->journal, jwriter->cur_block, jwriter->cur_block_len, error)) {
+		if (jwriter->dictionary) {
+			/* Whatever made it to disk can't be relied upon */
+			jwriter->dictionary->len = 0;
+		}
+
 		return FALSE;
 	}
 
@@ -1239,8 +1384,12 @@ tracker_db_journal_fsync (void)
  */
 
 
+/* Finds the chunk following the current one, sets @file_number to 0
+ * when that is the active journal file.
+ */
 static gchar*
-reader_get_next_filepath (JournalReader *jreader)
+reader_find_next_filepath (JournalReader *jreader,
+                           guint         *file_number)
 {
 	gchar *filename_open = NULL;
 	gchar *test;
@@ -1248,7 +1397,7 @@ reader_get_next_filepath (JournalReader *jreader)
 	test = g_strdup_printf ("%s.%d", jreader->filename, jreader->current_file + 1);
 
 	if (g_file_test (test, G_FILE_TEST_EXISTS)) {
-		jreader->current_file++;
+		*file_number = jreader->current_file + 1;
 		filename_open = test;
 	} else {
 		gchar *filename;
@@ -1276,7 +1425,7 @@ reader_get_next_filepath (JournalReader *jreader)
 		g_free (filename);
 
 		if (g_file_query_exists (possible, NULL)) {
-			jreader->current_file++;
+			*file_number = jreader->current_file + 1;
 			filename_open = g_file_get_path (possible);
 		}
 		g_object_unref (possible);
@@ -1285,57 +1434,236 @@ reader_get_next_filepath (JournalReader *jreader)
 	if (filename_open == NULL) {
 		filename_open = g_strdup (jreader->filename);
 		/* Last file is the active journal file */
-		jreader->current_file = 0;
+		*file_number = 0;
 	}
 
 	return filename_open;
 }
 
+static gchar*
+reader_get_next_filepath (JournalReader *jreader)
+{
+	return reader_find_next_filepath (jreader, &jreader->current_file);
+}
+
+/* Inflates a whole rotated chunk into memory, so it can be walked just
+ * like a mapped one, CRCs included.
+ */
+static GBytes *
+journal_inflate_chunk (const gchar  *filename,
+                       GError      **error)
+{
+	GMappedFile *mapped;
+	GConverter *converter;
+	GConverterResult result;
+	GByteArray *array;
+	const gchar *in;
+	gsize in_left, used = 0;
+	GError *inner_error = NULL;
+
+	mapped = g_mapped_file_new (filename, FALSE, error);
+	if (!mapped) {
+		return NULL;
+	}
+
+	in = g_mapped_file_get_contents (mapped);
+	in_left = g_mapped_file_get_length (mapped);
+
+	converter = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+
+	/* Journal data compresses well, start with a generous guess */
+	array = g_byte_array_sized_new (MAX (in_left * 4, INFLATE_BLOCK_SIZE));
+	g_byte_array_set_size (array, MAX (in_left * 4, INFLATE_BLOCK_SIZE));
+
+	do {
+		gsize bytes_read, bytes_written;
+
+		if (array->len - used < INFLATE_BLOCK_SIZE) {
+			g_byte_array_set_size (array, array->len * 2);
+		}
+
+		result = g_converter_convert (converter,
+		                              in, in_left,
+		                              array->data + used, array->len - used,
+		                              G_CONVERTER_INPUT_AT_END,
+		                              &bytes_read, &bytes_written,
+		                              &inner_error);
+
+		if (result == G_CONVERTER_ERROR) {
+			break;
+		}
+
+		in += bytes_read;
+		in_left -= bytes_read;
+		used += bytes_written;
+	} while (result != G_CONVERTER_FINISHED);
+
+	g_object_unref (converter);
+	g_mapped_file_unref (mapped);
+
+	if (inner_error) {
+		if (used == 0) {
+			g_propagate_error (error, inner_error);
+			g_byte_array_unref (array);
+			return NULL;
+		}
+
+		/* Replay what could be recovered, the damaged tail
+		 * is reported as a damaged journal entry.
+		 */
+		g_warning ("Truncated journal chunk '%s': %s",
+		           filename, inner_error->message);
+		g_error_free (inner_error);
+	}
+
+	g_byte_array_set_size (array, used);
+
+	return g_byte_array_free_to_bytes (array);
+}
+
+static gboolean
+journal_chunk_load (const gchar   *filename,
+                    GMappedFile  **file,
+                    GBytes       **inflated,
+                    GError       **error)
+{
+	if (g_str_has_suffix (filename, ".gz")) {
+		*inflated = journal_inflate_chunk (filename, error);
+
+		return *inflated != NULL;
+	}
+
+	*file = g_mapped_file_new (filename, FALSE, error);
+
+	if (!*file) {
+		return FALSE;
+	}
+
+#if defined (HAVE_MMAP) && defined (MADV_SEQUENTIAL) && defined (MADV_WILLNEED)
+	if (g_mapped_file_get_length (*file) > 0) {
+		gchar *contents;
+		gsize length;
+
+		contents = g_mapped_file_get_contents (*file);
+		length = g_mapped_file_get_length (*file);
+
+		/* Replay walks the file once from start to end */
+		madvise (contents, length, MADV_SEQUENTIAL);
+		madvise (contents, length, MADV_WILLNEED);
+	}
+#endif
+
+	return TRUE;
+}
+
+static void
+journal_chunk_free (JournalChunk *chunk)
+{
+	if (chunk->file) {
+		g_mapped_file_unref (chunk->file);
+	}
+	if (chunk->inflated) {
+		g_bytes_unref (chunk->inflated);
+	}
+	g_clear_error (&chunk->error);
+	g_free (chunk->filename);
+	g_slice_free (JournalChunk, chunk);
+}
+
+static gpointer
+reader_prefetch_thread (gpointer data)
+{
+	JournalChunk *chunk = data;
+
+	journal_chunk_load (chunk->filename, &chunk->file,
+	                    &chunk->inflated, &chunk->error);
+
+	return chunk;
+}
+
+/* Loads the chunk after the current one while the current one is being
+ * replayed, inflating rotated chunks is the slow part of replay.
+ */
+static void
+reader_prefetch_next (JournalReader *jreader)
+{
+	JournalChunk *chunk;
+	guint file_number;
+
+	g_return_if_fail (jreader->prefetch == NULL);
+
+	chunk = g_slice_new0 (JournalChunk);
+	chunk->filename = reader_find_next_filepath (jreader, &file_number);
+
+	jreader->prefetch = g_thread_try_new ("journal prefetch",
+	                                      reader_prefetch_thread,
+	                                      chunk, NULL);
+
+	if (!jreader->prefetch) {
+		/* Just load it when it's needed */
+		journal_chunk_free (chunk);
+	}
+}
+
+static JournalChunk *
+reader_take_prefetch (JournalReader *jreader)
+{
+	JournalChunk *chunk;
+
+	if (!jreader->prefetch) {
+		return NULL;
+	}
+
+	chunk = g_thread_join (jreader->prefetch);
+	jreader->prefetch = NULL;
+
+	return chunk;
+}
+
 static gboolean
 db_journal_reader_init_file (JournalReader  *jreader,
                              const gchar    *filename,
                              GError        **error)
 {
-	if (g_str_has_suffix (filename, ".gz")) {
-		GFile *file;
-		GInputStream *stream, *cstream;
-		GConverter *converter;
+	JournalChunk *chunk;
 
-		file = g_file_new_for_path (filename);
+	chunk = reader_take_prefetch (jreader);
 
-		stream = G_INPUT_STREAM (g_file_read (file, NULL, error));
-		g_object_unref (file);
-		if (!stream) {
+	if (chunk && g_strcmp0 (chunk->filename, filename) == 0) {
+		if (chunk->error) {
+			g_propagate_error (error, chunk->error);
+			chunk->error = NULL;
+			journal_chunk_free (chunk);
 			return FALSE;
 		}
 
-		jreader->underlying_stream = g_object_ref (stream);
-
-		if (jreader->underlying_stream_info) {
-			g_object_unref (jreader->underlying_stream_info);
-			jreader->underlying_stream_info = NULL;
-		}
-
-		converter = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
-		cstream = g_converter_input_stream_new (stream, converter);
-		g_object_unref (stream);
-		g_object_unref (converter);
-
-		jreader->stream = g_data_input_stream_new (cstream);
-		g_object_unref (cstream);
+		jreader->file = chunk->file;
+		jreader->inflated = chunk->inflated;
+		chunk->file = NULL;
+		chunk->inflated = NULL;
+		journal_chunk_free (chunk);
 	} else {
-		jreader->file = g_mapped_file_new (filename, FALSE, error);
+		if (chunk) {
+			journal_chunk_free (chunk);
+		}
 
-		if (!jreader->file) {
+		if (!journal_chunk_load (filename, &jreader->file, &jreader->inflated, error)) {
 			return FALSE;
 		}
+	}
 
-		jreader->last_success = jreader->start = jreader->current =
-			g_mapped_file_get_contents (jreader->file);
+	if (jreader->file) {
+		jreader->start = g_mapped_file_get_contents (jreader->file);
+		jreader->end = jreader->start + g_mapped_file_get_length (jreader->file);
+	} else {
+		gsize size;
 
-		jreader->end = jreader->current + g_mapped_file_get_length (jreader->file);
+		jreader->start = g_bytes_get_data (jreader->inflated, &size);
+		jreader->end = jreader->start + size;
 	}
 
+	jreader->last_success = jreader->current = jreader->start;
+
 	if (!journal_verify_header (jreader)) {
 		g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
 		             TRACKER_DB_JOURNAL_ERROR_BEGIN_OF_JOURNAL,
@@ -1343,9 +1671,28 @@ db_journal_reader_init_file (JournalReader  *jreader,
 		return FALSE;
 	}
 
+	if (jreader->current_file != 0) {
+		/* Rotated chunk, the next one follows */
+		reader_prefetch_next (jreader);
+	}
+
 	return TRUE;
 }
 
+static void
+db_journal_reader_release_file (JournalReader *jreader)
+{
+	if (jreader->file) {
+		g_mapped_file_unref (jreader->file);
+		jreader->file = NULL;
+	}
+
+	if (jreader->inflated) {
+		g_bytes_unref (jreader->inflated);
+		jreader->inflated = NULL;
+	}
+}
+
 static gboolean
 db_journal_reader_init (JournalReader  *jreader,
                         gboolean        global_reader,
@@ -1465,21 +1812,7 @@ reader_next_file (GError **error)
 
 	filename_open = reader_get_next_filepath (&reader);
 
-	if (reader.stream) {
-		g_object_unref (reader.stream);
-		reader.stream = NULL;
-
-		g_object_unref (reader.underlying_stream);
-		reader.underlying_stream = NULL;
-		if (reader.underlying_stream_info) {
-			g_object_unref (reader.underlying_stream_info);
-			reader.underlying_stream_info = NULL;
-		}
-
-	} else {
-		g_mapped_file_unref (reader.file);
-		reader.file = NULL;
-	}
+	db_journal_reader_release_file (&reader);
 
 	if (!db_journal_reader_init_file (&reader, filename_open, error)) {
 		g_free (filename_open);
@@ -1501,23 +1834,35 @@ reader_next_file (GError **error)
 static gboolean
 db_journal_reader_shutdown (JournalReader *jreader)
 {
-	if (jreader->stream) {
-		g_object_unref (jreader->stream);
-		jreader->stream = NULL;
-		g_object_unref (jreader->underlying_stream);
-		jreader->underlying_stream = NULL;
-		if (jreader->underlying_stream_info) {
-			g_object_unref (jreader->underlying_stream_info);
-			jreader->underlying_stream_info = NULL;
-		}
-	} else if (jreader->file) {
-		g_mapped_file_unref (jreader->file);
-		jreader->file = NULL;
+	JournalChunk *chunk;
+
+	chunk = reader_take_prefetch (jreader);
+	if (chunk) {
+		journal_chunk_free (chunk);
 	}
 
+	db_journal_reader_release_file (jreader);
+
 	g_free (jreader->filename);
 	jreader->filename = NULL;
 
+	if (jreader->inflater) {
+		inflateEnd (jreader->inflater);
+		g_free (jreader->inflater);
+		jreader->inflater = NULL;
+	}
+
+	g_free (jreader->dictionary);
+	jreader->dictionary = NULL;
+	g_free (jreader->payload);
+	jreader->payload = NULL;
+	jreader->payload_alloc = 0;
+	jreader->packed = NULL;
+	jreader->resume = NULL;
+	jreader->resume_end = NULL;
+	jreader->payload_begin = NULL;
+	jreader->compressed_format = FALSE;
+
 	jreader->last_success = NULL;
 	jreader->start = NULL;
 	jreader->current = NULL;
@@ -1545,11 +1890,74 @@ tracker_db_journal_reader_shutdown (void)
 TrackerDBJournalEntryType
 tracker_db_journal_reader_get_type (void)
 {
-	g_return_val_if_fail (reader.file != NULL || reader.stream != NULL, FALSE);
+	g_return_val_if_fail (reader.file != NULL || reader.inflated != NULL, FALSE);
 
 	return reader.type;
 }
 
+/* Inflates the data of a compressed transaction, which is then read
+ * in place of the data in the chunk until the end of the transaction.
+ */
+static gboolean
+journal_reader_unpack (JournalReader  *jreader,
+                       GError        **error)
+{
+	int res;
+
+	if (!jreader->inflater) {
+		jreader->inflater = g_new0 (z_stream, 1);
+
+		if (inflateInit2 (jreader->inflater, -MAX_WBITS) != Z_OK) {
+			g_free (jreader->inflater);
+			jreader->inflater = NULL;
+			g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
+			             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
+			             "Could not initialize decompression");
+			return FALSE;
+		}
+	} else {
+		inflateReset (jreader->inflater);
+	}
+
+	if (jreader->packed_dictionary &&
+	    inflateSetDictionary (jreader->inflater,
+	                          (const Bytef *) jreader->dictionary->data,
+	                          jreader->dictionary->len) != Z_OK) {
+		g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
+		             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
+		             "Damaged journal entry, dictionary not available");
+		return FALSE;
+	}
+
+	if (jreader->payload_alloc < jreader->payload_len) {
+		g_free (jreader->payload);
+		jreader->payload = g_malloc (jreader->payload_len);
+		jreader->payload_alloc = jreader->payload_len;
+	}
+
+	jreader->inflater->next_in = (Bytef *) jreader->packed;
+	jreader->inflater->avail_in = jreader->packed_len;
+	jreader->inflater->next_out = (Bytef *) jreader->payload;
+	jreader->inflater->avail_out = jreader->payload_len;
+
+	res = inflate (jreader->inflater, Z_FINISH);
+
+	if (res != Z_STREAM_END || jreader->inflater->total_out != jreader->payload_len) {
+		g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
+		             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
+		             "Damaged journal entry, decompression failed");
+		return FALSE;
+	}
+
+	jreader->packed = NULL;
+	jreader->resume = jreader->current;
+	jreader->resume_end = jreader->end;
+	jreader->current = jreader->payload;
+	jreader->end = jreader->payload + jreader->payload_len;
+
+	return TRUE;
+}
+
 static gboolean
 db_journal_reader_next (JournalReader *jreader, gboolean global_reader, GError **error)
 {
@@ -1557,16 +1965,14 @@ db_journal_reader_next (JournalReader *jreader, gboolean global_reader, GError *
 	static gboolean debug_unchecked = TRUE;
 	static gboolean slow_down = FALSE;
 
-	g_return_val_if_fail (jreader->file != NULL || jreader->stream != NULL, FALSE);
+	g_return_val_if_fail (jreader->file != NULL || jreader->inflated != NULL, FALSE);
 
 	/* reset struct */
-	g_free (jreader->uri);
 	jreader->uri = NULL;
 	jreader->g_id = 0;
 	jreader->s_id = 0;
 	jreader->p_id = 0;
 	jreader->o_id = 0;
-	g_free (jreader->object);
 	jreader->object = NULL;
 
 	/*
@@ -1665,32 +2071,30 @@ db_journal_reader_next (JournalReader *jreader, gboolean global_reader, GError *
 			return FALSE;
 		}
 
-		if (!jreader->stream) {
-			/* Set the bounds for the entry */
-			jreader->entry_end = jreader->entry_begin + entry_size;
+		/* Set the bounds for the entry */
+		jreader->entry_end = jreader->entry_begin + entry_size;
 
-			/* Check the end of the entry does not exceed the end
-			 * of the journal.
-			 */
-			if (jreader->end < jreader->entry_end) {
-				g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
-				             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
-				             "Damaged journal entry, end < entry end");
-				return FALSE;
-			}
+		/* Check the end of the entry does not exceed the end
+		 * of the journal.
+		 */
+		if (jreader->end < jreader->entry_end) {
+			g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
+			             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
+			             "Damaged journal entry, end < entry end");
+			return FALSE;
+		}
 
-			/* Read entry size check at the end of the entry */
-			entry_size_check = read_uint32 (jreader->entry_end - 4);
+		/* Read entry size check at the end of the entry */
+		entry_size_check = read_uint32 (jreader->entry_end - 4);
 
-			if (entry_size != entry_size_check) {
-				/* damaged journal entry */
-				g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
-				             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
-				             "Damaged journal entry, %d != %d (entry size != entry size check)",
-				             entry_size,
-				             entry_size_check);
-				return FALSE;
-			}
+		if (entry_size != entry_size_check) {
+			/* damaged journal entry */
+			g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
+			             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
+			             "Damaged journal entry, %d != %d (entry size != entry size check)",
+			             entry_size,
+			             entry_size_check);
+			return FALSE;
 		}
 
 		/* Read the amount of triples */
@@ -1707,23 +2111,18 @@ db_journal_reader_next (JournalReader *jreader, gboolean global_reader, GError *
 			return FALSE;
 		}
 
-		if (!jreader->stream) {
-			// Maybe read in whole transaction in one buffer, so we can do CRC even without mmap (when reading compressed journals)
-			// might this be too problematic memory-wise
+		/* Calculate the crc */
+		crc = tracker_crc32 (jreader->entry_begin + (sizeof (guint32) * 3), entry_size - (sizeof (guint32) * 3));
 
-			/* Calculate the crc */
-			crc = tracker_crc32 (jreader->entry_begin + (sizeof (guint32) * 3), entry_size - (sizeof (guint32) * 3));
-
-			/* Verify checksum */
-			if (crc != crc_check) {
-				/* damaged journal entry */
-				g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
-				             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
-				             "Damaged journal entry, 0x%.8x != 0x%.8x (crc32 failed)",
-				             crc,
-				             crc_check);
-				return FALSE;
-			}
+		/* Verify checksum */
+		if (crc != crc_check) {
+			/* damaged journal entry */
+			g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
+			             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
+			             "Damaged journal entry, 0x%.8x != 0x%.8x (crc32 failed)",
+			             crc,
+			             crc_check);
+			return FALSE;
 		}
 
 		/* Read the timestamp */
@@ -1739,7 +2138,37 @@ db_journal_reader_next (JournalReader *jreader, gboolean global_reader, GError *
 			return FALSE;
 		}
 
-		if (t_kind == TRANSACTION_FORMAT_DATA)
+		jreader->payload_begin = jreader->current;
+		jreader->packed = NULL;
+
+		if (jreader->compressed_format) {
+			if (!jreader->dictionary) {
+				jreader->dictionary = g_new (JournalDictionary, 1);
+				jreader->dictionary->len = 0;
+			}
+
+			if (!(t_kind & TRANSACTION_FORMAT_DICTIONARY)) {
+				jreader->dictionary->len = 0;
+			}
+
+			if (t_kind & TRANSACTION_FORMAT_COMPRESSED) {
+				jreader->payload_len = journal_read_uint32 (jreader, &inner_error);
+				if (inner_error) {
+					g_propagate_error (error, inner_error);
+					return FALSE;
+				}
+
+				/* Inflated once data is read, checking the last
+				 * transaction does not need it.
+				 */
+				jreader->packed = jreader->current;
+				jreader->packed_len = (jreader->entry_end - 4) - jreader->current;
+				jreader->packed_dictionary = (t_kind & TRANSACTION_FORMAT_DICTIONARY) != 0;
+				jreader->current = jreader->entry_end - 4;
+			}
+		}
+
+		if (t_kind & TRANSACTION_FORMAT_DATA)
 			jreader->type = TRACKER_DB_JOURNAL_START_TRANSACTION;
 		else
 			jreader->type = TRACKER_DB_JOURNAL_START_ONTOLOGY_TRANSACTION;
@@ -1748,23 +2177,52 @@ db_journal_reader_next (JournalReader *jreader, gboolean global_reader, GError *
 	} else if (jreader->amount_of_triples == 0) {
 		/* end of transaction */
 
-		/* read redundant entry size at end of transaction */
-		journal_read_uint32 (jreader, &inner_error);
-		if (inner_error) {
-			g_propagate_error (error, inner_error);
+		if (jreader->packed && !journal_reader_unpack (jreader, error)) {
 			return FALSE;
 		}
 
-		if (!jreader->stream) {
-			if (jreader->current != jreader->entry_end) {
-				/* damaged journal entry */
+		if (jreader->compressed_format) {
+			/* Feed the dictionary for the next transaction */
+			if (jreader->resume) {
+				journal_dictionary_append (jreader->dictionary,
+				                           jreader->payload,
+				                           jreader->payload_len);
+			} else {
+				journal_dictionary_append (jreader->dictionary,
+				                           jreader->payload_begin,
+				                           (jreader->entry_end - 4) - jreader->payload_begin);
+			}
+		}
+
+		if (jreader->resume) {
+			if (jreader->current != jreader->end) {
 				g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
 				             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
-				             "Damaged journal entry, %p != %p (end of transaction with 0 triples)",
-				             jreader->current,
-				             jreader->entry_end);
+				             "Damaged journal entry, trailing data in compressed transaction");
 				return FALSE;
 			}
+
+			jreader->current = jreader->resume;
+			jreader->end = jreader->resume_end;
+			jreader->resume = NULL;
+			jreader->resume_end = NULL;
+		}
+
+		/* read redundant entry size at end of transaction */
+		journal_read_uint32 (jreader, &inner_error);
+		if (inner_error) {
+			g_propagate_error (error, inner_error);
+			return FALSE;
+		}
+
+		if (jreader->current != jreader->entry_end) {
+			/* damaged journal entry */
+			g_set_error (error, TRACKER_DB_JOURNAL_ERROR,
+			             TRACKER_DB_JOURNAL_ERROR_DAMAGED_JOURNAL_ENTRY,
+			             "Damaged journal entry, %p != %p (end of transaction with 0 triples)",
+			             jreader->current,
+			             jreader->entry_end);
+			return FALSE;
 		}
 
 		jreader->type = TRACKER_DB_JOURNAL_END_TRANSACTION;
@@ -1774,6 +2232,10 @@ db_journal_reader_next (JournalReader *jreader, gboolean global_reader, GError *
 	} else {
 		DataFormat df;
 
+		if (jreader->packed && !journal_reader_unpack (jreader, error)) {
+			return FALSE;
+		}
+
 		df = journal_read_uint32 (jreader, &inner_error);
 		if (inner_error) {
 			g_propagate_error (error, inner_error);
@@ -1912,7 +2374,7 @@ gboolean
 tracker_db_journal_reader_get_resource (gint         *id,
                                         const gchar **uri)
 {
-	g_return_val_if_fail (reader.file != NULL || reader.stream != NULL, FALSE);
+	g_return_val_if_fail (reader.file != NULL || reader.inflated != NULL, FALSE);
 	g_return_val_if_fail (reader.type == TRACKER_DB_JOURNAL_RESOURCE, FALSE);
 
 	*id = reader.s_id;
@@ -1927,7 +2389,7 @@ tracker_db_journal_reader_get_statement (gint         *g_id,
                                          gint         *p_id,
                                          const gchar **object)
 {
-	g_return_val_if_fail (reader.file != NULL || reader.stream != NULL, FALSE);
+	g_return_val_if_fail (reader.file != NULL || reader.inflated != NULL, FALSE);
 	g_return_val_if_fail (reader.type == TRACKER_DB_JOURNAL_INSERT_STATEMENT ||
 	                      reader.type == TRACKER_DB_JOURNAL_DELETE_STATEMENT ||
 	                      reader.type == TRACKER_DB_JOURNAL_UPDATE_STATEMENT,
@@ -1949,7 +2411,7 @@ tracker_db_journal_reader_get_statement_id (gint *g_id,
                                             gint *p_id,
                                             gint *o_id)
 {
-	g_return_val_if_fail (reader.file != NULL || reader.stream != NULL, FALSE);
+	g_return_val_if_fail (reader.file != NULL || reader.inflated != NULL, FALSE);
 	g_return_val_if_fail (reader.type == TRACKER_DB_JOURNAL_INSERT_STATEMENT_ID ||
 	                      reader.type == TRACKER_DB_JOURNAL_DELETE_STATEMENT_ID ||
 	                      reader.type == TRACKER_DB_JOURNAL_UPDATE_STATEMENT_ID,
@@ -2024,26 +2486,10 @@ tracker_db_journal_reader_get_progress (void)
 		total = ((gdouble) ((gdouble) current_file) / ((gdouble) total_chunks));
 	}
 
-	if (reader.start != 0) {
-		/* When the last uncompressed part is being processed: */
+	if (reader.start != 0 && reader.end > reader.start) {
+		/* Both mapped and inflated chunks are held in memory */
 		gdouble percent = ((gdouble)(reader.end - reader.start));
 		ret = chunk = (((gdouble)(reader.current - reader.start)) / percent);
-	} else if (reader.underlying_stream) {
-		goffset size;
-
-		/* When a compressed part is being processed: */
-
-		if (!reader.underlying_stream_info) {
-			reader.underlying_stream_info =
-				g_file_input_stream_query_info (G_FILE_INPUT_STREAM (reader.underlying_stream),
-			                                    G_FILE_ATTRIBUTE_STANDARD_SIZE,
-			                                    NULL, NULL);
-		}
-
-		if (reader.underlying_stream_info) {
-			size = g_file_info_get_size (reader.underlying_stream_info);
-			ret = chunk = (gdouble) ((gdouble)g_seekable_tell (G_SEEKABLE (reader.underlying_stream))) / ((gdouble)size);
-		}
 	}
 
 	if (total_chunks > 0) {
@@ -2197,4 +2643,10 @@ tracker_db_journal_set_rotating (gboolean     do_rotating,
 {
 	/* intentionally left blank, used for internal API compatibility */
 }
+
+void
+tracker_db_journal_set_compression (gboolean compress)
+{
+	/* intentionally left blank, used for internal API compatibility */
+}
 #endif /* DISABLE_JOURNAL */
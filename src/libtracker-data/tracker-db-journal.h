@@ -75,6 +75,8 @@ void         tracker_db_journal_get_rotating                 (gboolean    *do_ro
                                                               gsize       *chunk_size,
                                                               gchar      **rotate_to);
 
+void         tracker_db_journal_set_compression              (gboolean     compress);
+
 gboolean     tracker_db_journal_start_transaction            (time_t       time);
 gboolean     tracker_db_journal_start_ontology_transaction   (time_t       time,
                                                               GError     **error);
@@ -107,6 +109,8 @@ gboolean     tracker_db_journal_append_resource              (gint         s_id,
                                                               const gchar *uri);
 
 gboolean     tracker_db_journal_rollback_transaction         (GError **error);
+void         tracker_db_journal_savepoint                    (void);
+void         tracker_db_journal_rollback_to_savepoint        (void);
 gboolean     tracker_db_journal_commit_db_transaction        (GError **error);
 
 gboolean     tracker_db_journal_fsync                        (void);
@@ -68,6 +68,13 @@
 #define NEED_MTIME_CHECK_FILENAME     "no-need-mtime-check.txt"
 #define PARSER_SHA1_FILENAME          "parser-sha1.txt"
 
+/* Maximum number of connections open at once, when interfaces can be
+ * used from several threads (TRACKER_DB_MANAGER_ENABLE_MUTEXES) further
+ * threads share the least used ones. Otherwise this only limits how
+ * many idle connections are kept around.
+ */
+#define MAX_INTERFACES                16
+
 typedef enum {
 	TRACKER_DB_LOCATION_DATA_DIR,
 	TRACKER_DB_LOCATION_USER_DATA_DIR,
@@ -150,6 +157,7 @@ static TrackerDBInterface *tracker_db_manager_get_db_interfaces     (GError
                                                                      gint                 num,
                                                                      ...);
 static void                db_remove_locale_file                    (void);
+static void                db_interface_release                     (TrackerDBInterface  *iface);
 
 static gboolean              initialized;
 static gboolean              locations_initialized;
@@ -161,7 +169,17 @@ static TrackerDBManagerFlags old_flags = 0;
 static guint                 s_cache_size;
 static guint                 u_cache_size;
 
-static GPrivate              interface_data_key = G_PRIVATE_INIT ((GDestroyNotify)g_object_unref);
+static GPrivate              interface_data_key = G_PRIVATE_INIT ((GDestroyNotify) db_interface_release);
+
+/* Connections given back by finished threads, each keeps its
+ * statement cache. All open connections are in interface_users,
+ * along with the number of threads using them. Protected by
+ * interface_pool_mutex.
+ */
+static GQueue                interface_pool = G_QUEUE_INIT;
+static GHashTable           *interface_users;
+static guint                 n_interfaces;
+static GMutex                interface_pool_mutex;
 
 /* mutex protecting DB manager initialization/shutdown */
 static GMutex                init_mutex;
@@ -1295,6 +1313,13 @@ db_manager_shutdown_unlocked (void)
 	/* shutdown db interface in all threads */
 	g_private_replace (&interface_data_key, NULL);
 
+	g_mutex_lock (&interface_pool_mutex);
+	g_queue_free_full (&interface_pool, g_object_unref);
+	g_queue_init (&interface_pool);
+	g_clear_pointer (&interface_users, g_hash_table_unref);
+	n_interfaces = 0;
+	g_mutex_unlock (&interface_pool_mutex);
+
 	/* Since we don't reference this enum anywhere, we do
 	 * it here to make sure it exists when we call
 	 * g_type_class_peek(). This wouldn't be necessary if
@@ -1374,6 +1399,94 @@ tracker_db_manager_get_file (TrackerDB db)
 	return dbs[db].abs_filename;
 }
 
+/* Called when a thread using a connection exits. Once no thread uses
+ * it, the connection is kept for the next thread asking for one, up to
+ * MAX_INTERFACES.
+ */
+static void
+db_interface_release (TrackerDBInterface *iface)
+{
+	gpointer users;
+
+	g_mutex_lock (&interface_pool_mutex);
+
+	if (interface_users &&
+	    g_hash_table_lookup_extended (interface_users, iface, NULL, &users)) {
+		guint n_users = GPOINTER_TO_UINT (users) - 1;
+
+		if (n_users > 0) {
+			/* Still used by other threads, drop this thread's reference */
+			g_hash_table_insert (interface_users, iface, GUINT_TO_POINTER (n_users));
+		} else if (initialized &&
+		           g_queue_get_length (&interface_pool) < MAX_INTERFACES) {
+			g_hash_table_insert (interface_users, iface, GUINT_TO_POINTER (0));
+			g_queue_push_head (&interface_pool, iface);
+			iface = NULL;
+		} else {
+			g_hash_table_remove (interface_users, iface);
+			n_interfaces--;
+		}
+	}
+
+	g_mutex_unlock (&interface_pool_mutex);
+
+	if (iface) {
+		g_object_unref (iface);
+	}
+}
+
+/* Takes a connection for the calling thread, either an idle one, or if
+ * the maximum number of connections is open, one in use by other threads.
+ * Returns NULL if a new connection should be opened, in which case a slot
+ * is reserved for it. Must be called with interface_pool_mutex held.
+ */
+static TrackerDBInterface *
+db_interface_acquire_unlocked (gboolean can_share)
+{
+	TrackerDBInterface *iface, *least_used = NULL;
+	guint n_users, least_users = G_MAXUINT;
+	GHashTableIter iter;
+	gpointer key, value;
+
+	if (!interface_users) {
+		interface_users = g_hash_table_new (NULL, NULL);
+	}
+
+	iface = g_queue_pop_head (&interface_pool);
+
+	if (iface) {
+		g_hash_table_insert (interface_users, iface, GUINT_TO_POINTER (1));
+		return iface;
+	}
+
+	if (!can_share || n_interfaces < MAX_INTERFACES) {
+		n_interfaces++;
+		return NULL;
+	}
+
+	g_hash_table_iter_init (&iter, interface_users);
+
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		n_users = GPOINTER_TO_UINT (value);
+
+		if (n_users < least_users) {
+			least_used = key;
+			least_users = n_users;
+		}
+	}
+
+	if (!least_used) {
+		/* All slots are taken by connections still being opened */
+		n_interfaces++;
+		return NULL;
+	}
+
+	g_hash_table_insert (interface_users, least_used,
+	                     GUINT_TO_POINTER (least_users + 1));
+
+	return g_object_ref (least_used);
+}
+
 /**
  * tracker_db_manager_get_db_interfaces:
  * @num: amount of TrackerDB files wanted
@@ -1443,7 +1556,11 @@ tracker_db_manager_get_db_interfaces (GError   **error,
 /**
  * tracker_db_manager_get_db_interface:
  *
- * Request a database connection to the database
+ * Request a database connection to the database, each thread gets its
+ * own connection and statement cache. Connections of threads that exited
+ * are reused before opening new ones. When connections can be used from
+ * several threads, at most MAX_INTERFACES are open and further threads
+ * share them.
  *
  * The caller must NOT g_object_unref the result
  *
@@ -1454,16 +1571,29 @@ tracker_db_manager_get_db_interface (void)
 {
 	GError *internal_error = NULL;
 	TrackerDBInterface *interface;
+	TrackerDBManagerFlags flags;
 
 	g_return_val_if_fail (initialized != FALSE, NULL);
 
 	interface = g_private_get (&interface_data_key);
 
+	if (interface) {
+		return interface;
+	}
+
+	flags = tracker_db_manager_get_flags (NULL, NULL);
+
+	/* Reuse a connection left by a thread that went away, or share one */
+	g_mutex_lock (&interface_pool_mutex);
+	interface = db_interface_acquire_unlocked ((flags & TRACKER_DB_MANAGER_ENABLE_MUTEXES) != 0);
+	g_mutex_unlock (&interface_pool_mutex);
+
+	if (interface) {
+		g_private_set (&interface_data_key, interface);
+	}
+
 	/* Ensure the interface is there */
 	if (!interface) {
-		TrackerDBManagerFlags flags;
-
-		flags = tracker_db_manager_get_flags (NULL, NULL);
 		interface = tracker_db_manager_get_db_interfaces (&internal_error,
 		                                                  (flags & TRACKER_DB_MANAGER_READONLY) != 0,
 		                                                  1, TRACKER_DB_METADATA);
@@ -1471,6 +1601,11 @@ tracker_db_manager_get_db_interface (void)
 		if (internal_error) {
 			g_critical ("Error opening database: %s", internal_error->message);
 			g_error_free (internal_error);
+
+			g_mutex_lock (&interface_pool_mutex);
+			n_interfaces--;
+			g_mutex_unlock (&interface_pool_mutex);
+
 			return NULL;
 		}
 
@@ -1484,6 +1619,12 @@ tracker_db_manager_get_db_interface (void)
 		                                              TRACKER_DB_STATEMENT_CACHE_TYPE_UPDATE,
 		                                              u_cache_size);
 
+		g_mutex_lock (&interface_pool_mutex);
+		if (interface_users) {
+			g_hash_table_insert (interface_users, interface, GUINT_TO_POINTER (1));
+		}
+		g_mutex_unlock (&interface_pool_mutex);
+
 		g_private_set (&interface_data_key, interface);
 	}
 
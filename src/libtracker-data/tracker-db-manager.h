@@ -49,6 +49,7 @@ typedef enum {
 	TRACKER_DB_MANAGER_READONLY              = 1 << 5,
 	TRACKER_DB_MANAGER_DO_NOT_CHECK_ONTOLOGY = 1 << 6,
 	TRACKER_DB_MANAGER_ENABLE_MUTEXES        = 1 << 7,
+	TRACKER_DB_MANAGER_FTS_REINDEX_IN_BACKGROUND = 1 << 8,
 } TrackerDBManagerFlags;
 
 GType               tracker_db_get_type                       (void) G_GNUC_CONST;
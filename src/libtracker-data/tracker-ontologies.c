@@ -72,6 +72,9 @@ static GvdbTable *gvdb_namespaces_table;
 static GvdbTable *gvdb_classes_table;
 static GvdbTable *gvdb_properties_table;
 
+/* Bumped whenever the set of loaded ontologies may have changed */
+static gint        generation;
+
 void
 tracker_ontologies_init (void)
 {
@@ -117,6 +120,8 @@ tracker_ontologies_init (void)
 	 */
 	property_type_enum_class = g_type_class_ref (TRACKER_TYPE_PROPERTY_TYPE);
 
+	g_atomic_int_inc (&generation);
+
 	initialized = TRUE;
 }
 
@@ -176,9 +181,17 @@ tracker_ontologies_shutdown (void)
 		gvdb_table = NULL;
 	}
 
+	g_atomic_int_inc (&generation);
+
 	initialized = FALSE;
 }
 
+guint
+tracker_ontologies_get_generation (void)
+{
+	return (guint) g_atomic_int_get (&generation);
+}
+
 TrackerProperty *
 tracker_ontologies_get_rdf_type (void)
 {
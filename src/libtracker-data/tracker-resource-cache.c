@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "tracker-resource-cache.h"
+
+/* URI -> resource ID mappings that outlive transactions. Only
+ * committed resources are added, so any thread may trust a hit.
+ * Resource rows are never deleted, an entry only goes stale when
+ * the whole database does, see tracker_resource_cache_clear().
+ *
+ * Eviction follows the CLOCK algorithm: a hit sets the entry's
+ * referenced bit, and the hand sweeping for a victim clears bits
+ * until it finds an unreferenced entry. New entries start
+ * unreferenced, so URIs seen once (e.g. during a crawl) go first.
+ */
+
+typedef struct {
+	gchar *uri;
+	gint id;
+	guint referenced : 1;
+} ResourceCacheEntry;
+
+static GMutex mutex;
+static ResourceCacheEntry *entries = NULL;
+static guint n_entries = 0;
+static guint max_entries = TRACKER_RESOURCE_CACHE_SIZE_DEFAULT;
+static guint hand = 0;
+/* URI (owned by the entry) -> slot + 1 */
+static GHashTable *slots = NULL;
+
+static void
+resource_cache_clear_unlocked (void)
+{
+	guint i;
+
+	for (i = 0; i < n_entries; i++) {
+		g_free (entries[i].uri);
+	}
+
+	if (slots) {
+		g_hash_table_remove_all (slots);
+	}
+
+	n_entries = 0;
+	hand = 0;
+}
+
+void
+tracker_resource_cache_set_size (guint size)
+{
+	g_mutex_lock (&mutex);
+
+	resource_cache_clear_unlocked ();
+	g_free (entries);
+	entries = NULL;
+	max_entries = size;
+
+	g_mutex_unlock (&mutex);
+}
+
+gint
+tracker_resource_cache_lookup (const gchar *uri)
+{
+	gint id = 0;
+	guint slot;
+
+	g_return_val_if_fail (uri != NULL, 0);
+
+	g_mutex_lock (&mutex);
+
+	if (slots) {
+		slot = GPOINTER_TO_UINT (g_hash_table_lookup (slots, uri));
+
+		if (slot > 0) {
+			entries[slot - 1].referenced = TRUE;
+			id = entries[slot - 1].id;
+		}
+	}
+
+	g_mutex_unlock (&mutex);
+
+	return id;
+}
+
+void
+tracker_resource_cache_insert (const gchar *uri,
+                               gint         id)
+{
+	ResourceCacheEntry *entry;
+	guint slot;
+
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (id > 0);
+
+	g_mutex_lock (&mutex);
+
+	if (max_entries == 0) {
+		g_mutex_unlock (&mutex);
+		return;
+	}
+
+	if (G_UNLIKELY (!slots)) {
+		slots = g_hash_table_new (g_str_hash, g_str_equal);
+	}
+
+	if (G_UNLIKELY (!entries)) {
+		entries = g_new0 (ResourceCacheEntry, max_entries);
+	}
+
+	slot = GPOINTER_TO_UINT (g_hash_table_lookup (slots, uri));
+
+	if (slot > 0) {
+		entries[slot - 1].id = id;
+		g_mutex_unlock (&mutex);
+		return;
+	}
+
+	if (n_entries < max_entries) {
+		slot = n_entries++;
+	} else {
+		while (entries[hand].referenced) {
+			entries[hand].referenced = FALSE;
+			hand = (hand + 1) % max_entries;
+		}
+
+		slot = hand;
+		hand = (hand + 1) % max_entries;
+
+		g_hash_table_remove (slots, entries[slot].uri);
+		g_free (entries[slot].uri);
+	}
+
+	entry = &entries[slot];
+	entry->uri = g_strdup (uri);
+	entry->id = id;
+	entry->referenced = FALSE;
+	g_hash_table_insert (slots, entry->uri, GUINT_TO_POINTER (slot + 1));
+
+	g_mutex_unlock (&mutex);
+}
+
+void
+tracker_resource_cache_clear (void)
+{
+	g_mutex_lock (&mutex);
+	resource_cache_clear_unlocked ();
+	g_mutex_unlock (&mutex);
+}
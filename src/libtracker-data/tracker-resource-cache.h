@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __LIBTRACKER_DATA_RESOURCE_CACHE_H__
+#define __LIBTRACKER_DATA_RESOURCE_CACHE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#if !defined (__LIBTRACKER_DATA_INSIDE__) && !defined (TRACKER_COMPILATION)
+#error "only <libtracker-data/tracker-data.h> must be included directly."
+#endif
+
+#define TRACKER_RESOURCE_CACHE_SIZE_DEFAULT 10000
+
+void     tracker_resource_cache_set_size (guint        size);
+gint     tracker_resource_cache_lookup   (const gchar *uri);
+void     tracker_resource_cache_insert   (const gchar *uri,
+                                          gint         id);
+void     tracker_resource_cache_clear    (void);
+
+G_END_DECLS
+
+#endif /* __LIBTRACKER_DATA_RESOURCE_CACHE_H__ */
@@ -1145,6 +1145,16 @@ class Tracker.Sparql.Expression : Object {
 			}
 
 			return PropertyType.INTEGER;
+		case SparqlTokenType.PARAMETERIZED_VAR:
+			next ();
+
+			sql.append ("?");
+
+			var binding = new LiteralBinding ();
+			binding.parameter_name = get_last_string ().substring (1);
+			query.bindings.append (binding);
+
+			return PropertyType.STRING;
 		case SparqlTokenType.VAR:
 			next ();
 			string variable_name = get_last_string ().substring (1);
@@ -1573,12 +1583,18 @@ class Tracker.Sparql.Expression : Object {
 		expect (SparqlTokenType.OPEN_PARENS);
 		sql.append (" IN (");
 		if (!accept (SparqlTokenType.CLOSE_PARENS)) {
-			in_variable_count++;
+			// Parameters keep the SQL the same across executions,
+			// only literals count towards the limit
+			if (current () != SparqlTokenType.PARAMETERIZED_VAR) {
+				in_variable_count++;
+			}
 			translate_expression (sql);
 			while (accept (SparqlTokenType.COMMA)) {
 				sql.append (", ");
 
-				in_variable_count++;
+				if (current () != SparqlTokenType.PARAMETERIZED_VAR) {
+					in_variable_count++;
+				}
 
 				if (in_variable_count > MAX_VARIABLES_FOR_IN && !query.no_cache) {
 					query.no_cache = true;
@@ -34,6 +34,9 @@ namespace Tracker.Sparql {
 					// single subject
 					var subject_id = Data.query_resource_id (subject);
 
+					// the generated SQL depends on the rdf:types of the subject
+					query.no_translation_cache = true;
+
 					DBCursor cursor = null;
 					if (subject_id > 0) {
 						var iface = DBManager.get_db_interface ();
@@ -85,6 +88,9 @@ namespace Tracker.Sparql {
 					// single object
 					var object_id = Data.query_resource_id (object);
 
+					// the generated SQL depends on the rdf:types of the object
+					query.no_translation_cache = true;
+
 					var iface = DBManager.get_db_interface ();
 					var stmt = iface.create_statement (DBStatementCacheType.SELECT,
 					                                   "SELECT (SELECT Uri FROM Resource WHERE ID = \"rdf:type\") " +
@@ -768,6 +774,17 @@ class Tracker.Sparql.Pattern : Object {
 				string escaped_literal = string.joinv ("''", binding.literal.split ("'"));
 				sql.append_printf (" MATCH '%s'", escaped_literal);
 
+				// tokens of resources changed during an FTS
+				// reindex are outdated until it is complete,
+				// the table goes away then so the SQL must
+				// not outlive the reindex in any cache
+				if (Data.Manager.fts_reindex_pending ()) {
+					sql.append_printf (" AND \"%s\".\"rowid\" NOT IN (SELECT ID FROM FtsReindexStale)",
+					                   binding.table.sql_query_tablename);
+					query.no_translation_cache = true;
+					query.no_cache = true;
+				}
+
 				if (match_str == null) {
 				        match_str = new StringBuilder ();
 					match_str.append_printf (" MATCH '%s'", escaped_literal);
@@ -1338,7 +1355,17 @@ class Tracker.Sparql.Pattern : Object {
 		long begin_sql_len = sql.len;
 
 		bool object_is_var;
-		string object = parse_var_or_term (sql, out object_is_var);
+		bool object_is_parameter = false;
+		string object;
+
+		if (accept (SparqlTokenType.PARAMETERIZED_VAR)) {
+			// ~name, value is bound at execution time
+			object = get_last_string ().substring (1);
+			object_is_var = false;
+			object_is_parameter = true;
+		} else {
+			object = parse_var_or_term (sql, out object_is_var);
+		}
 
 		string db_table = null;
 		bool rdftype = false;
@@ -1351,6 +1378,14 @@ class Tracker.Sparql.Pattern : Object {
 
 		Class subject_type = null;
 
+		if (object_is_parameter &&
+		    (current_predicate_is_var ||
+		     current_predicate == "http://www.w3.org/1999/02/22-rdf-syntax-ns#type" ||
+		     current_predicate == "http://www.w3.org/2000/01/rdf-schema#domain" ||
+		     current_predicate == "http://www.tracker-project.org/ontologies/fts#match")) {
+			throw get_error ("parameterized variables are not supported as object of `%s'".printf (current_predicate));
+		}
+
 		if (!current_predicate_is_var) {
 			prop = Ontologies.get_property_by_uri (current_predicate);
 
@@ -1561,7 +1596,11 @@ class Tracker.Sparql.Pattern : Object {
 				                   context.get_variable (current_subject).name);
 			} else {
 				var binding = new LiteralBinding ();
-				binding.literal = object;
+				if (object_is_parameter) {
+					binding.parameter_name = object;
+				} else {
+					binding.literal = object;
+				}
 				// binding.data_type = triple.object.type;
 				binding.table = table;
 				if (prop != null) {
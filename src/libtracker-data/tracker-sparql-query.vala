@@ -62,6 +62,8 @@ namespace Tracker.Sparql {
 	class LiteralBinding : DataBinding {
 		public bool is_fts_match;
 		public string literal;
+		// name of the ~parameter providing the value, if any
+		public string? parameter_name;
 	}
 
 	// Represents a mapping of a SPARQL variable to a SQL table and column
@@ -175,6 +177,17 @@ namespace Tracker.Sparql {
 		}
 	}
 
+	// Cached SQL translation of a SELECT or ASK query
+	class Translation {
+		public string sql;
+		public bool no_cache;
+		public string[] literals;
+		public string?[] literal_parameters;
+		public PropertyType[] literal_types;
+		public PropertyType[] types;
+		public string[] variable_names;
+	}
+
 	class Solution {
 		public HashTable<string,int> hash;
 		public GenericArray<string> values;
@@ -247,6 +260,38 @@ public class Tracker.Sparql.Query : Object {
 
 	public bool no_cache { get; set; }
 
+	// a{sv} dictionary with the values of ~parameters
+	Variant? parameters;
+
+	// Set when the generated SQL depends on database contents
+	// and thus must not be kept in the translation cache
+	internal bool no_translation_cache;
+
+	// Statements of an update decomposed by prepare_update (),
+	// null elements stand for a flush of the update buffer
+	class UpdateOperation {
+		public UpdateType type;
+		public bool silent;
+		public string? graph;
+		public string subject;
+		public string predicate;
+		public string? object;
+	}
+
+	GenericArray<UpdateOperation?> prepared_operations;
+	bool preparing;
+	bool prepare_failed;
+
+	// SQL translations of recent SELECT/ASK queries, shared by all threads
+	const uint TRANSLATION_CACHE_SIZE = 256;
+	static Mutex translation_mutex;
+	static HashTable<string,Translation> translation_cache;
+	static Queue<string> translation_order;
+	static uint translation_generation;
+	static uint translation_schema_generation;
+	static uint translation_hits;
+	static uint translation_misses;
+
 	public Query (string query) {
 		no_cache = false; /* Start with false, expression sets it */
 		tokens = new TokenInfo[BUFFER_SIZE];
@@ -266,6 +311,10 @@ public class Tracker.Sparql.Query : Object {
 		this.update_extensions = true;
 	}
 
+	public void set_parameters (Variant? parameters) {
+		this.parameters = parameters;
+	}
+
 	string get_uuid_for_name (uchar[] base_uuid, string name) {
 		var checksum = new Checksum (ChecksumType.SHA1);
 		// base UUID, unique per file
@@ -297,7 +346,10 @@ public class Tracker.Sparql.Query : Object {
 
 			uri = get_uuid_for_name (base_uuid, user_bnodeid);
 
-			if (blank_nodes != null) {
+			if (blank_nodes != null && preparing) {
+				// collision check needs the database
+				prepare_failed = true;
+			} else if (blank_nodes != null) {
 				while (Data.query_resource_id (uri) > 0) {
 					// uri collision, generate new UUID
 					uchar[] new_base_uuid = new uchar[16];
@@ -417,7 +469,97 @@ public class Tracker.Sparql.Query : Object {
 	}
 
 
+	public static void get_translation_cache_stats (out uint hits, out uint misses, out uint size) {
+		translation_mutex.lock ();
+		hits = translation_hits;
+		misses = translation_misses;
+		size = (translation_cache != null) ? translation_cache.size () : 0;
+		translation_mutex.unlock ();
+	}
+
+	Translation? lookup_translation () {
+		Translation translation = null;
+
+		translation_mutex.lock ();
+
+		uint generation = Ontologies.get_generation ();
+		uint schema_generation = Data.Manager.get_schema_generation ();
+		if (translation_cache == null || translation_generation != generation ||
+		    translation_schema_generation != schema_generation) {
+			// ontology (re)loaded or tables changed, previous
+			// translations are stale
+			translation_cache = new HashTable<string,Translation> (str_hash, str_equal);
+			translation_order = new Queue<string> ();
+			translation_generation = generation;
+			translation_schema_generation = schema_generation;
+		}
+
+		translation = translation_cache.lookup (query_string.strip ());
+		if (translation != null) {
+			translation_hits++;
+		} else {
+			translation_misses++;
+		}
+
+		translation_mutex.unlock ();
+
+		return translation;
+	}
+
+	void cache_translation (string sql, PropertyType[] types, string[] variable_names) {
+		if (no_translation_cache) {
+			return;
+		}
+
+		var translation = new Translation ();
+		translation.sql = sql;
+		translation.no_cache = no_cache;
+		translation.types = types;
+		translation.variable_names = variable_names;
+
+		foreach (LiteralBinding binding in bindings) {
+			translation.literals += binding.literal;
+			translation.literal_parameters += binding.parameter_name;
+			translation.literal_types += binding.data_type;
+		}
+
+		string key = query_string.strip ();
+
+		translation_mutex.lock ();
+
+		if (translation_generation == Ontologies.get_generation () &&
+		    translation_schema_generation == Data.Manager.get_schema_generation () &&
+		    translation_cache.lookup (key) == null) {
+			if (translation_cache.size () >= TRANSLATION_CACHE_SIZE) {
+				translation_cache.remove (translation_order.pop_head ());
+			}
+
+			translation_cache.insert (key, translation);
+			translation_order.push_tail (key);
+		}
+
+		translation_mutex.unlock ();
+	}
+
+	DBCursor? execute_translation (Translation translation) throws DBInterfaceError, Sparql.Error, DateError {
+		no_cache = translation.no_cache;
+
+		for (int i = 0; i < translation.literals.length; i++) {
+			var binding = new LiteralBinding ();
+			binding.literal = translation.literals[i];
+			binding.parameter_name = translation.literal_parameters[i];
+			binding.data_type = translation.literal_types[i];
+			bindings.append (binding);
+		}
+
+		return exec_sql_cursor (translation.sql, translation.types, translation.variable_names);
+	}
+
 	public DBCursor? execute_cursor () throws DBInterfaceError, Sparql.Error, DateError {
+		var translation = lookup_translation ();
+		if (translation != null) {
+			return execute_translation (translation);
+		}
 
 		prepare_execute ();
 
@@ -439,10 +581,53 @@ public class Tracker.Sparql.Query : Object {
 		}
 	}
 
+	/**
+	 * Parses the update and decomposes it into statements without
+	 * touching the database, so that it can run outside the update
+	 * thread. Updates whose statements depend on the database (WHERE
+	 * clauses, named blank nodes in inserts) are left for
+	 * execute_update () to parse, false is returned in that case.
+	 */
+	public bool prepare_update () throws GLib.Error {
+		assert (update_extensions);
+
+		preparing = true;
+		prepared_operations = new GenericArray<UpdateOperation?> ();
+
+		try {
+			execute_update (false);
+		} finally {
+			preparing = false;
+		}
+
+		if (prepare_failed) {
+			prepared_operations = null;
+			return false;
+		}
+
+		return true;
+	}
+
 	public Variant? execute_update (bool blank) throws GLib.Error {
 		Variant result = null;
 		assert (update_extensions);
 
+		if (prepared_operations != null && !preparing) {
+			assert (!blank);
+
+			for (int i = 0; i < prepared_operations.length; i++) {
+				unowned UpdateOperation? op = prepared_operations[i];
+
+				if (op == null) {
+					Data.update_buffer_flush ();
+				} else {
+					apply_statement (op.type, op.silent, op.graph, op.subject, op.predicate, op.object);
+				}
+			}
+
+			return null;
+		}
+
 		scanner = new SparqlScanner ((char*) query_string, (long) query_string.length);
 		next ();
 
@@ -466,7 +651,7 @@ public class Tracker.Sparql.Query : Object {
 			ublank_nodes = new VariantBuilder ((VariantType) "aaa{ss}");
 		}
 
-		while (current () != SparqlTokenType.EOF) {
+		while (current () != SparqlTokenType.EOF && !prepare_failed) {
 			switch (current ()) {
 			case SparqlTokenType.WITH:
 			case SparqlTokenType.INSERT:
@@ -513,22 +698,47 @@ public class Tracker.Sparql.Query : Object {
 		// set literals specified in query
 		int i = 0;
 		foreach (LiteralBinding binding in bindings) {
+			string literal = binding.literal;
+
+			if (binding.parameter_name != null) {
+				Variant value = null;
+				if (parameters != null) {
+					value = parameters.lookup_value (binding.parameter_name, null);
+				}
+				if (value == null) {
+					throw new Sparql.Error.TYPE ("Parameter `~%s' is not bound".printf (binding.parameter_name));
+				}
+
+				if (value.is_of_type (VariantType.STRING)) {
+					literal = value.get_string ();
+				} else if (binding.data_type == PropertyType.UNKNOWN && value.is_of_type (VariantType.INT64)) {
+					// untyped use in an expression, keep native value
+					stmt.bind_int (i++, value.get_int64 ());
+					continue;
+				} else if (binding.data_type == PropertyType.UNKNOWN && value.is_of_type (VariantType.DOUBLE)) {
+					stmt.bind_double (i++, value.get_double ());
+					continue;
+				} else {
+					literal = value.print (false);
+				}
+			}
+
 			if (binding.data_type == PropertyType.BOOLEAN) {
-				if (binding.literal == "true" || binding.literal == "1") {
+				if (literal == "true" || literal == "1") {
 					stmt.bind_int (i, 1);
-				} else if (binding.literal == "false" || binding.literal == "0") {
+				} else if (literal == "false" || literal == "0") {
 					stmt.bind_int (i, 0);
 				} else {
-					throw new Sparql.Error.TYPE ("`%s' is not a valid boolean".printf (binding.literal));
+					throw new Sparql.Error.TYPE ("`%s' is not a valid boolean".printf (literal));
 				}
 			} else if (binding.data_type == PropertyType.DATE) {
-				stmt.bind_int (i, (int) string_to_date (binding.literal + "T00:00:00Z", null));
+				stmt.bind_int (i, (int) string_to_date (literal + "T00:00:00Z", null));
 			} else if (binding.data_type == PropertyType.DATETIME) {
-				stmt.bind_double (i, string_to_date (binding.literal, null));
+				stmt.bind_double (i, string_to_date (literal, null));
 			} else if (binding.data_type == PropertyType.INTEGER) {
-				stmt.bind_int (i, int.parse (binding.literal));
+				stmt.bind_int (i, int64.parse (literal));
 			} else {
-				stmt.bind_text (i, binding.literal);
+				stmt.bind_text (i, literal);
 			}
 			i++;
 		}
@@ -558,6 +768,8 @@ public class Tracker.Sparql.Query : Object {
 		SelectContext context;
 		string sql = get_select_query (out context);
 
+		cache_translation (sql, context.types, context.variable_names);
+
 		return exec_sql_cursor (sql, context.types, context.variable_names);
 	}
 
@@ -593,7 +805,13 @@ public class Tracker.Sparql.Query : Object {
 	}
 
 	DBCursor? execute_ask_cursor () throws DBInterfaceError, Sparql.Error, DateError {
-		return exec_sql_cursor (get_ask_query (), new PropertyType[] { PropertyType.BOOLEAN }, new string[] { "result" });
+		string sql = get_ask_query ();
+		var types = new PropertyType[] { PropertyType.BOOLEAN };
+		var variable_names = new string[] { "result" };
+
+		cache_translation (sql, types, variable_names);
+
+		return exec_sql_cursor (sql, types, variable_names);
 	}
 
 	private void parse_from_or_into_param () throws Sparql.Error {
@@ -695,6 +913,12 @@ public class Tracker.Sparql.Query : Object {
 
 		if (!data) {
 			if (delete_where || accept (SparqlTokenType.WHERE)) {
+				if (preparing) {
+					// solutions depend on the database
+					prepare_failed = true;
+					return;
+				}
+
 				pattern.current_graph = current_graph;
 				context = pattern.translate_group_graph_pattern (pattern_sql);
 				pattern.current_graph = null;
@@ -744,18 +968,25 @@ public class Tracker.Sparql.Query : Object {
 		sql.append (pattern_sql.str);
 		sql.append (")");
 
-		var cursor = exec_sql_cursor (sql.str, null, null);
-
 		int n_solutions = 0;
-		while (cursor.next ()) {
-			// get values of all variables to be bound
-			for (var_idx = 0; var_idx < solution.hash.size (); var_idx++) {
-				solution.values.add (cursor.get_string (var_idx));
+
+		if (preparing) {
+			// without WHERE clause there is exactly one solution,
+			// which binds no variables
+			n_solutions = 1;
+		} else {
+			var cursor = exec_sql_cursor (sql.str, null, null);
+
+			while (cursor.next ()) {
+				// get values of all variables to be bound
+				for (var_idx = 0; var_idx < solution.hash.size (); var_idx++) {
+					solution.values.add (cursor.get_string (var_idx));
+				}
+				n_solutions++;
 			}
-			n_solutions++;
-		}
 
-		cursor = null;
+			cursor = null;
+		}
 
 		// Iterate over all solutions twice
 		// First handle deletes
@@ -764,14 +995,14 @@ public class Tracker.Sparql.Query : Object {
 				solution.solution_index = i;
 				set_location (delete_location);
 				parse_construct_triples_block (solution, UpdateType.DELETE);
-				Data.update_buffer_might_flush ();
+				might_flush ();
 			}
 
 			// Force flush on delete/insert operations,
 			// so the elements are already removed at
 			// the time of insertion.
 			if (insert_location != null)
-				Data.update_buffer_flush ();
+				flush ();
 		}
 
 		// Then handle inserts/updates
@@ -791,7 +1022,7 @@ public class Tracker.Sparql.Query : Object {
 					update_blank_nodes.add_value (blank_nodes);
 				}
 
-				Data.update_buffer_might_flush ();
+				might_flush ();
 			}
 		}
 
@@ -803,12 +1034,26 @@ public class Tracker.Sparql.Query : Object {
 		}
 
 		// ensure possible WHERE clause in next part gets the correct results
-		Data.update_buffer_flush ();
+		flush ();
 		bindings = null;
 
 		context = context.parent_context;
 	}
 
+	void flush () throws DBInterfaceError {
+		if (preparing) {
+			prepared_operations.add (null);
+		} else {
+			Data.update_buffer_flush ();
+		}
+	}
+
+	void might_flush () throws DBInterfaceError {
+		if (!preparing) {
+			Data.update_buffer_might_flush ();
+		}
+	}
+
 	internal string resolve_prefixed_name (string prefix, string local_name) throws Sparql.Error {
 		string ns = prefix_map.lookup (prefix);
 		if (ns == null) {
@@ -1056,22 +1301,39 @@ public class Tracker.Sparql.Query : Object {
 			// should be excluded from the output RDF graph of CONSTRUCT
 			return;
 		}
+		if (is_null && type != UpdateType.UPDATE) {
+			if (!silent) {
+				throw get_error ("'null' not supported in this mode");
+			}
+			return;
+		}
+
+		if (preparing) {
+			var op = new UpdateOperation ();
+			op.type = type;
+			op.silent = silent;
+			op.graph = current_graph;
+			op.subject = current_subject;
+			op.predicate = current_predicate;
+			op.object = is_null ? null : object;
+			prepared_operations.add (op);
+			return;
+		}
+
+		apply_statement (type, silent, current_graph, current_subject, current_predicate, is_null ? null : object);
+	}
+
+	static void apply_statement (UpdateType type, bool silent, string? graph, string subject, string predicate, string? object) throws Sparql.Error {
 		try {
 			if (type == UpdateType.UPDATE) {
 				// update triple in database
-				Data.update_statement (current_graph, current_subject, current_predicate, is_null ? null : object);
+				Data.update_statement (graph, subject, predicate, object);
 			} else if (type == UpdateType.DELETE) {
 				// delete triple from database
-				if (is_null) {
-					throw get_error ("'null' not supported in this mode");
-				}
-				Data.delete_statement (current_graph, current_subject, current_predicate, object);
+				Data.delete_statement (graph, subject, predicate, object);
 			} else if (type == UpdateType.INSERT) {
 				// insert triple into database
-				if (is_null) {
-					throw get_error ("'null' not supported in this mode");
-				}
-				Data.insert_statement (current_graph, current_subject, current_predicate, object);
+				Data.insert_statement (graph, subject, predicate, object);
 			}
 		} catch (Sparql.Error e) {
 			if (!silent) {
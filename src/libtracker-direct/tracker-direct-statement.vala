@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+// The SQL translation of the query is kept by the translation cache
+// in Tracker.Sparql.Query, so executions after the first one only bind
+// the parameter values and run the cached SQLite statement.
+public class Tracker.Direct.Statement : Tracker.Sparql.Statement {
+	public Statement (Connection conn, string sparql) {
+		Object (connection: conn, sparql: sparql);
+	}
+
+	public override Sparql.Cursor execute (Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
+		var conn = (Connection) connection;
+		return conn.query_with_parameters (sparql, get_bindings (), cancellable);
+	}
+
+	public async override Sparql.Cursor execute_async (Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
+		var conn = (Connection) connection;
+		return yield conn.query_with_parameters_async (sparql, get_bindings (), cancellable);
+	}
+}
@@ -20,7 +20,23 @@
 public class Tracker.Direct.Connection : Tracker.Sparql.Connection {
 	static int use_count;
 	bool initialized;
-	private Mutex mutex = Mutex ();
+
+	// Shared by all connections and never freed, each worker thread
+	// gets its own database connection from the DB manager
+	static ThreadPool<QueryTask> query_pool;
+
+	class QueryTask {
+		public unowned Connection connection;
+		public string sparql;
+		public Variant? parameters;
+		public Cancellable? cancellable;
+		public Sparql.Cursor result;
+		public Sparql.Error sparql_error;
+		public IOError io_error;
+		public DBusError dbus_error;
+		public SourceFunc callback;
+		public MainContext context;
+	}
 
 	public Connection () throws Sparql.Error, IOError, DBusError {
 		try {
@@ -40,6 +56,10 @@ public class Tracker.Direct.Connection : Tracker.Sparql.Connection {
 				Data.Manager.init (DBManagerFlags.READONLY | DBManagerFlags.ENABLE_MUTEXES, null, null, false, false, select_cache_size, 0, null, null);
 			}
 
+			if (query_pool == null) {
+				query_pool = new ThreadPool<QueryTask>.with_owned_data (pool_dispatch_cb, (int) get_num_processors (), false);
+			}
+
 			use_count++;
 			initialized = true;
 		} catch (Error e) {
@@ -61,9 +81,10 @@ public class Tracker.Direct.Connection : Tracker.Sparql.Connection {
 		}
 	}
 
-	Sparql.Cursor query_unlocked (string sparql) throws Sparql.Error, DBusError {
+	Sparql.Cursor query_unlocked (string sparql, Variant? parameters) throws Sparql.Error, DBusError {
 		try {
 			var query_object = new Sparql.Query (sparql);
+			query_object.set_parameters (parameters);
 			var cursor = query_object.execute_cursor ();
 			cursor.connection = this;
 			return cursor;
@@ -75,60 +96,75 @@ public class Tracker.Direct.Connection : Tracker.Sparql.Connection {
 	}
 
 	public override Sparql.Cursor query (string sparql, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
+		return query_with_parameters (sparql, null, cancellable);
+	}
+
+	internal Sparql.Cursor query_with_parameters (string sparql, Variant? parameters, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
 		// Check here for early cancellation, just in case
 		// the operation can be entirely avoided
 		if (cancellable != null && cancellable.is_cancelled ()) {
 			throw new IOError.CANCELLED ("Operation was cancelled");
 		}
 
-		mutex.lock ();
+		// Every thread queries through its own database connection,
+		// so concurrent readers do not need to be serialized here
+		return query_unlocked (sparql, parameters);
+	}
+
+	static void pool_dispatch_cb (owned QueryTask task) {
 		try {
-			return query_unlocked (sparql);
-		} finally {
-			mutex.unlock ();
+			task.result = task.connection.query_with_parameters (task.sparql, task.parameters, task.cancellable);
+		} catch (IOError e_io) {
+			task.io_error = e_io;
+		} catch (Sparql.Error e_spql) {
+			task.sparql_error = e_spql;
+		} catch (DBusError e_dbus) {
+			task.dbus_error = e_dbus;
 		}
+
+		var source = new IdleSource ();
+		source.set_callback (() => {
+			task.callback ();
+			return false;
+		});
+		source.attach (task.context);
 	}
 
 	public async override Sparql.Cursor query_async (string sparql, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
-		// run in a separate thread
-		Sparql.Error sparql_error = null;
-		IOError io_error = null;
-		DBusError dbus_error = null;
-		Sparql.Cursor result = null;
-		var context = MainContext.get_thread_default ();
-
-		g_io_scheduler_push_job (job => {
-			try {
-				result = query (sparql, cancellable);
-			} catch (IOError e_io) {
-				io_error = e_io;
-			} catch (Sparql.Error e_spql) {
-				sparql_error = e_spql;
-			} catch (DBusError e_dbus) {
-				dbus_error = e_dbus;
-			}
+		return yield query_with_parameters_async (sparql, null, cancellable);
+	}
 
-			var source = new IdleSource ();
-			source.set_callback (() => {
-				query_async.callback ();
-				return false;
-			});
-			source.attach (context);
+	internal async Sparql.Cursor query_with_parameters_async (string sparql, Variant? parameters, Cancellable? cancellable) throws Sparql.Error, IOError, DBusError {
+		var task = new QueryTask ();
+		task.connection = this;
+		task.sparql = sparql;
+		task.parameters = parameters;
+		task.cancellable = cancellable;
+		task.callback = query_with_parameters_async.callback;
+		task.context = MainContext.get_thread_default ();
 
-			return false;
-		}, Priority.DEFAULT, cancellable);
+		// run in a separate thread
+		try {
+			query_pool.add (task);
+		} catch (ThreadError e) {
+			throw new Sparql.Error.INTERNAL (e.message);
+		}
 		yield;
 
 		if (cancellable != null && cancellable.is_cancelled ()) {
 			throw new IOError.CANCELLED ("Operation was cancelled");
-		} else if (sparql_error != null) {
-			throw sparql_error;
-		} else if (io_error != null) {
-			throw io_error;
-		} else if (dbus_error != null) {
-			throw dbus_error;
+		} else if (task.sparql_error != null) {
+			throw task.sparql_error;
+		} else if (task.io_error != null) {
+			throw task.io_error;
+		} else if (task.dbus_error != null) {
+			throw task.dbus_error;
 		} else {
-			return result;
+			return task.result;
 		}
 	}
+
+	public override Sparql.Statement? query_statement (string sparql, Cancellable? cancellable = null) throws Sparql.Error {
+		return new Tracker.Direct.Statement (this, sparql);
+	}
 }
@@ -114,13 +114,55 @@ tracker_fts_init_db (sqlite3    *db,
 	return retval;
 }
 
+/* Creates the FTS5 table itself, with fts_view as its content */
+static gboolean
+create_fts_table (sqlite3     *db,
+                  const gchar *table_name,
+                  GHashTable  *tables)
+{
+	GString *fts, *str;
+	GHashTableIter iter;
+	GList *columns;
+	gint rc;
+
+	fts = g_string_new ("CREATE VIRTUAL TABLE ");
+	g_string_append_printf (fts, "%s USING fts5(content=\"fts_view\", ",
+				table_name);
+
+	g_hash_table_iter_init (&iter, tables);
+
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &columns)) {
+		while (columns) {
+			g_string_append_printf (fts, "\"%s\", ",
+						(gchar *) columns->data);
+			columns = columns->next;
+		}
+	}
+
+	g_string_append (fts, "tokenize=TrackerTokenizer)");
+	rc = sqlite3_exec(db, fts->str, NULL, NULL, NULL);
+	g_string_free (fts, TRUE);
+
+	if (rc != SQLITE_OK)
+		return FALSE;
+
+	str = g_string_new (NULL);
+	g_string_append_printf (str,
+	                        "INSERT INTO %s(%s, rank) VALUES('rank', 'tracker_rank()')",
+	                        table_name, table_name);
+	rc = sqlite3_exec (db, str->str, NULL, NULL, NULL);
+	g_string_free (str, TRUE);
+
+	return (rc == SQLITE_OK);
+}
+
 gboolean
 tracker_fts_create_table (sqlite3    *db,
                           gchar      *table_name,
                           GHashTable *tables,
                           GHashTable *grouped_columns)
 {
-	GString *str, *from, *fts;
+	GString *str, *from;
 	GHashTableIter iter;
 	gchar *index_table;
 	GList *columns;
@@ -136,10 +178,6 @@ tracker_fts_create_table (sqlite3    *db,
 	str = g_string_new ("CREATE VIEW fts_view AS SELECT Resource.ID as rowid ");
 	from = g_string_new ("FROM Resource ");
 
-	fts = g_string_new ("CREATE VIRTUAL TABLE ");
-	g_string_append_printf (fts, "%s USING fts5(content=\"fts_view\", ",
-				table_name);
-
 	while (g_hash_table_iter_next (&iter, (gpointer *) &index_table,
 				       (gpointer *) &columns)) {
 		while (columns) {
@@ -156,8 +194,6 @@ tracker_fts_create_table (sqlite3    *db,
 
 			g_string_append_printf (str, " AS \"%s\" ",
 						(gchar *) columns->data);
-			g_string_append_printf (fts, "\"%s\", ",
-						(gchar *) columns->data);
 
 			columns = columns->next;
 		}
@@ -178,21 +214,7 @@ tracker_fts_create_table (sqlite3    *db,
 		return FALSE;
 	}
 
-	g_string_append (fts, "tokenize=TrackerTokenizer)");
-	rc = sqlite3_exec(db, fts->str, NULL, NULL, NULL);
-	g_string_free (fts, TRUE);
-
-	if (rc != SQLITE_OK)
-		return FALSE;
-
-	str = g_string_new (NULL);
-	g_string_append_printf (str,
-	                        "INSERT INTO %s(%s, rank) VALUES('rank', 'tracker_rank()')",
-	                        table_name, table_name);
-	rc = sqlite3_exec (db, str->str, NULL, NULL, NULL);
-	g_string_free (str, TRUE);
-
-	return (rc == SQLITE_OK);
+	return create_fts_table (db, table_name, tables);
 }
 
 gboolean
@@ -266,3 +288,59 @@ tracker_fts_rebuild_tokens (sqlite3     *db,
 	sqlite3_exec(db, query, NULL, NULL, NULL);
 	g_free (query);
 }
+
+/* Background reindexing: the tokens are built into a second table,
+ * <table_name>_reindex, while the original one keeps serving queries,
+ * then the new table takes its place.
+ */
+gboolean
+tracker_fts_create_reindex_table (sqlite3     *db,
+                                  const gchar *table_name,
+                                  GHashTable  *tables)
+{
+	gchar *reindex_name;
+	gboolean retval;
+
+	g_return_val_if_fail (initialized == TRUE, FALSE);
+
+	tracker_fts_drop_reindex_table (db, table_name);
+
+	reindex_name = g_strdup_printf ("%s_reindex", table_name);
+	retval = create_fts_table (db, reindex_name, tables);
+	g_free (reindex_name);
+
+	return retval;
+}
+
+void
+tracker_fts_drop_reindex_table (sqlite3     *db,
+                                const gchar *table_name)
+{
+	gchar *query;
+
+	query = g_strdup_printf ("DROP TABLE IF EXISTS %s_reindex", table_name);
+	sqlite3_exec (db, query, NULL, NULL, NULL);
+	g_free (query);
+}
+
+gboolean
+tracker_fts_switch_reindex_table (sqlite3     *db,
+                                  const gchar *table_name)
+{
+	gchar *query;
+	int rc;
+
+	query = g_strdup_printf ("DROP TABLE %s", table_name);
+	rc = sqlite3_exec (db, query, NULL, NULL, NULL);
+	g_free (query);
+
+	if (rc != SQLITE_OK)
+		return FALSE;
+
+	query = g_strdup_printf ("ALTER TABLE %s_reindex RENAME TO %s",
+				 table_name, table_name);
+	rc = sqlite3_exec (db, query, NULL, NULL, NULL);
+	g_free (query);
+
+	return rc == SQLITE_OK;
+}
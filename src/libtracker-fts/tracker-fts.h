@@ -43,6 +43,14 @@ gboolean    tracker_fts_alter_table      (sqlite3    *db,
 void        tracker_fts_rebuild_tokens   (sqlite3     *db,
                                           const gchar *table_name);
 
+gboolean    tracker_fts_create_reindex_table (sqlite3     *db,
+                                              const gchar *table_name,
+                                              GHashTable  *tables);
+void        tracker_fts_drop_reindex_table   (sqlite3     *db,
+                                              const gchar *table_name);
+gboolean    tracker_fts_switch_reindex_table (sqlite3     *db,
+                                              const gchar *table_name);
+
 G_END_DECLS
 
 #endif /* __LIBTRACKER_FTS_FTS_H__ */
@@ -72,6 +72,8 @@ struct _TrackerDecoratorPrivate {
 	TrackerNotifier *notifier;
 	gchar *data_source;
 
+	TrackerSparqlStatement *item_url_statement;
+
 	GArray *classes; /* Array of ClassInfo */
 	gchar **class_names;
 
@@ -84,7 +86,15 @@ struct _TrackerDecoratorPrivate {
 	GArray *prepended_ids;
 	GSequence *blacklist_items;
 
-	GHashTable *tasks; /* Associative array of GTasks */
+	/* Pending items are paged through in tracker:id order, one class
+	 * priority group at a time. Everything at or below the position of
+	 * a group has been handed out, blacklisted or is being processed.
+	 */
+	GArray *group_positions; /* Array of gint, one per priority group */
+	gint query_group; /* Group being paged through */
+	gint querying_group; /* Group of the running query, -1 for prepended IDs */
+
+	GHashTable *tasks; /* GTask -> tracker ID */
 	GArray *sparql_buffer; /* Array of SparqlUpdate */
 	GArray *commit_buffer; /* Array of SparqlUpdate */
 	GTimer *timer;
@@ -289,22 +299,31 @@ decorator_update_state (TrackerDecorator *decorator,
 }
 
 static void
-item_warn (TrackerSparqlConnection *conn,
+item_warn (TrackerDecorator        *decorator,
+           TrackerSparqlConnection *conn,
            gint                     id,
            const gchar             *sparql,
            const GError            *error)
 {
-	TrackerSparqlCursor *cursor;
+	TrackerDecoratorPrivate *priv = decorator->priv;
+	TrackerSparqlCursor *cursor = NULL;
 	const gchar *elem;
-	gchar *query;
 
-	query = g_strdup_printf ("SELECT COALESCE (nie:url (?u), ?u) {"
-	                         "  ?u a rdfs:Resource. "
-	                         "  FILTER (tracker:id (?u) = %d)"
-	                         "}", id);
+	if (!priv->item_url_statement) {
+		priv->item_url_statement =
+			tracker_sparql_connection_query_statement (conn,
+			                                           "SELECT COALESCE (nie:url (?u), ?u) {"
+			                                           "  ?u a rdfs:Resource. "
+			                                           "  FILTER (tracker:id (?u) = ~id)"
+			                                           "}",
+			                                           NULL, NULL);
+	}
 
-	cursor = tracker_sparql_connection_query (conn, query, NULL, NULL);
-	g_free (query);
+	if (priv->item_url_statement) {
+		tracker_sparql_statement_bind_int (priv->item_url_statement, "id", id);
+		cursor = tracker_sparql_statement_execute (priv->item_url_statement,
+		                                           NULL, NULL);
+	}
 
 	g_debug ("--8<------------------------------");
 	g_debug ("The information relevant for a bug report is between "
@@ -367,7 +386,7 @@ decorator_commit_cb (GObject      *object,
 				continue;
 
 			decorator_blacklist_add (decorator, update->id);
-			item_warn (conn, update->id, update->sparql, child_error);
+			item_warn (decorator, conn, update->id, update->sparql, child_error);
 		}
 
 		g_ptr_array_unref (errors);
@@ -508,15 +527,63 @@ decorator_finish (TrackerDecorator *decorator)
 	decorator_update_state (decorator, "Idle", FALSE);
 }
 
+static guint
+decorator_get_n_groups (TrackerDecorator *decorator)
+{
+	TrackerDecoratorPrivate *priv = decorator->priv;
+	ClassInfo *prev = NULL, *cur;
+	guint i, n_groups = 0;
+
+	for (i = 0; i < priv->classes->len; i++) {
+		cur = &g_array_index (priv->classes, ClassInfo, i);
+
+		if (!prev || prev->priority != cur->priority)
+			n_groups++;
+
+		prev = cur;
+	}
+
+	return n_groups;
+}
+
+/* Makes items with tracker:id above @id be looked at again */
+static void
+decorator_rewind (TrackerDecorator *decorator,
+                  gint              id)
+{
+	TrackerDecoratorPrivate *priv = decorator->priv;
+	guint i, n_groups;
+
+	n_groups = decorator_get_n_groups (decorator);
+
+	if (priv->group_positions->len != n_groups) {
+		/* Groups changed, start over */
+		g_array_set_size (priv->group_positions, 0);
+		g_array_set_size (priv->group_positions, n_groups);
+	}
+
+	for (i = 0; i < priv->group_positions->len; i++) {
+		gint *position = &g_array_index (priv->group_positions, gint, i);
+
+		*position = MIN (*position, id);
+	}
+
+	priv->query_group = 0;
+}
+
 static void
 decorator_rebuild_cache (TrackerDecorator *decorator)
 {
 	TrackerDecoratorPrivate *priv = decorator->priv;
+	TrackerDecoratorInfo *info;
 
 	priv->n_remaining_items = 0;
-	g_queue_foreach (&priv->item_cache,
-	                 (GFunc) tracker_decorator_info_unref, NULL);
-	g_queue_clear (&priv->item_cache);
+
+	/* Cached items go back to the pending set */
+	while ((info = g_queue_pop_head (&priv->item_cache)) != NULL) {
+		decorator_rewind (decorator, info->id - 1);
+		tracker_decorator_info_unref (info);
+	}
 
         decorator_cache_next_items (decorator);
 }
@@ -588,7 +655,7 @@ decorator_cancel_active_tasks (TrackerDecorator *decorator)
 
 	g_hash_table_iter_init (&iter, priv->tasks);
 
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer*) &task)) {
+	while (g_hash_table_iter_next (&iter, (gpointer*) &task, NULL)) {
 		g_cancellable_cancel (g_task_get_cancellable (task));
 	}
 
@@ -605,28 +672,6 @@ query_append_id (GString *string,
 	g_string_append_printf (string, "%d", id);
 }
 
-static void
-query_add_blacklisted_filter (TrackerDecorator *decorator,
-                              GString          *query)
-{
-	TrackerDecoratorPrivate *priv = decorator->priv;
-	GSequenceIter *iter;
-
-	if (g_sequence_get_length (priv->blacklist_items) == 0)
-		return;
-
-	g_string_append (query, "&& tracker:id(?urn) NOT IN (");
-
-	iter = g_sequence_get_begin_iter (priv->blacklist_items);
-
-	while (!g_sequence_iter_is_end (iter)) {
-		query_append_id (query, GPOINTER_TO_INT (g_sequence_get (iter)));
-		iter = g_sequence_iter_next (iter);
-	}
-
-	g_string_append (query, ")");
-}
-
 static void
 query_add_update_buffer_ids (GString *query,
                              GArray  *commit_buffer)
@@ -688,8 +733,8 @@ query_append_current_tasks_filter (TrackerDecorator *decorator,
 {
 	TrackerDecoratorPrivate *priv = decorator->priv;
 	GHashTableIter iter;
-	gint i = 0, id;
-	GTask *task;
+	gint i = 0;
+	gpointer id;
 
 	if (g_hash_table_size (priv->tasks) == 0)
 		return;
@@ -697,27 +742,33 @@ query_append_current_tasks_filter (TrackerDecorator *decorator,
 	g_string_append (query, "&& tracker:id(?urn) NOT IN (");
 	g_hash_table_iter_init (&iter, priv->tasks);
 
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &task)) {
+	while (g_hash_table_iter_next (&iter, NULL, &id)) {
 		if (i != 0)
 			g_string_append (query, ",");
 
-		id = GPOINTER_TO_INT (g_task_get_task_data (task));
-		g_string_append_printf (query, "%d", id);
+		g_string_append_printf (query, "%d", GPOINTER_TO_INT (id));
 		i++;
 	}
 
 	g_string_append (query, ")");
 }
 
+/* Without @for_prepended, only items past the position of the
+ * priority group are considered, so the query only has to walk
+ * the tracker:id index from there, no matter how many items were
+ * blacklisted below it. @group is -1 to query all groups.
+ */
 static gchar *
 create_query_string (TrackerDecorator  *decorator,
                      gchar            **select_clauses,
-                     gboolean           for_prepended)
+                     gboolean           for_prepended,
+                     gint               group)
 {
 	TrackerDecoratorPrivate *priv = decorator->priv;
 	ClassInfo *prev = NULL, *cur;
+	gboolean first = TRUE;
 	GString *query;
-	gint i;
+	gint i, cur_group = -1;
 
 	query = g_string_new ("SELECT ");
 
@@ -731,9 +782,17 @@ create_query_string (TrackerDecorator  *decorator,
 		cur = &g_array_index (priv->classes, ClassInfo, i);
 
 		if (!prev || prev->priority != cur->priority) {
-			if (prev)
+			cur_group++;
+			prev = cur;
+
+			if (group >= 0 && cur_group != group)
+				continue;
+
+			if (!first)
 				g_string_append (query, "))} UNION ");
 
+			first = FALSE;
+
 			g_string_append_printf (query,
 			                        "{ ?urn a rdfs:Resource;"
 			                        "       a ?type ;"
@@ -741,31 +800,53 @@ create_query_string (TrackerDecorator  *decorator,
 			                        "  FILTER (! EXISTS { ?urn nie:dataSource <%s> } ",
 			                        priv->data_source);
 
-			query_add_blacklisted_filter (decorator, query);
-			query_add_processing_filter (decorator, query);
-
-			if (for_prepended && priv->prepended_ids->len > 0) {
+			if (for_prepended) {
 				query_add_id_filter (query, priv->prepended_ids);
-				g_array_set_size (priv->prepended_ids, 0);
+			} else {
+				g_string_append_printf (query, "&& tracker:id(?urn) > %d ",
+				                        g_array_index (priv->group_positions, gint, cur_group));
+			}
+
+			if (group < 0 && !for_prepended) {
+				/* Items being processed may be behind the positions,
+				 * only the count needs to leave them out.
+				 */
+				query_add_processing_filter (decorator, query);
+				query_append_current_tasks_filter (decorator, query);
 			}
 
-			query_append_current_tasks_filter (decorator, query);
 			g_string_append (query, " && ?type IN (");
 		} else {
+			prev = cur;
+
+			if (group >= 0 && cur_group != group)
+				continue;
+
 			g_string_append (query, ",");
 		}
 
 		g_string_append_printf (query, "%s", cur->class_name);
-		prev = cur;
 	}
 
-	g_string_append_printf (query, "))}}} LIMIT %d", QUERY_BATCH_SIZE);
+	if (group >= 0 || for_prepended) {
+		g_string_append_printf (query,
+		                        "))}} ORDER BY tracker:id(?urn) LIMIT %d} "
+		                        "ORDER BY tracker:id(?urn)",
+		                        QUERY_BATCH_SIZE);
+	} else {
+		g_string_append (query, "))}}}");
+	}
+
+	if (for_prepended)
+		g_array_set_size (priv->prepended_ids, 0);
 
 	return g_string_free (query, FALSE);
 }
 
+/* A @group of -1 fetches the prepended IDs */
 static gchar *
-create_remaining_items_query (TrackerDecorator *decorator)
+create_remaining_items_query (TrackerDecorator *decorator,
+                              gint              group)
 {
 	gchar *clauses[] = {
 		"?urn",
@@ -775,7 +856,35 @@ create_remaining_items_query (TrackerDecorator *decorator)
 		NULL
 	};
 
-	return create_query_string (decorator, clauses, TRUE);
+	return create_query_string (decorator, clauses, group < 0, group);
+}
+
+/* Blacklisted items are left out of the count on this side, the
+ * blacklist can grow too large to be a filter in the query. The
+ * group of a blacklisted item is not known here, only those past
+ * the positions of all groups are sure to have been counted.
+ */
+static gint
+decorator_count_blacklisted_pending (TrackerDecorator *decorator)
+{
+	TrackerDecoratorPrivate *priv = decorator->priv;
+	GSequenceIter *iter;
+	gint position = 0;
+	guint i;
+
+	for (i = 0; i < priv->group_positions->len; i++) {
+		position = MAX (position,
+		                g_array_index (priv->group_positions, gint, i));
+	}
+
+	/* First blacklisted item above the position */
+	iter = g_sequence_search (priv->blacklist_items,
+	                          GINT_TO_POINTER (position),
+	                          sequence_compare_func,
+	                          NULL);
+
+	return g_sequence_get_length (priv->blacklist_items) -
+		g_sequence_iter_get_position (iter);
 }
 
 static void
@@ -800,7 +909,8 @@ decorator_query_remaining_items_cb (GObject      *object,
 	}
 
 	priv->n_remaining_items = g_queue_get_length (&priv->item_cache) +
-		tracker_sparql_cursor_get_integer (cursor, 0);
+		MAX (0, tracker_sparql_cursor_get_integer (cursor, 0) -
+		     decorator_count_blacklisted_pending (decorator));
 	g_object_unref (cursor);
 
 	g_debug ("Found %ld items to extract", priv->n_remaining_items);
@@ -814,10 +924,12 @@ decorator_query_remaining_items_cb (GObject      *object,
 static void
 decorator_query_remaining_items (TrackerDecorator *decorator)
 {
+	TrackerDecoratorPrivate *priv = decorator->priv;
 	gchar *query, *clauses[] = { "COUNT(?urn)", NULL };
 	TrackerSparqlConnection *sparql_conn;
 
-	query = create_query_string (decorator, clauses, FALSE);
+	priv->query_group = 0;
+	query = create_query_string (decorator, clauses, FALSE, -1);
 
 	if (query) {
 		sparql_conn = tracker_miner_get_connection (TRACKER_MINER (decorator));
@@ -850,7 +962,7 @@ decorator_pair_tasks (TrackerDecorator *decorator)
 		g_object_unref (task);
 
 		/* Store the decorator-side task in the active task pool */
-		g_hash_table_add (priv->tasks, info->task);
+		g_hash_table_insert (priv->tasks, info->task, GINT_TO_POINTER (info->id));
 	}
 }
 
@@ -873,6 +985,57 @@ decorator_item_cache_remove (TrackerDecorator *decorator,
 	}
 }
 
+static gboolean
+decorator_update_buffer_has_id (GArray *buffer,
+                                gint    id)
+{
+	guint i;
+
+	if (!buffer)
+		return FALSE;
+
+	for (i = 0; i < buffer->len; i++) {
+		if (g_array_index (buffer, SparqlUpdate, i).id == id)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Whether @id is blacklisted or anywhere between the item cache
+ * and the store, rewinding may page through such items again.
+ */
+static gboolean
+decorator_has_id (TrackerDecorator *decorator,
+                  gint              id)
+{
+	TrackerDecoratorPrivate *priv = decorator->priv;
+	GHashTableIter iter;
+	gpointer task_id;
+	GList *item;
+
+	if (g_sequence_lookup (priv->blacklist_items, GINT_TO_POINTER (id),
+	                       sequence_compare_func, NULL))
+		return TRUE;
+
+	for (item = g_queue_peek_head_link (&priv->item_cache); item; item = item->next) {
+		TrackerDecoratorInfo *info = item->data;
+
+		if (info->id == id)
+			return TRUE;
+	}
+
+	g_hash_table_iter_init (&iter, priv->tasks);
+
+	while (g_hash_table_iter_next (&iter, NULL, &task_id)) {
+		if (GPOINTER_TO_INT (task_id) == id)
+			return TRUE;
+	}
+
+	return (decorator_update_buffer_has_id (priv->sparql_buffer, id) ||
+	        decorator_update_buffer_has_id (priv->commit_buffer, id));
+}
+
 static void
 decorator_cache_items_cb (GObject      *object,
                           GAsyncResult *result,
@@ -884,6 +1047,7 @@ decorator_cache_items_cb (GObject      *object,
 	TrackerSparqlCursor *cursor;
 	TrackerDecoratorInfo *info;
 	GError *error = NULL;
+	gint n_rows = 0, id;
 
 	conn = TRACKER_SPARQL_CONNECTION (object);
 	cursor = tracker_sparql_connection_query_finish (conn, result, &error);
@@ -895,9 +1059,37 @@ decorator_cache_items_cb (GObject      *object,
 		g_error_free (error);
 	} else {
 		while (tracker_sparql_cursor_next (cursor, NULL, NULL)) {
+			id = tracker_sparql_cursor_get_integer (cursor, 1);
+			n_rows++;
+
+			if (priv->querying_group >= 0 &&
+			    priv->querying_group < priv->group_positions->len) {
+				gint *position;
+
+				position = &g_array_index (priv->group_positions, gint,
+				                           priv->querying_group);
+				*position = MAX (*position, id);
+			}
+
+			if (decorator_has_id (decorator, id))
+				continue;
+
 			info = tracker_decorator_info_new (decorator, cursor);
 			g_queue_push_tail (&priv->item_cache, info);
 		}
+
+		/* A short page means the group is done with */
+		if (priv->querying_group >= 0 && n_rows < QUERY_BATCH_SIZE)
+			priv->query_group = MAX (priv->query_group, priv->querying_group + 1);
+
+		/* Everything in this page was skipped, look further */
+		if (g_queue_is_empty (&priv->item_cache) &&
+		    (priv->querying_group < 0 || n_rows == QUERY_BATCH_SIZE ||
+		     priv->query_group < priv->group_positions->len)) {
+			g_object_unref (cursor);
+			decorator_cache_next_items (decorator);
+			return;
+		}
 	}
 
 	if (!g_queue_is_empty (&priv->item_cache) && !priv->processing) {
@@ -920,16 +1112,28 @@ decorator_cache_next_items (TrackerDecorator *decorator)
 	    !g_queue_is_empty (&priv->item_cache))
 		return;
 
-        priv->querying = TRUE;
-
 	if (priv->n_remaining_items == 0) {
+		priv->querying = TRUE;
 		decorator_query_remaining_items (decorator);
 	} else {
 		TrackerSparqlConnection *sparql_conn;
 		gchar *query;
 
+		if (priv->prepended_ids->len > 0) {
+			priv->querying_group = -1;
+		} else if (priv->query_group < priv->group_positions->len) {
+			priv->querying_group = priv->query_group;
+		} else {
+			/* All groups were paged through */
+			if (priv->processing)
+				decorator_finish (decorator);
+			return;
+		}
+
+		priv->querying = TRUE;
+
 		sparql_conn = tracker_miner_get_connection (TRACKER_MINER (decorator));
-		query = create_remaining_items_query (decorator);
+		query = create_remaining_items_query (decorator, priv->querying_group);
 		tracker_sparql_connection_query_async (sparql_conn, query,
 						       NULL, decorator_cache_items_cb,
 						       decorator);
@@ -1019,6 +1223,7 @@ decorator_set_classes (TrackerDecorator  *decorator,
 		decorator_add_class (decorator, classes[i]);
 	}
 
+	decorator_rewind (decorator, 0);
 	update_notifier (decorator);
 }
 
@@ -1073,6 +1278,7 @@ notifier_events_cb (TrackerDecorator *decorator,
 			/* Merely use this as a hint that there is something
 			 * left to be processed.
 			 */
+			decorator_rewind (decorator, id - 1);
 			check_added = TRUE;
 			break;
 		case TRACKER_NOTIFIER_EVENT_DELETE:
@@ -1135,6 +1341,7 @@ tracker_decorator_finalize (GObject *object)
 	priv = decorator->priv;
 
 	g_clear_object (&priv->notifier);
+	g_clear_object (&priv->item_url_statement);
 
 	g_queue_foreach (&priv->item_cache,
 	                 (GFunc) tracker_decorator_info_unref,
@@ -1148,6 +1355,7 @@ tracker_decorator_finalize (GObject *object)
 	g_hash_table_destroy (priv->tasks);
 	g_array_unref (priv->classes);
 	g_array_unref (priv->prepended_ids);
+	g_array_unref (priv->group_positions);
 	g_clear_pointer (&priv->sparql_buffer, (GDestroyNotify) g_array_unref);
 	g_clear_pointer (&priv->commit_buffer, (GDestroyNotify) g_array_unref);
 	g_sequence_free (priv->blacklist_items);
@@ -1300,6 +1508,7 @@ tracker_decorator_init (TrackerDecorator *decorator)
 	g_array_set_clear_func (priv->classes, (GDestroyNotify) class_info_clear);
 	priv->blacklist_items = g_sequence_new (NULL);
 	priv->prepended_ids = g_array_new (FALSE, FALSE, sizeof (gint));
+	priv->group_positions = g_array_new (FALSE, TRUE, sizeof (gint));
 	priv->batch_size = DEFAULT_BATCH_SIZE;
 	priv->timer = g_timer_new ();
 
@@ -1569,6 +1778,7 @@ tracker_decorator_set_priority_rdf_types (TrackerDecorator    *decorator,
 	}
 
 	g_array_sort (priv->classes, (GCompareFunc) class_compare_func);
+	decorator_rewind (decorator, 0);
 	decorator_rebuild_cache (decorator);
 }
 
@@ -1683,5 +1893,6 @@ tracker_decorator_info_get_sparql (TrackerDecoratorInfo *info)
 void
 _tracker_decorator_invalidate_cache (TrackerDecorator *decorator)
 {
+	decorator_rewind (decorator, 0);
 	decorator_rebuild_cache (decorator);
 }
@@ -36,6 +36,9 @@ static gboolean force_check_updated = FALSE;
 
 #define MAX_DEPTH 1
 
+/* Files looked up per execution of the files statement */
+#define FILES_QUERY_BATCH_SIZE 100
+
 enum {
 	PROP_0,
 	PROP_INDEXING_TREE,
@@ -75,6 +78,11 @@ typedef struct {
 	TrackerSparqlConnection *connection;
 	GCancellable *cancellable;
 
+	/* Prepared statements for the per-file/directory lookups */
+	TrackerSparqlStatement *contents_statement;
+	TrackerSparqlStatement *file_iri_statement;
+	TrackerSparqlStatement *files_statement;
+
 	TrackerCrawler *crawler;
 	TrackerMonitor *monitor;
 	TrackerDataProvider *data_provider;
@@ -101,6 +109,8 @@ typedef struct {
 typedef struct {
 	TrackerFileNotifier *notifier;
 	gint max_depth;
+	GPtrArray *files;
+	guint offset;
 } SparqlStartData;
 
 static gboolean crawl_directories_start (TrackerFileNotifier *notifier);
@@ -776,7 +786,7 @@ sparql_contents_query_cb (GObject      *object,
 	TrackerSparqlCursor *cursor;
 	GError *error = NULL;
 
-	cursor = tracker_sparql_connection_query_finish (TRACKER_SPARQL_CONNECTION (object),
+	cursor = tracker_sparql_statement_execute_finish (TRACKER_SPARQL_STATEMENT (object),
 	                                                 result, &error);
 	if (error) {
 		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
@@ -799,56 +809,71 @@ out:
 	}
 }
 
-static gchar *
-sparql_contents_compose_query (GFile **directories,
-                               guint   n_dirs)
+static void
+sparql_contents_query_start (TrackerFileNotifier *notifier,
+                             GFile               *directory)
 {
-	GString *str;
+	TrackerFileNotifierPrivate *priv;
 	gchar *uri;
-	gint i;
-	gboolean first = TRUE;
-
-	str = g_string_new ("SELECT nie:url(?u) ?u nfo:fileLastModified(?u) "
-	                    "       IF (nie:mimeType(?u) = \"inode/directory\", true, false) {"
-			    " ?u nfo:belongsToContainer ?f . ?f nie:url ?url ."
-			    " FILTER (?url IN (");
-	for (i = 0; i < n_dirs; i++) {
-		if (!first) {
-			g_string_append_c (str, ',');
-		}
 
-		first = FALSE;
-		uri = g_file_get_uri (directories[i]);
-		g_string_append_printf (str, "\"%s\"", uri);
-		g_free (uri);
+	priv = notifier->priv;
+
+	if (G_UNLIKELY (priv->contents_statement == NULL)) {
+		return;
 	}
 
-	g_string_append (str, "))}");
+	uri = g_file_get_uri (directory);
+	tracker_sparql_statement_bind_string (priv->contents_statement, "url", uri);
+	g_free (uri);
 
-	return g_string_free (str, FALSE);
+	tracker_sparql_statement_execute_async (priv->contents_statement,
+	                                        priv->cancellable,
+	                                        sparql_contents_query_cb,
+	                                        notifier);
 }
 
 static void
-sparql_contents_query_start (TrackerFileNotifier  *notifier,
-                             GFile               **directories,
-                             guint                 n_dirs)
+sparql_start_data_free (SparqlStartData *data)
+{
+	g_ptr_array_unref (data->files);
+	g_free (data);
+}
+
+static void sparql_files_query_cb (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data);
+
+static void
+sparql_files_query_next (SparqlStartData *data)
 {
 	TrackerFileNotifierPrivate *priv;
-	gchar *sparql;
+	gint i;
 
-	priv = notifier->priv;
+	priv = data->notifier->priv;
 
-	if (G_UNLIKELY (priv->connection == NULL)) {
-		return;
+	for (i = 0; i < FILES_QUERY_BATCH_SIZE; i++) {
+		gchar *name, *uri;
+		GFile *file;
+
+		/* The last batch repeats its last file, so all executions
+		 * share the same statement.
+		 */
+		file = g_ptr_array_index (data->files,
+		                          MIN (data->offset + i, data->files->len - 1));
+
+		name = g_strdup_printf ("url%d", i);
+		uri = g_file_get_uri (file);
+		tracker_sparql_statement_bind_string (priv->files_statement, name, uri);
+		g_free (name);
+		g_free (uri);
 	}
 
-	sparql = sparql_contents_compose_query (directories, n_dirs);
-	tracker_sparql_connection_query_async (priv->connection,
-	                                       sparql,
-	                                       priv->cancellable,
-	                                       sparql_contents_query_cb,
-	                                       notifier);
-	g_free (sparql);
+	data->offset += FILES_QUERY_BATCH_SIZE;
+
+	tracker_sparql_statement_execute_async (priv->files_statement,
+	                                        priv->cancellable,
+	                                        sparql_files_query_cb,
+	                                        data);
 }
 
 /* Query for file information, used on all elements found during crawling */
@@ -868,7 +893,7 @@ sparql_files_query_cb (GObject      *object,
 	notifier = data->notifier;
 	priv = notifier->priv;
 
-	cursor = tracker_sparql_connection_query_finish (TRACKER_SPARQL_CONNECTION (object),
+	cursor = tracker_sparql_statement_execute_finish (TRACKER_SPARQL_STATEMENT (object),
 	                                                 result, &error);
 	if (error) {
 		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
@@ -883,6 +908,11 @@ sparql_files_query_cb (GObject      *object,
 		g_object_unref (cursor);
 	}
 
+	if (data->offset < data->files->len) {
+		sparql_files_query_next (data);
+		return;
+	}
+
 	file_notifier_traverse_tree (notifier, data->max_depth);
 	directory = priv->current_index_root->current_dir;
 	flags = priv->current_index_root->flags;
@@ -896,7 +926,7 @@ sparql_files_query_cb (GObject      *object,
 		 * must check the contents in the store to handle contents
 		 * having been deleted in the directory.
 		 */
-		sparql_contents_query_start (notifier, &directory, 1);
+		sparql_contents_query_start (notifier, directory);
 	} else {
 		finish_current_directory (notifier, FALSE);
 	}
@@ -905,27 +935,23 @@ out:
 	if (error) {
 	        g_error_free (error);
 	}
-	g_free (data);
+	sparql_start_data_free (data);
 }
 
 static gchar *
-sparql_files_compose_query (GFile **files,
-			    guint   n_files)
+sparql_files_compose_query (void)
 {
 	GString *str;
-	gchar *uri;
-	gint i = 0;
+	gint i;
 
 	str = g_string_new ("SELECT ?url ?u nfo:fileLastModified(?u) {"
 			    "  ?u a rdfs:Resource ; nie:url ?url . "
 			    "FILTER (?url IN (");
-	for (i = 0; i < n_files; i++) {
+	for (i = 0; i < FILES_QUERY_BATCH_SIZE; i++) {
 		if (i != 0)
 			g_string_append_c (str, ',');
 
-		uri = g_file_get_uri (files[i]);
-		g_string_append_printf (str, "\"%s\"", uri);
-		g_free (uri);
+		g_string_append_printf (str, "~url%d", i);
 	}
 
 	g_string_append (str, "))}");
@@ -940,25 +966,24 @@ sparql_files_query_start (TrackerFileNotifier  *notifier,
                           gint                  max_depth)
 {
 	TrackerFileNotifierPrivate *priv;
-	gchar *sparql;
-	SparqlStartData *data = g_new (SparqlStartData, 1);
-
-	data->notifier = notifier;
-	data->max_depth = max_depth;
+	SparqlStartData *data;
+	guint i;
 
 	priv = notifier->priv;
 
-	if (G_UNLIKELY (priv->connection == NULL)) {
+	if (G_UNLIKELY (priv->files_statement == NULL)) {
 		return;
 	}
 
-	sparql = sparql_files_compose_query (files, n_files);
-	tracker_sparql_connection_query_async (priv->connection,
-	                                       sparql,
-	                                       priv->cancellable,
-	                                       sparql_files_query_cb,
-	                                       data);
-	g_free (sparql);
+	data = g_new0 (SparqlStartData, 1);
+	data->notifier = notifier;
+	data->max_depth = max_depth;
+	data->files = g_ptr_array_new_full (n_files, g_object_unref);
+
+	for (i = 0; i < n_files; i++)
+		g_ptr_array_add (data->files, g_object_ref (files[i]));
+
+	sparql_files_query_next (data);
 }
 
 static gboolean
@@ -1619,6 +1644,9 @@ tracker_file_notifier_finalize (GObject *object)
 	g_object_unref (priv->crawler);
 	g_object_unref (priv->monitor);
 	g_object_unref (priv->file_system);
+	g_clear_object (&priv->contents_statement);
+	g_clear_object (&priv->file_iri_statement);
+	g_clear_object (&priv->files_statement);
 	g_clear_object (&priv->connection);
 
 	if (priv->current_index_root)
@@ -1811,6 +1839,38 @@ tracker_file_notifier_init (TrackerFileNotifier *notifier)
 		g_warning ("Could not get SPARQL connection: %s\n",
 		           error->message);
 		g_error_free (error);
+	} else {
+		priv->contents_statement =
+			tracker_sparql_connection_query_statement (priv->connection,
+			                                           "SELECT nie:url(?u) ?u nfo:fileLastModified(?u) "
+			                                           "       IF (nie:mimeType(?u) = \"inode/directory\", true, false) {"
+			                                           " ?u nfo:belongsToContainer ?f . ?f nie:url ~url"
+			                                           "}",
+			                                           NULL, &error);
+		if (!error) {
+			priv->file_iri_statement =
+				tracker_sparql_connection_query_statement (priv->connection,
+				                                           "SELECT ?u {"
+				                                           "  ?u a rdfs:Resource ; nie:url ~url "
+				                                           "}",
+				                                           NULL, &error);
+		}
+		if (!error) {
+			gchar *sparql;
+
+			sparql = sparql_files_compose_query ();
+			priv->files_statement =
+				tracker_sparql_connection_query_statement (priv->connection,
+				                                           sparql,
+				                                           NULL, &error);
+			g_free (sparql);
+		}
+
+		if (error) {
+			g_warning ("Could not prepare SPARQL statements: %s\n",
+			           error->message);
+			g_error_free (error);
+		}
 	}
 
 	priv->timer = g_timer_new ();
@@ -1946,17 +2006,18 @@ tracker_file_notifier_get_file_iri (TrackerFileNotifier *notifier,
 		force = TRUE;
 	}
 
-	if (!iri && force) {
+	if (!iri && force && priv->file_iri_statement) {
 		TrackerSparqlCursor *cursor;
 		const gchar *str;
-		gchar *sparql;
+		gchar *uri;
 
 		/* Fetch data for this file synchronously */
-		sparql = sparql_files_compose_query (&file, 1);
-		cursor = tracker_sparql_connection_query (priv->connection,
-		                                          sparql, NULL, NULL);
-		g_free (sparql);
+		uri = g_file_get_uri (file);
+		tracker_sparql_statement_bind_string (priv->file_iri_statement, "url", uri);
+		g_free (uri);
 
+		cursor = tracker_sparql_statement_execute (priv->file_iri_statement,
+		                                           NULL, NULL);
 		if (!cursor)
 			return NULL;
 
@@ -1965,7 +2026,7 @@ tracker_file_notifier_get_file_iri (TrackerFileNotifier *notifier,
 			return NULL;
 		}
 
-		str = tracker_sparql_cursor_get_string (cursor, 1, NULL);
+		str = tracker_sparql_cursor_get_string (cursor, 0, NULL);
 		iri = g_strdup (str);
 		tracker_file_system_set_property (priv->file_system, canonical,
 		                                  quark_property_iri, iri);
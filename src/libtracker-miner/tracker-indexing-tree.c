@@ -19,6 +19,8 @@
  * Author: Carlos Garnacho  <carlos@lanedo.com>
  */
 
+#include <string.h>
+
 #include <libtracker-common/tracker-file-utils.h>
 #include "tracker-indexing-tree.h"
 
@@ -35,6 +37,8 @@ G_DEFINE_TYPE (TrackerIndexingTree, tracker_indexing_tree, G_TYPE_OBJECT)
 typedef struct _TrackerIndexingTreePrivate TrackerIndexingTreePrivate;
 typedef struct _NodeData NodeData;
 typedef struct _PatternData PatternData;
+typedef struct _FilterTrie FilterTrie;
+typedef struct _FilterMatcher FilterMatcher;
 typedef struct _FindNodeData FindNodeData;
 
 struct _NodeData
@@ -47,11 +51,37 @@ struct _NodeData
 
 struct _PatternData
 {
+	gchar *glob_string;
 	GPatternSpec *pattern;
 	TrackerFilterType type;
 	GFile *file; /* Only filled in in absolute paths */
 };
 
+/* Byte trie of the literal part of "foo*" and "*foo" globs, the
+ * latter are stored reversed.
+ */
+struct _FilterTrie
+{
+	guchar byte;
+	guint terminal : 1;
+	FilterTrie *children;
+	FilterTrie *next;
+};
+
+/* All filters of a type compiled together, so checking a basename
+ * costs about the same with a few filters as with hundreds.
+ */
+struct _FilterMatcher
+{
+	GHashTable *basenames; /* globs without wildcards */
+	FilterTrie *prefixes;
+	FilterTrie *suffixes;
+	GList *patterns; /* GPatternSpec, any other glob */
+	GList *files; /* GFile, absolute paths */
+	guint match_all : 1;
+	guint match_basename : 1;
+};
+
 struct _FindNodeData
 {
 	GEqualFunc func;
@@ -64,6 +94,8 @@ struct _TrackerIndexingTreePrivate
 	GNode *config_tree;
 	GList *filter_patterns;
 	TrackerFilterPolicy policies[TRACKER_FILTER_PARENT_DIRECTORY + 1];
+	/* Built on demand, NULL after the filters change */
+	FilterMatcher *matchers[TRACKER_FILTER_PARENT_DIRECTORY + 1];
 
 	GFile *root;
 	guint filter_hidden : 1;
@@ -120,6 +152,7 @@ pattern_data_new (const gchar *glob_string,
 	PatternData *data;
 
 	data = g_slice_new0 (PatternData);
+	data->glob_string = g_strdup (glob_string);
 	data->pattern = g_pattern_spec_new (glob_string);
 	data->type = type;
 
@@ -138,9 +171,199 @@ pattern_data_free (PatternData *data)
 	}
 
 	g_pattern_spec_free (data->pattern);
+	g_free (data->glob_string);
 	g_slice_free (PatternData, data);
 }
 
+static void
+filter_trie_free (FilterTrie *trie)
+{
+	while (trie) {
+		FilterTrie *next = trie->next;
+
+		filter_trie_free (trie->children);
+		g_slice_free (FilterTrie, trie);
+		trie = next;
+	}
+}
+
+static void
+filter_trie_insert (FilterTrie   **trie,
+                    const guchar  *str,
+                    gssize         len,
+                    gboolean       reversed)
+{
+	gssize i;
+
+	for (i = 0; i < len; i++) {
+		guchar byte = reversed ? str[len - 1 - i] : str[i];
+		FilterTrie *node;
+
+		for (node = *trie; node; node = node->next) {
+			if (node->byte == byte)
+				break;
+		}
+
+		if (!node) {
+			node = g_slice_new0 (FilterTrie);
+			node->byte = byte;
+			node->next = *trie;
+			*trie = node;
+		}
+
+		if (i == len - 1) {
+			node->terminal = TRUE;
+		}
+
+		trie = &node->children;
+	}
+}
+
+/* Returns %TRUE if a string in @trie is a prefix of @str (or a
+ * suffix if @reversed)
+ */
+static gboolean
+filter_trie_match (FilterTrie   *trie,
+                   const guchar *str,
+                   gsize         len,
+                   gboolean      reversed)
+{
+	gsize i;
+
+	for (i = 0; i < len && trie; i++) {
+		guchar byte = reversed ? str[len - 1 - i] : str[i];
+
+		while (trie && trie->byte != byte) {
+			trie = trie->next;
+		}
+
+		if (!trie) {
+			return FALSE;
+		} else if (trie->terminal) {
+			return TRUE;
+		}
+
+		trie = trie->children;
+	}
+
+	return FALSE;
+}
+
+static void
+filter_matcher_free (FilterMatcher *matcher)
+{
+	g_hash_table_unref (matcher->basenames);
+	filter_trie_free (matcher->prefixes);
+	filter_trie_free (matcher->suffixes);
+	g_list_free (matcher->patterns);
+	g_list_free (matcher->files);
+	g_slice_free (FilterMatcher, matcher);
+}
+
+static FilterMatcher *
+filter_matcher_new (GList             *filter_patterns,
+                    TrackerFilterType  type)
+{
+	FilterMatcher *matcher;
+	GList *l;
+
+	matcher = g_slice_new0 (FilterMatcher);
+	matcher->basenames = g_hash_table_new (g_str_hash, g_str_equal);
+
+	for (l = filter_patterns; l; l = l->next) {
+		PatternData *data = l->data;
+		const gchar *glob = data->glob_string;
+		const gchar *wildcard;
+		gsize len;
+
+		if (data->type != type)
+			continue;
+
+		if (data->file) {
+			/* Basenames never contain separators, only
+			 * the path can match.
+			 */
+			matcher->files = g_list_prepend (matcher->files, data->file);
+			continue;
+		}
+
+		matcher->match_basename = TRUE;
+		len = strlen (glob);
+		wildcard = strpbrk (glob, "*?");
+
+		if (!wildcard) {
+			g_hash_table_add (matcher->basenames, (gpointer) glob);
+		} else if (strcmp (glob, "*") == 0) {
+			matcher->match_all = TRUE;
+		} else if (wildcard == glob && glob[0] == '*' &&
+		           !strpbrk (glob + 1, "*?")) {
+			filter_trie_insert (&matcher->suffixes,
+			                    (const guchar *) glob + 1, len - 1, TRUE);
+		} else if (wildcard == glob + len - 1 && *wildcard == '*') {
+			filter_trie_insert (&matcher->prefixes,
+			                    (const guchar *) glob, len - 1, FALSE);
+		} else {
+			matcher->patterns = g_list_prepend (matcher->patterns,
+			                                    data->pattern);
+		}
+	}
+
+	return matcher;
+}
+
+static gboolean
+filter_matcher_match (FilterMatcher *matcher,
+                      GFile         *file)
+{
+	gboolean match = FALSE;
+	gchar *basename;
+	gsize len;
+	GList *l;
+
+	for (l = matcher->files; l; l = l->next) {
+		if (g_file_equal (file, l->data) ||
+		    g_file_has_prefix (file, l->data)) {
+			return TRUE;
+		}
+	}
+
+	if (!matcher->match_basename) {
+		return FALSE;
+	} else if (matcher->match_all) {
+		return TRUE;
+	}
+
+	basename = g_file_get_basename (file);
+	len = strlen (basename);
+
+	if (g_hash_table_contains (matcher->basenames, basename) ||
+	    filter_trie_match (matcher->prefixes, (const guchar *) basename, len, FALSE) ||
+	    filter_trie_match (matcher->suffixes, (const guchar *) basename, len, TRUE)) {
+		match = TRUE;
+	}
+
+	for (l = matcher->patterns; l && !match; l = l->next) {
+		match = g_pattern_match (l->data, len, basename, NULL);
+	}
+
+	g_free (basename);
+
+	return match;
+}
+
+static void
+indexing_tree_clear_matchers (TrackerIndexingTreePrivate *priv)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (priv->matchers); i++) {
+		if (priv->matchers[i]) {
+			filter_matcher_free (priv->matchers[i]);
+			priv->matchers[i] = NULL;
+		}
+	}
+}
+
 static void
 tracker_indexing_tree_get_property (GObject    *object,
                                     guint       prop_id,
@@ -222,6 +445,7 @@ tracker_indexing_tree_finalize (GObject *object)
 	tree = TRACKER_INDEXING_TREE (object);
 	priv = tree->priv;
 
+	indexing_tree_clear_matchers (priv);
 	g_list_foreach (priv->filter_patterns, (GFunc) pattern_data_free, NULL);
 	g_list_free (priv->filter_patterns);
 
@@ -702,6 +926,7 @@ tracker_indexing_tree_add_filter (TrackerIndexingTree *tree,
 
 	data = pattern_data_new (glob_string, filter);
 	priv->filter_patterns = g_list_prepend (priv->filter_patterns, data);
+	indexing_tree_clear_matchers (priv);
 }
 
 /**
@@ -721,6 +946,7 @@ tracker_indexing_tree_clear_filters (TrackerIndexingTree *tree,
 	g_return_if_fail (TRACKER_IS_INDEXING_TREE (tree));
 
 	priv = tree->priv;
+	indexing_tree_clear_matchers (priv);
 
 	for (l = priv->filter_patterns; l; l = l->next) {
 		PatternData *data = l->data;
@@ -752,39 +978,17 @@ tracker_indexing_tree_file_matches_filter (TrackerIndexingTree *tree,
                                            GFile               *file)
 {
 	TrackerIndexingTreePrivate *priv;
-	GList *filters;
-	gchar *basename;
 
 	g_return_val_if_fail (TRACKER_IS_INDEXING_TREE (tree), FALSE);
 	g_return_val_if_fail (G_IS_FILE (file), FALSE);
 
 	priv = tree->priv;
-	filters = priv->filter_patterns;
-	basename = g_file_get_basename (file);
-
-	while (filters) {
-		PatternData *data = filters->data;
 
-		filters = filters->next;
-
-		if (data->type != type)
-			continue;
-
-		if (data->file &&
-		    (g_file_equal (file, data->file) ||
-		     g_file_has_prefix (file, data->file))) {
-			g_free (basename);
-			return TRUE;
-		}
-
-		if (g_pattern_match_string (data->pattern, basename)) {
-			g_free (basename);
-			return TRUE;
-		}
+	if (!priv->matchers[type]) {
+		priv->matchers[type] = filter_matcher_new (priv->filter_patterns, type);
 	}
 
-	g_free (basename);
-	return FALSE;
+	return filter_matcher_match (priv->matchers[type], file);
 }
 
 static gboolean
@@ -109,6 +109,24 @@ class Tracker.Sparql.Backend : Connection {
 		}
 	}
 
+	public async override Cursor query_stream_async (string sparql, Cancellable? cancellable = null) throws Sparql.Error, IOError, DBusError, GLib.Error {
+		debug ("%s(): '%s'", Log.METHOD, sparql);
+		if (direct != null) {
+			return yield direct.query_stream_async (sparql, cancellable);
+		} else {
+			return yield bus.query_stream_async (sparql, cancellable);
+		}
+	}
+
+	public override Statement? query_statement (string sparql, Cancellable? cancellable = null) throws Sparql.Error {
+		debug ("%s(): '%s'", Log.METHOD, sparql);
+		if (direct != null) {
+			return direct.query_statement (sparql, cancellable);
+		} else {
+			return bus.query_statement (sparql, cancellable);
+		}
+	}
+
 	public override void update (string sparql, int priority = GLib.Priority.DEFAULT, Cancellable? cancellable = null) throws Sparql.Error, IOError, DBusError, GLib.Error {
 		debug ("%s(priority:%d): '%s'", Log.METHOD, priority, sparql);
 		if (bus == null) {
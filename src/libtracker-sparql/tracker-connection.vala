@@ -272,6 +272,71 @@ public abstract class Tracker.Sparql.Connection : Object {
 	 */
 	public async abstract Cursor query_async (string sparql, Cancellable? cancellable = null) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError;
 
+	/**
+	 * tracker_sparql_connection_query_stream_finish:
+	 * @self: a #TrackerSparqlConnection
+	 * @_res_: a #GAsyncResult with the result of the operation
+	 * @error: #GError for error reporting.
+	 *
+	 * Finishes the asynchronous SPARQL query operation.
+	 *
+	 * Returns: a #TrackerSparqlCursor. On error, #NULL is returned and
+	 * the @error is set accordingly. Call g_object_unref() on the
+	 * returned cursor when no longer needed.
+	 *
+	 * Since: 1.12
+	 */
+
+	/**
+	 * tracker_sparql_connection_query_stream_async:
+	 * @self: a #TrackerSparqlConnection
+	 * @sparql: string containing the SPARQL query
+	 * @cancellable: a #GCancellable used to cancel the operation
+	 * @_callback_: user-defined #GAsyncReadyCallback to be called when
+	 *              asynchronous operation is finished.
+	 * @_user_data_: user-defined data to be passed to @_callback_
+	 *
+	 * Executes asynchronously a SPARQL query, like
+	 * tracker_sparql_connection_query_async(), but the operation finishes
+	 * as soon as results start arriving, and the cursor receives further
+	 * results as it is iterated instead of holding all of them in memory.
+	 * This is best suited to queries returning large amounts of results.
+	 *
+	 * The returned cursor should be iterated with
+	 * tracker_sparql_cursor_next_async(), errors happening while the
+	 * results are produced are reported there. The cursor cannot be
+	 * rewound with tracker_sparql_cursor_rewind().
+	 *
+	 * Since: 1.12
+	 */
+	public async virtual Cursor query_stream_async (string sparql, Cancellable? cancellable = null) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError {
+		return yield query_async (sparql, cancellable);
+	}
+
+	/**
+	 * tracker_sparql_connection_query_statement:
+	 * @self: a #TrackerSparqlConnection
+	 * @sparql: string containing the SPARQL query
+	 * @cancellable: a #GCancellable used to cancel the operation
+	 * @error: #GError for error reporting.
+	 *
+	 * Prepares the given @sparql query as a #TrackerSparqlStatement.
+	 * The query may contain parameterized variables in the form
+	 * <literal>~name</literal>, whose values are set through the
+	 * statement before execution. This is the preferred way of running
+	 * the same query repeatedly with different values.
+	 *
+	 * Returns: a #TrackerSparqlStatement. On error, #NULL is returned
+	 * and the @error is set accordingly. Call g_object_unref() on the
+	 * returned statement when no longer needed.
+	 *
+	 * Since: 1.12
+	 */
+	public virtual Statement? query_statement (string sparql, Cancellable? cancellable = null) throws Sparql.Error {
+		warning ("Interface 'query_statement' not implemented");
+		return null;
+	}
+
 	/**
 	 * tracker_sparql_connection_update:
 	 * @self: a #TrackerSparqlConnection
@@ -334,9 +399,14 @@ public abstract class Tracker.Sparql.Connection : Object {
 	 * @_user_data_: user-defined data to be passed to @_callback_
 	 *
 	 * Executes asynchronously an array of SPARQL updates. Each update in the
-	 * array is its own transaction. This means that update n+1 is not halted
+	 * array is applied on its own. This means that update n+1 is not halted
 	 * due to an error in update n.
 	 *
+	 * Since 1.12 the updates are committed together, an update that fails
+	 * is reverted without affecting the others. This makes
+	 * tracker_sparql_connection_update_array_async() the preferred way to
+	 * write many small updates.
+	 *
 	 * Since: 0.10
 	 */
 
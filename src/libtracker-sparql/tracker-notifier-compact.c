@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "tracker-notifier-compact.h"
+
+static gboolean
+read_varint (const guint8 **data,
+             const guint8  *end,
+             guint32       *value)
+{
+	guint32 result = 0;
+	guint shift = 0;
+
+	while (*data < end && shift < 32) {
+		guint8 byte = *(*data)++;
+
+		result |= (guint32) (byte & 0x7f) << shift;
+
+		if ((byte & 0x80) == 0) {
+			*value = result;
+			return TRUE;
+		}
+
+		shift += 7;
+	}
+
+	return FALSE;
+}
+
+/* Decodes the GraphUpdatedCompact format, as produced by
+ * tracker_events_batch_encode() in tracker-store, calling @func
+ * for each change. Returns %FALSE if @changes is truncated or
+ * otherwise malformed, changes decoded so far have been handed
+ * to @func then.
+ */
+gboolean
+tracker_notifier_compact_foreach (GVariant                   *changes,
+                                  TrackerNotifierCompactFunc  func,
+                                  gpointer                    user_data)
+{
+	const guint8 *data, *end;
+	guint32 subject = 0, delta, count, predicate, object;
+	gsize len;
+	guint i;
+
+	data = g_variant_get_fixed_array (changes, &len, sizeof (guint8));
+	end = data + len;
+
+	while (data < end) {
+		if (!read_varint (&data, end, &delta) ||
+		    !read_varint (&data, end, &count))
+			return FALSE;
+
+		subject += delta;
+		predicate = 0;
+
+		for (i = 0; i < count; i++) {
+			if (!read_varint (&data, end, &delta) ||
+			    !read_varint (&data, end, &object))
+				return FALSE;
+
+			predicate += delta;
+			func (subject, predicate, object, user_data);
+		}
+	}
+
+	return TRUE;
+}
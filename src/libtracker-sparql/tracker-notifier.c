@@ -84,25 +84,70 @@
 
 #include "config.h"
 
+#include <string.h>
+#include <unistd.h>
+
+#include <gio/gunixfdlist.h>
+
 #include "tracker-notifier.h"
+#include "tracker-notifier-compact.h"
+#include "tracker-ontologies.h"
 #include "tracker-sparql-enum-types.h"
 #include "tracker-generated-no-checks.h"
 
 typedef struct _TrackerNotifierPrivate TrackerNotifierPrivate;
 typedef struct _TrackerNotifierEventCache TrackerNotifierEventCache;
+typedef struct _TrackerNotifierRowsFilter TrackerNotifierRowsFilter;
+
+/* Resources whose IDs are needed to tell event types apart */
+enum {
+	ID_RDF_TYPE,
+	ID_NIE_DATA_SOURCE,
+	ID_EXTRACTOR_DATA_SOURCE,
+	N_IDS
+};
+
+static const gchar *id_resources[] = {
+	TRACKER_PREFIX_RDF "type",
+	TRACKER_PREFIX_NIE "dataSource",
+	TRACKER_PREFIX_TRACKER "extractor-data-source",
+	NULL
+};
 
 struct _TrackerNotifierPrivate {
 	TrackerSparqlConnection *connection;
 	GDBusConnection *dbus_connection;
 	TrackerNotifierFlags flags;
-	GHashTable *cached_ids; /* gchar -> gint64* */
 	GHashTable *cached_events; /* gchar -> GSequence */
 	gchar **expanded_classes;
 	gchar **classes;
+	gint64 ids[N_IDS];
 	guint graph_updated_signal_id;
+	guint subscription_id;
+	guint rows_filter_id;
+	TrackerNotifierRowsFilter *rows_filter; /* Owned by the connection */
+	guint store_watch_id;
+	GCancellable *cancellable;
 	guint has_arg0_filter : 1;
+	guint store_vanished : 1;
 };
 
+/* GraphUpdatedRows carries a file descriptor, which signal subscriptions
+ * don't give access to, so those signals are picked from a message filter
+ * in the GDBus worker thread, and handled in the notifier main context.
+ */
+struct _TrackerNotifierRowsFilter {
+	GWeakRef notifier;
+	GMainContext *context;
+	volatile gint subscription_id;
+};
+
+typedef struct {
+	TrackerNotifier *notifier;
+	GVariant *parameters;
+	gint fd;
+} TrackerNotifierRows;
+
 struct _TrackerNotifierEventCache {
 	gchar *class;
 	GSequence *sequence;
@@ -139,28 +184,32 @@ G_DEFINE_TYPE_WITH_CODE (TrackerNotifier, tracker_notifier, G_TYPE_OBJECT,
                          G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE,
                                                 tracker_notifier_initable_iface_init))
 
+/* Only needed if the store didn't give the IDs on subscription */
 static void
-tracker_notifier_cache_id (TrackerNotifier *notifier,
-                           const gchar     *urn)
+tracker_notifier_query_ids (TrackerNotifier *notifier)
 {
 	TrackerSparqlCursor *cursor;
 	TrackerNotifierPrivate *priv;
-	gchar *sparql;
+	GString *sparql;
+	gint i;
 
 	priv = tracker_notifier_get_instance_private (notifier);
-	sparql = g_strdup_printf ("SELECT tracker:id(%s) {}", urn);
-	cursor = tracker_sparql_connection_query (priv->connection, sparql,
+	sparql = g_string_new ("SELECT ");
+
+	for (i = 0; i < N_IDS; i++)
+		g_string_append_printf (sparql, "tracker:id(<%s>) ", id_resources[i]);
+
+	g_string_append (sparql, "{}");
+	cursor = tracker_sparql_connection_query (priv->connection, sparql->str,
 	                                          NULL, NULL);
-	g_free (sparql);
+	g_string_free (sparql, TRUE);
 
 	if (!cursor)
 		return;
 
 	if (tracker_sparql_cursor_next (cursor, NULL, NULL)) {
-		gint64 id = tracker_sparql_cursor_get_integer (cursor, 0);
-		gint64 *ptr = g_memdup (&id, sizeof (gint64));
-
-		g_hash_table_insert (priv->cached_ids, g_strdup (urn), ptr);
+		for (i = 0; i < N_IDS; i++)
+			priv->ids[i] = tracker_sparql_cursor_get_integer (cursor, i);
 	}
 
 	g_object_unref (cursor);
@@ -169,15 +218,13 @@ tracker_notifier_cache_id (TrackerNotifier *notifier,
 static gboolean
 tracker_notifier_id_matches (TrackerNotifier *notifier,
                              gint64           id,
-                             const gchar     *urn)
+                             gint             which)
 {
 	TrackerNotifierPrivate *priv;
-	gint64 *cached_id;
 
 	priv = tracker_notifier_get_instance_private (notifier);
-	cached_id = g_hash_table_lookup (priv->cached_ids, urn);
 
-	return (cached_id && *cached_id == id);
+	return (priv->ids[which] != 0 && priv->ids[which] == id);
 }
 
 static TrackerNotifierEvent *
@@ -290,73 +337,123 @@ tracker_notifier_event_cache_get_event (TrackerNotifierEventCache *cache,
 }
 
 static void
-handle_deletes (TrackerNotifier           *notifier,
-                TrackerNotifierEventCache *cache,
-                GVariantIter              *iter)
+handle_delete (TrackerNotifier           *notifier,
+               TrackerNotifierEventCache *cache,
+               gint                       subject,
+               gint                       predicate,
+               gint                       object)
 {
-	gint graph, subject, predicate, object;
 	TrackerNotifierPrivate *priv;
+	TrackerNotifierEvent *event;
 
 	priv = tracker_notifier_get_instance_private (notifier);
+	event = tracker_notifier_event_cache_get_event (cache, subject);
+
+	if (tracker_notifier_id_matches (notifier, predicate, ID_RDF_TYPE)) {
+		if (event->delayed &&
+		    event->type == TRACKER_NOTIFIER_EVENT_CREATE) {
+			/* This rdf:type was created and dropped,
+			 * restore type to its original unset state so
+			 * it is ignored and freed afterwards.
+			 */
+			event->type = -1;
+		} else {
+			event->type = TRACKER_NOTIFIER_EVENT_DELETE;
+		}
+	} else if (event->type != TRACKER_NOTIFIER_EVENT_DELETE &&
+	           (priv->flags & TRACKER_NOTIFIER_FLAG_NOTIFY_UNEXTRACTED) == 0 &&
+	           tracker_notifier_id_matches (notifier, predicate, ID_NIE_DATA_SOURCE) &&
+	           tracker_notifier_id_matches (notifier, object, ID_EXTRACTOR_DATA_SOURCE)) {
+		event->delayed = TRUE;
+	} else if (event->type < 0) {
+		event->type = TRACKER_NOTIFIER_EVENT_UPDATE;
+	}
+}
 
-	while (g_variant_iter_loop (iter, "(iiii)",
-	                            &graph, &subject, &predicate, &object)) {
-		TrackerNotifierEvent *event;
+static void
+handle_update (TrackerNotifier           *notifier,
+               TrackerNotifierEventCache *cache,
+               gint                       subject,
+               gint                       predicate,
+               gint                       object)
+{
+	TrackerNotifierPrivate *priv;
+	TrackerNotifierEvent *event;
 
-		event = tracker_notifier_event_cache_get_event (cache, subject);
-
-		if (tracker_notifier_id_matches (notifier, predicate, "rdf:type")) {
-			if (event->delayed &&
-			    event->type == TRACKER_NOTIFIER_EVENT_CREATE) {
-				/* This rdf:type was created and dropped,
-				 * restore type to its original unset state so
-				 * it is ignored and freed afterwards.
-				 */
-				event->type = -1;
-			} else {
-				event->type = TRACKER_NOTIFIER_EVENT_DELETE;
-			}
-		} else if (event->type != TRACKER_NOTIFIER_EVENT_DELETE &&
-		           (priv->flags & TRACKER_NOTIFIER_FLAG_NOTIFY_UNEXTRACTED) == 0 &&
-		           tracker_notifier_id_matches (notifier, predicate, "nie:dataSource") &&
-		           tracker_notifier_id_matches (notifier, object, "tracker:extractor-data-source")) {
+	priv = tracker_notifier_get_instance_private (notifier);
+	event = tracker_notifier_event_cache_get_event (cache, subject);
+
+	if (tracker_notifier_id_matches (notifier, predicate, ID_RDF_TYPE)) {
+		event->type = TRACKER_NOTIFIER_EVENT_CREATE;
+
+		if ((priv->flags & TRACKER_NOTIFIER_FLAG_NOTIFY_UNEXTRACTED) == 0)
 			event->delayed = TRUE;
-		} else if (event->type < 0) {
+	} else if (tracker_notifier_id_matches (notifier, predicate, ID_NIE_DATA_SOURCE) &&
+	           tracker_notifier_id_matches (notifier, object, ID_EXTRACTOR_DATA_SOURCE)) {
+		if (event->type < 0)
 			event->type = TRACKER_NOTIFIER_EVENT_UPDATE;
-		}
+		event->delayed = FALSE;
+	} else if (event->type < 0) {
+		event->type = TRACKER_NOTIFIER_EVENT_UPDATE;
 	}
 }
 
 static void
-handle_updates (TrackerNotifier           *notifier,
+handle_deletes (TrackerNotifier           *notifier,
                 TrackerNotifierEventCache *cache,
                 GVariantIter              *iter)
 {
 	gint graph, subject, predicate, object;
-	TrackerNotifierPrivate *priv;
 
-	priv = tracker_notifier_get_instance_private (notifier);
+	while (g_variant_iter_loop (iter, "(iiii)",
+	                            &graph, &subject, &predicate, &object)) {
+		handle_delete (notifier, cache, subject, predicate, object);
+	}
+}
+
+static void
+handle_updates (TrackerNotifier           *notifier,
+                TrackerNotifierEventCache *cache,
+                GVariantIter              *iter)
+{
+	gint graph, subject, predicate, object;
 
 	while (g_variant_iter_loop (iter, "(iiii)",
 	                            &graph, &subject, &predicate, &object)) {
-		TrackerNotifierEvent *event;
+		handle_update (notifier, cache, subject, predicate, object);
+	}
+}
 
-		event = tracker_notifier_event_cache_get_event (cache, subject);
+typedef struct {
+	TrackerNotifier *notifier;
+	TrackerNotifierEventCache *cache;
+	gboolean deletes;
+} CompactChangesData;
 
-		if (tracker_notifier_id_matches (notifier, predicate, "rdf:type")) {
-			event->type = TRACKER_NOTIFIER_EVENT_CREATE;
+static void
+handle_compact_change (guint32  subject,
+                       guint32  predicate,
+                       guint32  object,
+                       gpointer user_data)
+{
+	CompactChangesData *data = user_data;
 
-			if ((priv->flags & TRACKER_NOTIFIER_FLAG_NOTIFY_UNEXTRACTED) == 0)
-				event->delayed = TRUE;
-		} else if (tracker_notifier_id_matches (notifier, predicate, "nie:dataSource") &&
-		           tracker_notifier_id_matches (notifier, object, "tracker:extractor-data-source")) {
-			if (event->type < 0)
-				event->type = TRACKER_NOTIFIER_EVENT_UPDATE;
-			event->delayed = FALSE;
-		} else if (event->type < 0) {
-			event->type = TRACKER_NOTIFIER_EVENT_UPDATE;
-		}
-	}
+	if (data->deletes)
+		handle_delete (data->notifier, data->cache, subject, predicate, object);
+	else
+		handle_update (data->notifier, data->cache, subject, predicate, object);
+}
+
+static void
+handle_compact_changes (TrackerNotifier           *notifier,
+                        TrackerNotifierEventCache *cache,
+                        GVariant                  *changes,
+                        gboolean                   deletes)
+{
+	CompactChangesData data = { notifier, cache, deletes };
+
+	if (!tracker_notifier_compact_foreach (changes, handle_compact_change, &data))
+		g_warning ("Malformed GraphUpdatedCompact payload, ignoring the rest");
 }
 
 static GPtrArray *
@@ -584,6 +681,143 @@ tracker_notifier_query_extra_deleted_info (TrackerNotifier *notifier,
 	g_object_unref (cursor);
 }
 
+static TrackerNotifierEvent *
+find_event_by_id (GPtrArray *events,
+                  gint64     id)
+{
+	TrackerNotifierEvent *event;
+	guint min = 0, max = events->len;
+
+	/* Events are sorted by ID */
+	while (min < max) {
+		guint mid = (min + max) / 2;
+
+		event = g_ptr_array_index (events, mid);
+
+		if (event->id == id)
+			return event;
+		else if (event->id < id)
+			min = mid + 1;
+		else
+			max = mid;
+	}
+
+	return NULL;
+}
+
+/* Rows are packed, so the integers in there may be unaligned */
+static inline gint32
+read_int32 (const gchar *data,
+            gint         index)
+{
+	gint32 value;
+
+	memcpy (&value, data + index * sizeof (gint32), sizeof (gint32));
+	return value;
+}
+
+/* Reads the rows the store wrote for GraphUpdatedRows, each of them being
+ * the column count, the column types, the offsets of the end of each
+ * column string, and the nul-terminated strings. Columns are the resource
+ * ID, its URN and the location if asked for.
+ */
+static void
+tracker_notifier_read_rows (TrackerNotifier *notifier,
+                            GPtrArray       *events,
+                            GMappedFile     *rows)
+{
+	TrackerNotifierPrivate *priv;
+	const gchar *data, *end;
+
+	priv = tracker_notifier_get_instance_private (notifier);
+	data = g_mapped_file_get_contents (rows);
+	end = data + g_mapped_file_get_length (rows);
+
+	while (data < end) {
+		TrackerNotifierEvent *event;
+		const gchar *types, *offsets, *strings;
+		gint32 n_columns, strings_size, offset;
+
+		if (end - data < sizeof (gint32))
+			goto malformed;
+
+		n_columns = read_int32 (data, 0);
+		data += sizeof (gint32);
+
+		if (n_columns < 2 || end - data < 2 * n_columns * sizeof (gint32))
+			goto malformed;
+
+		types = data;
+		offsets = types + n_columns * sizeof (gint32);
+		strings = offsets + n_columns * sizeof (gint32);
+		strings_size = read_int32 (offsets, n_columns - 1) + 1;
+
+		if (strings_size <= 0 || end - strings < strings_size ||
+		    strings[strings_size - 1] != '\0')
+			goto malformed;
+
+		data = strings + strings_size;
+
+		event = find_event_by_id (events, g_ascii_strtoll (strings, NULL, 10));
+		if (!event)
+			continue;
+
+		if (priv->flags & TRACKER_NOTIFIER_FLAG_QUERY_URN) {
+			offset = read_int32 (offsets, 0) + 1;
+			if (offset <= 0 || offset >= strings_size)
+				goto malformed;
+
+			g_free (event->urn);
+			event->urn = g_strdup (strings + offset);
+		}
+
+		if ((priv->flags & TRACKER_NOTIFIER_FLAG_QUERY_LOCATION) &&
+		    n_columns > 2 &&
+		    read_int32 (types, 2) != TRACKER_SPARQL_VALUE_TYPE_UNBOUND) {
+			offset = read_int32 (offsets, 1) + 1;
+			if (offset <= 0 || offset >= strings_size)
+				goto malformed;
+
+			g_free (event->location);
+			event->location = g_strdup (strings + offset);
+		}
+	}
+
+	return;
+
+malformed:
+	g_warning ("Malformed GraphUpdatedRows data, ignoring the rest");
+}
+
+static void
+tracker_notifier_emit_events (TrackerNotifier           *notifier,
+                              TrackerNotifierEventCache *cache,
+                              GMappedFile               *rows)
+{
+	TrackerNotifierPrivate *priv;
+	GPtrArray *events;
+
+	priv = tracker_notifier_get_instance_private (notifier);
+	events = tracker_notifier_event_cache_flush_events (cache);
+
+	if (events) {
+		if (rows) {
+			tracker_notifier_read_rows (notifier, events, rows);
+		} else {
+			if (priv->flags &
+			    (TRACKER_NOTIFIER_FLAG_QUERY_URN |
+			     TRACKER_NOTIFIER_FLAG_QUERY_LOCATION))
+				tracker_notifier_query_extra_info (notifier, events);
+
+			if (priv->flags & TRACKER_NOTIFIER_FLAG_QUERY_URN)
+				tracker_notifier_query_extra_deleted_info (notifier, events);
+		}
+
+		g_signal_emit (notifier, signals[EVENTS], 0, events);
+		g_ptr_array_unref (events);
+	}
+}
+
 static void
 graph_updated_cb (GDBusConnection *connection,
                   const gchar     *sender_name,
@@ -597,7 +831,6 @@ graph_updated_cb (GDBusConnection *connection,
 	TrackerNotifierPrivate *priv;
 	TrackerNotifierEventCache *cache;
 	GVariantIter *deletes, *updates;
-	GPtrArray *events;
 	const gchar *class;
 
 	priv = tracker_notifier_get_instance_private (notifier);
@@ -618,19 +851,362 @@ graph_updated_cb (GDBusConnection *connection,
 	g_variant_iter_free (deletes);
 	g_variant_iter_free (updates);
 
-	events = tracker_notifier_event_cache_flush_events (cache);
-	if (events) {
-		if (priv->flags &
-		    (TRACKER_NOTIFIER_FLAG_QUERY_URN |
-		     TRACKER_NOTIFIER_FLAG_QUERY_LOCATION))
-			tracker_notifier_query_extra_info (notifier, events);
+	tracker_notifier_emit_events (notifier, cache, NULL);
+}
 
-		if (priv->flags & TRACKER_NOTIFIER_FLAG_QUERY_URN)
-			tracker_notifier_query_extra_deleted_info (notifier, events);
+static void
+graph_updated_compact_cb (GDBusConnection *connection,
+                          const gchar     *sender_name,
+                          const gchar     *object_path,
+                          const gchar     *interface_name,
+                          const gchar     *signal_name,
+                          GVariant        *parameters,
+                          gpointer         user_data)
+{
+	TrackerNotifier *notifier = user_data;
+	TrackerNotifierPrivate *priv;
+	TrackerNotifierEventCache *cache;
+	GVariant *deletes, *updates;
+	const gchar *class;
+	guint subscription_id;
 
-		g_signal_emit (notifier, signals[EVENTS], 0, events);
-		g_ptr_array_unref (events);
+	priv = tracker_notifier_get_instance_private (notifier);
+	g_variant_get (parameters, "(u&s@ay@ay)",
+	               &subscription_id, &class, &deletes, &updates);
+
+	/* Other notifiers in this process get their own signals */
+	if (subscription_id == priv->subscription_id) {
+		cache = tracker_notifier_get_event_cache (notifier, class);
+		handle_compact_changes (notifier, cache, deletes, TRUE);
+		handle_compact_changes (notifier, cache, updates, FALSE);
+
+		tracker_notifier_emit_events (notifier, cache, NULL);
+	}
+
+	g_variant_unref (deletes);
+	g_variant_unref (updates);
+}
+
+static gboolean
+graph_updated_rows_dispatch (gpointer user_data)
+{
+	TrackerNotifierRows *rows = user_data;
+	TrackerNotifierEventCache *cache;
+	GVariant *deletes, *updates;
+	GMappedFile *mapped = NULL;
+	GError *error = NULL;
+	const gchar *class;
+
+	g_variant_get (rows->parameters, "(u&s@ay@ayh)",
+	               NULL, &class, &deletes, &updates, NULL);
+
+	cache = tracker_notifier_get_event_cache (rows->notifier, class);
+	handle_compact_changes (rows->notifier, cache, deletes, TRUE);
+	handle_compact_changes (rows->notifier, cache, updates, FALSE);
+
+	/* An empty file can't be mapped, but has no rows either */
+	if (lseek (rows->fd, 0, SEEK_END) > 0) {
+		mapped = g_mapped_file_new_from_fd (rows->fd, FALSE, &error);
+
+		if (!mapped) {
+			g_warning ("Could not map GraphUpdatedRows data: %s",
+			           error->message);
+			g_error_free (error);
+		}
+	}
+
+	tracker_notifier_emit_events (rows->notifier, cache, mapped);
+
+	if (mapped)
+		g_mapped_file_unref (mapped);
+
+	g_variant_unref (deletes);
+	g_variant_unref (updates);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+tracker_notifier_rows_free (TrackerNotifierRows *rows)
+{
+	g_object_unref (rows->notifier);
+	g_variant_unref (rows->parameters);
+	close (rows->fd);
+	g_free (rows);
+}
+
+static GDBusMessage *
+graph_updated_rows_filter (GDBusConnection *connection,
+                           GDBusMessage    *message,
+                           gboolean         incoming,
+                           gpointer         user_data)
+{
+	TrackerNotifierRowsFilter *filter = user_data;
+	TrackerNotifierRows *rows;
+	TrackerNotifier *notifier;
+	GUnixFDList *fd_list;
+	GVariant *parameters;
+	GSource *source;
+	guint subscription_id;
+	gint handle, fd;
+
+	if (!incoming ||
+	    g_dbus_message_get_message_type (message) != G_DBUS_MESSAGE_TYPE_SIGNAL ||
+	    g_strcmp0 (g_dbus_message_get_member (message), "GraphUpdatedRows") != 0 ||
+	    g_strcmp0 (g_dbus_message_get_interface (message), TRACKER_DBUS_INTERFACE_RESOURCES) != 0)
+		return message;
+
+	parameters = g_dbus_message_get_body (message);
+	if (!parameters ||
+	    !g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(usayayh)")))
+		return message;
+
+	g_variant_get (parameters, "(u&s@ay@ayh)",
+	               &subscription_id, NULL, NULL, NULL, &handle);
+
+	/* Signals to other notifiers in this process go through */
+	if (subscription_id != (guint) g_atomic_int_get (&filter->subscription_id))
+		return message;
+
+	fd_list = g_dbus_message_get_unix_fd_list (message);
+	fd = fd_list ? g_unix_fd_list_get (fd_list, handle, NULL) : -1;
+	notifier = g_weak_ref_get (&filter->notifier);
+
+	if (fd >= 0 && notifier) {
+		rows = g_new0 (TrackerNotifierRows, 1);
+		rows->notifier = notifier;
+		rows->parameters = g_variant_ref (parameters);
+		rows->fd = fd;
+
+		source = g_idle_source_new ();
+		g_source_set_callback (source, graph_updated_rows_dispatch, rows,
+		                       (GDestroyNotify) tracker_notifier_rows_free);
+		g_source_attach (source, filter->context);
+		g_source_unref (source);
+	} else {
+		if (fd >= 0)
+			close (fd);
+		g_clear_object (&notifier);
+	}
+
+	g_object_unref (message);
+
+	return NULL;
+}
+
+static void
+tracker_notifier_rows_filter_free (TrackerNotifierRowsFilter *filter)
+{
+	g_weak_ref_clear (&filter->notifier);
+	g_main_context_unref (filter->context);
+	g_free (filter);
+}
+
+/* URNs and locations come along the notification if asked for,
+ * instead of being queried afterwards.
+ */
+static GVariant *
+tracker_notifier_subscribe_parameters (TrackerNotifier *notifier)
+{
+	const gchar * const none[] = { NULL };
+	const gchar * const location[] = { "nie:url(nie:isStoredAs(?u))", NULL };
+	TrackerNotifierPrivate *priv;
+
+	priv = tracker_notifier_get_instance_private (notifier);
+
+	return g_variant_new ("(^as^as^as^asb)",
+	                      priv->expanded_classes ?
+	                      (const gchar * const *) priv->expanded_classes : none,
+	                      none,
+	                      id_resources,
+	                      (priv->flags & TRACKER_NOTIFIER_FLAG_QUERY_LOCATION) ?
+	                      location : none,
+	                      priv->rows_filter != NULL);
+}
+
+static void
+tracker_notifier_take_subscription (TrackerNotifier *notifier,
+                                    GVariant        *reply)
+{
+	TrackerNotifierPrivate *priv;
+	GVariantIter *ids;
+	gint32 id;
+	gint i = 0;
+
+	priv = tracker_notifier_get_instance_private (notifier);
+	g_variant_get (reply, "(uai)", &priv->subscription_id, &ids);
+
+	while (i < N_IDS && g_variant_iter_next (ids, "i", &id))
+		priv->ids[i++] = id;
+
+	g_variant_iter_free (ids);
+	g_variant_unref (reply);
+
+	if (priv->rows_filter)
+		g_atomic_int_set (&priv->rows_filter->subscription_id, priv->subscription_id);
+}
+
+static void
+resubscribe_cb (GObject      *source,
+                GAsyncResult *res,
+                gpointer      user_data)
+{
+	TrackerNotifier *notifier;
+	TrackerNotifierPrivate *priv;
+	GError *error = NULL;
+	GVariant *reply;
+
+	reply = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source),
+	                                       res, &error);
+
+	if (!reply) {
+		/* The notifier is gone if the call was cancelled */
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			g_warning ("Could not subscribe again to graph updates: %s",
+			           error->message);
+		g_error_free (error);
+		return;
 	}
+
+	notifier = user_data;
+	priv = tracker_notifier_get_instance_private (notifier);
+
+	if (priv->store_vanished) {
+		/* The store went away again, this subscription is void */
+		g_variant_unref (reply);
+		return;
+	}
+
+	tracker_notifier_take_subscription (notifier, reply);
+}
+
+/* Subscriptions live in the store, they are lost if it exits. Whenever
+ * it comes back (e.g. through D-Bus activation), subscribe again.
+ */
+static void
+store_appeared_cb (GDBusConnection *connection,
+                   const gchar     *name,
+                   const gchar     *name_owner,
+                   gpointer         user_data)
+{
+	TrackerNotifier *notifier = user_data;
+	TrackerNotifierPrivate *priv;
+
+	priv = tracker_notifier_get_instance_private (notifier);
+
+	if (!priv->store_vanished)
+		return;
+
+	priv->store_vanished = FALSE;
+
+	g_dbus_connection_call (priv->dbus_connection,
+	                        TRACKER_DBUS_SERVICE,
+	                        TRACKER_DBUS_OBJECT_RESOURCES,
+	                        TRACKER_DBUS_INTERFACE_RESOURCES,
+	                        "SubscribeGraphUpdated",
+	                        tracker_notifier_subscribe_parameters (notifier),
+	                        G_VARIANT_TYPE ("(uai)"),
+	                        G_DBUS_CALL_FLAGS_NONE,
+	                        -1, priv->cancellable,
+	                        resubscribe_cb, notifier);
+}
+
+static void
+store_vanished_cb (GDBusConnection *connection,
+                   const gchar     *name,
+                   gpointer         user_data)
+{
+	TrackerNotifier *notifier = user_data;
+	TrackerNotifierPrivate *priv;
+
+	priv = tracker_notifier_get_instance_private (notifier);
+	priv->store_vanished = TRUE;
+
+	/* A new store may hand out the same ID to someone else */
+	priv->subscription_id = 0;
+
+	if (priv->rows_filter)
+		g_atomic_int_set (&priv->rows_filter->subscription_id, 0);
+}
+
+static gboolean
+tracker_notifier_subscribe_compact (TrackerNotifier *notifier,
+                                    GCancellable    *cancellable)
+{
+	TrackerNotifierRowsFilter *filter;
+	TrackerNotifierPrivate *priv;
+	GError *error = NULL;
+	GVariant *reply;
+
+	priv = tracker_notifier_get_instance_private (notifier);
+
+	if ((priv->flags & (TRACKER_NOTIFIER_FLAG_QUERY_URN |
+	                    TRACKER_NOTIFIER_FLAG_QUERY_LOCATION)) != 0) {
+		filter = g_new0 (TrackerNotifierRowsFilter, 1);
+		g_weak_ref_init (&filter->notifier, notifier);
+		filter->context = g_main_context_ref_thread_default ();
+		priv->rows_filter = filter;
+		priv->rows_filter_id =
+			g_dbus_connection_add_filter (priv->dbus_connection,
+			                              graph_updated_rows_filter,
+			                              filter,
+			                              (GDestroyNotify) tracker_notifier_rows_filter_free);
+	} else {
+		priv->graph_updated_signal_id =
+			g_dbus_connection_signal_subscribe (priv->dbus_connection,
+			                                    TRACKER_DBUS_SERVICE,
+			                                    TRACKER_DBUS_INTERFACE_RESOURCES,
+			                                    "GraphUpdatedCompact",
+			                                    TRACKER_DBUS_OBJECT_RESOURCES,
+			                                    NULL,
+			                                    G_DBUS_SIGNAL_FLAGS_NONE,
+			                                    graph_updated_compact_cb,
+			                                    notifier, NULL);
+	}
+
+	reply = g_dbus_connection_call_sync (priv->dbus_connection,
+	                                     TRACKER_DBUS_SERVICE,
+	                                     TRACKER_DBUS_OBJECT_RESOURCES,
+	                                     TRACKER_DBUS_INTERFACE_RESOURCES,
+	                                     "SubscribeGraphUpdated",
+	                                     tracker_notifier_subscribe_parameters (notifier),
+	                                     G_VARIANT_TYPE ("(uai)"),
+	                                     G_DBUS_CALL_FLAGS_NONE,
+	                                     -1, cancellable, &error);
+
+	if (!reply) {
+		g_debug ("Could not subscribe to compact graph updates: %s",
+		         error->message);
+		g_error_free (error);
+
+		if (priv->rows_filter_id != 0) {
+			g_dbus_connection_remove_filter (priv->dbus_connection,
+			                                 priv->rows_filter_id);
+			priv->rows_filter_id = 0;
+			priv->rows_filter = NULL;
+		}
+
+		if (priv->graph_updated_signal_id != 0) {
+			g_dbus_connection_signal_unsubscribe (priv->dbus_connection,
+			                                      priv->graph_updated_signal_id);
+			priv->graph_updated_signal_id = 0;
+		}
+
+		return FALSE;
+	}
+
+	tracker_notifier_take_subscription (notifier, reply);
+
+	priv->cancellable = g_cancellable_new ();
+	priv->store_watch_id =
+		g_bus_watch_name_on_connection (priv->dbus_connection,
+		                                TRACKER_DBUS_SERVICE,
+		                                G_BUS_NAME_WATCHER_FLAGS_NONE,
+		                                store_appeared_cb,
+		                                store_vanished_cb,
+		                                notifier, NULL);
+
+	return TRUE;
 }
 
 static gboolean
@@ -696,14 +1272,18 @@ tracker_notifier_initable_init (GInitable     *initable,
 	if (!expand_class_iris (notifier, cancellable, error))
 		return FALSE;
 
-	tracker_notifier_cache_id (notifier, "rdf:type");
-	tracker_notifier_cache_id (notifier, "nie:dataSource");
-	tracker_notifier_cache_id (notifier, "tracker:extractor-data-source");
-
 	priv->dbus_connection = g_bus_get_sync (G_BUS_TYPE_SESSION, cancellable, error);
 	if (!priv->dbus_connection)
 		return FALSE;
 
+	/* Prefer the compact format, stores not implementing it
+	 * get GraphUpdated listened for.
+	 */
+	if (tracker_notifier_subscribe_compact (notifier, cancellable))
+		return TRUE;
+
+	tracker_notifier_query_ids (notifier);
+
 	priv->has_arg0_filter =
 		priv->expanded_classes && g_strv_length (priv->expanded_classes) == 1;
 	priv->graph_updated_signal_id =
@@ -777,12 +1357,35 @@ tracker_notifier_finalize (GObject *object)
 
 	priv = tracker_notifier_get_instance_private (TRACKER_NOTIFIER (object));
 
-	g_dbus_connection_signal_unsubscribe (priv->dbus_connection,
-	                                      priv->graph_updated_signal_id);
+	if (priv->store_watch_id != 0)
+		g_bus_unwatch_name (priv->store_watch_id);
+
+	if (priv->cancellable) {
+		g_cancellable_cancel (priv->cancellable);
+		g_object_unref (priv->cancellable);
+	}
+
+	if (priv->graph_updated_signal_id != 0)
+		g_dbus_connection_signal_unsubscribe (priv->dbus_connection,
+		                                      priv->graph_updated_signal_id);
+
+	if (priv->rows_filter_id != 0)
+		g_dbus_connection_remove_filter (priv->dbus_connection,
+		                                 priv->rows_filter_id);
+
+	if (priv->subscription_id != 0) {
+		g_dbus_connection_call (priv->dbus_connection,
+		                        TRACKER_DBUS_SERVICE,
+		                        TRACKER_DBUS_OBJECT_RESOURCES,
+		                        TRACKER_DBUS_INTERFACE_RESOURCES,
+		                        "UnsubscribeGraphUpdated",
+		                        g_variant_new ("(u)", priv->subscription_id),
+		                        NULL, G_DBUS_CALL_FLAGS_NONE,
+		                        -1, NULL, NULL, NULL);
+	}
 
 	g_object_unref (priv->dbus_connection);
 	g_object_unref (priv->connection);
-	g_hash_table_unref (priv->cached_ids);
 	g_hash_table_unref (priv->cached_events);
 	g_strfreev (priv->expanded_classes);
 	g_strfreev (priv->classes);
@@ -857,9 +1460,6 @@ tracker_notifier_init (TrackerNotifier *notifier)
 						     g_str_equal,
 						     NULL,
 	                                             (GDestroyNotify) tracker_notifier_event_cache_free);
-	priv->cached_ids = g_hash_table_new_full (g_str_hash,
-	                                          g_str_equal,
-	                                          g_free, g_free);
 }
 
 /**
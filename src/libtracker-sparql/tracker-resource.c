@@ -1510,3 +1510,274 @@ tracker_resource_print_sparql_update (TrackerResource         *resource,
 
 	return g_string_free (context.string, FALSE);
 }
+
+/* Values are stored in the a{sv} dictionary with these types:
+ *
+ *   b, i, x, d, s:  boolean, int, int64, double and string values
+ *   (s):            URIs, so they can be told apart from strings
+ *   a{sv}:          related resources
+ *   av:             properties holding a list of values
+ *
+ * Keys starting with '@' hold data about the resource itself.
+ */
+static GVariant *serialize_resource (TrackerResource *resource,
+                                     GList           *parents);
+
+static GVariant *
+serialize_value (const GValue *value,
+                 GList        *parents)
+{
+	GType type = G_VALUE_TYPE (value);
+
+	if (type == G_TYPE_BOOLEAN) {
+		return g_variant_new_boolean (g_value_get_boolean (value));
+	} else if (type == G_TYPE_INT) {
+		return g_variant_new_int32 (g_value_get_int (value));
+	} else if (type == G_TYPE_INT64) {
+		return g_variant_new_int64 (g_value_get_int64 (value));
+	} else if (type == G_TYPE_DOUBLE) {
+		return g_variant_new_double (g_value_get_double (value));
+	} else if (type == G_TYPE_STRING) {
+		return g_variant_new_string (g_value_get_string (value));
+	} else if (type == TRACKER_TYPE_URI) {
+		return g_variant_new ("(s)", g_value_get_string (value));
+	} else if (type == TRACKER_TYPE_RESOURCE) {
+		return serialize_resource (g_value_get_object (value), parents);
+	} else if (type == G_TYPE_PTR_ARRAY) {
+		GPtrArray *array = g_value_get_boxed (value);
+		GVariantBuilder builder;
+		guint i;
+
+		g_variant_builder_init (&builder, G_VARIANT_TYPE ("av"));
+
+		for (i = 0; i < array->len; i++) {
+			GVariant *child;
+
+			child = serialize_value (g_ptr_array_index (array, i), parents);
+
+			if (!child) {
+				g_variant_builder_clear (&builder);
+				return NULL;
+			}
+
+			g_variant_builder_add (&builder, "v", child);
+		}
+
+		return g_variant_builder_end (&builder);
+	}
+
+	return NULL;
+}
+
+static GVariant *
+serialize_resource (TrackerResource *resource,
+                    GList           *parents)
+{
+	TrackerResourcePrivate *priv;
+	GVariantBuilder builder, overwrite;
+	GHashTableIter iter;
+	gpointer key, value;
+	GList link = { resource, parents, NULL };
+
+	/* Cyclic relationships can't be expressed in a tree */
+	if (g_list_find (parents, resource))
+		return NULL;
+
+	priv = GET_PRIVATE (resource);
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_init (&overwrite, G_VARIANT_TYPE_STRING_ARRAY);
+
+	/* Blank nodes get a new identifier when deserialized */
+	if (!is_blank_node (priv->identifier)) {
+		g_variant_builder_add (&builder, "{sv}", "@id",
+		                       g_variant_new_string (priv->identifier));
+	}
+
+	g_hash_table_iter_init (&iter, priv->properties);
+
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		GVariant *child;
+
+		child = serialize_value (value, &link);
+
+		if (!child) {
+			g_variant_builder_clear (&builder);
+			g_variant_builder_clear (&overwrite);
+			return NULL;
+		}
+
+		g_variant_builder_add (&builder, "{sv}", key, child);
+
+		if (g_hash_table_lookup (priv->overwrite, key))
+			g_variant_builder_add (&overwrite, "s", key);
+	}
+
+	g_variant_builder_add (&builder, "{sv}", "@overwrite",
+	                       g_variant_builder_end (&overwrite));
+
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * tracker_resource_serialize:
+ * @resource: a #TrackerResource
+ *
+ * Serializes @resource and all the resources it relates to into a
+ * #GVariant of type <literal>a{sv}</literal>, which can be turned back
+ * into an equivalent resource with tracker_resource_deserialize().
+ *
+ * Only boolean, integer, double, string, URI and relation values can
+ * be serialized. Resources with cyclic relationships can't be
+ * serialized either.
+ *
+ * Returns: (transfer floating) (nullable): a #GVariant, or %NULL if
+ *     @resource holds values that can't be serialized.
+ *
+ * Since: 1.12
+ */
+GVariant *
+tracker_resource_serialize (TrackerResource *resource)
+{
+	g_return_val_if_fail (TRACKER_IS_RESOURCE (resource), NULL);
+
+	return serialize_resource (resource, NULL);
+}
+
+static gboolean
+deserialize_value (GVariant *variant,
+                   GValue   *value)
+{
+	if (g_variant_is_of_type (variant, G_VARIANT_TYPE_BOOLEAN)) {
+		g_value_init (value, G_TYPE_BOOLEAN);
+		g_value_set_boolean (value, g_variant_get_boolean (variant));
+	} else if (g_variant_is_of_type (variant, G_VARIANT_TYPE_INT32)) {
+		g_value_init (value, G_TYPE_INT);
+		g_value_set_int (value, g_variant_get_int32 (variant));
+	} else if (g_variant_is_of_type (variant, G_VARIANT_TYPE_INT64)) {
+		g_value_init (value, G_TYPE_INT64);
+		g_value_set_int64 (value, g_variant_get_int64 (variant));
+	} else if (g_variant_is_of_type (variant, G_VARIANT_TYPE_DOUBLE)) {
+		g_value_init (value, G_TYPE_DOUBLE);
+		g_value_set_double (value, g_variant_get_double (variant));
+	} else if (g_variant_is_of_type (variant, G_VARIANT_TYPE_STRING)) {
+		g_value_init (value, G_TYPE_STRING);
+		g_value_set_string (value, g_variant_get_string (variant, NULL));
+	} else if (g_variant_is_of_type (variant, G_VARIANT_TYPE ("(s)"))) {
+		const gchar *uri;
+
+		g_variant_get (variant, "(&s)", &uri);
+		g_value_init (value, TRACKER_TYPE_URI);
+		g_value_set_string (value, uri);
+	} else if (g_variant_is_of_type (variant, G_VARIANT_TYPE_VARDICT)) {
+		TrackerResource *resource;
+
+		resource = tracker_resource_deserialize (variant);
+
+		if (!resource)
+			return FALSE;
+
+		g_value_init (value, TRACKER_TYPE_RESOURCE);
+		g_value_take_object (value, resource);
+	} else {
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * tracker_resource_deserialize:
+ * @variant: a #GVariant of type <literal>a{sv}</literal>
+ *
+ * Creates a #TrackerResource from the data serialized by
+ * tracker_resource_serialize(). Blank nodes get new identifiers.
+ *
+ * Returns: (transfer full) (nullable): a newly created #TrackerResource,
+ *     or %NULL if @variant does not hold a serialized resource. Free
+ *     with g_object_unref() when done.
+ *
+ * Since: 1.12
+ */
+TrackerResource *
+tracker_resource_deserialize (GVariant *variant)
+{
+	TrackerResource *resource;
+	TrackerResourcePrivate *priv;
+	GVariant *child, *overwrite;
+	const gchar *key, *identifier = NULL;
+	GVariantIter iter;
+
+	g_return_val_if_fail (variant != NULL, NULL);
+
+	if (!g_variant_is_of_type (variant, G_VARIANT_TYPE_VARDICT))
+		return NULL;
+
+	g_variant_lookup (variant, "@id", "&s", &identifier);
+	resource = tracker_resource_new (identifier);
+	priv = GET_PRIVATE (resource);
+
+	g_variant_iter_init (&iter, variant);
+
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &child)) {
+		GValue *value;
+
+		if (key[0] == '@') {
+			g_variant_unref (child);
+			continue;
+		}
+
+		value = g_slice_new0 (GValue);
+
+		if (g_variant_is_of_type (child, G_VARIANT_TYPE ("av"))) {
+			GPtrArray *array;
+			GVariant *item;
+			GVariantIter array_iter;
+
+			array = g_ptr_array_new_with_free_func ((GDestroyNotify) free_value);
+			g_value_init (value, G_TYPE_PTR_ARRAY);
+			g_value_take_boxed (value, array);
+
+			g_variant_iter_init (&array_iter, child);
+
+			while (g_variant_iter_next (&array_iter, "v", &item)) {
+				GValue *array_value = g_slice_new0 (GValue);
+
+				if (!deserialize_value (item, array_value)) {
+					g_slice_free (GValue, array_value);
+					g_variant_unref (item);
+					g_variant_unref (child);
+					free_value (value);
+					g_object_unref (resource);
+					return NULL;
+				}
+
+				g_ptr_array_add (array, array_value);
+				g_variant_unref (item);
+			}
+		} else if (!deserialize_value (child, value)) {
+			g_slice_free (GValue, value);
+			g_variant_unref (child);
+			g_object_unref (resource);
+			return NULL;
+		}
+
+		g_hash_table_insert (priv->properties, g_strdup (key), value);
+		g_variant_unref (child);
+	}
+
+	overwrite = g_variant_lookup_value (variant, "@overwrite",
+	                                    G_VARIANT_TYPE_STRING_ARRAY);
+
+	if (overwrite) {
+		g_variant_iter_init (&iter, overwrite);
+
+		while (g_variant_iter_next (&iter, "&s", &key)) {
+			g_hash_table_insert (priv->overwrite, g_strdup (key),
+			                     GINT_TO_POINTER (TRUE));
+		}
+
+		g_variant_unref (overwrite);
+	}
+
+	return resource;
+}
@@ -77,6 +77,9 @@ char *tracker_resource_print_turtle(TrackerResource *self, TrackerNamespaceManag
 
 char *tracker_resource_print_sparql_update (TrackerResource *self, TrackerNamespaceManager *namespaces, const char *graph_id);
 
+GVariant *tracker_resource_serialize (TrackerResource *resource);
+TrackerResource *tracker_resource_deserialize (GVariant *variant);
+
 G_END_DECLS
 
 #endif /* __LIBTRACKER_RESOURCE_H__ */
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+/**
+ * SECTION: tracker-sparql-statement
+ * @short_description: Prepared statements
+ * @title: TrackerSparqlStatement
+ * @stability: Unstable
+ * @include: tracker-sparql.h
+ *
+ * <para>
+ * #TrackerSparqlStatement represents a SPARQL query that can be executed
+ * several times with different values. The query may contain
+ * parameterized variables in the form <literal>~name</literal>, which
+ * can appear in filter expressions and as the object of a triple
+ * pattern. Values are given with tracker_sparql_statement_bind_string()
+ * and friends before each execution.
+ * </para>
+ * <para>
+ * Parameter values never go through the SPARQL parser, so there is no
+ * need to escape them, and the store can reuse the translation of the
+ * query across executions.
+ * </para>
+ */
+
+/**
+ * TrackerSparqlStatement:
+ *
+ * The <structname>TrackerSparqlStatement</structname> object represents
+ * a prepared query.
+ */
+public abstract class Tracker.Sparql.Statement : Object {
+	/**
+	 * TrackerSparqlStatement:sparql:
+	 *
+	 * The SPARQL query of this statement.
+	 *
+	 * Since: 1.12
+	 */
+	public string sparql { get; construct set; }
+
+	/**
+	 * TrackerSparqlStatement:connection:
+	 *
+	 * The #TrackerSparqlConnection this statement runs on.
+	 *
+	 * Since: 1.12
+	 */
+	public Connection connection { get; construct set; }
+
+	HashTable<string,Variant> bindings = new HashTable<string,Variant> (str_hash, str_equal);
+
+	/**
+	 * tracker_sparql_statement_bind_int:
+	 * @self: a #TrackerSparqlStatement
+	 * @name: name of the parameter, without the leading <literal>~</literal>
+	 * @value: value
+	 *
+	 * Binds the integer @value to the parameterized variable @name.
+	 *
+	 * Since: 1.12
+	 */
+	public void bind_int (string name, int64 value) {
+		bindings.insert (name, new Variant.int64 (value));
+	}
+
+	/**
+	 * tracker_sparql_statement_bind_double:
+	 * @self: a #TrackerSparqlStatement
+	 * @name: name of the parameter, without the leading <literal>~</literal>
+	 * @value: value
+	 *
+	 * Binds the double @value to the parameterized variable @name.
+	 *
+	 * Since: 1.12
+	 */
+	public void bind_double (string name, double value) {
+		bindings.insert (name, new Variant.double (value));
+	}
+
+	/**
+	 * tracker_sparql_statement_bind_string:
+	 * @self: a #TrackerSparqlStatement
+	 * @name: name of the parameter, without the leading <literal>~</literal>
+	 * @value: value
+	 *
+	 * Binds the string @value to the parameterized variable @name.
+	 * When the variable is the object of a resource property, @value
+	 * is taken as the URI of the resource.
+	 *
+	 * Since: 1.12
+	 */
+	public void bind_string (string name, string value) {
+		bindings.insert (name, new Variant.string (value));
+	}
+
+	/**
+	 * tracker_sparql_statement_clear_bindings:
+	 * @self: a #TrackerSparqlStatement
+	 *
+	 * Clears all values bound to the statement.
+	 *
+	 * Since: 1.12
+	 */
+	public void clear_bindings () {
+		bindings.remove_all ();
+	}
+
+	/**
+	 * tracker_sparql_statement_get_bindings:
+	 * @self: a #TrackerSparqlStatement
+	 *
+	 * Returns the bound values as a dictionary from parameter name to
+	 * value, this is mainly useful to implementations of this class.
+	 *
+	 * Returns: a #GVariant of type <literal>a{sv}</literal>
+	 *
+	 * Since: 1.12
+	 */
+	public Variant get_bindings () {
+		var builder = new VariantBuilder ((VariantType) "a{sv}");
+
+		var iter = HashTableIter<string,Variant> (bindings);
+		unowned string name;
+		unowned Variant value;
+		while (iter.next (out name, out value)) {
+			builder.add ("{sv}", name, value);
+		}
+
+		return builder.end ();
+	}
+
+	/**
+	 * tracker_sparql_statement_execute:
+	 * @self: a #TrackerSparqlStatement
+	 * @cancellable: a #GCancellable used to cancel the operation
+	 * @error: #GError for error reporting.
+	 *
+	 * Executes the statement with the currently bound values. The API
+	 * call is completely synchronous, so it may block.
+	 *
+	 * Returns: a #TrackerSparqlCursor with the results. On error, #NULL
+	 * is returned and the @error is set accordingly. Call
+	 * g_object_unref() on the returned cursor when no longer needed.
+	 *
+	 * Since: 1.12
+	 */
+	public abstract Cursor execute (Cancellable? cancellable = null) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError;
+
+	/**
+	 * tracker_sparql_statement_execute_finish:
+	 * @self: a #TrackerSparqlStatement
+	 * @_res_: a #GAsyncResult with the result of the operation
+	 * @error: #GError for error reporting.
+	 *
+	 * Finishes the asynchronous execution of the statement.
+	 *
+	 * Returns: a #TrackerSparqlCursor with the results. On error, #NULL
+	 * is returned and the @error is set accordingly. Call
+	 * g_object_unref() on the returned cursor when no longer needed.
+	 *
+	 * Since: 1.12
+	 */
+
+	/**
+	 * tracker_sparql_statement_execute_async:
+	 * @self: a #TrackerSparqlStatement
+	 * @cancellable: a #GCancellable used to cancel the operation
+	 * @_callback_: user-defined #GAsyncReadyCallback to be called when
+	 *              asynchronous operation is finished.
+	 * @_user_data_: user-defined data to be passed to @_callback_
+	 *
+	 * Executes asynchronously the statement with the currently bound
+	 * values. Values bound after this call do not affect the operation.
+	 *
+	 * Since: 1.12
+	 */
+	public async abstract Cursor execute_async (Cancellable? cancellable = null) throws Sparql.Error, GLib.Error, GLib.IOError, DBusError;
+}
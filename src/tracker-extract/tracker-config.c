@@ -48,6 +48,10 @@ enum {
 	PROP_MAX_BYTES,
 	PROP_MAX_MEDIA_ART_WIDTH,
 	PROP_WAIT_FOR_MINER_FS,
+	PROP_MAX_EXTRACTING_FILES,
+	PROP_CACHE_SIZE,
+	PROP_WORKER_PROCESSES,
+	PROP_WORKER_MEMORY_LIMIT,
 };
 
 G_DEFINE_TYPE (TrackerConfig, tracker_config, G_TYPE_SETTINGS);
@@ -106,6 +110,42 @@ tracker_config_class_init (TrackerConfigClass *klass)
 	                                                       "%TRUE to wait for tracker-miner-fs is done before extracting. %FAlSE otherwise",
 	                                                       FALSE,
 	                                                       G_PARAM_READWRITE));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_MAX_EXTRACTING_FILES,
+	                                 g_param_spec_int ("max-extracting-files",
+	                                                   "Max extracting files",
+	                                                   "Maximum number of files extracted at once (0=number of processors)",
+	                                                   0, 256,
+	                                                   0,
+	                                                   G_PARAM_READWRITE));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_CACHE_SIZE,
+	                                 g_param_spec_int ("cache-size",
+	                                                   "Cache size",
+	                                                   "Size in MiB of the extraction result cache (0=disabled)",
+	                                                   0, 65536,
+	                                                   0,
+	                                                   G_PARAM_READWRITE));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_WORKER_PROCESSES,
+	                                 g_param_spec_int ("worker-processes",
+	                                                   "Worker processes",
+	                                                   "Number of sandboxed extractor processes (0=extract in process)",
+	                                                   0, 64,
+	                                                   0,
+	                                                   G_PARAM_READWRITE));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_WORKER_MEMORY_LIMIT,
+	                                 g_param_spec_int ("worker-memory-limit",
+	                                                   "Worker memory limit",
+	                                                   "Maximum address space in MiB of each extractor process (0=unlimited)",
+	                                                   0, 65536,
+	                                                   0,
+	                                                   G_PARAM_READWRITE));
 }
 
 static void
@@ -135,6 +175,10 @@ config_set_property (GObject      *object,
 	case PROP_MAX_BYTES:
 	case PROP_MAX_MEDIA_ART_WIDTH:
 	case PROP_WAIT_FOR_MINER_FS:
+	case PROP_MAX_EXTRACTING_FILES:
+	case PROP_CACHE_SIZE:
+	case PROP_WORKER_PROCESSES:
+	case PROP_WORKER_MEMORY_LIMIT:
 		break;
 
 	default:
@@ -177,6 +221,26 @@ config_get_property (GObject    *object,
 		                     tracker_config_get_wait_for_miner_fs (config));
 		break;
 
+	case PROP_MAX_EXTRACTING_FILES:
+		g_value_set_int (value,
+		                 tracker_config_get_max_extracting_files (config));
+		break;
+
+	case PROP_CACHE_SIZE:
+		g_value_set_int (value,
+		                 tracker_config_get_cache_size (config));
+		break;
+
+	case PROP_WORKER_PROCESSES:
+		g_value_set_int (value,
+		                 tracker_config_get_worker_processes (config));
+		break;
+
+	case PROP_WORKER_MEMORY_LIMIT:
+		g_value_set_int (value,
+		                 tracker_config_get_worker_memory_limit (config));
+		break;
+
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
 		break;
@@ -229,6 +293,10 @@ config_constructed (GObject *object)
 	g_settings_bind (settings, "max-bytes", object, "max-bytes", G_SETTINGS_BIND_GET);
 	g_settings_bind (settings, "max-media-art-width", object, "max-media-art-width", G_SETTINGS_BIND_GET);
 	g_settings_bind (settings, "wait-for-miner-fs", object, "wait-for-miner-fs", G_SETTINGS_BIND_GET);
+	g_settings_bind (settings, "max-extracting-files", object, "max-extracting-files", G_SETTINGS_BIND_GET);
+	g_settings_bind (settings, "cache-size", object, "cache-size", G_SETTINGS_BIND_GET);
+	g_settings_bind (settings, "worker-processes", object, "worker-processes", G_SETTINGS_BIND_GET);
+	g_settings_bind (settings, "worker-memory-limit", object, "worker-memory-limit", G_SETTINGS_BIND_GET);
 }
 
 TrackerConfig *
@@ -321,3 +389,35 @@ tracker_config_get_wait_for_miner_fs (TrackerConfig *config)
 
 	return g_settings_get_boolean (G_SETTINGS (config), "wait-for-miner-fs");
 }
+
+gint
+tracker_config_get_max_extracting_files (TrackerConfig *config)
+{
+	g_return_val_if_fail (TRACKER_IS_CONFIG (config), 0);
+
+	return g_settings_get_int (G_SETTINGS (config), "max-extracting-files");
+}
+
+gint
+tracker_config_get_cache_size (TrackerConfig *config)
+{
+	g_return_val_if_fail (TRACKER_IS_CONFIG (config), 0);
+
+	return g_settings_get_int (G_SETTINGS (config), "cache-size");
+}
+
+gint
+tracker_config_get_worker_processes (TrackerConfig *config)
+{
+	g_return_val_if_fail (TRACKER_IS_CONFIG (config), 0);
+
+	return g_settings_get_int (G_SETTINGS (config), "worker-processes");
+}
+
+gint
+tracker_config_get_worker_memory_limit (TrackerConfig *config)
+{
+	g_return_val_if_fail (TRACKER_IS_CONFIG (config), 0);
+
+	return g_settings_get_int (G_SETTINGS (config), "worker-memory-limit");
+}
@@ -51,6 +51,10 @@ gint           tracker_config_get_sched_idle          (TrackerConfig *config);
 gint           tracker_config_get_max_bytes           (TrackerConfig *config);
 gint           tracker_config_get_max_media_art_width (TrackerConfig *config);
 gboolean       tracker_config_get_wait_for_miner_fs   (TrackerConfig *config);
+gint           tracker_config_get_max_extracting_files (TrackerConfig *config);
+gint           tracker_config_get_cache_size          (TrackerConfig *config);
+gint           tracker_config_get_worker_processes    (TrackerConfig *config);
+gint           tracker_config_get_worker_memory_limit (TrackerConfig *config);
 
 void           tracker_config_set_verbosity           (TrackerConfig *config,
                                                        gint           value);
@@ -0,0 +1,741 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <glib/gstdio.h>
+
+#include <libtracker-extract/tracker-extract.h>
+
+#include "tracker-extract-cache.h"
+
+/* Files are identified by their size, and the contents of up to
+ * three chunks of this size at their start, middle and end. Smaller
+ * files are hashed as a whole.
+ */
+#define CHUNK_SIZE (64 * 1024)
+
+/* Cached results are stored in a file per key, named after the
+ * hex SHA1 of the key.
+ */
+#define KEY_LENGTH 40
+
+typedef struct _TrackerExtractCachePrivate TrackerExtractCachePrivate;
+typedef struct _CacheEntry CacheEntry;
+typedef struct _LookupData LookupData;
+typedef struct _StoreData StoreData;
+
+struct _CacheEntry
+{
+	gchar *key;
+	guint64 size;
+	GList link;
+};
+
+struct _LookupData
+{
+	GFile *file;
+	gchar *module_id;
+	gchar *key;
+};
+
+struct _StoreData
+{
+	gchar *key;
+	gchar *uri;
+	GBytes *bytes;
+};
+
+struct _TrackerExtractCachePrivate
+{
+	gchar *path;
+	guint64 max_size;
+
+	/* Accessed from the lookup and store threads */
+	GMutex mutex;
+	GHashTable *entries;
+	GQueue lru;
+	guint64 size;
+
+	/* Mimetype -> module ID, only accessed from the main thread */
+	GHashTable *module_ids;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (TrackerExtractCache, tracker_extract_cache, G_TYPE_OBJECT)
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+	g_free (entry->key);
+	g_slice_free (CacheEntry, entry);
+}
+
+static void
+lookup_data_free (LookupData *data)
+{
+	g_object_unref (data->file);
+	g_free (data->module_id);
+	g_free (data->key);
+	g_slice_free (LookupData, data);
+}
+
+static void
+store_data_free (StoreData *data)
+{
+	g_free (data->key);
+	g_free (data->uri);
+	g_bytes_unref (data->bytes);
+	g_slice_free (StoreData, data);
+}
+
+static void
+tracker_extract_cache_finalize (GObject *object)
+{
+	TrackerExtractCachePrivate *priv;
+
+	priv = tracker_extract_cache_get_instance_private (TRACKER_EXTRACT_CACHE (object));
+
+	g_hash_table_unref (priv->entries);
+	g_hash_table_unref (priv->module_ids);
+	g_mutex_clear (&priv->mutex);
+	g_free (priv->path);
+
+	G_OBJECT_CLASS (tracker_extract_cache_parent_class)->finalize (object);
+}
+
+static void
+tracker_extract_cache_class_init (TrackerExtractCacheClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = tracker_extract_cache_finalize;
+}
+
+static void
+tracker_extract_cache_init (TrackerExtractCache *cache)
+{
+	TrackerExtractCachePrivate *priv;
+
+	priv = tracker_extract_cache_get_instance_private (cache);
+
+	g_mutex_init (&priv->mutex);
+	g_queue_init (&priv->lru);
+	priv->entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+	                                       (GDestroyNotify) cache_entry_free);
+	priv->module_ids = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                          g_free, g_free);
+}
+
+static gboolean
+cache_is_key (const gchar *name)
+{
+	gint i;
+
+	for (i = 0; i < KEY_LENGTH; i++) {
+		if (!g_ascii_isxdigit (name[i]))
+			return FALSE;
+	}
+
+	return name[KEY_LENGTH] == '\0';
+}
+
+static gchar *
+cache_get_entry_path (TrackerExtractCache *cache,
+                      const gchar         *key)
+{
+	TrackerExtractCachePrivate *priv;
+
+	priv = tracker_extract_cache_get_instance_private (cache);
+
+	return g_build_filename (priv->path, key, NULL);
+}
+
+/* Must be called with the mutex held */
+static void
+cache_remove_entry (TrackerExtractCache *cache,
+                    CacheEntry          *entry)
+{
+	TrackerExtractCachePrivate *priv;
+	gchar *path;
+
+	priv = tracker_extract_cache_get_instance_private (cache);
+
+	path = cache_get_entry_path (cache, entry->key);
+	g_unlink (path);
+	g_free (path);
+
+	g_queue_unlink (&priv->lru, &entry->link);
+	priv->size -= entry->size;
+	g_hash_table_remove (priv->entries, entry->key);
+}
+
+/* Must be called with the mutex held */
+static void
+cache_evict (TrackerExtractCache *cache)
+{
+	TrackerExtractCachePrivate *priv;
+
+	priv = tracker_extract_cache_get_instance_private (cache);
+
+	while (priv->size > priv->max_size && priv->lru.tail) {
+		g_debug ("Evicting extraction cache entry '%s'",
+		         ((CacheEntry *) priv->lru.tail->data)->key);
+		cache_remove_entry (cache, priv->lru.tail->data);
+	}
+}
+
+/* Must be called with the mutex held, the entry becomes the most
+ * recently used one.
+ */
+static void
+cache_add_entry (TrackerExtractCache *cache,
+                 const gchar         *key,
+                 guint64              size)
+{
+	TrackerExtractCachePrivate *priv;
+	CacheEntry *entry;
+
+	priv = tracker_extract_cache_get_instance_private (cache);
+	entry = g_hash_table_lookup (priv->entries, key);
+
+	if (entry) {
+		g_queue_unlink (&priv->lru, &entry->link);
+		priv->size -= entry->size;
+	} else {
+		entry = g_slice_new0 (CacheEntry);
+		entry->key = g_strdup (key);
+		entry->link.data = entry;
+		g_hash_table_insert (priv->entries, entry->key, entry);
+	}
+
+	entry->size = size;
+	priv->size += size;
+	g_queue_push_head_link (&priv->lru, &entry->link);
+}
+
+static gint
+compare_file_info_mtime (GFileInfo *a,
+                         GFileInfo *b)
+{
+	guint64 mtime_a, mtime_b;
+
+	mtime_a = g_file_info_get_attribute_uint64 (a, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+	mtime_b = g_file_info_get_attribute_uint64 (b, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+
+	return (mtime_a > mtime_b) - (mtime_a < mtime_b);
+}
+
+static void
+cache_load_entries (TrackerExtractCache *cache)
+{
+	TrackerExtractCachePrivate *priv;
+	GFileEnumerator *enumerator;
+	GFileInfo *info;
+	GList *infos = NULL, *l;
+	GFile *dir;
+
+	priv = tracker_extract_cache_get_instance_private (cache);
+	dir = g_file_new_for_path (priv->path);
+	enumerator = g_file_enumerate_children (dir,
+	                                        G_FILE_ATTRIBUTE_STANDARD_NAME ","
+	                                        G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+	                                        G_FILE_ATTRIBUTE_TIME_MODIFIED,
+	                                        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+	                                        NULL, NULL);
+	g_object_unref (dir);
+
+	if (!enumerator)
+		return;
+
+	while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL)) != NULL) {
+		if (cache_is_key (g_file_info_get_name (info))) {
+			infos = g_list_prepend (infos, info);
+		} else {
+			gchar *path;
+
+			/* Leftovers of interrupted writes */
+			path = g_build_filename (priv->path, g_file_info_get_name (info), NULL);
+			g_unlink (path);
+			g_free (path);
+			g_object_unref (info);
+		}
+	}
+
+	g_file_enumerator_close (enumerator, NULL, NULL);
+	g_object_unref (enumerator);
+
+	/* Oldest first, so the most recently used entries end up at the head */
+	infos = g_list_sort (infos, (GCompareFunc) compare_file_info_mtime);
+
+	g_mutex_lock (&priv->mutex);
+
+	for (l = infos; l; l = l->next) {
+		info = l->data;
+		cache_add_entry (cache, g_file_info_get_name (info),
+		                 g_file_info_get_size (info));
+	}
+
+	cache_evict (cache);
+
+	g_mutex_unlock (&priv->mutex);
+
+	g_debug ("Extraction cache holds %u entries, %" G_GUINT64_FORMAT " bytes",
+	         g_hash_table_size (priv->entries), priv->size);
+
+	g_list_free_full (infos, g_object_unref);
+}
+
+TrackerExtractCache *
+tracker_extract_cache_new (const gchar *path,
+                           guint64      max_size)
+{
+	TrackerExtractCache *cache;
+	TrackerExtractCachePrivate *priv;
+
+	g_return_val_if_fail (path != NULL, NULL);
+
+	if (g_mkdir_with_parents (path, 0700) != 0) {
+		g_warning ("The extraction cache directory %s could not be created",
+		           path);
+		return NULL;
+	}
+
+	cache = g_object_new (TRACKER_TYPE_EXTRACT_CACHE, NULL);
+	priv = tracker_extract_cache_get_instance_private (cache);
+	priv->path = g_strdup (path);
+	priv->max_size = max_size;
+
+	cache_load_entries (cache);
+
+	return cache;
+}
+
+/* Modules don't carry a version, the path and modification time of
+ * the module handling the mimetype change whenever it is updated.
+ */
+static const gchar *
+cache_get_module_id (TrackerExtractCache *cache,
+                     const gchar         *mimetype)
+{
+	TrackerExtractCachePrivate *priv;
+	TrackerMimetypeInfo *info;
+	struct stat st = { 0 };
+	GModule *module;
+	const gchar *name;
+	gchar *module_id;
+
+	priv = tracker_extract_cache_get_instance_private (cache);
+
+	if (g_hash_table_lookup_extended (priv->module_ids, mimetype,
+	                                  NULL, (gpointer *) &module_id))
+		return module_id;
+
+	info = tracker_extract_module_manager_get_mimetype_handlers (mimetype);
+
+	if (info) {
+		module = tracker_mimetype_info_get_module (info, NULL);
+		name = module ? g_module_name (module) : "dummy";
+
+		if (module)
+			g_stat (name, &st);
+
+		module_id = g_strdup_printf ("%s:%s:%" G_GINT64_FORMAT ":%s",
+		                             PACKAGE_VERSION, name,
+		                             (gint64) st.st_mtime, mimetype);
+		tracker_mimetype_info_free (info);
+	} else {
+		/* Nothing to extract, so nothing to cache */
+		module_id = NULL;
+	}
+
+	g_hash_table_insert (priv->module_ids, g_strdup (mimetype), module_id);
+
+	return module_id;
+}
+
+static gboolean
+cache_checksum_chunk (GChecksum     *checksum,
+                      GInputStream  *stream,
+                      goffset        offset,
+                      gsize          len,
+                      guchar        *buffer,
+                      GCancellable  *cancellable,
+                      GError       **error)
+{
+	gsize bytes_read;
+
+	if (!g_seekable_seek (G_SEEKABLE (stream), offset, G_SEEK_SET,
+	                      cancellable, error))
+		return FALSE;
+
+	if (!g_input_stream_read_all (stream, buffer, len, &bytes_read,
+	                              cancellable, error))
+		return FALSE;
+
+	g_checksum_update (checksum, buffer, bytes_read);
+
+	return TRUE;
+}
+
+static gchar *
+cache_compute_key (GFile         *file,
+                   const gchar   *module_id,
+                   GCancellable  *cancellable,
+                   GError       **error)
+{
+	GFileInputStream *stream;
+	GFileInfo *info;
+	GChecksum *checksum;
+	guchar *buffer;
+	gchar *size_str, *key = NULL;
+	goffset size, offset;
+	gboolean success = TRUE;
+
+	stream = g_file_read (file, cancellable, error);
+
+	if (!stream)
+		return NULL;
+
+	info = g_file_input_stream_query_info (stream,
+	                                       G_FILE_ATTRIBUTE_STANDARD_SIZE,
+	                                       cancellable, error);
+	if (!info) {
+		g_object_unref (stream);
+		return NULL;
+	}
+
+	size = g_file_info_get_size (info);
+	g_object_unref (info);
+
+	checksum = g_checksum_new (G_CHECKSUM_SHA1);
+	g_checksum_update (checksum, (const guchar *) module_id, strlen (module_id) + 1);
+
+	size_str = g_strdup_printf ("%" G_GOFFSET_FORMAT, size);
+	g_checksum_update (checksum, (const guchar *) size_str, strlen (size_str) + 1);
+	g_free (size_str);
+
+	buffer = g_malloc (CHUNK_SIZE);
+
+	if (size <= 3 * CHUNK_SIZE) {
+		for (offset = 0; success && offset < size; offset += CHUNK_SIZE) {
+			success = cache_checksum_chunk (checksum, G_INPUT_STREAM (stream),
+			                                offset, CHUNK_SIZE, buffer,
+			                                cancellable, error);
+		}
+	} else {
+		success = (cache_checksum_chunk (checksum, G_INPUT_STREAM (stream),
+		                                 0, CHUNK_SIZE, buffer,
+		                                 cancellable, error) &&
+		           cache_checksum_chunk (checksum, G_INPUT_STREAM (stream),
+		                                 (size - CHUNK_SIZE) / 2, CHUNK_SIZE, buffer,
+		                                 cancellable, error) &&
+		           cache_checksum_chunk (checksum, G_INPUT_STREAM (stream),
+		                                 size - CHUNK_SIZE, CHUNK_SIZE, buffer,
+		                                 cancellable, error));
+	}
+
+	if (success)
+		key = g_strdup (g_checksum_get_string (checksum));
+
+	g_free (buffer);
+	g_checksum_free (checksum);
+	g_input_stream_close (G_INPUT_STREAM (stream), NULL, NULL);
+	g_object_unref (stream);
+
+	return key;
+}
+
+static TrackerResource *
+cache_load_resource (TrackerExtractCache *cache,
+                     const gchar         *key)
+{
+	TrackerExtractCachePrivate *priv;
+	TrackerResource *resource = NULL;
+	CacheEntry *entry;
+	GVariant *variant;
+	GBytes *bytes;
+	gchar *path, *contents;
+	gsize len;
+
+	priv = tracker_extract_cache_get_instance_private (cache);
+
+	g_mutex_lock (&priv->mutex);
+	entry = g_hash_table_lookup (priv->entries, key);
+
+	if (entry)
+		cache_add_entry (cache, key, entry->size);
+
+	g_mutex_unlock (&priv->mutex);
+
+	if (!entry)
+		return NULL;
+
+	path = cache_get_entry_path (cache, key);
+
+	if (g_file_get_contents (path, &contents, &len, NULL)) {
+		bytes = g_bytes_new_take (contents, len);
+
+		/* Data read from disk is untrusted, GVariant checks it on access */
+		variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE_VARDICT,
+		                                                        bytes, FALSE));
+		resource = tracker_resource_deserialize (variant);
+		g_variant_unref (variant);
+		g_bytes_unref (bytes);
+	}
+
+	if (resource) {
+		/* Keep the LRU order across restarts */
+		g_utime (path, NULL);
+	} else {
+		g_mutex_lock (&priv->mutex);
+		entry = g_hash_table_lookup (priv->entries, key);
+		if (entry)
+			cache_remove_entry (cache, entry);
+		g_mutex_unlock (&priv->mutex);
+	}
+
+	g_free (path);
+
+	return resource;
+}
+
+static void
+cache_lookup_thread (GTask        *task,
+                     gpointer      source_object,
+                     gpointer      task_data,
+                     GCancellable *cancellable)
+{
+	TrackerExtractCache *cache = source_object;
+	LookupData *data = task_data;
+	GError *error = NULL;
+
+	data->key = cache_compute_key (data->file, data->module_id,
+	                               cancellable, &error);
+
+	if (!data->key) {
+		g_task_return_error (task, error);
+		return;
+	}
+
+	g_task_return_pointer (task, cache_load_resource (cache, data->key),
+	                       g_object_unref);
+}
+
+/* Computes the cache key for @file and looks up the cached
+ * extraction result for it.
+ */
+void
+tracker_extract_cache_lookup_async (TrackerExtractCache *cache,
+                                    GFile               *file,
+                                    const gchar         *mimetype,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+	const gchar *module_id;
+	LookupData *data;
+	GTask *task;
+
+	g_return_if_fail (TRACKER_IS_EXTRACT_CACHE (cache));
+	g_return_if_fail (G_IS_FILE (file));
+
+	task = g_task_new (cache, cancellable, callback, user_data);
+	module_id = mimetype ? cache_get_module_id (cache, mimetype) : NULL;
+
+	if (!module_id) {
+		g_task_return_pointer (task, NULL, NULL);
+		g_object_unref (task);
+		return;
+	}
+
+	data = g_slice_new0 (LookupData);
+	data->file = g_object_ref (file);
+	data->module_id = g_strdup (module_id);
+	g_task_set_task_data (task, data, (GDestroyNotify) lookup_data_free);
+
+	g_task_run_in_thread (task, cache_lookup_thread);
+	g_object_unref (task);
+}
+
+/* Returns the cached resource, or %NULL if there is none. @key is
+ * set to the key the result should be stored with, or to %NULL if
+ * the file can't be cached.
+ */
+TrackerResource *
+tracker_extract_cache_lookup_finish (TrackerExtractCache  *cache,
+                                     GAsyncResult         *result,
+                                     gchar               **key,
+                                     GError              **error)
+{
+	LookupData *data;
+
+	g_return_val_if_fail (TRACKER_IS_EXTRACT_CACHE (cache), NULL);
+	g_return_val_if_fail (g_task_is_valid (result, cache), NULL);
+
+	data = g_task_get_task_data (G_TASK (result));
+
+	if (key)
+		*key = data ? g_strdup (data->key) : NULL;
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/* Whether @str is a whole string value in the serialized @bytes */
+static gboolean
+cache_bytes_have_string (GBytes      *bytes,
+                         const gchar *str)
+{
+	return memmem (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes),
+	               str, strlen (str) + 1) != NULL;
+}
+
+/* When metadata is guaranteed, modules fall back to the file name
+ * for titles and to the modification time for dates. Those values
+ * are only right for this file, not for others with its contents.
+ */
+static gboolean
+cache_bytes_have_file_fallbacks (GBytes      *bytes,
+                                 const gchar *uri)
+{
+	TrackerResource *fallbacks;
+	const gchar *date;
+	gchar *title = NULL;
+	gboolean found = FALSE;
+
+	fallbacks = tracker_resource_new (NULL);
+
+	if (tracker_guarantee_resource_title_from_file (fallbacks, "nie:title",
+	                                                NULL, uri, &title))
+		found = cache_bytes_have_string (bytes, title);
+
+	if (!found &&
+	    tracker_guarantee_resource_date_from_file_mtime (fallbacks, "nie:contentCreated",
+	                                                     NULL, uri)) {
+		date = tracker_resource_get_first_string (fallbacks, "nie:contentCreated");
+		found = date && cache_bytes_have_string (bytes, date);
+	}
+
+	g_free (title);
+	g_object_unref (fallbacks);
+
+	return found;
+}
+
+static void
+cache_store_thread (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+	TrackerExtractCache *cache = source_object;
+	TrackerExtractCachePrivate *priv;
+	StoreData *data = task_data;
+	GError *error = NULL;
+	gchar *path;
+
+	priv = tracker_extract_cache_get_instance_private (cache);
+
+	if (cache_bytes_have_file_fallbacks (data->bytes, data->uri)) {
+		g_debug ("Extraction result for '%s' has values taken from the file, "
+		         "not caching it", data->uri);
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	path = cache_get_entry_path (cache, data->key);
+
+	if (g_file_set_contents (path,
+	                         g_bytes_get_data (data->bytes, NULL),
+	                         g_bytes_get_size (data->bytes),
+	                         &error)) {
+		g_mutex_lock (&priv->mutex);
+		cache_add_entry (cache, data->key, g_bytes_get_size (data->bytes));
+		cache_evict (cache);
+		g_mutex_unlock (&priv->mutex);
+	} else {
+		g_warning ("Could not store extraction result in cache: %s",
+		           error->message);
+		g_error_free (error);
+	}
+
+	g_free (path);
+	g_task_return_boolean (task, TRUE);
+}
+
+/* Stores @resource, the extraction result for @file, with the key
+ * given by tracker_extract_cache_lookup_finish(). The file is written
+ * in a thread. Results holding values that only apply to @file, like
+ * its location or the fallbacks derived from it, are not stored.
+ */
+void
+tracker_extract_cache_store (TrackerExtractCache *cache,
+                             const gchar         *key,
+                             GFile               *file,
+                             TrackerResource     *resource)
+{
+	TrackerExtractCachePrivate *priv;
+	StoreData *data;
+	GVariant *variant;
+	GBytes *bytes;
+	GTask *task;
+	gchar *uri;
+
+	g_return_if_fail (TRACKER_IS_EXTRACT_CACHE (cache));
+	g_return_if_fail (key != NULL);
+	g_return_if_fail (G_IS_FILE (file));
+	g_return_if_fail (TRACKER_IS_RESOURCE (resource));
+
+	priv = tracker_extract_cache_get_instance_private (cache);
+	variant = tracker_resource_serialize (resource);
+
+	if (!variant) {
+		g_debug ("Extraction result can't be serialized, not caching it");
+		return;
+	}
+
+	g_variant_ref_sink (variant);
+	bytes = g_variant_get_data_as_bytes (variant);
+	g_variant_unref (variant);
+
+	/* Results mentioning the file location can't be used for copies */
+	uri = g_file_get_uri (file);
+
+	if (memmem (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes),
+	            uri, strlen (uri)) != NULL ||
+	    g_bytes_get_size (bytes) > priv->max_size) {
+		g_debug ("Not caching extraction result for '%s'", uri);
+		g_bytes_unref (bytes);
+		g_free (uri);
+		return;
+	}
+
+	data = g_slice_new0 (StoreData);
+	data->key = g_strdup (key);
+	data->uri = uri;
+	data->bytes = bytes;
+
+	task = g_task_new (cache, NULL, NULL, NULL);
+	g_task_set_task_data (task, data, (GDestroyNotify) store_data_free);
+	g_task_run_in_thread (task, cache_store_thread);
+	g_object_unref (task);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __TRACKER_EXTRACT_CACHE_H__
+#define __TRACKER_EXTRACT_CACHE_H__
+
+#include <gio/gio.h>
+#include <libtracker-sparql/tracker-sparql.h>
+
+G_BEGIN_DECLS
+
+#define TRACKER_TYPE_EXTRACT_CACHE         (tracker_extract_cache_get_type ())
+#define TRACKER_EXTRACT_CACHE(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), TRACKER_TYPE_EXTRACT_CACHE, TrackerExtractCache))
+#define TRACKER_EXTRACT_CACHE_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), TRACKER_TYPE_EXTRACT_CACHE, TrackerExtractCacheClass))
+#define TRACKER_IS_EXTRACT_CACHE(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), TRACKER_TYPE_EXTRACT_CACHE))
+#define TRACKER_IS_EXTRACT_CACHE_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), TRACKER_TYPE_EXTRACT_CACHE))
+#define TRACKER_EXTRACT_CACHE_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), TRACKER_TYPE_EXTRACT_CACHE, TrackerExtractCacheClass))
+
+typedef struct _TrackerExtractCache TrackerExtractCache;
+typedef struct _TrackerExtractCacheClass TrackerExtractCacheClass;
+
+struct _TrackerExtractCache
+{
+	GObject parent_instance;
+};
+
+struct _TrackerExtractCacheClass
+{
+	GObjectClass parent_class;
+};
+
+GType tracker_extract_cache_get_type (void) G_GNUC_CONST;
+
+TrackerExtractCache *
+     tracker_extract_cache_new          (const gchar          *path,
+                                         guint64               max_size);
+
+void tracker_extract_cache_lookup_async (TrackerExtractCache  *cache,
+                                         GFile                *file,
+                                         const gchar          *mimetype,
+                                         GCancellable         *cancellable,
+                                         GAsyncReadyCallback   callback,
+                                         gpointer              user_data);
+TrackerResource *
+     tracker_extract_cache_lookup_finish (TrackerExtractCache  *cache,
+                                          GAsyncResult         *result,
+                                          gchar               **key,
+                                          GError              **error);
+
+void tracker_extract_cache_store        (TrackerExtractCache  *cache,
+                                         const gchar          *key,
+                                         GFile                *file,
+                                         TrackerResource      *resource);
+
+G_END_DECLS
+
+#endif /* __TRACKER_EXTRACT_CACHE_H__ */
@@ -23,8 +23,10 @@
 #include <libtracker-extract/tracker-extract.h>
 
 #include "tracker-extract-decorator.h"
+#include "tracker-extract-cache.h"
 #include "tracker-extract-persistence.h"
 #include "tracker-extract-priority-dbus.h"
+#include "tracker-main.h"
 
 enum {
 	PROP_EXTRACTOR = 1
@@ -32,7 +34,9 @@ enum {
 
 #define TRACKER_EXTRACT_DATA_SOURCE TRACKER_PREFIX_TRACKER "extractor-data-source"
 #define TRACKER_EXTRACT_FAILURE_DATA_SOURCE TRACKER_PREFIX_TRACKER "extractor-failure-data-source"
-#define MAX_EXTRACTING_FILES 1
+
+/* Finished files held back behind a slow one, per extraction slot */
+#define MAX_HELD_BACK_FACTOR 8
 
 #define TRACKER_EXTRACT_DECORATOR_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), TRACKER_TYPE_EXTRACT_DECORATOR, TrackerExtractDecoratorPrivate))
 
@@ -43,16 +47,34 @@ struct _ExtractData {
 	TrackerDecorator *decorator;
 	TrackerDecoratorInfo *decorator_info;
 	GFile *file;
+
+	/* Key of the extraction result in the cache */
+	gchar *cache_key;
+
+	/* Set once extraction finished */
+	gboolean done;
+	TrackerExtractInfo *info;
+	GError *error;
 };
 
 struct _TrackerExtractDecoratorPrivate {
 	TrackerExtract *extractor;
 	GTimer *timer;
 	guint n_extracting_files;
+	guint max_extracting_files;
+
+	/* ExtractData being extracted or waiting for the ones
+	 * before them, in the order files were handed by the
+	 * decorator, so results are committed in that same order.
+	 */
+	GQueue extracting;
 
 	TrackerExtractPersistence *persistence;
 	GHashTable *recovery_files;
 
+	/* Results of previous extractions, may be NULL */
+	TrackerExtractCache *cache;
+
 	/* DBus name -> AppData */
 	GHashTable *apps;
 	TrackerExtractDBusPriority *iface;
@@ -133,6 +155,7 @@ tracker_extract_decorator_finalize (GObject *object)
 	if (priv->timer)
 		g_timer_destroy (priv->timer);
 
+	g_clear_object (&priv->cache);
 	g_object_unref (priv->iface);
 	g_hash_table_unref (priv->apps);
 	g_hash_table_unref (priv->recovery_files);
@@ -177,46 +200,160 @@ decorator_save_info (TrackerSparqlBuilder    *sparql,
 }
 
 static void
-get_metadata_cb (TrackerExtract *extract,
-                 GAsyncResult   *result,
-                 ExtractData    *data)
+extract_data_complete (ExtractData *data)
 {
-	TrackerExtractDecoratorPrivate *priv;
-	TrackerExtractInfo *info;
-	GError *error = NULL;
 	GTask *task;
 
-	priv = TRACKER_EXTRACT_DECORATOR (data->decorator)->priv;
 	task = tracker_decorator_info_get_task (data->decorator_info);
-	info = tracker_extract_file_finish (extract, result, &error);
-
-	tracker_extract_persistence_remove_file (priv->persistence, data->file);
-	g_hash_table_remove (priv->recovery_files, tracker_decorator_info_get_url (data->decorator_info));
 
-	if (error) {
-		if (error->domain == TRACKER_EXTRACT_ERROR) {
-			g_message ("Extraction failed: %s\n", error ? error->message : "no error given");
+	if (data->error) {
+		if (g_error_matches (data->error, TRACKER_EXTRACT_ERROR,
+		                     TRACKER_EXTRACT_ERROR_CRASHED)) {
+			gchar *sparql;
+
+			/* Retrying was already done by the worker pool, don't
+			 * let the file crash more workers on the next run.
+			 */
+			g_message ("Extraction failed, ignoring file: %s",
+			           data->error->message);
+			sparql = g_strdup_printf ("INSERT { GRAPH <" TRACKER_OWN_GRAPH_URN "> {"
+			                          "  <%s> nie:dataSource <" TRACKER_EXTRACT_DATA_SOURCE ">;"
+			                          "       nie:dataSource <" TRACKER_EXTRACT_FAILURE_DATA_SOURCE ">."
+			                          "} }",
+			                          tracker_decorator_info_get_urn (data->decorator_info));
+			tracker_sparql_builder_append (g_task_get_task_data (task), sparql);
+			g_task_return_boolean (task, TRUE);
+			g_clear_error (&data->error);
+			g_free (sparql);
+		} else if (data->error->domain == TRACKER_EXTRACT_ERROR) {
+			g_message ("Extraction failed: %s\n", data->error->message);
 			g_task_return_boolean (task, FALSE);
-			g_clear_error (&error);
+			g_clear_error (&data->error);
 		} else {
-			g_task_return_error (task, error);
+			g_task_return_error (task, data->error);
+			data->error = NULL;
 		}
 	} else {
 		decorator_save_info (g_task_get_task_data (task),
 		                     TRACKER_EXTRACT_DECORATOR (data->decorator),
-		                     data->decorator_info, info);
+		                     data->decorator_info, data->info);
 		g_task_return_boolean (task, TRUE);
-		tracker_extract_info_unref (info);
+		tracker_extract_info_unref (data->info);
 	}
 
-	priv->n_extracting_files--;
-	decorator_get_next_file (data->decorator);
-
 	tracker_decorator_info_unref (data->decorator_info);
 	g_object_unref (data->file);
+	g_free (data->cache_key);
 	g_free (data);
 }
 
+static void
+extract_data_done (ExtractData *data)
+{
+	TrackerExtractDecoratorPrivate *priv;
+	TrackerDecorator *decorator;
+
+	decorator = data->decorator;
+	priv = TRACKER_EXTRACT_DECORATOR (decorator)->priv;
+	data->done = TRUE;
+
+	/* The slot is free, even if the result has to wait */
+	priv->n_extracting_files--;
+
+	g_hash_table_remove (priv->recovery_files, tracker_decorator_info_get_url (data->decorator_info));
+
+	/* Files finishing out of order wait for the ones before them */
+	while (!g_queue_is_empty (&priv->extracting)) {
+		data = g_queue_peek_head (&priv->extracting);
+
+		if (!data->done)
+			break;
+
+		g_queue_pop_head (&priv->extracting);
+		extract_data_complete (data);
+	}
+
+	decorator_get_next_file (decorator);
+}
+
+static void
+get_metadata_cb (TrackerExtract *extract,
+                 GAsyncResult   *result,
+                 ExtractData    *data)
+{
+	TrackerExtractDecoratorPrivate *priv;
+	TrackerResource *resource;
+
+	priv = TRACKER_EXTRACT_DECORATOR (data->decorator)->priv;
+	data->info = tracker_extract_file_finish (extract, result, &data->error);
+
+	tracker_extract_persistence_remove_file (priv->persistence, data->file);
+
+	/* Stored before decorator_save_info() binds it to the file's URN */
+	if (data->info && data->cache_key) {
+		resource = tracker_extract_info_get_resource (data->info);
+
+		if (resource) {
+			tracker_extract_cache_store (priv->cache, data->cache_key,
+			                             data->file, resource);
+		}
+	}
+
+	extract_data_done (data);
+}
+
+static void
+extract_data_run (ExtractData *data)
+{
+	TrackerExtractDecoratorPrivate *priv;
+	GTask *task;
+
+	priv = TRACKER_EXTRACT_DECORATOR (data->decorator)->priv;
+	task = tracker_decorator_info_get_task (data->decorator_info);
+
+	tracker_extract_persistence_add_file (priv->persistence, data->file);
+
+	tracker_extract_file (priv->extractor,
+	                      tracker_decorator_info_get_url (data->decorator_info),
+	                      tracker_decorator_info_get_mimetype (data->decorator_info),
+	                      g_task_get_cancellable (task),
+	                      (GAsyncReadyCallback) get_metadata_cb, data);
+}
+
+static void
+cache_lookup_cb (TrackerExtractCache *cache,
+                 GAsyncResult        *result,
+                 ExtractData         *data)
+{
+	TrackerResource *resource;
+	GError *error = NULL;
+
+	resource = tracker_extract_cache_lookup_finish (cache, result,
+	                                                &data->cache_key,
+	                                                &error);
+	if (error) {
+		g_debug ("Could not look up extraction cache for '%s': %s",
+		         tracker_decorator_info_get_url (data->decorator_info),
+		         error->message);
+		g_error_free (error);
+	}
+
+	if (!resource) {
+		extract_data_run (data);
+		return;
+	}
+
+	g_message ("Using cached metadata for '%s'",
+	           tracker_decorator_info_get_url (data->decorator_info));
+
+	data->info = tracker_extract_info_new (data->file,
+	                                       tracker_decorator_info_get_mimetype (data->decorator_info));
+	tracker_extract_info_set_resource (data->info, resource);
+	g_object_unref (resource);
+
+	extract_data_done (data);
+}
+
 static GFile *
 decorator_get_recovery_file (TrackerExtractDecorator *decorator,
                              TrackerDecoratorInfo    *info)
@@ -246,7 +383,6 @@ decorator_next_item_cb (TrackerDecorator *decorator,
 	TrackerDecoratorInfo *info;
 	GError *error = NULL;
 	ExtractData *data;
-	GTask *task;
 
 	priv = TRACKER_EXTRACT_DECORATOR (decorator)->priv;
 	info = tracker_decorator_next_finish (decorator, result, &error);
@@ -275,17 +411,20 @@ decorator_next_item_cb (TrackerDecorator *decorator,
 	data->decorator = decorator;
 	data->decorator_info = info;
 	data->file = decorator_get_recovery_file (TRACKER_EXTRACT_DECORATOR (decorator), info);
-	task = tracker_decorator_info_get_task (info);
 
 	g_message ("Extracting metadata for '%s'", tracker_decorator_info_get_url (info));
 
-	tracker_extract_persistence_add_file (priv->persistence, data->file);
+	g_queue_push_tail (&priv->extracting, data);
 
-	tracker_extract_file (priv->extractor,
-	                      tracker_decorator_info_get_url (info),
-	                      tracker_decorator_info_get_mimetype (info),
-	                      g_task_get_cancellable (task),
-	                      (GAsyncReadyCallback) get_metadata_cb, data);
+	if (priv->cache) {
+		tracker_extract_cache_lookup_async (priv->cache, data->file,
+		                                    tracker_decorator_info_get_mimetype (info),
+		                                    g_task_get_cancellable (tracker_decorator_info_get_task (info)),
+		                                    (GAsyncReadyCallback) cache_lookup_cb,
+		                                    data);
+	} else {
+		extract_data_run (data);
+	}
 }
 
 static void
@@ -301,7 +440,9 @@ decorator_get_next_file (TrackerDecorator *decorator)
 		return;
 
 	available_items = tracker_decorator_get_n_items (decorator);
-	while (priv->n_extracting_files < MAX_EXTRACTING_FILES &&
+	while (priv->n_extracting_files < priv->max_extracting_files &&
+	       g_queue_get_length (&priv->extracting) <
+	       priv->max_extracting_files * MAX_HELD_BACK_FACTOR &&
 	       available_items > 0) {
 		priv->n_extracting_files++;
 		available_items--;
@@ -605,6 +746,7 @@ tracker_extract_decorator_init (TrackerExtractDecorator *decorator)
 	TrackerExtractDecoratorPrivate *priv;
 
 	decorator->priv = priv = TRACKER_EXTRACT_DECORATOR_GET_PRIVATE (decorator);
+	g_queue_init (&priv->extracting);
 	priv->recovery_files = g_hash_table_new_full (g_str_hash, g_str_equal,
 	                                              (GDestroyNotify) g_free,
 	                                              (GDestroyNotify) g_object_unref);
@@ -619,10 +761,27 @@ tracker_extract_decorator_initable_init (GInitable     *initable,
 	TrackerExtractDecoratorPrivate *priv;
 	GDBusConnection                *conn;
 	gboolean                        ret = TRUE;
+	gint                            cache_size;
 
 	decorator = TRACKER_EXTRACT_DECORATOR (initable);
 	priv = decorator->priv;
 
+	priv->max_extracting_files =
+		tracker_config_get_max_extracting_files (tracker_main_get_config ());
+	if (priv->max_extracting_files == 0)
+		priv->max_extracting_files = g_get_num_processors ();
+
+	cache_size = tracker_config_get_cache_size (tracker_main_get_config ());
+	if (cache_size > 0) {
+		gchar *cache_path;
+
+		cache_path = g_build_filename (g_get_user_cache_dir (), "tracker",
+		                               "extract-cache", NULL);
+		priv->cache = tracker_extract_cache_new (cache_path,
+		                                         (guint64) cache_size * 1024 * 1024);
+		g_free (cache_path);
+	}
+
 	priv->apps = g_hash_table_new_full (g_str_hash,
 	                                    g_str_equal,
 	                                    g_free,
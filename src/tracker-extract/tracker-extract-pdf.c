@@ -51,6 +51,17 @@
 /* Time in seconds before we stop processing content */
 #define EXTRACTION_PROCESS_TIMEOUT 10
 
+/* Most threads extracting page text from a single document, each
+ * of them parses the document on its own.
+ */
+#define MAX_EXTRACTION_THREADS 4
+
+/* Extra threads are only worth parsing the document again for large
+ * files, and are given at least this many pages each.
+ */
+#define THREADED_EXTRACTION_MIN_SIZE (1024 * 1024)
+#define THREADED_EXTRACTION_MIN_PAGES 16
+
 typedef struct {
 	gchar *title;
 	gchar *subject;
@@ -60,6 +71,33 @@ typedef struct {
 	gchar *keywords;
 } PDFData;
 
+typedef struct {
+	/* PDF data, shared by the documents of all threads */
+	gchar *contents;
+	gsize len;
+
+	gint n_pages;
+	gint64 deadline;
+
+	/* Accessed atomically */
+	gint next_page;
+	gint n_pages_extracted;
+	gint budget_reached;
+
+	/* Full text of each page, in page order */
+	gchar **texts;
+	gsize *text_lens;
+
+	/* Pages 0 to n_prefix_pages - 1 are extracted, and hold
+	 * prefix_bytes of text, protected by the mutex.
+	 */
+	GMutex mutex;
+	gboolean *done;
+	gint n_prefix_pages;
+	gsize prefix_bytes;
+	gsize budget;
+} PageExtraction;
+
 static void
 read_toc (PopplerIndexIter  *index,
           GString          **toc)
@@ -192,64 +230,176 @@ read_outline (PopplerDocument *document,
 	}
 }
 
-static gchar *
-extract_content_text (PopplerDocument *document,
-                      gsize            n_bytes)
+/* Stores the text of page @i. Once the pages before it are done
+ * too and their text fills the budget, no more pages are handed out.
+ * Which pages are used only depends on page order, not on the order
+ * in which threads finish them.
+ */
+static void
+page_extraction_finish_page (PageExtraction *extraction,
+                             gint            i,
+                             gchar          *text)
 {
-	GString *string;
-	GTimer *timer;
-	gsize remaining_bytes;
-	gint n_pages, i;
-	gdouble elapsed;
-
-	n_pages = poppler_document_get_n_pages (document);
-	string = g_string_new ("");
-	timer = g_timer_new ();
-
-	for (i = 0, remaining_bytes = n_bytes, elapsed = g_timer_elapsed (timer, NULL);
-	     i < n_pages && remaining_bytes > 0 && elapsed < EXTRACTION_PROCESS_TIMEOUT;
-	     i++, elapsed = g_timer_elapsed (timer, NULL)) {
+	g_mutex_lock (&extraction->mutex);
+
+	extraction->texts[i] = text;
+	extraction->text_lens[i] = text ? strlen (text) : 0;
+	extraction->done[i] = TRUE;
+
+	while (extraction->n_prefix_pages < extraction->n_pages &&
+	       extraction->done[extraction->n_prefix_pages]) {
+		extraction->prefix_bytes += extraction->text_lens[extraction->n_prefix_pages];
+		extraction->n_prefix_pages++;
+	}
+
+	if (extraction->prefix_bytes >= extraction->budget)
+		g_atomic_int_set (&extraction->budget_reached, TRUE);
+
+	g_mutex_unlock (&extraction->mutex);
+}
+
+static void
+page_extraction_run (PageExtraction  *extraction,
+                     PopplerDocument *document)
+{
+	gint i;
+
+	while (!g_atomic_int_get (&extraction->budget_reached) &&
+	       g_get_monotonic_time () < extraction->deadline) {
 		PopplerPage *page;
-		gsize written_bytes = 0;
 		gchar *text;
 
+		i = g_atomic_int_add (&extraction->next_page, 1);
+
+		if (i >= extraction->n_pages)
+			break;
+
 		page = poppler_document_get_page (document, i);
-		text = poppler_page_get_text (page);
+		text = page ? poppler_page_get_text (page) : NULL;
+		g_clear_object (&page);
 
-		if (!text) {
-			g_object_unref (page);
-			continue;
-		}
+		g_atomic_int_inc (&extraction->n_pages_extracted);
 
-		if (tracker_text_validate_utf8 (text,
-		                                MIN (strlen (text), remaining_bytes),
-		                                &string,
-		                                &written_bytes)) {
-			g_string_append_c (string, ' ');
-		}
+		g_debug ("Extracted %" G_GSIZE_FORMAT " bytes from page %d",
+		         text ? strlen (text) : 0, i);
 
-		remaining_bytes -= written_bytes;
+		page_extraction_finish_page (extraction, i, text);
+	}
+}
 
-		g_debug ("Extracted %" G_GSIZE_FORMAT " bytes from page %d, "
-		         "%" G_GSIZE_FORMAT " bytes remaining",
-		         written_bytes, i, remaining_bytes);
+static gpointer
+page_extraction_thread (gpointer user_data)
+{
+	PageExtraction *extraction = user_data;
+	PopplerDocument *document;
+	GError *error = NULL;
 
-		g_free (text);
-		g_object_unref (page);
+	/* Poppler documents can't be shared across threads, but the
+	 * data can.
+	 */
+	document = poppler_document_new_from_data (extraction->contents,
+	                                           extraction->len,
+	                                           NULL, &error);
+	if (!document) {
+		g_debug ("Could not open document for page extraction: %s",
+		         error ? error->message : "no error given");
+		g_clear_error (&error);
+		return NULL;
+	}
+
+	page_extraction_run (extraction, document);
+	g_object_unref (document);
+
+	return NULL;
+}
+
+static gchar *
+extract_content_text (PopplerDocument *document,
+                      gchar           *contents,
+                      gsize            len,
+                      gsize            n_bytes)
+{
+	PageExtraction extraction = { 0 };
+	GThread *threads[MAX_EXTRACTION_THREADS - 1];
+	GString *string;
+	gint64 start;
+	gint i, n_threads = 0;
+	gsize remaining;
+
+	start = g_get_monotonic_time ();
+
+	extraction.contents = contents;
+	extraction.len = len;
+	extraction.n_pages = poppler_document_get_n_pages (document);
+	extraction.deadline = start + EXTRACTION_PROCESS_TIMEOUT * G_USEC_PER_SEC;
+	extraction.budget = n_bytes;
+	extraction.budget_reached = (n_bytes == 0);
+	extraction.texts = g_new0 (gchar *, extraction.n_pages);
+	extraction.text_lens = g_new0 (gsize, extraction.n_pages);
+	extraction.done = g_new0 (gboolean, extraction.n_pages);
+	g_mutex_init (&extraction.mutex);
+
+	/* Pages are handed out in order to whichever thread is free,
+	 * this thread uses the already loaded document.
+	 */
+	if (contents && len >= THREADED_EXTRACTION_MIN_SIZE) {
+		n_threads = MIN (g_get_num_processors (), MAX_EXTRACTION_THREADS);
+		n_threads = MIN (n_threads, extraction.n_pages / THREADED_EXTRACTION_MIN_PAGES);
+		n_threads = MAX (n_threads - 1, 0);
 	}
 
-	if (elapsed >= EXTRACTION_PROCESS_TIMEOUT) {
+	for (i = 0; i < n_threads; i++) {
+		threads[i] = g_thread_new ("pdf-text", page_extraction_thread, &extraction);
+	}
+
+	page_extraction_run (&extraction, document);
+
+	for (i = 0; i < n_threads; i++) {
+		g_thread_join (threads[i]);
+	}
+
+	if (g_get_monotonic_time () >= extraction.deadline) {
 		g_debug ("Extraction timed out, %d seconds reached", EXTRACTION_PROCESS_TIMEOUT);
 	}
 
-	g_debug ("Content extraction finished: %d/%d pages indexed in %2.2f seconds, "
-	         "%" G_GSIZE_FORMAT " bytes extracted",
-	         i,
-	         n_pages,
-	         g_timer_elapsed (timer, NULL),
-	         (n_bytes - remaining_bytes));
+	/* The budget is spent in page order */
+	remaining = n_bytes;
+	string = g_string_sized_new (MIN (extraction.prefix_bytes, n_bytes) + extraction.n_pages);
+
+	for (i = 0; i < extraction.n_pages; i++) {
+		gsize valid_len = 0;
+
+		if (!extraction.texts[i])
+			continue;
+
+		if (remaining > 0) {
+			tracker_text_validate_utf8 (extraction.texts[i],
+			                            MIN (extraction.text_lens[i], remaining),
+			                            NULL,
+			                            &valid_len);
+		}
+
+		if (valid_len > 0) {
+			g_string_append_len (string, extraction.texts[i], valid_len);
+			g_string_append_c (string, ' ');
+			remaining -= valid_len;
+		}
+
+		g_free (extraction.texts[i]);
+	}
+
+	g_debug ("Content extraction finished: %d/%d pages indexed in %2.2f seconds "
+	         "using %d threads, %" G_GSIZE_FORMAT " bytes extracted",
+	         MIN (extraction.n_pages_extracted, extraction.n_pages),
+	         extraction.n_pages,
+	         (g_get_monotonic_time () - start) / (gdouble) G_USEC_PER_SEC,
+	         n_threads + 1,
+	         n_bytes - remaining);
 
-	g_timer_destroy (timer);
+	g_mutex_clear (&extraction.mutex);
+	g_free (extraction.texts);
+	g_free (extraction.text_lens);
+	g_free (extraction.done);
 
 	return g_string_free (string, FALSE);
 }
@@ -589,7 +739,7 @@ tracker_extract_get_metadata (TrackerExtractInfo *info)
 
 	config = tracker_main_get_config ();
 	n_bytes = tracker_config_get_max_bytes (config);
-	content = extract_content_text (document, n_bytes);
+	content = extract_content_text (document, contents, len, n_bytes);
 
 	if (content) {
 		tracker_resource_set_string (metadata, "nie:plainTextContent", content);
@@ -39,11 +39,12 @@
 #include "tracker-main.h"
 #include "tracker-read.h"
 
-static gchar *
+static GBytes *
 get_file_content (GFile *file,
                   gsize  n_bytes)
 {
-	gchar *text, *uri, *path;
+	gchar *uri, *path;
+	GBytes *text;
 	int fd;
 
 	/* If no content requested, return */
@@ -71,9 +72,10 @@ get_file_content (GFile *file,
 	         uri, n_bytes);
 
 	/* Read up to n_bytes from stream. Output is always, always valid UTF-8,
-	 * this function closes the FD.
+	 * this function closes the FD. The text is mapped from the file
+	 * unless it had to be converted.
 	 */
-	text = tracker_read_text_from_fd (fd, n_bytes);
+	text = tracker_read_text_bytes_from_fd (fd, n_bytes);
 	g_free (uri);
 	g_free (path);
 
@@ -85,7 +87,7 @@ tracker_extract_get_metadata (TrackerExtractInfo *info)
 {
 	TrackerResource *metadata;
 	TrackerConfig *config;
-	gchar *content;
+	GBytes *content;
 
 	config = tracker_main_get_config ();
 
@@ -97,8 +99,9 @@ tracker_extract_get_metadata (TrackerExtractInfo *info)
 	tracker_resource_add_uri (metadata, "rdf:type", "nfo:FileDataObject");
 
 	if (content) {
-		tracker_resource_set_string (metadata, "nie:plainTextContent", content);
-		g_free (content);
+		tracker_resource_set_string (metadata, "nie:plainTextContent",
+		                             g_bytes_get_data (content, NULL));
+		g_bytes_unref (content);
 	}
 
 	tracker_extract_info_set_resource (info, metadata);
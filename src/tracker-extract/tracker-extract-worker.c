@@ -0,0 +1,955 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include <glib-unix.h>
+
+#include <libtracker-common/tracker-common.h>
+#include <libtracker-extract/tracker-extract.h>
+
+#include "tracker-extract-worker.h"
+
+/* Times a file is handed to a fresh worker after crashing one */
+#define MAX_ATTEMPTS 2
+
+/* Seconds before replacing a worker that died without handling any
+ * file, so a broken setup doesn't turn into a respawn loop.
+ */
+#define RESPAWN_TIMEOUT 1
+
+/* Replies bigger than this are taken as a misbehaving worker */
+#define MAX_REPLY_SIZE (16 * 1024 * 1024)
+
+/* Seconds a worker gets to handle a file before it's taken as hung
+ * and killed, like a crashing one.
+ */
+#define REQUEST_TIMEOUT 30
+
+/* Messages are a native endian guint32 size followed by a serialized
+ * GVariant, requests hold the URI and mimetype (empty if unknown),
+ * replies hold whether extraction succeeded, the mimetype used, the
+ * serialized resource if any, a #TrackerExtractError code and an
+ * error message.
+ */
+#define REQUEST_TYPE "(ss)"
+#define REPLY_TYPE   "(bsmvis)"
+
+typedef struct _TrackerExtractWorkerPoolPrivate TrackerExtractWorkerPoolPrivate;
+typedef struct _Worker Worker;
+typedef struct _WorkerRequest WorkerRequest;
+
+struct _WorkerRequest
+{
+	TrackerExtractWorkerPool *pool;
+	gint ref_count;
+	GTask *task;
+	gchar *uri;
+	gchar *mimetype;
+	guint n_attempts;
+	gulong cancelled_id;
+
+	/* Set while a worker handles the request */
+	Worker *worker;
+	guint timeout_id;
+};
+
+struct _Worker
+{
+	TrackerExtractWorkerPool *pool;
+	GSubprocess *process;
+	gint fd;
+	guint source_id;
+	GByteArray *input;
+	WorkerRequest *request;
+	guint n_handled;
+};
+
+struct _TrackerExtractWorkerPoolPrivate
+{
+	gchar **argv;
+	guint n_workers;
+	GPtrArray *workers;
+	GQueue pending;
+	guint respawn_id;
+	guint request_timeout;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (TrackerExtractWorkerPool, tracker_extract_worker_pool, G_TYPE_OBJECT)
+
+static void pool_dispatch (TrackerExtractWorkerPool *pool);
+
+static gboolean
+send_all (gint           fd,
+          const guint8  *data,
+          gsize          len,
+          GError       **error)
+{
+	while (len > 0) {
+		gssize n;
+
+		n = send (fd, data, len, MSG_NOSIGNAL);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+
+			g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+			             "Could not send message: %s", g_strerror (errno));
+			return FALSE;
+		}
+
+		data += n;
+		len -= n;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+send_message (gint       fd,
+              GVariant  *message,
+              GError   **error)
+{
+	guint32 size;
+	gboolean success;
+
+	g_variant_ref_sink (message);
+	size = g_variant_get_size (message);
+
+	success = (send_all (fd, (const guint8 *) &size, sizeof (size), error) &&
+	           send_all (fd, g_variant_get_data (message), size, error));
+
+	g_variant_unref (message);
+
+	return success;
+}
+
+static WorkerRequest *
+worker_request_ref (WorkerRequest *request)
+{
+	g_atomic_int_inc (&request->ref_count);
+	return request;
+}
+
+static void
+worker_request_unref (WorkerRequest *request)
+{
+	if (!g_atomic_int_dec_and_test (&request->ref_count))
+		return;
+
+	g_object_unref (request->task);
+	g_free (request->uri);
+	g_free (request->mimetype);
+	g_slice_free (WorkerRequest, request);
+}
+
+static void
+worker_request_finish (WorkerRequest *request)
+{
+	GCancellable *cancellable;
+
+	cancellable = g_task_get_cancellable (request->task);
+
+	if (cancellable && request->cancelled_id != 0)
+		g_cancellable_disconnect (cancellable, request->cancelled_id);
+
+	if (request->timeout_id != 0)
+		g_source_remove (request->timeout_id);
+
+	request->cancelled_id = 0;
+	request->timeout_id = 0;
+	request->worker = NULL;
+}
+
+/* The worker is found dead afterwards, and the request is retried
+ * or failed as if it crashed.
+ */
+static gboolean
+request_timeout_cb (WorkerRequest *request)
+{
+	request->timeout_id = 0;
+
+	g_message ("Extractor worker %s took too long processing '%s', killing it",
+	           g_subprocess_get_identifier (request->worker->process),
+	           request->uri);
+	g_subprocess_force_exit (request->worker->process);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+request_cancelled_idle (WorkerRequest *request)
+{
+	Worker *worker = request->worker;
+
+	/* There's no interrupting a module, the worker is replaced */
+	if (worker) {
+		g_message ("Cancelled task for '%s' was currently being "
+		           "processed, killing worker",
+		           request->uri);
+		g_subprocess_force_exit (worker->process);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+/* This function may be called on the thread calling g_cancellable_cancel(),
+ * workers are only ever looked at in the main context, where they die.
+ */
+static void
+request_cancelled_cb (GCancellable  *cancellable,
+                      WorkerRequest *request)
+{
+	g_main_context_invoke_full (NULL, G_PRIORITY_DEFAULT,
+	                            (GSourceFunc) request_cancelled_idle,
+	                            worker_request_ref (request),
+	                            (GDestroyNotify) worker_request_unref);
+}
+
+static void
+worker_free (Worker *worker)
+{
+	if (worker->source_id)
+		g_source_remove (worker->source_id);
+
+	g_subprocess_force_exit (worker->process);
+	g_object_unref (worker->process);
+	close (worker->fd);
+	g_byte_array_unref (worker->input);
+	g_slice_free (Worker, worker);
+}
+
+static gboolean worker_fd_cb (gint          fd,
+                              GIOCondition  condition,
+                              Worker       *worker);
+
+static Worker *
+worker_new (TrackerExtractWorkerPool  *pool,
+            GError                   **error)
+{
+	TrackerExtractWorkerPoolPrivate *priv;
+	GSubprocessLauncher *launcher;
+	GSubprocess *process;
+	Worker *worker;
+	gint fds[2];
+
+	priv = tracker_extract_worker_pool_get_instance_private (pool);
+
+	if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+		g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+		             "Could not create socket pair: %s", g_strerror (errno));
+		return NULL;
+	}
+
+	launcher = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_NONE);
+	g_subprocess_launcher_take_fd (launcher, fds[1], TRACKER_EXTRACT_WORKER_FD);
+	process = g_subprocess_launcher_spawnv (launcher,
+	                                        (const gchar * const *) priv->argv,
+	                                        error);
+	/* Closes the worker end of the socket pair here */
+	g_object_unref (launcher);
+
+	if (!process) {
+		close (fds[0]);
+		return NULL;
+	}
+
+	g_unix_set_fd_nonblocking (fds[0], TRUE, NULL);
+
+	worker = g_slice_new0 (Worker);
+	worker->pool = pool;
+	worker->process = process;
+	worker->fd = fds[0];
+	worker->input = g_byte_array_new ();
+	worker->source_id = g_unix_fd_add (worker->fd,
+	                                   G_IO_IN | G_IO_HUP | G_IO_ERR,
+	                                   (GUnixFDSourceFunc) worker_fd_cb,
+	                                   worker);
+
+	g_debug ("Started extractor worker %s",
+	         g_subprocess_get_identifier (process));
+
+	return worker;
+}
+
+static gboolean
+pool_respawn_cb (gpointer user_data)
+{
+	TrackerExtractWorkerPool *pool = user_data;
+	TrackerExtractWorkerPoolPrivate *priv;
+
+	priv = tracker_extract_worker_pool_get_instance_private (pool);
+	priv->respawn_id = 0;
+	pool_dispatch (pool);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Fails all pending requests if no worker can be started */
+static void
+pool_fail_pending (TrackerExtractWorkerPool *pool,
+                   const GError             *error)
+{
+	TrackerExtractWorkerPoolPrivate *priv;
+	WorkerRequest *request;
+
+	priv = tracker_extract_worker_pool_get_instance_private (pool);
+
+	while ((request = g_queue_pop_head (&priv->pending)) != NULL) {
+		g_task_return_error (request->task, g_error_copy (error));
+		worker_request_unref (request);
+	}
+}
+
+static void
+pool_ensure_workers (TrackerExtractWorkerPool *pool)
+{
+	TrackerExtractWorkerPoolPrivate *priv;
+	GError *error = NULL;
+	Worker *worker;
+
+	priv = tracker_extract_worker_pool_get_instance_private (pool);
+
+	if (priv->respawn_id != 0)
+		return;
+
+	while (priv->workers->len < priv->n_workers) {
+		worker = worker_new (pool, &error);
+
+		if (!worker) {
+			g_warning ("Could not start extractor worker: %s",
+			           error->message);
+
+			if (priv->workers->len == 0)
+				pool_fail_pending (pool, error);
+
+			g_error_free (error);
+			break;
+		}
+
+		g_ptr_array_add (priv->workers, worker);
+	}
+}
+
+static void
+worker_died (Worker *worker)
+{
+	TrackerExtractWorkerPool *pool = worker->pool;
+	TrackerExtractWorkerPoolPrivate *priv;
+	WorkerRequest *request;
+
+	priv = tracker_extract_worker_pool_get_instance_private (pool);
+	request = worker->request;
+
+	if (request) {
+		g_message ("Extractor worker %s died while processing '%s'",
+		           g_subprocess_get_identifier (worker->process),
+		           request->uri);
+
+		worker_request_finish (request);
+
+		if (g_task_return_error_if_cancelled (request->task)) {
+			worker_request_unref (request);
+		} else if (request->n_attempts < MAX_ATTEMPTS) {
+			g_queue_push_head (&priv->pending, request);
+		} else {
+			g_task_return_new_error (request->task,
+			                         TRACKER_EXTRACT_ERROR,
+			                         TRACKER_EXTRACT_ERROR_CRASHED,
+			                         "Extractor crashed on '%s'",
+			                         request->uri);
+			worker_request_unref (request);
+		}
+	} else {
+		g_message ("Extractor worker %s exited",
+		           g_subprocess_get_identifier (worker->process));
+	}
+
+	if (worker->n_handled == 0 && priv->respawn_id == 0) {
+		priv->respawn_id = g_timeout_add_seconds (RESPAWN_TIMEOUT,
+		                                          pool_respawn_cb,
+		                                          pool);
+	}
+
+	g_ptr_array_remove (priv->workers, worker);
+	worker_free (worker);
+
+	pool_dispatch (pool);
+}
+
+static void
+worker_handle_reply (Worker   *worker,
+                     GVariant *reply)
+{
+	WorkerRequest *request = worker->request;
+	const gchar *mimetype, *message;
+	GVariant *serialized;
+	gboolean success;
+	gint code;
+
+	worker->request = NULL;
+	worker->n_handled++;
+	worker_request_finish (request);
+
+	g_variant_get (reply, "(b&sm@vi&s)",
+	               &success, &mimetype, &serialized, &code, &message);
+
+	if (success) {
+		TrackerExtractInfo *info;
+		GFile *file;
+
+		file = g_file_new_for_uri (request->uri);
+		info = tracker_extract_info_new (file, mimetype);
+		g_object_unref (file);
+
+		if (serialized) {
+			TrackerResource *resource;
+			GVariant *variant;
+
+			variant = g_variant_get_variant (serialized);
+			resource = tracker_resource_deserialize (variant);
+			tracker_extract_info_set_resource (info, resource);
+			g_clear_object (&resource);
+			g_variant_unref (variant);
+		}
+
+		g_task_return_pointer (request->task, info,
+		                       (GDestroyNotify) tracker_extract_info_unref);
+	} else {
+		/* Crashes are only for the controller to tell */
+		if (code != TRACKER_EXTRACT_ERROR_NO_MIMETYPE)
+			code = TRACKER_EXTRACT_ERROR_NO_EXTRACTOR;
+
+		g_task_return_new_error (request->task,
+		                         TRACKER_EXTRACT_ERROR,
+		                         code, "%s", message);
+	}
+
+	if (serialized)
+		g_variant_unref (serialized);
+
+	worker_request_unref (request);
+}
+
+static gboolean
+worker_fd_cb (gint          fd,
+              GIOCondition  condition,
+              Worker       *worker)
+{
+	gboolean dead = FALSE;
+	guint8 buffer[4096];
+	guint32 size;
+
+	while (TRUE) {
+		gssize n;
+
+		n = read (fd, buffer, sizeof (buffer));
+
+		if (n > 0) {
+			g_byte_array_append (worker->input, buffer, n);
+		} else if (n < 0 && errno == EINTR) {
+			continue;
+		} else {
+			/* EOF or error, unless there's just nothing left to read */
+			dead = !(n < 0 && errno == EAGAIN);
+			break;
+		}
+	}
+
+	while (!dead && worker->input->len >= sizeof (size)) {
+		GVariant *reply;
+		GBytes *bytes;
+
+		memcpy (&size, worker->input->data, sizeof (size));
+
+		if (size > MAX_REPLY_SIZE) {
+			g_warning ("Reply from extractor worker %s is too big (%u bytes)",
+			           g_subprocess_get_identifier (worker->process),
+			           size);
+			dead = TRUE;
+			break;
+		}
+
+		if (worker->input->len < sizeof (size) + size)
+			break;
+
+		bytes = g_bytes_new (worker->input->data + sizeof (size), size);
+		g_byte_array_remove_range (worker->input, 0, sizeof (size) + size);
+
+		reply = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (REPLY_TYPE),
+		                                                      bytes, FALSE));
+		g_bytes_unref (bytes);
+
+		if (worker->request) {
+			worker_handle_reply (worker, reply);
+		} else {
+			g_warning ("Unexpected reply from extractor worker %s",
+			           g_subprocess_get_identifier (worker->process));
+			dead = TRUE;
+		}
+
+		g_variant_unref (reply);
+	}
+
+	if (dead) {
+		/* The source is removed by returning G_SOURCE_REMOVE */
+		worker->source_id = 0;
+		worker_died (worker);
+		return G_SOURCE_REMOVE;
+	}
+
+	pool_dispatch (worker->pool);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+worker_send_request (Worker        *worker,
+                     WorkerRequest *request)
+{
+	TrackerExtractWorkerPoolPrivate *priv;
+	GCancellable *cancellable;
+	GError *error = NULL;
+
+	priv = tracker_extract_worker_pool_get_instance_private (worker->pool);
+
+	if (!send_message (worker->fd,
+	                   g_variant_new (REQUEST_TYPE,
+	                                  request->uri,
+	                                  request->mimetype ? request->mimetype : ""),
+	                   &error)) {
+		g_warning ("Could not send request to extractor worker: %s",
+		           error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	request->n_attempts++;
+	request->worker = worker;
+	worker->request = request;
+
+	if (priv->request_timeout > 0) {
+		request->timeout_id = g_timeout_add_seconds (priv->request_timeout,
+		                                             (GSourceFunc) request_timeout_cb,
+		                                             request);
+	}
+
+	cancellable = g_task_get_cancellable (request->task);
+
+	if (cancellable) {
+		request->cancelled_id = g_cancellable_connect (cancellable,
+		                                               G_CALLBACK (request_cancelled_cb),
+		                                               request, NULL);
+	}
+
+	return TRUE;
+}
+
+static void
+pool_dispatch (TrackerExtractWorkerPool *pool)
+{
+	TrackerExtractWorkerPoolPrivate *priv;
+	guint i;
+
+	priv = tracker_extract_worker_pool_get_instance_private (pool);
+
+	if (g_queue_is_empty (&priv->pending))
+		return;
+
+	pool_ensure_workers (pool);
+
+	for (i = 0; i < priv->workers->len; i++) {
+		Worker *worker = g_ptr_array_index (priv->workers, i);
+		WorkerRequest *request;
+
+		if (worker->request)
+			continue;
+
+		request = g_queue_pop_head (&priv->pending);
+
+		while (request && g_task_return_error_if_cancelled (request->task)) {
+			worker_request_unref (request);
+			request = g_queue_pop_head (&priv->pending);
+		}
+
+		if (!request)
+			break;
+
+		if (!worker_send_request (worker, request)) {
+			/* The worker will be found dead and replaced */
+			g_queue_push_head (&priv->pending, request);
+			g_subprocess_force_exit (worker->process);
+		}
+	}
+}
+
+static void
+tracker_extract_worker_pool_finalize (GObject *object)
+{
+	TrackerExtractWorkerPoolPrivate *priv;
+	GError *error;
+	guint i;
+
+	priv = tracker_extract_worker_pool_get_instance_private (TRACKER_EXTRACT_WORKER_POOL (object));
+
+	if (priv->respawn_id)
+		g_source_remove (priv->respawn_id);
+
+	error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CANCELLED,
+	                             "Extractor is shutting down");
+
+	for (i = 0; i < priv->workers->len; i++) {
+		Worker *worker = g_ptr_array_index (priv->workers, i);
+
+		if (worker->request) {
+			g_queue_push_tail (&priv->pending, worker->request);
+			worker_request_finish (worker->request);
+			worker->request = NULL;
+		}
+	}
+
+	pool_fail_pending (TRACKER_EXTRACT_WORKER_POOL (object), error);
+	g_error_free (error);
+
+	g_ptr_array_unref (priv->workers);
+	g_strfreev (priv->argv);
+
+	G_OBJECT_CLASS (tracker_extract_worker_pool_parent_class)->finalize (object);
+}
+
+static void
+tracker_extract_worker_pool_class_init (TrackerExtractWorkerPoolClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = tracker_extract_worker_pool_finalize;
+}
+
+static void
+tracker_extract_worker_pool_init (TrackerExtractWorkerPool *pool)
+{
+	TrackerExtractWorkerPoolPrivate *priv;
+
+	priv = tracker_extract_worker_pool_get_instance_private (pool);
+	priv->workers = g_ptr_array_new_with_free_func ((GDestroyNotify) worker_free);
+	g_queue_init (&priv->pending);
+	priv->request_timeout = REQUEST_TIMEOUT;
+}
+
+/* Spawns @n_workers processes running @argv, each gets its end of
+ * the socket pair as %TRACKER_EXTRACT_WORKER_FD.
+ */
+TrackerExtractWorkerPool *
+tracker_extract_worker_pool_new_for_argv (const gchar * const  *argv,
+                                          guint                 n_workers,
+                                          GError              **error)
+{
+	TrackerExtractWorkerPool *pool;
+	TrackerExtractWorkerPoolPrivate *priv;
+	guint i;
+
+	g_return_val_if_fail (argv != NULL && argv[0] != NULL, NULL);
+	g_return_val_if_fail (n_workers > 0, NULL);
+
+	pool = g_object_new (TRACKER_TYPE_EXTRACT_WORKER_POOL, NULL);
+	priv = tracker_extract_worker_pool_get_instance_private (pool);
+	priv->n_workers = n_workers;
+	priv->argv = g_strdupv ((gchar **) argv);
+
+	/* Start them right away, so they're warm by the time files arrive */
+	for (i = 0; i < n_workers; i++) {
+		Worker *worker;
+
+		worker = worker_new (pool, error);
+
+		if (!worker) {
+			g_object_unref (pool);
+			return NULL;
+		}
+
+		g_ptr_array_add (priv->workers, worker);
+	}
+
+	return pool;
+}
+
+TrackerExtractWorkerPool *
+tracker_extract_worker_pool_new (guint         n_workers,
+                                 guint         memory_limit,
+                                 gint          verbosity,
+                                 const gchar  *force_module,
+                                 GError      **error)
+{
+	TrackerExtractWorkerPool *pool;
+	GPtrArray *argv;
+
+	/* Workers run this same binary */
+	argv = g_ptr_array_new_with_free_func (g_free);
+	g_ptr_array_add (argv, g_strdup ("/proc/self/exe"));
+	g_ptr_array_add (argv, g_strdup_printf ("--worker-fd=%d", TRACKER_EXTRACT_WORKER_FD));
+	g_ptr_array_add (argv, g_strdup_printf ("--worker-memory-limit=%u", memory_limit));
+	g_ptr_array_add (argv, g_strdup_printf ("--verbosity=%d", verbosity));
+	if (force_module)
+		g_ptr_array_add (argv, g_strdup_printf ("--force-module=%s", force_module));
+	g_ptr_array_add (argv, NULL);
+
+	pool = tracker_extract_worker_pool_new_for_argv ((const gchar * const *) argv->pdata,
+	                                                 n_workers, error);
+	g_ptr_array_unref (argv);
+
+	return pool;
+}
+
+/* Sets the seconds a worker gets to handle a file before it is
+ * killed, 0 to wait forever.
+ */
+void
+tracker_extract_worker_pool_set_timeout (TrackerExtractWorkerPool *pool,
+                                         guint                     seconds)
+{
+	TrackerExtractWorkerPoolPrivate *priv;
+
+	g_return_if_fail (TRACKER_IS_EXTRACT_WORKER_POOL (pool));
+
+	priv = tracker_extract_worker_pool_get_instance_private (pool);
+	priv->request_timeout = seconds;
+}
+
+static gboolean
+pool_push_cb (WorkerRequest *request)
+{
+	TrackerExtractWorkerPoolPrivate *priv;
+
+	priv = tracker_extract_worker_pool_get_instance_private (request->pool);
+	g_queue_push_tail (&priv->pending, request);
+	pool_dispatch (request->pool);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Hands the file to the next free worker, @task is returned a
+ * #TrackerExtractInfo, or an error.
+ *
+ * This function can be called in any thread.
+ */
+void
+tracker_extract_worker_pool_push (TrackerExtractWorkerPool *pool,
+                                  const gchar              *uri,
+                                  const gchar              *mimetype,
+                                  GTask                    *task)
+{
+	WorkerRequest *request;
+
+	g_return_if_fail (TRACKER_IS_EXTRACT_WORKER_POOL (pool));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (G_IS_TASK (task));
+
+	request = g_slice_new0 (WorkerRequest);
+	request->ref_count = 1;
+	request->pool = pool;
+	request->task = g_object_ref (task);
+	request->uri = g_strdup (uri);
+	request->mimetype = g_strdup (mimetype);
+
+	g_main_context_invoke (NULL, (GSourceFunc) pool_push_cb, request);
+}
+
+static gboolean
+read_all (gint    fd,
+          guint8 *data,
+          gsize   len)
+{
+	while (len > 0) {
+		gssize n;
+
+		n = read (fd, data, len);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return FALSE;
+
+		data += n;
+		len -= n;
+	}
+
+	return TRUE;
+}
+
+static GVariant *
+read_message (gint fd)
+{
+	guint32 size;
+	guint8 *data;
+	GBytes *bytes;
+	GVariant *message;
+
+	if (!read_all (fd, (guint8 *) &size, sizeof (size)))
+		return NULL;
+
+	data = g_malloc (size);
+
+	if (!read_all (fd, data, size)) {
+		g_free (data);
+		return NULL;
+	}
+
+	bytes = g_bytes_new_take (data, size);
+	message = g_variant_new_from_bytes (G_VARIANT_TYPE (REQUEST_TYPE), bytes, FALSE);
+	g_bytes_unref (bytes);
+
+	return g_variant_ref_sink (message);
+}
+
+/* Reads the next request sent to a worker, returns %FALSE once the
+ * other end is closed. @mimetype is set to %NULL if unknown.
+ */
+gboolean
+tracker_extract_worker_read_request (gint    fd,
+                                     gchar **uri,
+                                     gchar **mimetype)
+{
+	GVariant *request;
+	const gchar *str;
+
+	request = read_message (fd);
+
+	if (!request)
+		return FALSE;
+
+	g_variant_get (request, "(s&s)", uri, &str);
+	*mimetype = str[0] != '\0' ? g_strdup (str) : NULL;
+	g_variant_unref (request);
+
+	return TRUE;
+}
+
+/* Sends back the result of extracting the last requested file,
+ * either @info or @extract_error.
+ */
+gboolean
+tracker_extract_worker_send_reply (gint                 fd,
+                                   TrackerExtractInfo  *info,
+                                   const GError        *extract_error,
+                                   GError             **error)
+{
+	TrackerResource *resource;
+	GVariant *serialized = NULL, *reply;
+	gint code;
+
+	g_return_val_if_fail (info != NULL || extract_error != NULL, FALSE);
+
+	if (!info) {
+		code = extract_error->domain == TRACKER_EXTRACT_ERROR ?
+			extract_error->code : TRACKER_EXTRACT_ERROR_NO_EXTRACTOR;
+		reply = g_variant_new (REPLY_TYPE, FALSE, "", NULL, code,
+		                       extract_error->message);
+		return send_message (fd, reply, error);
+	}
+
+	resource = tracker_extract_info_get_resource (info);
+
+	if (resource) {
+		serialized = tracker_resource_serialize (resource);
+
+		if (!serialized) {
+			reply = g_variant_new (REPLY_TYPE, FALSE, "", NULL,
+			                       TRACKER_EXTRACT_ERROR_NO_EXTRACTOR,
+			                       "Extracted data could not be serialized");
+			return send_message (fd, reply, error);
+		}
+	}
+
+	reply = g_variant_new (REPLY_TYPE, TRUE,
+	                       tracker_extract_info_get_mimetype (info),
+	                       serialized, 0, "");
+
+	return send_message (fd, reply, error);
+}
+
+/* Loads the modules, locks the process down and extracts the files
+ * requested through @fd until the other end is closed.
+ */
+gint
+tracker_extract_worker_run (TrackerExtract *extract,
+                            gint            fd,
+                            guint           memory_limit)
+{
+	gchar *uri, *mimetype;
+
+#ifdef PR_SET_PDEATHSIG
+	/* Don't outlive the controller */
+	prctl (PR_SET_PDEATHSIG, SIGKILL);
+#endif
+
+	if (memory_limit > 0) {
+		struct rlimit rl;
+
+		rl.rlim_cur = rl.rlim_max = (rlim_t) memory_limit * 1024 * 1024;
+
+		if (setrlimit (RLIMIT_AS, &rl) != 0) {
+			g_warning ("Could not set worker memory limit: %s",
+			           g_strerror (errno));
+		}
+	}
+
+	tracker_module_manager_load_modules ();
+
+	if (!tracker_seccomp_init ())
+		return EXIT_FAILURE;
+
+	while (tracker_extract_worker_read_request (fd, &uri, &mimetype)) {
+		TrackerExtractInfo *info;
+		GError *extract_error = NULL, *error = NULL;
+		gboolean sent;
+
+		info = tracker_extract_file_sync (extract, uri, mimetype,
+		                                  &extract_error);
+		sent = tracker_extract_worker_send_reply (fd, info, extract_error,
+		                                          &error);
+
+		g_clear_pointer (&info, tracker_extract_info_unref);
+		g_clear_error (&extract_error);
+		g_free (uri);
+		g_free (mimetype);
+
+		if (!sent) {
+			g_warning ("Could not send reply to controller: %s",
+			           error->message);
+			g_error_free (error);
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
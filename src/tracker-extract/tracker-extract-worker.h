@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __TRACKER_EXTRACT_WORKER_H__
+#define __TRACKER_EXTRACT_WORKER_H__
+
+#include <gio/gio.h>
+
+#include "tracker-extract.h"
+
+G_BEGIN_DECLS
+
+/* Workers get their end of the socket pair as this fd */
+#define TRACKER_EXTRACT_WORKER_FD 3
+
+#define TRACKER_TYPE_EXTRACT_WORKER_POOL         (tracker_extract_worker_pool_get_type ())
+#define TRACKER_EXTRACT_WORKER_POOL(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), TRACKER_TYPE_EXTRACT_WORKER_POOL, TrackerExtractWorkerPool))
+#define TRACKER_EXTRACT_WORKER_POOL_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), TRACKER_TYPE_EXTRACT_WORKER_POOL, TrackerExtractWorkerPoolClass))
+#define TRACKER_IS_EXTRACT_WORKER_POOL(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), TRACKER_TYPE_EXTRACT_WORKER_POOL))
+#define TRACKER_IS_EXTRACT_WORKER_POOL_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), TRACKER_TYPE_EXTRACT_WORKER_POOL))
+#define TRACKER_EXTRACT_WORKER_POOL_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), TRACKER_TYPE_EXTRACT_WORKER_POOL, TrackerExtractWorkerPoolClass))
+
+typedef struct _TrackerExtractWorkerPool TrackerExtractWorkerPool;
+typedef struct _TrackerExtractWorkerPoolClass TrackerExtractWorkerPoolClass;
+
+struct _TrackerExtractWorkerPool
+{
+	GObject parent_instance;
+};
+
+struct _TrackerExtractWorkerPoolClass
+{
+	GObjectClass parent_class;
+};
+
+GType tracker_extract_worker_pool_get_type (void) G_GNUC_CONST;
+
+TrackerExtractWorkerPool *
+     tracker_extract_worker_pool_new          (guint                      n_workers,
+                                               guint                      memory_limit,
+                                               gint                       verbosity,
+                                               const gchar               *force_module,
+                                               GError                   **error);
+TrackerExtractWorkerPool *
+     tracker_extract_worker_pool_new_for_argv (const gchar * const       *argv,
+                                               guint                      n_workers,
+                                               GError                   **error);
+
+void tracker_extract_worker_pool_set_timeout  (TrackerExtractWorkerPool  *pool,
+                                               guint                      seconds);
+
+void tracker_extract_worker_pool_push         (TrackerExtractWorkerPool  *pool,
+                                               const gchar               *uri,
+                                               const gchar               *mimetype,
+                                               GTask                     *task);
+
+/* Runs in the worker processes */
+gint tracker_extract_worker_run               (TrackerExtract            *extract,
+                                               gint                       fd,
+                                               guint                      memory_limit);
+
+gboolean tracker_extract_worker_read_request  (gint                       fd,
+                                               gchar                    **uri,
+                                               gchar                    **mimetype);
+gboolean tracker_extract_worker_send_reply    (gint                       fd,
+                                               TrackerExtractInfo        *info,
+                                               const GError              *extract_error,
+                                               GError                   **error);
+
+G_END_DECLS
+
+#endif /* __TRACKER_EXTRACT_WORKER_H__ */
@@ -35,6 +35,7 @@
 #include <libtracker-extract/tracker-extract.h>
 
 #include "tracker-extract.h"
+#include "tracker-extract-worker.h"
 #include "tracker-main.h"
 
 #ifdef THREAD_ENABLE_TRACE
@@ -76,6 +77,9 @@ typedef struct {
 
 	gint unhandled_count;
 
+	/* Worker processes running the modules, may be NULL */
+	TrackerExtractWorkerPool *worker_pool;
+
 #ifdef HAVE_LIBMEDIAART
 	MediaArtProcess *media_art_process;
 #endif
@@ -134,7 +138,9 @@ tracker_extract_init (TrackerExtract *object)
 	                                               (GDestroyNotify) statistics_data_free);
 	priv->single_thread_extractors = g_hash_table_new (NULL, NULL);
 	priv->thread_pool = g_thread_pool_new ((GFunc) get_metadata,
-	                                       NULL, 10, TRUE, NULL);
+	                                       NULL,
+	                                       MAX (10, g_get_num_processors ()),
+	                                       TRUE, NULL);
 
 #ifdef HAVE_LIBMEDIAART
 	GError *error = NULL;
@@ -161,6 +167,7 @@ tracker_extract_finalize (GObject *object)
 
 	g_hash_table_destroy (priv->single_thread_extractors);
 	g_thread_pool_free (priv->thread_pool, TRUE, FALSE);
+	g_clear_object (&priv->worker_pool);
 
 	if (!priv->disable_summary_on_finalize) {
 		report_statistics (object);
@@ -648,6 +655,7 @@ tracker_extract_file (TrackerExtract      *extract,
                       GAsyncReadyCallback  cb,
                       gpointer             user_data)
 {
+	TrackerExtractPrivate *priv;
 	GError *error = NULL;
 	TrackerExtractTask *task;
 	GTask *async_task;
@@ -664,6 +672,15 @@ tracker_extract_file (TrackerExtract      *extract,
 
 	async_task = g_task_new (extract, cancellable, cb, user_data);
 
+	priv = TRACKER_EXTRACT_GET_PRIVATE (extract);
+
+	if (priv->worker_pool) {
+		tracker_extract_worker_pool_push (priv->worker_pool, file,
+		                                  mimetype, async_task);
+		g_object_unref (async_task);
+		return;
+	}
+
 	task = extract_task_new (extract, file, mimetype, cancellable,
 	                         G_ASYNC_RESULT (async_task), &error);
 
@@ -671,10 +688,6 @@ tracker_extract_file (TrackerExtract      *extract,
 		g_warning ("Could not get mimetype, %s", error->message);
 		g_task_return_error (async_task, error);
 	} else {
-		TrackerExtractPrivate *priv;
-
-		priv = TRACKER_EXTRACT_GET_PRIVATE (task->extract);
-
 		g_mutex_lock (&priv->task_mutex);
 		priv->running_tasks = g_list_prepend (priv->running_tasks, task);
 		g_mutex_unlock (&priv->task_mutex);
@@ -702,6 +715,57 @@ tracker_extract_get_media_art_process (TrackerExtract *extract)
 
 #endif
 
+/* Runs the modules handling @uri in the calling thread, until one
+ * of them succeeds.
+ */
+TrackerExtractInfo *
+tracker_extract_file_sync (TrackerExtract  *object,
+                           const gchar     *uri,
+                           const gchar     *mimetype,
+                           GError         **error)
+{
+	TrackerExtractTask *task;
+	TrackerExtractInfo *info = NULL;
+
+	g_return_val_if_fail (TRACKER_IS_EXTRACT (object), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+
+	task = extract_task_new (object, uri, mimetype, NULL, NULL, error);
+
+	if (!task)
+		return NULL;
+
+	task->mimetype_handlers = tracker_extract_module_manager_get_mimetype_handlers (task->mimetype);
+	if (task->mimetype_handlers) {
+		task->cur_module = tracker_mimetype_info_get_module (task->mimetype_handlers, &task->cur_func);
+	}
+
+	while (task->cur_func) {
+		if (!filter_module (object, task->cur_module) &&
+		    get_file_metadata (task, &info)) {
+			break;
+		}
+
+		if (!tracker_mimetype_info_iter_next (task->mimetype_handlers)) {
+			break;
+		}
+
+		task->cur_module = tracker_mimetype_info_get_module (task->mimetype_handlers,
+		                                                     &task->cur_func);
+	}
+
+	if (!info) {
+		g_set_error (error, tracker_extract_error_quark (),
+		             TRACKER_EXTRACT_ERROR_NO_EXTRACTOR,
+		             "Could not get any metadata for uri:'%s' and mime:'%s'",
+		             uri, task->mimetype);
+	}
+
+	extract_task_free (task);
+
+	return info;
+}
+
 void
 tracker_extract_get_metadata_by_cmdline (TrackerExtract *object,
                                          const gchar    *uri,
@@ -710,18 +774,17 @@ tracker_extract_get_metadata_by_cmdline (TrackerExtract *object,
 {
 	GError *error = NULL;
 	TrackerExtractPrivate *priv;
-	TrackerExtractTask *task;
 	TrackerExtractInfo *info;
-	gboolean no_data_or_modules = TRUE;
+	TrackerResource *resource = NULL;
 
 	priv = TRACKER_EXTRACT_GET_PRIVATE (object);
 	priv->disable_summary_on_finalize = TRUE;
 
 	g_return_if_fail (uri != NULL);
 
-	task = extract_task_new (object, uri, mime, NULL, NULL, &error);
+	info = tracker_extract_file_sync (object, uri, mime, &error);
 
-	if (error) {
+	if (error && error->domain != TRACKER_EXTRACT_ERROR) {
 		g_printerr ("%s, %s\n",
 		            _("Metadata extraction failed"),
 		            error->message);
@@ -730,69 +793,75 @@ tracker_extract_get_metadata_by_cmdline (TrackerExtract *object,
 		return;
 	}
 
-	task->mimetype_handlers = tracker_extract_module_manager_get_mimetype_handlers (task->mimetype);
-	if (task->mimetype_handlers) {
-		task->cur_module = tracker_mimetype_info_get_module (task->mimetype_handlers, &task->cur_func);
-	}
+	g_clear_error (&error);
 
-	while (task->cur_func) {
-		if (!filter_module (object, task->cur_module) &&
-		    get_file_metadata (task, &info)) {
-			TrackerResource *resource = tracker_extract_info_get_resource (info);
-
-			if (resource == NULL)
-				break;
+	if (info)
+		resource = tracker_extract_info_get_resource (info);
 
-			no_data_or_modules = FALSE;
+	if (resource) {
+		if (output_format == TRACKER_SERIALIZATION_FORMAT_SPARQL) {
+			char *text;
 
-			if (output_format == TRACKER_SERIALIZATION_FORMAT_SPARQL) {
-				char *text;
-
-				/* If this was going into the tracker-store we'd generate a unique ID
-				 * here, so that the data persisted across file renames.
-				 */
-				tracker_resource_set_identifier (resource, uri);
+			/* If this was going into the tracker-store we'd generate a unique ID
+			 * here, so that the data persisted across file renames.
+			 */
+			tracker_resource_set_identifier (resource, uri);
 
-				text = tracker_resource_print_sparql_update (resource, NULL, NULL);
+			text = tracker_resource_print_sparql_update (resource, NULL, NULL);
 
-				g_print ("%s\n", text);
+			g_print ("%s\n", text);
 
-				g_free (text);
-			} else if (output_format == TRACKER_SERIALIZATION_FORMAT_TURTLE) {
-				char *turtle;
+			g_free (text);
+		} else if (output_format == TRACKER_SERIALIZATION_FORMAT_TURTLE) {
+			char *turtle;
 
-				/* If this was going into the tracker-store we'd generate a unique ID
-				 * here, so that the data persisted across file renames.
-				 */
-				tracker_resource_set_identifier (resource, uri);
+			/* If this was going into the tracker-store we'd generate a unique ID
+			 * here, so that the data persisted across file renames.
+			 */
+			tracker_resource_set_identifier (resource, uri);
 
-				turtle = tracker_resource_print_turtle (resource, NULL);
+			turtle = tracker_resource_print_turtle (resource, NULL);
 
-				if (turtle) {
-					g_print ("%s\n", turtle);
-					g_free (turtle);
-				}
+			if (turtle) {
+				g_print ("%s\n", turtle);
+				g_free (turtle);
 			}
-
-			tracker_extract_info_unref (info);
-			break;
-		} else {
-			if (!tracker_mimetype_info_iter_next (task->mimetype_handlers)) {
-				break;
-			}
-
-			task->cur_module = tracker_mimetype_info_get_module (task->mimetype_handlers,
-			                                                     &task->cur_func);
 		}
-	}
-
-	if (no_data_or_modules) {
+	} else {
 		g_printerr ("%s: %s\n",
 		         uri,
 		         _("No metadata or extractor modules found to handle this file"));
 	}
 
-	extract_task_free (task);
+	if (info)
+		tracker_extract_info_unref (info);
+}
+
+/* Moves module execution out of process, into @n_workers sandboxed
+ * worker processes.
+ */
+gboolean
+tracker_extract_start_workers (TrackerExtract  *extract,
+                               guint            n_workers,
+                               guint            memory_limit,
+                               gint             verbosity,
+                               GError         **error)
+{
+	TrackerExtractPrivate *priv;
+
+	g_return_val_if_fail (TRACKER_IS_EXTRACT (extract), FALSE);
+	g_return_val_if_fail (n_workers > 0, FALSE);
+
+	priv = TRACKER_EXTRACT_GET_PRIVATE (extract);
+	g_return_val_if_fail (priv->worker_pool == NULL, FALSE);
+
+	priv->worker_pool = tracker_extract_worker_pool_new (n_workers,
+	                                                     memory_limit,
+	                                                     verbosity,
+	                                                     priv->force_module,
+	                                                     error);
+
+	return priv->worker_pool != NULL;
 }
 
 TrackerExtractInfo *
@@ -43,7 +43,8 @@ typedef struct TrackerExtractClass TrackerExtractClass;
 
 typedef enum {
 	TRACKER_EXTRACT_ERROR_NO_MIMETYPE,
-	TRACKER_EXTRACT_ERROR_NO_EXTRACTOR
+	TRACKER_EXTRACT_ERROR_NO_EXTRACTOR,
+	TRACKER_EXTRACT_ERROR_CRASHED
 } TrackerExtractError;
 
 struct TrackerExtract {
@@ -69,6 +70,17 @@ TrackerExtractInfo *
                 tracker_extract_file_finish             (TrackerExtract         *extract,
                                                          GAsyncResult           *res,
                                                          GError                **error);
+TrackerExtractInfo *
+                tracker_extract_file_sync               (TrackerExtract         *extract,
+                                                         const gchar            *file,
+                                                         const gchar            *mimetype,
+                                                         GError                **error);
+
+gboolean        tracker_extract_start_workers           (TrackerExtract         *extract,
+                                                         guint                   n_workers,
+                                                         guint                   memory_limit,
+                                                         gint                    verbosity,
+                                                         GError                **error);
 
 #ifdef HAVE_LIBMEDIAART
 MediaArtProcess *
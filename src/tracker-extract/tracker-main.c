@@ -51,6 +51,7 @@
 #include "tracker-extract.h"
 #include "tracker-extract-controller.h"
 #include "tracker-extract-decorator.h"
+#include "tracker-extract-worker.h"
 
 #ifdef THREAD_ENABLE_TRACE
 #warning Main thread traces enabled
@@ -74,6 +75,8 @@ static gchar *mime_type;
 static gchar *force_module;
 static gchar *output_format_name;
 static gboolean version;
+static gint worker_fd = -1;
+static gint worker_memory_limit;
 
 static TrackerConfig *config;
 
@@ -102,6 +105,13 @@ static GOptionEntry entries[] = {
 	  G_OPTION_ARG_NONE, &version,
 	  N_("Displays version information"),
 	  NULL },
+	/* Used to start the sandboxed worker processes */
+	{ "worker-fd", 0, G_OPTION_FLAG_HIDDEN,
+	  G_OPTION_ARG_INT, &worker_fd,
+	  NULL, NULL },
+	{ "worker-memory-limit", 0, G_OPTION_FLAG_HIDDEN,
+	  G_OPTION_ARG_INT, &worker_memory_limit,
+	  NULL, NULL },
 	{ NULL }
 };
 
@@ -231,6 +241,14 @@ sanity_check_option_values (TrackerConfig *config)
 	           tracker_config_get_sched_idle (config));
 	g_message ("  Max bytes (per file)  .................  %d",
 	           tracker_config_get_max_bytes (config));
+	g_message ("  Max extracting files  .................  %d",
+	           tracker_config_get_max_extracting_files (config));
+	g_message ("  Cache size (MiB)  .....................  %d",
+	           tracker_config_get_cache_size (config));
+	g_message ("  Worker processes  .....................  %d",
+	           tracker_config_get_worker_processes (config));
+	g_message ("  Worker memory limit (MiB)  ............  %d",
+	           tracker_config_get_worker_memory_limit (config));
 }
 
 TrackerConfig *
@@ -300,6 +318,33 @@ run_standalone (TrackerConfig *config)
 	return EXIT_SUCCESS;
 }
 
+static int
+run_worker (TrackerConfig *config)
+{
+	TrackerExtract *object;
+	gint retval;
+
+	tracker_locale_init ();
+
+	initialize_priority_and_scheduling (tracker_config_get_sched_idle (config),
+	                                    tracker_db_manager_get_first_index_done () == FALSE);
+
+	object = tracker_extract_new (TRUE, force_module);
+
+	if (!object) {
+		tracker_locale_shutdown ();
+		return EXIT_FAILURE;
+	}
+
+	retval = tracker_extract_worker_run (object, worker_fd,
+	                                     MAX (worker_memory_limit, 0));
+
+	g_object_unref (object);
+	tracker_locale_shutdown ();
+
+	return retval;
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -360,6 +405,16 @@ main (int argc, char *argv[])
 		g_free (log_filename);
 	}
 
+	if (worker_fd >= 0) {
+		gint retval;
+
+		retval = run_worker (config);
+		tracker_log_shutdown ();
+		g_object_unref (config);
+
+		return retval;
+	}
+
 	sanity_check_option_values (config);
 
 	/* Set conditions when we use stand alone settings */
@@ -384,6 +439,17 @@ main (int argc, char *argv[])
 
 	tracker_module_manager_load_modules ();
 
+	if (tracker_config_get_worker_processes (config) > 0 &&
+	    !tracker_extract_start_workers (extract,
+	                                    tracker_config_get_worker_processes (config),
+	                                    tracker_config_get_worker_memory_limit (config),
+	                                    tracker_config_get_verbosity (config),
+	                                    &error)) {
+		g_warning ("Could not start extractor workers, extracting in process: %s",
+		           error->message);
+		g_clear_error (&error);
+	}
+
 	decorator = tracker_extract_decorator_new (extract, NULL, &error);
 
 	if (error) {
@@ -19,9 +19,12 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <glib.h>
 #include <gio/gio.h>
@@ -87,168 +90,175 @@ get_string_from_guessed_encoding (const gchar *str,
 	return NULL;
 }
 
-/* Returns %TRUE if read operation should continue, %FALSE otherwise */
+/* Returns %TRUE if the first bytes read look like text worth
+ * indexing, @len being the number of bytes read so far.
+ */
 static gboolean
-process_chunk (const gchar  *read_bytes,
-               gsize         read_size,
-               gsize         buffer_size,
-               gsize        *remaining_size,
-               GString     **s)
+check_first_chunk (const gchar *data,
+                   gsize        len)
 {
-	/* If no more bytes to read, halt loop */
-	if (read_size == 0) {
-		return FALSE;
-	}
-
-	/* First of all, check if this is the first time we
-	 * have tried to read the stream up to the BUFFER_SIZE
-	 * limit. Then make sure that we read the maximum size
-	 * of the buffer. If we don't do this, there is the
-	 * case where we read 10 bytes in and it is just one
-	 * line with no '\n'. Once we have confirmed this we
-	 * check that the buffer has a '\n' to make sure the
-	 * file is worth indexing. Similarly if the file has
-	 * <= 3 bytes then we drop it.
+	/* If the file has <= 3 bytes then we drop it. If the first
+	 * BUFFER_SIZE bytes are just one line with no '\n', the file
+	 * is not worth indexing either.
 	 *
 	 * NOTE: We may have non-UTF8 content read (say,
 	 * UTF-16LE), so we can't rely on methods which assume
 	 * NUL-terminated strings, as g_strstr_len().
 	 */
-	if (*s == NULL) {
-		if (read_size <= 3) {
-			g_debug ("  File has less than 3 characters in it, "
-			         "not indexing file");
-			return FALSE;
-		}
-
-		if (read_size == buffer_size) {
-			const gchar *i;
-			gboolean eol_found = FALSE;
-
-			i = read_bytes;
-			while (i != &read_bytes[read_size - 1]) {
-				if (*i == '\n') {
-					eol_found = TRUE;
-					break;
-				}
-				i++;
-			}
-
-			if (!eol_found) {
-				g_debug ("  No '\\n' in the first %" G_GSSIZE_FORMAT " bytes, "
-				         "not indexing file",
-				         read_size);
-				return FALSE;
-			}
-		}
+	if (len <= 3) {
+		g_debug ("  File has less than 3 characters in it, "
+		         "not indexing file");
+		return FALSE;
 	}
 
-	/* Update remaining bytes */
-	*remaining_size -= read_size;
-
-	g_debug ("  Read "
-	         "%" G_GSSIZE_FORMAT " bytes from file, %" G_GSIZE_FORMAT " "
-	         "bytes remaining until configured threshold is reached",
-	         read_size,
-	         *remaining_size);
-
-	/* Append non-NIL terminated bytes */
-	*s = (*s ?
-	      g_string_append_len (*s, read_bytes, read_size) :
-	      g_string_new_len (read_bytes, read_size));
+	if (len >= BUFFER_SIZE &&
+	    memchr (data, '\n', BUFFER_SIZE - 1) == NULL) {
+		g_debug ("  No '\\n' in the first %d bytes, "
+		         "not indexing file",
+		         BUFFER_SIZE);
+		return FALSE;
+	}
 
 	return TRUE;
 }
 
-static gchar *
-process_whole_string (GString  *s)
+/* Works out how to turn the @len bytes at @data into UTF-8. Either
+ * @converted is set to a newly allocated UTF-8 string of
+ * @converted_len bytes, when transcoding was needed, or @valid_len
+ * is set to the number of bytes at @data that are valid UTF-8 as is.
+ *
+ * Returns: %FALSE if there is no usable text in @data.
+ */
+static gboolean
+process_text (const gchar  *data,
+              gsize         len,
+              gsize        *valid_len,
+              gchar       **converted,
+              gsize        *converted_len)
 {
-	gchar *utf8 = NULL;
-	gsize  utf8_len = 0;
 	gsize n_valid_utf8_bytes = 0;
 
+	*converted = NULL;
+	*converted_len = 0;
+	*valid_len = 0;
+
 	/* Support also UTF-16 encoded text files, as the ones generated in
 	 * Windows OS. We will only accept text files in UTF-16 which come
 	 * with a proper BOM. */
-	if (s->len > 2) {
-		GError *error = NULL;
+	if (len > 2) {
+		const gchar *codeset = NULL;
+
+		if (memcmp (data, "\xFF\xFE", 2) == 0)
+			codeset = "UTF-16LE";
+		else if (memcmp (data, "\xFE\xFF", 2) == 0)
+			codeset = "UTF-16BE";
+
+		if (codeset) {
+			GError *error = NULL;
+
+			g_debug ("String comes in %s, converting", codeset);
+			*converted = g_convert (&data[2],
+			                        len - 2,
+			                        "UTF-8",
+			                        codeset,
+			                        NULL,
+			                        converted_len,
+			                        &error);
+
+			if (error) {
+				g_warning ("Couldn't convert string from UTF-16 to UTF-8...: %s",
+				           error->message);
+				g_error_free (error);
+				return FALSE;
+			}
 
-		if (memcmp (s->str, "\xFF\xFE", 2) == 0) {
-			g_debug ("String comes in UTF-16LE, converting");
-			utf8 = g_convert (&(s->str[2]),
-			                  s->len - 2,
-			                  "UTF-8",
-			                  "UTF-16LE",
-			                  NULL,
-			                  &utf8_len,
-			                  &error);
-
-		} else if (memcmp (s->str, "\xFE\xFF", 2) == 0) {
-			g_debug ("String comes in UTF-16BE, converting");
-			utf8 = g_convert (&(s->str[2]),
-			                  s->len - 2,
-			                  "UTF-8",
-			                  "UTF-16BE",
-			                  NULL,
-			                  &utf8_len,
-			                  &error);
-		}
+			if (*converted_len < 1) {
+				g_clear_pointer (converted, g_free);
+				return FALSE;
+			}
 
-		if (error) {
-			g_warning ("Couldn't convert string from UTF-16 to UTF-8...: %s",
-			           error->message);
-			g_error_free (error);
-			g_string_free (s, TRUE);
-			return NULL;
+			return TRUE;
 		}
 	}
 
-	if (utf8) {
-		n_valid_utf8_bytes = utf8_len;
-		g_string_free (s, TRUE);
-	} else {
-		utf8_len = s->len;
-		utf8 = g_string_free (s, FALSE);
-
-		/* Get number of valid UTF-8 bytes found */
-		tracker_text_validate_utf8 (utf8,
-					    utf8_len,
-					    NULL,
-					    &n_valid_utf8_bytes);
-	}
+	/* Get number of valid UTF-8 bytes found */
+	tracker_text_validate_utf8 (data,
+	                            len,
+	                            NULL,
+	                            &n_valid_utf8_bytes);
 
 	/* A valid UTF-8 file will be that where all read bytes are valid,
 	 *  with a margin of 3 bytes for the last UTF-8 character which might
 	 *  have been cut. */
-	if (utf8_len - n_valid_utf8_bytes > 3) {
-		gchar *from_guessed_str;
-		gsize  from_guessed_str_len;
-
+	if (len - n_valid_utf8_bytes > 3) {
 		/* If not UTF-8, try to get contents in guessed encoding
 		 *  (returns valid UTF-8) */
-		from_guessed_str = get_string_from_guessed_encoding (utf8,
-		                                                     utf8_len,
-		                                                     &from_guessed_str_len);
-		g_free (utf8);
-		if (!from_guessed_str)
-			return NULL;
-		utf8 = from_guessed_str;
-		utf8_len = from_guessed_str_len;
-	} else if (n_valid_utf8_bytes < utf8_len) {
+		*converted = get_string_from_guessed_encoding (data,
+		                                               len,
+		                                               converted_len);
+		if (*converted && *converted_len < 1)
+			g_clear_pointer (converted, g_free);
+
+		return *converted != NULL;
+	}
+
+	if (n_valid_utf8_bytes < len) {
 		g_debug ("  Truncating to last valid UTF-8 character "
 		         "(%" G_GSSIZE_FORMAT "/%" G_GSSIZE_FORMAT " bytes)",
 		         n_valid_utf8_bytes,
-		         utf8_len);
-		utf8[n_valid_utf8_bytes] = '\0';
-		utf8_len = n_valid_utf8_bytes;
+		         len);
 	}
 
-	if (utf8_len < 1) {
-		g_free (utf8);
+	*valid_len = n_valid_utf8_bytes;
+
+	return n_valid_utf8_bytes > 0;
+}
+
+/* Takes ownership of @buffer, which has room for a NUL byte
+ * after the @len bytes read into it. The length of the returned
+ * text is set in @text_len.
+ */
+static gchar *
+process_buffer (gchar *buffer,
+                gsize  len,
+                gsize *text_len)
+{
+	gchar *converted;
+	gsize converted_len, valid_len;
+
+	*text_len = 0;
+
+	if (!process_text (buffer, len, &valid_len, &converted, &converted_len)) {
+		g_free (buffer);
 		return NULL;
 	}
 
-	return utf8;
+	if (converted) {
+		g_free (buffer);
+		*text_len = converted_len;
+		return converted;
+	}
+
+	/* Truncate in place */
+	buffer[valid_len] = '\0';
+	*text_len = valid_len;
+
+	return buffer;
+}
+
+/* Grows @buffer so it can take @len more bytes and a NUL byte */
+static gchar *
+buffer_ensure (gchar *buffer,
+               gsize  buffer_len,
+               gsize *allocated,
+               gsize  len)
+{
+	if (buffer_len + len + 1 <= *allocated)
+		return buffer;
+
+	*allocated = MAX (*allocated * 2, buffer_len + len + 1);
+
+	return g_realloc (buffer, *allocated);
 }
 
 /**
@@ -268,13 +278,14 @@ gchar *
 tracker_read_text_from_stream (GInputStream *stream,
                                gsize         max_bytes)
 {
-	GString *s = NULL;
-	gsize n_bytes_remaining = max_bytes;
+	gchar *buffer = NULL;
+	gsize buffer_len = 0, allocated = 0, text_len;
 
 	g_return_val_if_fail (stream, NULL);
 	g_return_val_if_fail (max_bytes > 0, NULL);
 
-	/* Reading in chunks of BUFFER_SIZE
+	/* Reading in chunks of BUFFER_SIZE straight into the
+	 * returned buffer
 	 *   Loop is halted whenever one of this conditions is met:
 	 *     a) Read bytes reached the maximum allowed (max_bytes)
 	 *     b) No more bytes to read
@@ -282,15 +293,17 @@ tracker_read_text_from_stream (GInputStream *stream,
 	 *     d) Stream has less than 3 bytes
 	 *     e) Stream has a single line of BUFFER_SIZE bytes with no EOL
 	 */
-	while (n_bytes_remaining > 0) {
-		gchar buf[BUFFER_SIZE];
+	while (buffer_len < max_bytes) {
 		GError *error = NULL;
-		gsize n_bytes_read;
+		gsize n_bytes_read, chunk_size;
+
+		chunk_size = MIN (BUFFER_SIZE, max_bytes - buffer_len);
+		buffer = buffer_ensure (buffer, buffer_len, &allocated, chunk_size);
 
 		/* Read bytes from stream */
 		if (!g_input_stream_read_all (stream,
-		                              buf,
-		                              MIN (BUFFER_SIZE, n_bytes_remaining),
+		                              &buffer[buffer_len],
+		                              chunk_size,
 		                              &n_bytes_read,
 		                              NULL,
 		                              &error)) {
@@ -300,20 +313,133 @@ tracker_read_text_from_stream (GInputStream *stream,
 			break;
 		}
 
-		/* Process read bytes, and halt loop if needed */
-		if (!process_chunk (buf,
-		                    n_bytes_read,
-		                    BUFFER_SIZE,
-		                    &n_bytes_remaining,
-		                    &s)) {
+		if (n_bytes_read == 0)
 			break;
+
+		if (buffer_len == 0 &&
+		    !check_first_chunk (buffer, n_bytes_read)) {
+			g_free (buffer);
+			return NULL;
 		}
+
+		buffer_len += n_bytes_read;
+
+		g_debug ("  Read "
+		         "%" G_GSSIZE_FORMAT " bytes from stream, %" G_GSIZE_FORMAT " "
+		         "bytes remaining until configured threshold is reached",
+		         n_bytes_read,
+		         max_bytes - buffer_len);
+	}
+
+	if (buffer_len == 0) {
+		g_free (buffer);
+		return NULL;
 	}
 
 	/* Validate UTF-8 if something was read, and return it */
-	return s ? process_whole_string (s) : NULL;
+	return process_buffer (buffer, buffer_len, &text_len);
 }
 
+static void
+close_fd (gint fd)
+{
+#ifdef HAVE_POSIX_FADVISE
+	if (posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED) != 0)
+		g_warning ("posix_fadvise() call failed: %m");
+#endif /* HAVE_POSIX_FADVISE */
+	close (fd);
+}
+
+/* Reads up to @max_bytes from @fd straight into the returned buffer,
+ * allocated once for regular files. Those are read rather than mapped,
+ * accessing the mapping of a file truncated meanwhile raises SIGBUS.
+ */
+static gchar *
+read_text_from_fd (gint   fd,
+                   gsize  max_bytes,
+                   gsize *len)
+{
+	gchar *buffer = NULL;
+	gsize buffer_len = 0, allocated = 0;
+	struct stat st;
+
+	*len = 0;
+
+	if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode)) {
+		/* Read what the file holds now, appended data is
+		 * left for the next extraction.
+		 */
+		max_bytes = MIN (max_bytes, (gsize) st.st_size);
+		allocated = max_bytes + 1;
+		buffer = g_malloc (allocated);
+	}
+
+	while (buffer_len < max_bytes) {
+		gsize chunk_size;
+		gssize n_bytes_read;
+
+		chunk_size = MIN (BUFFER_SIZE, max_bytes - buffer_len);
+		buffer = buffer_ensure (buffer, buffer_len, &allocated, chunk_size);
+
+		n_bytes_read = read (fd, &buffer[buffer_len], chunk_size);
+
+		if (n_bytes_read < 0 && errno == EINTR)
+			continue;
+
+		if (n_bytes_read <= 0)
+			break;
+
+		if (buffer_len == 0 &&
+		    !check_first_chunk (buffer, n_bytes_read)) {
+			close_fd (fd);
+			g_free (buffer);
+			return NULL;
+		}
+
+		buffer_len += n_bytes_read;
+	}
+
+	close_fd (fd);
+
+	if (buffer_len == 0) {
+		g_free (buffer);
+		return NULL;
+	}
+
+	return process_buffer (buffer, buffer_len, len);
+}
+
+/**
+ * tracker_read_text_bytes_from_fd:
+ * @fd: input fd to read from
+ * @max_bytes: max number of bytes to read from @fd
+ *
+ * Reads up to @max_bytes from @fd, and validates the read text as proper
+ *  UTF-8. Will also properly close the FD when finishes.
+ *
+ * Text that already is UTF-8 is truncated in place to the last valid
+ * character, so unlike tracker_read_text_from_fd() no copy is made
+ * for the caller.
+ *
+ * Returns: a #GBytes with the read text in UTF-8, or %NULL. Its data is
+ * always followed by a NUL byte that is not included in its size.
+ **/
+GBytes *
+tracker_read_text_bytes_from_fd (gint  fd,
+                                 gsize max_bytes)
+{
+	gchar *text;
+	gsize len;
+
+	g_return_val_if_fail (max_bytes > 0, NULL);
+
+	text = read_text_from_fd (fd, max_bytes, &len);
+
+	if (!text)
+		return NULL;
+
+	return g_bytes_new_take (text, len);
+}
 
 /**
  * tracker_read_text_from_fd:
@@ -332,53 +458,9 @@ gchar *
 tracker_read_text_from_fd (gint  fd,
                            gsize max_bytes)
 {
-	FILE *fz;
-	GString *s = NULL;
-	gsize n_bytes_remaining = max_bytes;
+	gsize len;
 
 	g_return_val_if_fail (max_bytes > 0, NULL);
 
-	if ((fz = fdopen (fd, "r")) == NULL) {
-		g_warning ("Cannot read from FD... could not extract text");
-		close (fd);
-		return NULL;
-	}
-
-	/* Reading in chunks of BUFFER_SIZE
-	 *   Loop is halted whenever one of this conditions is met:
-	 *     a) Read bytes reached the maximum allowed (max_bytes)
-	 *     b) No more bytes to read
-	 *     c) Error reading
-	 *     d) Stream has less than 3 bytes
-	 *     e) Stream has a single line of BUFFER_SIZE bytes with no EOL
-	 */
-	while (n_bytes_remaining > 0) {
-		gchar buf[BUFFER_SIZE];
-		gsize n_bytes_read;
-
-		/* Read bytes */
-		n_bytes_read = fread (buf,
-		                      1,
-		                      MIN (BUFFER_SIZE, n_bytes_remaining),
-		                      fz);
-
-		/* Process read bytes, and halt loop if needed */
-		if (!process_chunk (buf,
-		                    n_bytes_read,
-		                    BUFFER_SIZE,
-		                    &n_bytes_remaining,
-		                    &s)) {
-			break;
-		}
-	}
-
-	/* Close the file here */
-#ifdef HAVE_POSIX_FADVISE
-	if (posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED) != 0)
-		g_warning ("posix_fadvise() call failed: %m");
-#endif /* HAVE_POSIX_FADVISE */
-	fclose (fz);
-
-	/* Validate UTF-8 if something was read, and return it */
-	return s ? process_whole_string (s) : NULL;
+	return read_text_from_fd (fd, max_bytes, &len);
 }
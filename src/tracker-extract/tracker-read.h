@@ -31,6 +31,9 @@ gchar *tracker_read_text_from_stream (GInputStream *stream,
 gchar *tracker_read_text_from_fd (gint  fd,
                                   gsize max_bytes);
 
+GBytes *tracker_read_text_bytes_from_fd (gint  fd,
+                                         gsize max_bytes);
+
 G_END_DECLS
 
 #endif /* __TRACKER_READ_H__ */
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "tracker-checkpoint.h"
+
+/* Projected WAL growth in pages over the next
+ * TRACKER_WAL_CHECKPOINT_HORIZON seconds, from the growth since the
+ * previous commit @elapsed microseconds ago.
+ */
+gint64
+tracker_wal_checkpoint_growth (gint   n_pages,
+                               gint   last_pages,
+                               gint64 elapsed)
+{
+	if (elapsed <= 0 || n_pages <= last_pages) {
+		return 0;
+	}
+
+	return (gint64) (n_pages - last_pages) * TRACKER_WAL_CHECKPOINT_HORIZON * G_USEC_PER_SEC / elapsed;
+}
+
+/* Decides on the checkpoint to run after a commit left @n_pages pages
+ * in the WAL, @elapsed microseconds after one left @last_pages, or
+ * with @elapsed 0 for the first commit.
+ */
+TrackerWalCheckpoint
+tracker_wal_checkpoint_trigger (gint   n_pages,
+                                gint   last_pages,
+                                gint64 elapsed)
+{
+	gint64 growth;
+
+	if (n_pages >= TRACKER_WAL_MAX_PAGES) {
+		return TRACKER_WAL_CHECKPOINT_BLOCKING;
+	}
+
+	if (n_pages >= TRACKER_WAL_BUSY_CHECKPOINT_PAGES) {
+		return TRACKER_WAL_CHECKPOINT_BACKGROUND;
+	}
+
+	growth = tracker_wal_checkpoint_growth (n_pages, last_pages, elapsed);
+
+	if (n_pages >= TRACKER_WAL_CHECKPOINT_PAGES &&
+	    n_pages + growth >= TRACKER_WAL_MAX_PAGES) {
+		return TRACKER_WAL_CHECKPOINT_BACKGROUND;
+	}
+
+	/* wait for the store to go idle */
+	return TRACKER_WAL_CHECKPOINT_NONE;
+}
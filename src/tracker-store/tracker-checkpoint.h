@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __TRACKER_STORE_CHECKPOINT_H__
+#define __TRACKER_STORE_CHECKPOINT_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* WAL size in pages above which a checkpoint is run once idle */
+#define TRACKER_WAL_CHECKPOINT_PAGES      1000
+/* WAL size in pages above which a checkpoint is run right away */
+#define TRACKER_WAL_BUSY_CHECKPOINT_PAGES 5000
+/* WAL size in pages above which updates wait for a checkpoint */
+#define TRACKER_WAL_MAX_PAGES             10000
+/* seconds of WAL growth at the current write rate to look ahead */
+#define TRACKER_WAL_CHECKPOINT_HORIZON    5
+
+typedef enum {
+	TRACKER_WAL_CHECKPOINT_NONE,
+	TRACKER_WAL_CHECKPOINT_BACKGROUND,
+	TRACKER_WAL_CHECKPOINT_BLOCKING
+} TrackerWalCheckpoint;
+
+gint64               tracker_wal_checkpoint_growth  (gint   n_pages,
+                                                     gint   last_pages,
+                                                     gint64 elapsed);
+TrackerWalCheckpoint tracker_wal_checkpoint_trigger (gint   n_pages,
+                                                     gint   last_pages,
+                                                     gint64 elapsed);
+
+G_END_DECLS
+
+#endif /* __TRACKER_STORE_CHECKPOINT_H__ */
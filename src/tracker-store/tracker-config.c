@@ -37,6 +37,7 @@
 #define CONFIG_PATH   "/org/freedesktop/tracker/store/"
 
 #define GRAPHUPDATED_DELAY_DEFAULT	1000
+#define MAX_CONCURRENT_QUERIES_DEFAULT	0
 
 static void config_set_property         (GObject       *object,
                                          guint          param_id,
@@ -53,6 +54,7 @@ enum {
 	PROP_0,
 	PROP_VERBOSITY,
 	PROP_GRAPHUPDATED_DELAY,
+	PROP_MAX_CONCURRENT_QUERIES,
 };
 
 G_DEFINE_TYPE (TrackerConfig, tracker_config, G_TYPE_SETTINGS);
@@ -86,6 +88,16 @@ tracker_config_class_init (TrackerConfigClass *klass)
 	                                                    GRAPHUPDATED_DELAY_DEFAULT,
 	                                                    G_PARAM_READWRITE));
 
+	g_object_class_install_property (object_class,
+	                                 PROP_MAX_CONCURRENT_QUERIES,
+	                                 g_param_spec_int  ("max-concurrent-queries",
+	                                                    "Maximum concurrent queries",
+	                                                    "Maximum number of queries running at once, 0 for the number of processors. (0)",
+	                                                    0,
+	                                                    G_MAXINT,
+	                                                    MAX_CONCURRENT_QUERIES_DEFAULT,
+	                                                    G_PARAM_READWRITE));
+
 }
 
 static void
@@ -105,6 +117,11 @@ config_set_property (GObject      *object,
 		                                       g_value_get_int (value));
 		break;
 
+	case PROP_MAX_CONCURRENT_QUERIES:
+		tracker_config_set_max_concurrent_queries (TRACKER_CONFIG (object),
+		                                           g_value_get_int (value));
+		break;
+
 	case PROP_VERBOSITY:
 		tracker_config_set_verbosity (TRACKER_CONFIG (object),
 		                              g_value_get_enum (value));
@@ -126,6 +143,10 @@ config_get_property (GObject    *object,
 		g_value_set_int (value, tracker_config_get_graphupdated_delay (TRACKER_CONFIG (object)));
 		break;
 
+	case PROP_MAX_CONCURRENT_QUERIES:
+		g_value_set_int (value, tracker_config_get_max_concurrent_queries (TRACKER_CONFIG (object)));
+		break;
+
 		/* General */
 	case PROP_VERBOSITY:
 		g_value_set_enum (value, tracker_config_get_verbosity (TRACKER_CONFIG (object)));
@@ -179,6 +200,7 @@ config_constructed (GObject *object)
 	 */
 	g_settings_bind (settings, "verbosity", object, "verbosity", G_SETTINGS_BIND_GET | G_SETTINGS_BIND_GET_NO_CHANGES);
 	g_settings_bind (settings, "graphupdated-delay", object, "graphupdated-delay", G_SETTINGS_BIND_GET);
+	g_settings_bind (settings, "max-concurrent-queries", object, "max-concurrent-queries", G_SETTINGS_BIND_GET);
 }
 
 TrackerConfig *
@@ -259,3 +281,21 @@ tracker_config_set_graphupdated_delay (TrackerConfig *config,
 	g_settings_set_int(G_SETTINGS (config), "graphupdated-delay", value);
 	g_object_notify (G_OBJECT (config), "graphupdated-delay");
 }
+
+gint
+tracker_config_get_max_concurrent_queries (TrackerConfig *config)
+{
+	g_return_val_if_fail (TRACKER_IS_CONFIG (config), MAX_CONCURRENT_QUERIES_DEFAULT);
+
+	return g_settings_get_int (G_SETTINGS (config), "max-concurrent-queries");
+}
+
+void
+tracker_config_set_max_concurrent_queries (TrackerConfig *config,
+                                           gint           value)
+{
+	g_return_if_fail (TRACKER_IS_CONFIG (config));
+
+	g_settings_set_int (G_SETTINGS (config), "max-concurrent-queries", value);
+	g_object_notify (G_OBJECT (config), "max-concurrent-queries");
+}
@@ -111,6 +111,7 @@ public class Tracker.DBus {
 		if (old_owner != "" && new_owner == "") {
 			/* This means that old_owner got removed */
 			resources.unreg_batches (old_owner);
+			resources.unreg_subscriptions (old_owner);
 		}
 	}
 
@@ -29,9 +29,21 @@
 typedef struct {
 	gboolean frozen;
 	guint total;
+	guint savepoint_total;
 	GPtrArray *notify_classes;
 } EventsPrivate;
 
+typedef struct {
+	gint subject_id;
+	gint pred_id;
+	gint object_id;
+} CompactEvent;
+
+struct _TrackerEventsBatch {
+	GArray *deletes; /* CompactEvent, sorted and unique */
+	GArray *inserts; /* CompactEvent, sorted and unique */
+};
+
 static EventsPrivate *private;
 
 guint
@@ -126,6 +138,43 @@ tracker_events_reset_pending (void)
 	private->frozen = FALSE;
 }
 
+/* Called as a batch item starts, the events it adds are pending on
+ * top of those of the previous items until it is released or rolled
+ * back.
+ */
+void
+tracker_events_savepoint (void)
+{
+	guint i;
+
+	g_return_if_fail (private != NULL);
+
+	for (i = 0; i < private->notify_classes->len; i++) {
+		TrackerClass *class = g_ptr_array_index (private->notify_classes, i);
+
+		tracker_class_savepoint_events (class);
+	}
+
+	private->savepoint_total = private->total;
+}
+
+void
+tracker_events_rollback_to_savepoint (void)
+{
+	guint i;
+
+	g_return_if_fail (private != NULL);
+
+	for (i = 0; i < private->notify_classes->len; i++) {
+		TrackerClass *class = g_ptr_array_index (private->notify_classes, i);
+
+		tracker_class_rollback_events (class);
+	}
+
+	/* The total may have been reset in between */
+	private->total = MIN (private->total, private->savepoint_total);
+}
+
 void
 tracker_events_freeze (void)
 {
@@ -164,6 +213,233 @@ tracker_events_get_classes (guint *length)
 	return (TrackerClass **) (private->notify_classes->pdata);
 }
 
+static void
+collect_compact_event (gint     graph_id,
+                       gint     subject_id,
+                       gint     pred_id,
+                       gint     object_id,
+                       gpointer user_data)
+{
+	GArray *events = user_data;
+	CompactEvent event;
+
+	/* The graph is not part of the compact format */
+	event.subject_id = subject_id;
+	event.pred_id = pred_id;
+	event.object_id = object_id;
+	g_array_append_val (events, event);
+}
+
+static gint
+compare_compact_event (gconstpointer a,
+                       gconstpointer b)
+{
+	const CompactEvent *event1 = a, *event2 = b;
+
+	if (event1->subject_id != event2->subject_id)
+		return event1->subject_id < event2->subject_id ? -1 : 1;
+	if (event1->pred_id != event2->pred_id)
+		return event1->pred_id < event2->pred_id ? -1 : 1;
+	if (event1->object_id != event2->object_id)
+		return event1->object_id < event2->object_id ? -1 : 1;
+
+	return 0;
+}
+
+static void
+sort_and_deduplicate (GArray *events)
+{
+	CompactEvent *data;
+	guint i, n = 0;
+
+	if (events->len == 0)
+		return;
+
+	g_array_sort (events, compare_compact_event);
+	data = (CompactEvent *) events->data;
+
+	for (i = 1; i < events->len; i++) {
+		if (compare_compact_event (&data[n], &data[i]) != 0)
+			data[++n] = data[i];
+	}
+
+	g_array_set_size (events, n + 1);
+}
+
+/* Collects the ready events of @class, the same subject/predicate/object
+ * may have been changed by several transactions in the signal window,
+ * those are only encoded once.
+ */
+TrackerEventsBatch *
+tracker_events_batch_new (TrackerClass *class)
+{
+	TrackerEventsBatch *batch;
+
+	g_return_val_if_fail (TRACKER_IS_CLASS (class), NULL);
+
+	batch = g_slice_new0 (TrackerEventsBatch);
+	batch->deletes = g_array_new (FALSE, FALSE, sizeof (CompactEvent));
+	batch->inserts = g_array_new (FALSE, FALSE, sizeof (CompactEvent));
+
+	tracker_class_foreach_delete_event (class, collect_compact_event,
+	                                    batch->deletes);
+	tracker_class_foreach_insert_event (class, collect_compact_event,
+	                                    batch->inserts);
+
+	sort_and_deduplicate (batch->deletes);
+	sort_and_deduplicate (batch->inserts);
+
+	return batch;
+}
+
+static inline void
+append_varint (GByteArray *bytes,
+               guint32     value)
+{
+	guint8 byte;
+
+	do {
+		byte = value & 0x7f;
+		value >>= 7;
+
+		if (value != 0)
+			byte |= 0x80;
+
+		g_byte_array_append (bytes, &byte, 1);
+	} while (value != 0);
+}
+
+static inline gboolean
+predicate_matches (gint        pred_id,
+                   const gint *predicates,
+                   gint        n_predicates)
+{
+	gint i;
+
+	if (n_predicates == 0)
+		return TRUE;
+
+	for (i = 0; i < n_predicates; i++) {
+		if (predicates[i] == pred_id)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Encodes the deletes or inserts of @batch in the format of the
+ * GraphUpdatedCompact signal. Changes are grouped by subject, each group
+ * being the subject ID as a delta to the previous group, the number of
+ * changes, and the changes as predicate ID delta to the previous change
+ * in the group plus the object ID. All numbers are unsigned LEB128
+ * varints. Only predicates in @predicates are encoded, if given.
+ */
+GVariant *
+tracker_events_batch_encode (TrackerEventsBatch *batch,
+                             gboolean            deletes,
+                             const gint         *predicates,
+                             gint                n_predicates)
+{
+	const CompactEvent *data;
+	GByteArray *bytes;
+	GVariant *variant;
+	GBytes *payload;
+	GArray *events;
+	gint last_subject = 0;
+	guint i, j, k;
+
+	g_return_val_if_fail (batch != NULL, NULL);
+
+	events = deletes ? batch->deletes : batch->inserts;
+	data = (const CompactEvent *) events->data;
+	bytes = g_byte_array_sized_new (events->len * 4);
+
+	for (i = 0; i < events->len; i = j) {
+		gint last_pred = 0;
+		guint count = 0;
+
+		for (j = i; j < events->len && data[j].subject_id == data[i].subject_id; j++) {
+			if (predicate_matches (data[j].pred_id, predicates, n_predicates))
+				count++;
+		}
+
+		if (count == 0)
+			continue;
+
+		append_varint (bytes, data[i].subject_id - last_subject);
+		append_varint (bytes, count);
+		last_subject = data[i].subject_id;
+
+		for (k = i; k < j; k++) {
+			if (!predicate_matches (data[k].pred_id, predicates, n_predicates))
+				continue;
+
+			append_varint (bytes, data[k].pred_id - last_pred);
+			append_varint (bytes, data[k].object_id);
+			last_pred = data[k].pred_id;
+		}
+	}
+
+	payload = g_byte_array_free_to_bytes (bytes);
+	variant = g_variant_new_from_bytes (G_VARIANT_TYPE_BYTESTRING,
+	                                    payload, TRUE);
+	g_bytes_unref (payload);
+
+	return g_variant_ref_sink (variant);
+}
+
+/* Returns the sorted IDs of the subjects with deletes or inserts
+ * on @predicates (or any predicate if none given).
+ */
+gint *
+tracker_events_batch_get_subjects (TrackerEventsBatch *batch,
+                                   const gint         *predicates,
+                                   gint                n_predicates,
+                                   gint               *n_subjects)
+{
+	const CompactEvent *deletes, *inserts;
+	GArray *subjects;
+	guint i = 0, j = 0;
+	gint last = -1;
+
+	g_return_val_if_fail (batch != NULL, NULL);
+	g_return_val_if_fail (n_subjects != NULL, NULL);
+
+	deletes = (const CompactEvent *) batch->deletes->data;
+	inserts = (const CompactEvent *) batch->inserts->data;
+	subjects = g_array_new (FALSE, FALSE, sizeof (gint));
+
+	/* Both arrays are sorted by subject, merge them */
+	while (i < batch->deletes->len || j < batch->inserts->len) {
+		const CompactEvent *event;
+
+		if (j == batch->inserts->len ||
+		    (i < batch->deletes->len &&
+		     deletes[i].subject_id <= inserts[j].subject_id))
+			event = &deletes[i++];
+		else
+			event = &inserts[j++];
+
+		if (event->subject_id != last &&
+		    predicate_matches (event->pred_id, predicates, n_predicates)) {
+			g_array_append_val (subjects, event->subject_id);
+			last = event->subject_id;
+		}
+	}
+
+	*n_subjects = subjects->len;
+
+	return (gint *) g_array_free (subjects, FALSE);
+}
+
+void
+tracker_events_batch_free (TrackerEventsBatch *batch)
+{
+	g_array_unref (batch->deletes);
+	g_array_unref (batch->inserts);
+	g_slice_free (TrackerEventsBatch, batch);
+}
+
 void
 tracker_events_init (void)
 {
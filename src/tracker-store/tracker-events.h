@@ -30,6 +30,8 @@ G_BEGIN_DECLS
 
 typedef GStrv (*TrackerNotifyClassGetter)   (void);
 
+typedef struct _TrackerEventsBatch TrackerEventsBatch;
+
 void           tracker_events_init              (void);
 void           tracker_events_shutdown          (void);
 void           tracker_events_add_insert        (gint         graph_id,
@@ -48,9 +50,22 @@ void           tracker_events_add_delete        (gint         graph_id,
                                                  GPtrArray   *rdf_types);
 guint          tracker_events_get_total         (gboolean     and_reset);
 void           tracker_events_reset_pending     (void);
+void           tracker_events_savepoint         (void);
+void           tracker_events_rollback_to_savepoint (void);
 void           tracker_events_freeze            (void);
 TrackerClass** tracker_events_get_classes       (guint       *length);
 
+TrackerEventsBatch * tracker_events_batch_new    (TrackerClass       *class);
+GVariant *     tracker_events_batch_encode      (TrackerEventsBatch *batch,
+                                                 gboolean            deletes,
+                                                 const gint         *predicates,
+                                                 gint                n_predicates);
+gint *         tracker_events_batch_get_subjects (TrackerEventsBatch *batch,
+                                                 const gint         *predicates,
+                                                 gint                n_predicates,
+                                                 gint               *n_subjects);
+void           tracker_events_batch_free        (TrackerEventsBatch *batch);
+
 G_END_DECLS
 
 #endif /* __TRACKER_STORE_EVENTS_H__ */
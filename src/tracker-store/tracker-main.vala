@@ -60,6 +60,7 @@ License which can be viewed at:
 		message ("Store options:");
 		message ("  Readonly mode  ........................  %s", readonly_mode ? "yes" : "no");
 		message ("  GraphUpdated Delay ....................  %d", config.graphupdated_delay);
+		message ("  Max Concurrent Queries ................  %d", config.max_concurrent_queries);
 	}
 
 	static void do_shutdown () {
@@ -205,7 +206,7 @@ License which can be viewed at:
 		config_verbosity_changed_cb (config, null);
 		ulong config_verbosity_id = config.notify["verbosity"].connect (config_verbosity_changed_cb);
 
-		DBManagerFlags flags = DBManagerFlags.REMOVE_CACHE;
+		DBManagerFlags flags = DBManagerFlags.REMOVE_CACHE | DBManagerFlags.FTS_REINDEX_IN_BACKGROUND;
 
 		if (force_reindex) {
 			/* TODO port backup support
@@ -217,7 +218,7 @@ License which can be viewed at:
 		var notifier = Tracker.DBus.register_notifier ();
 		var busy_callback = notifier.get_callback ();
 
-		Tracker.Store.init ();
+		Tracker.Store.init (config.max_concurrent_queries);
 
 		/* Make Tracker available for introspection */
 		if (!Tracker.DBus.register_objects ()) {
@@ -239,6 +240,9 @@ License which can be viewed at:
 		bool do_rotating = (chunk_size_mb != -1);
 
 		Tracker.DBJournal.set_rotating (do_rotating, chunk_size, rotate_to);
+		Tracker.DBJournal.set_compression (db_config.journal_compression);
+
+		Tracker.ResourceCache.set_size (db_config.resource_cache_size);
 
 		int select_cache_size, update_cache_size;
 		string cache_size_s;
@@ -49,10 +49,90 @@ public class Tracker.Resources : Object {
 
 	const int DBUS_ARBITRARY_MAX_MSG_SIZE = 10000000;
 
+	const string INTERFACE = "org.freedesktop.Tracker1.Resources";
+
+	/* Subjects per GraphUpdatedRows query, keeps the IN lists short */
+	const int ROWS_QUERY_CHUNK = 500;
+
+	/* Receiver of GraphUpdatedCompact signals */
+	class GraphSubscription {
+		public uint id;
+		public string sender;
+		public string[] classes;
+		public int[] predicates;
+		public string[] fields;
+		public bool rows;
+
+		public string get_rows_query (string ids) {
+			return "SELECT tracker:id(?u) ?u %s { ?u a rdfs:Resource . FILTER (tracker:id(?u) IN (%s)) } ORDER BY tracker:id(?u)".printf (string.joinv (" ", fields), ids);
+		}
+
+		/* Fields are spliced into get_rows_query (), so each must be
+		 * a single expression: prefixed names, variables and function
+		 * calls, with balanced parentheses.
+		 */
+		public static bool is_valid_field (string field) {
+			int depth = 0;
+
+			if (field.strip () == "") {
+				return false;
+			}
+
+			for (int i = 0; i < field.length; i++) {
+				char c = field[i];
+
+				if (c == '(') {
+					depth++;
+				} else if (c == ')') {
+					if (--depth < 0) {
+						return false;
+					}
+				} else if (c == ' ' || c == ',') {
+					// only between function arguments
+					if (depth == 0) {
+						return false;
+					}
+				} else if (!c.isalnum () && c != '_' && c != '-' &&
+				           c != ':' && c != '?') {
+					return false;
+				}
+			}
+
+			return depth == 0;
+		}
+
+		public bool matches (Class cl) {
+			if (classes.length == 0) {
+				return true;
+			}
+
+			foreach (unowned string uri in classes) {
+				if (uri == cl.uri) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+	}
+
 	DBusConnection connection;
 	uint signal_timeout;
 	bool regular_commit_pending;
 	Tracker.Config config;
+	/* GraphUpdatedRows waiting for their rows to be queried */
+	class PendingRows {
+		public GraphSubscription subscription;
+		public string class_uri;
+		public Variant deletes;
+		public Variant inserts;
+		public int[] subjects;
+	}
+
+	GenericArray<GraphSubscription> graph_subscriptions = new GenericArray<GraphSubscription> ();
+	uint last_subscription_id;
+	Queue<PendingRows> rows_queue = new Queue<PendingRows> ();
+	bool rows_queue_running;
 
 	public signal void writeback ([DBus (signature = "a{iai}")] Variant subjects);
 	public signal void graph_updated (string classname, [DBus (signature = "a(iiii)")] Variant deletes, [DBus (signature = "a(iiii)")] Variant inserts);
@@ -89,7 +169,7 @@ public class Tracker.Resources : Object {
 		try {
 			var builder = new VariantBuilder ((VariantType) "aas");
 
-			yield Tracker.Store.sparql_query (query, Tracker.Store.Priority.HIGH, cursor => {
+			yield Tracker.Store.sparql_query (query, null, Tracker.Store.Priority.HIGH, cursor => {
 				while (cursor.next ()) {
 					builder.open ((VariantType) "as");
 
@@ -200,6 +280,313 @@ public class Tracker.Resources : Object {
 		/* no longer needed, just return */
 	}
 
+	public async uint subscribe_graph_updated (BusName sender, string[] classes, string[] predicates, string[] resources, string[] fields, bool rows, out int[] resource_ids) throws Error {
+		var request = DBusRequest.begin (sender, "Resources.SubscribeGraphUpdated");
+		resource_ids = null;
+		try {
+			var subscription = new GraphSubscription ();
+			subscription.sender = sender;
+			subscription.rows = rows;
+
+			foreach (unowned string field in fields) {
+				if (!GraphSubscription.is_valid_field (field)) {
+					throw new Sparql.Error.PARSE ("Invalid field '%s'", field);
+				}
+			}
+			subscription.fields = fields;
+
+			foreach (unowned string uri in classes) {
+				unowned Class? cl = Ontologies.get_class_by_uri (uri);
+				if (cl == null || !cl.notify) {
+					throw new Sparql.Error.UNKNOWN_CLASS ("Class '%s' not found or not notified", uri);
+				}
+				subscription.classes += uri;
+			}
+
+			foreach (unowned string uri in predicates) {
+				unowned Property? prop = Ontologies.get_property_by_uri (uri);
+				if (prop == null) {
+					throw new Sparql.Error.UNKNOWN_PROPERTY ("Property '%s' not found", uri);
+				}
+				subscription.predicates += prop.id;
+			}
+
+			if (rows) {
+				// check the fields once, so errors show up here
+				// rather than at every notification
+				yield Tracker.Store.sparql_query (subscription.get_rows_query ("0"), null, Tracker.Store.Priority.HIGH, cursor => {
+				}, sender);
+			}
+
+			int[] ids = new int[resources.length];
+
+			if (resources.length > 0) {
+				var sparql = new StringBuilder ("SELECT");
+				foreach (unowned string uri in resources) {
+					if ("<" in uri || ">" in uri) {
+						throw new Sparql.Error.PARSE ("Invalid resource URI '%s'", uri);
+					}
+					sparql.append_printf (" tracker:id(<%s>)", uri);
+				}
+				sparql.append (" {}");
+
+				yield Tracker.Store.sparql_query (sparql.str, null, Tracker.Store.Priority.HIGH, cursor => {
+					if (cursor.next ()) {
+						for (int i = 0; i < ids.length; i++) {
+							ids[i] = (int) cursor.get_integer (i);
+						}
+					}
+				}, sender);
+			}
+
+			subscription.id = ++last_subscription_id;
+			graph_subscriptions.add (subscription);
+
+			request.end ();
+
+			resource_ids = ids;
+			return subscription.id;
+		} catch (Error e) {
+			request.end (e);
+			if (e is Sparql.Error) {
+				throw e;
+			} else {
+				throw new Sparql.Error.INTERNAL (e.message);
+			}
+		}
+	}
+
+	public void unsubscribe_graph_updated (BusName sender, uint id) {
+		var request = DBusRequest.begin (sender, "Resources.UnsubscribeGraphUpdated");
+
+		for (int i = 0; i < graph_subscriptions.length; i++) {
+			var subscription = graph_subscriptions[i];
+
+			if (subscription.id == id && subscription.sender == sender) {
+				graph_subscriptions.remove_index (i);
+				break;
+			}
+		}
+
+		request.end ();
+	}
+
+	bool has_subscription (uint id) {
+		for (int i = 0; i < graph_subscriptions.length; i++) {
+			if (graph_subscriptions[i].id == id) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/* Same row format as Steroids.Query */
+	static void write_row (DataOutputStream output, Sparql.ValueType[] types, string[] values) throws Error {
+		int last_offset = -1;
+
+		output.put_int32 (values.length);
+
+		foreach (var type in types) {
+			output.put_int32 ((int) type);
+		}
+
+		foreach (unowned string? value in values) {
+			last_offset += (value != null ? value.length : 0) + 1;
+			output.put_int32 (last_offset);
+		}
+
+		foreach (unowned string? value in values) {
+			output.put_string (value != null ? value : "");
+			output.put_byte (0);
+		}
+	}
+
+	/* Resources that no longer exist have no rdf:type left for
+	 * the rows query to match, but still have a URN. Runs in the
+	 * query thread, right after the rows query.
+	 */
+	static void write_missing_rows (int[] subjects, bool[] found, int n_fields, DataOutputStream output) throws Error {
+		var ids = new StringBuilder ();
+
+		for (int i = 0; i < subjects.length; i++) {
+			if (!found[i]) {
+				if (ids.len > 0) {
+					ids.append_c (',');
+				}
+				ids.append_printf ("%d", subjects[i]);
+			}
+		}
+
+		if (ids.len == 0) {
+			return;
+		}
+
+		var types = new Sparql.ValueType[2 + n_fields];
+		var values = new string[2 + n_fields];
+
+		types[0] = Sparql.ValueType.INTEGER;
+		types[1] = Sparql.ValueType.URI;
+		for (int i = 2; i < types.length; i++) {
+			types[i] = Sparql.ValueType.UNBOUND;
+		}
+
+		var iface = DBManager.get_db_interface ();
+		var stmt = iface.create_statement (DBStatementCacheType.NONE, "SELECT ID, Uri FROM Resource WHERE ID IN (%s) ORDER BY ID", ids.str);
+		var cursor = stmt.start_cursor ();
+
+		while (cursor.next ()) {
+			values[0] = cursor.get_string (0);
+			values[1] = cursor.get_string (1);
+			write_row (output, types, values);
+		}
+	}
+
+	/* Writes a row per changed subject: its ID, its URN and the
+	 * subscription fields. Resources that no longer exist only get
+	 * their ID and URN. Subjects are queried ROWS_QUERY_CHUNK at a time.
+	 */
+	async void write_subscription_rows (PendingRows pending, DataOutputStream output) throws Error {
+		int[] subjects = pending.subjects;
+		int n_fields = pending.subscription.fields.length;
+
+		for (int start = 0; start < subjects.length; start += ROWS_QUERY_CHUNK) {
+			int[] chunk = subjects[start:int.min (start + ROWS_QUERY_CHUNK, subjects.length)];
+			var ids = new StringBuilder ();
+
+			foreach (int id in chunk) {
+				if (ids.len > 0) {
+					ids.append_c (',');
+				}
+				ids.append_printf ("%d", id);
+			}
+
+			yield Tracker.Store.sparql_query (pending.subscription.get_rows_query (ids.str), null, Tracker.Store.Priority.HIGH, cursor => {
+				var types = new Sparql.ValueType[cursor.n_columns];
+				var values = new string[cursor.n_columns];
+				bool[] found = new bool[chunk.length];
+				int next = 0;
+
+				while (cursor.next ()) {
+					int id = (int) cursor.get_integer (0);
+
+					// both are sorted by ID
+					while (next < chunk.length && chunk[next] < id) {
+						next++;
+					}
+					if (next < chunk.length && chunk[next] == id) {
+						found[next] = true;
+					}
+
+					for (int i = 0; i < cursor.n_columns; i++) {
+						types[i] = cursor.get_value_type (i);
+						values[i] = cursor.get_string (i);
+					}
+
+					write_row (output, types, values);
+				}
+
+				write_missing_rows (chunk, found, n_fields, output);
+			}, pending.subscription.sender);
+		}
+	}
+
+	async void emit_graph_updated_rows (PendingRows pending) {
+		try {
+			string path;
+			int fd = FileUtils.open_tmp ("tracker-rows-XXXXXX", out path);
+			FileUtils.unlink (path);
+
+			var output = new DataOutputStream (new BufferedOutputStream.sized (new UnixOutputStream (fd, true), Steroids.BUFFER_SIZE));
+			output.set_byte_order (DataStreamByteOrder.HOST_ENDIAN);
+
+			yield write_subscription_rows (pending, output);
+			output.flush ();
+
+			// the client may have gone while querying
+			if (has_subscription (pending.subscription.id)) {
+				var fd_list = new UnixFDList ();
+				int handle = fd_list.append (fd);
+
+				var message = new DBusMessage.signal (PATH, INTERFACE, "GraphUpdatedRows");
+				message.set_destination (pending.subscription.sender);
+				message.set_body (new Variant ("(us@ay@ayh)", pending.subscription.id, pending.class_uri, pending.deletes, pending.inserts, handle));
+				message.set_unix_fd_list (fd_list);
+
+				uint32 serial;
+				connection.send_message (message, DBusSendMessageFlags.NONE, out serial);
+			}
+
+			output.close ();
+		} catch (Error e) {
+			warning ("Could not emit GraphUpdatedRows: %s", e.message);
+		}
+	}
+
+	async void process_rows_queue () {
+		PendingRows pending;
+
+		// keep notifications in order for each subscriber
+		rows_queue_running = true;
+
+		while ((pending = rows_queue.pop_head ()) != null) {
+			yield emit_graph_updated_rows (pending);
+		}
+
+		rows_queue_running = false;
+	}
+
+	/* GraphUpdatedCompact (u subscription, s classname, ay deletes, ay inserts)
+	 * is sent to each subscriber only, see tracker_events_batch_encode()
+	 * for the payload format. Subscribers asking for rows get
+	 * GraphUpdatedRows instead, with the rows in an extra file descriptor.
+	 */
+	void emit_graph_updated_compact (Class cl) {
+		Tracker.EventsBatch batch = null;
+
+		for (int i = 0; i < graph_subscriptions.length; i++) {
+			var subscription = graph_subscriptions[i];
+
+			if (!subscription.matches (cl)) {
+				continue;
+			}
+
+			if (batch == null) {
+				batch = new Tracker.EventsBatch (cl);
+			}
+
+			var deletes = batch.encode (true, subscription.predicates);
+			var inserts = batch.encode (false, subscription.predicates);
+
+			if (deletes.get_size () == 0 && inserts.get_size () == 0) {
+				continue;
+			}
+
+			if (subscription.rows) {
+				var pending = new PendingRows ();
+				pending.subscription = subscription;
+				pending.class_uri = cl.uri;
+				pending.deletes = deletes;
+				pending.inserts = inserts;
+				pending.subjects = batch.get_subjects (subscription.predicates);
+				rows_queue.push_tail (pending);
+
+				if (!rows_queue_running) {
+					process_rows_queue.begin ();
+				}
+				continue;
+			}
+
+			try {
+				connection.emit_signal (subscription.sender, PATH, INTERFACE,
+				                        "GraphUpdatedCompact",
+				                        new Variant ("(us@ay@ay)", subscription.id, cl.uri, deletes, inserts));
+			} catch (Error e) {
+				warning ("Could not emit GraphUpdatedCompact: %s", e.message);
+			}
+		}
+	}
+
 	bool emit_graph_updated (Class cl) {
 		if (cl.has_insert_events () || cl.has_delete_events ()) {
 			var builder = new VariantBuilder ((VariantType) "a(iiii)");
@@ -216,6 +603,10 @@ public class Tracker.Resources : Object {
 
 			graph_updated (cl.uri, deletes, inserts);
 
+			if (graph_subscriptions.length > 0) {
+				emit_graph_updated_compact (cl);
+			}
+
 			cl.reset_ready_events ();
 
 			return true;
@@ -307,6 +698,22 @@ public class Tracker.Resources : Object {
 		Tracker.Writeback.reset_pending ();
 	}
 
+	void on_savepoint (Tracker.Data.SavepointAction action) {
+		switch (action) {
+		case Tracker.Data.SavepointAction.BEGIN:
+			Tracker.Events.savepoint ();
+			Tracker.Writeback.savepoint ();
+			break;
+		case Tracker.Data.SavepointAction.RELEASE:
+			Tracker.Writeback.release_savepoint ();
+			break;
+		case Tracker.Data.SavepointAction.ROLLBACK:
+			Tracker.Events.rollback_to_savepoint ();
+			Tracker.Writeback.rollback_to_savepoint ();
+			break;
+		}
+	}
+
 	void check_graph_updated_signal () {
 		/* Check for whether we need an immediate emit */
 		if (Tracker.Events.get_total (false) > GRAPH_UPDATED_IMMEDIATE_EMIT_AT) {
@@ -341,6 +748,7 @@ public class Tracker.Resources : Object {
 		Tracker.Data.add_delete_statement_callback (on_statement_deleted);
 		Tracker.Data.add_commit_statement_callback (on_statements_committed);
 		Tracker.Data.add_rollback_statement_callback (on_statements_rolled_back);
+		Tracker.Data.add_savepoint_callback (on_savepoint);
 	}
 
 	[DBus (visible = false)]
@@ -349,6 +757,7 @@ public class Tracker.Resources : Object {
 		Tracker.Data.remove_delete_statement_callback (on_statement_deleted);
 		Tracker.Data.remove_commit_statement_callback (on_statements_committed);
 		Tracker.Data.remove_rollback_statement_callback (on_statements_rolled_back);
+		Tracker.Data.remove_savepoint_callback (on_savepoint);
 
 		if (signal_timeout != 0) {
 			Source.remove (signal_timeout);
@@ -364,4 +773,13 @@ public class Tracker.Resources : Object {
 	public void unreg_batches (string old_owner) {
 		Tracker.Store.unreg_batches (old_owner);
 	}
+
+	[DBus (visible = false)]
+	public void unreg_subscriptions (string old_owner) {
+		for (int i = graph_subscriptions.length - 1; i >= 0; i--) {
+			if (graph_subscriptions[i].sender == old_owner) {
+				graph_subscriptions.remove_index (i);
+			}
+		}
+	}
 }
@@ -68,4 +68,83 @@ public class Tracker.Statistics : Object {
 
 		return builder.end ();
 	}
+
+	static void add_counter (VariantBuilder builder, string name, string value) {
+		builder.open ((VariantType) "as");
+		builder.add ("s", name);
+		builder.add ("s", value);
+		builder.close ();
+	}
+
+	[DBus (signature = "aas")]
+	public Variant get_counters (BusName sender) throws GLib.Error {
+		var request = DBusRequest.begin (sender, "Statistics.GetCounters");
+
+		var builder = new VariantBuilder ((VariantType) "aas");
+
+		uint hits, misses, size;
+		Sparql.Query.get_translation_cache_stats (out hits, out misses, out size);
+
+		add_counter (builder, "query-cache-hits", hits.to_string ());
+		add_counter (builder, "query-cache-misses", misses.to_string ());
+		add_counter (builder, "query-cache-size", size.to_string ());
+
+		int concurrency, max_concurrency;
+		Tracker.Store.get_query_stats (out concurrency, out max_concurrency);
+
+		add_counter (builder, "query-concurrency", concurrency.to_string ());
+		add_counter (builder, "query-concurrency-max", max_concurrency.to_string ());
+
+		string[] priorities = { "high", "low", "turtle" };
+
+		for (int i = 0; i < Tracker.Store.Priority.N_PRIORITIES; i++) {
+			uint n_queued;
+			var stats = Tracker.Store.get_query_queue_stats ((Tracker.Store.Priority) i, out n_queued);
+
+			/* times are cumulative, in milliseconds */
+			add_counter (builder, "query-%s-queued".printf (priorities[i]), n_queued.to_string ());
+			add_counter (builder, "query-%s-finished".printf (priorities[i]), stats.n_finished.to_string ());
+			add_counter (builder, "query-%s-wait-time".printf (priorities[i]), (stats.wait_time / 1000).to_string ());
+			add_counter (builder, "query-%s-run-time".printf (priorities[i]), (stats.run_time / 1000).to_string ());
+		}
+
+		var checkpoint_stats = Tracker.Store.get_checkpoint_stats ();
+		string[] modes = { "passive", "restart", "truncate" };
+
+		add_counter (builder, "wal-pages", checkpoint_stats.wal_pages.to_string ());
+
+		for (int i = 0; i < Tracker.Store.CheckpointMode.N_MODES; i++) {
+			add_counter (builder, "checkpoint-%s".printf (modes[i]), checkpoint_stats.n_checkpoints[i].to_string ());
+		}
+
+		/* histograms, checkpoints by duration in milliseconds and
+		 * by WAL size in pages when they started */
+		for (int i = 0; i < checkpoint_stats.durations.length; i++) {
+			string bucket;
+
+			if (i < Tracker.Store.CHECKPOINT_DURATION_BUCKETS.length) {
+				bucket = "le-" + Tracker.Store.CHECKPOINT_DURATION_BUCKETS[i].to_string ();
+			} else {
+				bucket = "gt-" + Tracker.Store.CHECKPOINT_DURATION_BUCKETS[i - 1].to_string ();
+			}
+
+			add_counter (builder, "checkpoint-duration-" + bucket, checkpoint_stats.durations[i].to_string ());
+		}
+
+		for (int i = 0; i < checkpoint_stats.wal_sizes.length; i++) {
+			string bucket;
+
+			if (i < Tracker.Store.CHECKPOINT_WAL_SIZE_BUCKETS.length) {
+				bucket = "le-" + Tracker.Store.CHECKPOINT_WAL_SIZE_BUCKETS[i].to_string ();
+			} else {
+				bucket = "gt-" + Tracker.Store.CHECKPOINT_WAL_SIZE_BUCKETS[i - 1].to_string ();
+			}
+
+			add_counter (builder, "checkpoint-wal-size-" + bucket, checkpoint_stats.wal_sizes[i].to_string ());
+		}
+
+		request.end ();
+
+		return builder.end ();
+	}
 }
@@ -24,57 +24,246 @@ public class Tracker.Steroids : Object {
 
 	public const int BUFFER_SIZE = 65536;
 
+	/* Result protocols of QueryWithProtocol, see Tracker.Bus.ColumnarCursor
+	 * and Tracker.Bus.StreamCursor */
+	public const uint PROTOCOL_ROWS = 0;
+	public const uint PROTOCOL_COLUMNAR = 1;
+	public const uint PROTOCOL_STREAMING = 2;
+
+	const int COLUMNAR_BLOCK_ROWS = 1024;
+
 	public async string[] query (BusName sender, string query, UnixOutputStream output_stream) throws Error {
-		var request = DBusRequest.begin (sender, "Steroids.Query");
-		request.debug ("query: %s", query);
-		try {
-			string[] variable_names = null;
+		return yield query_internal (sender, "Steroids.Query", query, null, PROTOCOL_ROWS, output_stream);
+	}
+
+	public async string[] query_statement (BusName sender, string query, [DBus (signature = "a{sv}")] Variant parameters, UnixOutputStream output_stream) throws Error {
+		return yield query_internal (sender, "Steroids.QueryStatement", query, parameters, PROTOCOL_ROWS, output_stream);
+	}
+
+	/* Like QueryStatement, the client asks for the highest result
+	 * protocol it understands and is told which one was used.
+	 */
+	public async string[] query_with_protocol (BusName sender, string query, [DBus (signature = "a{sv}")] Variant parameters, uint protocol, UnixOutputStream output_stream, out uint used_protocol) throws Error {
+		used_protocol = uint.min (protocol, PROTOCOL_STREAMING);
+
+		return yield query_internal (sender, "Steroids.QueryWithProtocol", query, parameters, used_protocol, output_stream);
+	}
+
+	static void write_rows (DBCursor cursor, DataOutputStream data_output_stream) throws Error {
+		int n_columns = cursor.n_columns;
 
-			yield Tracker.Store.sparql_query (query, Tracker.Store.Priority.HIGH, cursor => {
-				var data_output_stream = new DataOutputStream (new BufferedOutputStream.sized (output_stream, BUFFER_SIZE));
-				data_output_stream.set_byte_order (DataStreamByteOrder.HOST_ENDIAN);
+		int[] column_sizes = new int[n_columns];
+		int[] column_offsets = new int[n_columns];
+		string[] column_data = new string[n_columns];
 
-				int n_columns = cursor.n_columns;
+		while (cursor.next ()) {
+			int last_offset = -1;
 
-				int[] column_sizes = new int[n_columns];
-				int[] column_offsets = new int[n_columns];
-				string[] column_data = new string[n_columns];
+			for (int i = 0; i < n_columns ; i++) {
+				unowned string str = cursor.get_string (i);
+
+				column_sizes[i] = str != null ? str.length : 0;
+				column_data[i]  = str;
+
+				last_offset += column_sizes[i] + 1;
+				column_offsets[i] = last_offset;
+			}
+
+			data_output_stream.put_int32 (n_columns);
+
+			for (int i = 0; i < n_columns ; i++) {
+				/* Cast from enum to int */
+				data_output_stream.put_int32 ((int) cursor.get_value_type (i));
+			}
+
+			for (int i = 0; i < n_columns ; i++) {
+				data_output_stream.put_int32 (column_offsets[i]);
+			}
+
+			for (int i = 0; i < n_columns ; i++) {
+				data_output_stream.put_string (column_data[i] != null ? column_data[i] : "");
+				data_output_stream.put_byte (0);
+			}
+		}
+	}
 
-				variable_names = new string[n_columns];
+	/* Grows data by size bytes, aligned on 8 bytes, and returns
+	 * the offset of the new bytes.
+	 */
+	static uint column_data_reserve (ByteArray data, uint size) {
+		uint offset = (data.len + 7) & ~7;
+
+		data.set_size (offset + size);
+
+		return offset;
+	}
+
+	static void write_columns (DBCursor cursor, uint protocol, DataOutputStream data_output_stream, Tracker.Store.StreamStarted? started) throws Error {
+		int n_columns = cursor.n_columns;
+
+		int32[] types = new int32[n_columns * COLUMNAR_BLOCK_ROWS];
+		int32[] offsets = new int32[n_columns * COLUMNAR_BLOCK_ROWS];
+		ByteArray[] data = new ByteArray[n_columns];
+
+		for (int i = 0; i < n_columns; i++) {
+			data[i] = new ByteArray ();
+		}
+
+		data_output_stream.put_int32 ((int32) protocol);
+		data_output_stream.put_int32 (n_columns);
+
+		if (protocol == PROTOCOL_STREAMING) {
+			// the client gets the D-Bus reply only after all rows,
+			// so variable names go first in the stream
+			int64 header_size = 8;
+
+			for (int i = 0; i < n_columns; i++) {
+				unowned string name = cursor.get_variable_name (i);
+
+				data_output_stream.put_int32 (name.length);
+				data_output_stream.put_string (name);
+				data_output_stream.put_byte (0);
+				header_size += 4 + name.length + 1;
+			}
+
+			while (header_size % 8 != 0) {
+				data_output_stream.put_byte (0);
+				header_size++;
+			}
+
+			data_output_stream.flush ();
+		}
+
+		bool more = true;
+
+		while (more) {
+			int n_rows = 0;
+
+			while (n_rows < COLUMNAR_BLOCK_ROWS && (more = cursor.next ())) {
 				for (int i = 0; i < n_columns; i++) {
-					variable_names[i] = cursor.get_variable_name (i);
+					var type = cursor.get_value_type (i);
+					int cell = i * COLUMNAR_BLOCK_ROWS + n_rows;
+					uint offset;
+
+					types[cell] = (int32) type;
+
+					switch (type) {
+					case Sparql.ValueType.UNBOUND:
+						offset = 0;
+						break;
+					case Sparql.ValueType.INTEGER:
+						offset = column_data_reserve (data[i], 8);
+						*((int64*) ((uint8*) data[i].data + offset)) = cursor.get_integer (i);
+						break;
+					case Sparql.ValueType.BOOLEAN:
+						// booleans are selected as 'true'/'false'
+						offset = column_data_reserve (data[i], 8);
+						*((int64*) ((uint8*) data[i].data + offset)) = (cursor.get_string (i) == "true") ? 1 : 0;
+						break;
+					case Sparql.ValueType.DOUBLE:
+						offset = column_data_reserve (data[i], 8);
+						*((double*) ((uint8*) data[i].data + offset)) = cursor.get_double (i);
+						break;
+					default:
+						long length;
+						unowned string str = cursor.get_string (i, out length);
+
+						offset = data[i].len;
+						data[i].set_size (offset + (uint) length + 1);
+						Memory.copy ((uint8*) data[i].data + offset, str, length);
+						data[i].data[offset + length] = 0;
+						break;
+					}
+
+					offsets[cell] = (int32) offset;
 				}
 
-				while (cursor.next ()) {
-					int last_offset = -1;
+				n_rows++;
+			}
 
-					for (int i = 0; i < n_columns ; i++) {
-						unowned string str = cursor.get_string (i);
+			if (n_rows == 0) {
+				break;
+			}
 
-						column_sizes[i] = str != null ? str.length : 0;
-						column_data[i]  = str;
+			if (protocol == PROTOCOL_STREAMING) {
+				// blocks are prefixed by their size
+				int64 block_size = 8;
 
-						last_offset += column_sizes[i] + 1;
-						column_offsets[i] = last_offset;
-					}
+				for (int i = 0; i < n_columns; i++) {
+					column_data_reserve (data[i], 0);
+					block_size += n_rows * 8 + 8 + data[i].len;
+				}
 
-					data_output_stream.put_int32 (n_columns);
+				data_output_stream.put_int64 (block_size);
+			}
 
-					for (int i = 0; i < n_columns ; i++) {
-						/* Cast from enum to int */
-						data_output_stream.put_int32 ((int) cursor.get_value_type (i));
-					}
+			data_output_stream.put_int64 (n_rows);
 
-					for (int i = 0; i < n_columns ; i++) {
-						data_output_stream.put_int32 (column_offsets[i]);
-					}
+			for (int i = 0; i < n_columns; i++) {
+				int first = i * COLUMNAR_BLOCK_ROWS;
+				size_t bytes_written;
 
-					for (int i = 0; i < n_columns ; i++) {
-						data_output_stream.put_string (column_data[i] != null ? column_data[i] : "");
-						data_output_stream.put_byte (0);
-					}
+				for (int row = 0; row < n_rows; row++) {
+					data_output_stream.put_int32 (types[first + row]);
+				}
+
+				for (int row = 0; row < n_rows; row++) {
+					data_output_stream.put_int32 (offsets[first + row]);
 				}
-			}, sender);
+
+				// keep the next column aligned
+				column_data_reserve (data[i], 0);
+
+				data_output_stream.put_int64 (data[i].len);
+				data_output_stream.write_all (data[i].data, out bytes_written);
+				data[i].set_size (0);
+			}
+
+			if (protocol == PROTOCOL_STREAMING) {
+				data_output_stream.flush ();
+
+				if (started != null) {
+					started ();
+				}
+			}
+		}
+	}
+
+	static string[] write_results (DBCursor cursor, uint protocol, UnixOutputStream output_stream, Tracker.Store.StreamStarted? started) throws Error {
+		var data_output_stream = new DataOutputStream (new BufferedOutputStream.sized (output_stream, BUFFER_SIZE));
+		data_output_stream.set_byte_order (DataStreamByteOrder.HOST_ENDIAN);
+
+		int n_columns = cursor.n_columns;
+
+		var variable_names = new string[n_columns];
+		for (int i = 0; i < n_columns; i++) {
+			variable_names[i] = cursor.get_variable_name (i);
+		}
+
+		if (protocol >= PROTOCOL_COLUMNAR) {
+			write_columns (cursor, protocol, data_output_stream, started);
+		} else {
+			write_rows (cursor, data_output_stream);
+		}
+
+		return variable_names;
+	}
+
+	async string[] query_internal (BusName sender, string method, string query, Variant? parameters, uint protocol, UnixOutputStream output_stream) throws Error {
+		var request = DBusRequest.begin (sender, method);
+		request.debug ("query: %s", query);
+		try {
+			string[] variable_names = null;
+
+			if (protocol == PROTOCOL_STREAMING) {
+				yield Tracker.Store.sparql_query_stream (query, parameters, Tracker.Store.Priority.HIGH, (cursor, started) => {
+					variable_names = write_results (cursor, protocol, output_stream, started);
+				}, sender);
+			} else {
+				yield Tracker.Store.sparql_query (query, parameters, Tracker.Store.Priority.HIGH, cursor => {
+					variable_names = write_results (cursor, protocol, output_stream, null);
+				}, sender);
+			}
 
 			request.end ();
 
@@ -165,7 +354,6 @@ public class Tracker.Steroids : Object {
 
 			int query_count = data_input_stream.read_int32 ();
 
-			var combined_query = new StringBuilder ();
 			string[] query_array = new string[query_count];
 
 			int i;
@@ -180,44 +368,24 @@ public class Tracker.Steroids : Object {
 				data_input_stream.read_all (((uint8[]) query_array[i])[0:query_size], out bytes_read);
 
 				request.debug ("query: %s", query_array[i]);
-				combined_query.append (query_array[i]);
 			}
 
 			data_input_stream = null;
 
-			var builder = new VariantBuilder ((VariantType) "as");
-
-			// first try combined query for best possible performance
-			try {
-				yield Tracker.Store.sparql_update (combined_query.str, Tracker.Store.Priority.LOW, sender);
+			// all queries go in one transaction, failing ones are
+			// reverted on their own
+			var errors = yield Tracker.Store.sparql_update_batch (query_array, Tracker.Store.Priority.LOW, sender);
 
-				// combined query was successful
-				for (i = 0; i < query_count; i++) {
-					builder.add ("s", "");
-					builder.add ("s", "");
-				}
-
-				request.end ();
-
-				return builder.end ();
-			} catch {
-				// combined query was not successful
-				combined_query = null;
-			}
+			var builder = new VariantBuilder ((VariantType) "as");
 
-			// combined query was not successful, try queries one by one
 			for (i = 0; i < query_count; i++) {
-				request.debug ("query: %s", query_array[i]);
-
-				try {
-					yield Tracker.Store.sparql_update (query_array[i], Tracker.Store.Priority.LOW, sender);
+				if (errors[i] == null) {
 					builder.add ("s", "");
 					builder.add ("s", "");
-				} catch (Error e1) {
+				} else {
 					builder.add ("s", "org.freedesktop.Tracker1.SparqlError.Internal");
-					builder.add ("s", e1.message);
+					builder.add ("s", errors[i].message);
 				}
-
 			}
 
 			request.end ();
@@ -20,17 +20,55 @@
  */
 
 public class Tracker.Store {
-	const int MAX_CONCURRENT_QUERIES = 2;
+	const int MIN_CONCURRENT_QUERIES = 2;
 
 	const int MAX_TASK_TIME = 30;
 
+	/* maximum number of streamed queries running at once, they take
+	 * as long as their client does to read results, so they don't
+	 * use the query pool */
+	const int MAX_CONCURRENT_STREAMS = 4;
+
+	/* number of finished queries the concurrency is adapted on */
+	const int ADAPT_WINDOW = 32;
+	/* average queue wait in microseconds above which concurrency grows */
+	const int64 ADAPT_WAIT_THRESHOLD = 10000;
+
+	/* maximum number of updates committed together */
+	const int MAX_UPDATE_GROUP_SIZE = 64;
+
+	/* milliseconds without updates after which the store is idle */
+	const uint CHECKPOINT_IDLE_TIMEOUT = 1000;
+
+	/* upper bounds of the checkpoint histogram buckets, the last
+	 * bucket takes everything above */
+	public const int64 CHECKPOINT_DURATION_BUCKETS[] = { 10, 100, 1000 };
+	public const int CHECKPOINT_WAL_SIZE_BUCKETS[] = { 1000, 5000, 10000 };
+
+	const string[] CHECKPOINT_MODE_NAMES = { "PASSIVE", "RESTART", "TRUNCATE" };
+
 	static Queue<Task> query_queues[3 /* TRACKER_STORE_N_PRIORITIES */];
 	static Queue<Task> update_queues[3 /* TRACKER_STORE_N_PRIORITIES */];
+	static Queue<Task> stream_queue;
 	static int n_queries_running;
+	static int n_streams_running;
+	static int max_queries;
+	static int max_queries_limit;
+	static int window_finished;
+	static int window_contended;
+	static int64 window_wait_time;
+	static QueueStats query_stats[3 /* TRACKER_STORE_N_PRIORITIES */];
 	static bool update_running;
+	static bool fts_reindexing;
 	static ThreadPool<Task> update_pool;
 	static ThreadPool<Task> query_pool;
+	static ThreadPool<Task> stream_pool;
+	static ThreadPool<UpdateTask> prepare_pool;
 	static ThreadPool<bool> checkpoint_pool;
+	static uint checkpoint_idle_id;
+	static int checkpoint_counts[3 /* CheckpointMode.N_MODES */];
+	static int checkpoint_durations[4 /* CHECKPOINT_DURATION_BUCKETS + 1 */];
+	static int checkpoint_wal_sizes[4 /* CHECKPOINT_WAL_SIZE_BUCKETS + 1 */];
 	static GenericArray<Task> running_tasks;
 	static int max_task_time;
 	static bool active;
@@ -47,10 +85,40 @@ public class Tracker.Store {
 		QUERY,
 		UPDATE,
 		UPDATE_BLANK,
+		UPDATE_BATCH,
+		UPDATE_GROUP,
 		TURTLE,
+		FTS_REINDEX,
+	}
+
+	public enum CheckpointMode {
+		PASSIVE,
+		RESTART,
+		TRUNCATE,
+		N_MODES
 	}
 
 	public delegate void SparqlQueryInThread (DBCursor cursor) throws Error;
+	/* Called by streamed queries once results reached the client */
+	public delegate void StreamStarted ();
+	public delegate void SparqlStreamInThread (DBCursor cursor, StreamStarted started) throws Error;
+
+	public struct QueueStats {
+		public uint64 n_finished;
+		/* in microseconds */
+		public int64 wait_time;
+		public int64 run_time;
+	}
+
+	public struct CheckpointStats {
+		public int wal_pages;
+		/* by CheckpointMode */
+		public int[] n_checkpoints;
+		/* histograms, see CHECKPOINT_DURATION_BUCKETS and
+		 * CHECKPOINT_WAL_SIZE_BUCKETS */
+		public int[] durations;
+		public int[] wal_sizes;
+	}
 
 	abstract class Task {
 		public TaskType type;
@@ -61,9 +129,17 @@ public class Tracker.Store {
 
 	class QueryTask : Task {
 		public string query;
+		public Variant? parameters;
 		public Cancellable cancellable;
 		public uint watchdog_id;
+		public bool timed_out;
+		public Priority priority;
+		public int64 queue_time;
+		public int64 start_time;
 		public unowned SparqlQueryInThread in_thread;
+		public unowned SparqlStreamInThread stream_in_thread;
+		/* set once a stream sent its first results */
+		public int stream_started;
 
 		~QueryTask () {
 			if (watchdog_id > 0) {
@@ -72,16 +148,70 @@ public class Tracker.Store {
 		}
 	}
 
+	/* states of the parse stage of updates */
+	const int PREPARE_PENDING = 0;
+	const int PREPARE_RUNNING = 1;
+	const int PREPARE_DONE = 2;
+
 	class UpdateTask : Task {
 		public string query;
 		public Variant blank_nodes;
 		public Priority priority;
+		public int prepare_state;
+		public Sparql.Query? prepared;
+
+		/* Parses the update ahead of the update thread, runs in
+		 * a thread of prepare_pool. */
+		public virtual void prepare () {
+			prepared = prepare_query (query);
+		}
+
+		public static Sparql.Query? prepare_query (string sparql) {
+			var query = new Sparql.Query.update (sparql);
+
+			try {
+				if (query.prepare_update ()) {
+					return query;
+				}
+			} catch (Error e) {
+				// parsed again and reported by the update thread
+			}
+
+			return null;
+		}
+	}
+
+	class UpdateBatchTask : UpdateTask {
+		public string[] queries;
+		public Sparql.Query?[] prepared_queries;
+		public GenericArray<Error?> errors;
+
+		public override void prepare () {
+			var prepared_queries = new Sparql.Query?[queries.length];
+
+			for (int i = 0; i < queries.length; i++) {
+				prepared_queries[i] = prepare_query (queries[i]);
+			}
+
+			this.prepared_queries = prepared_queries;
+		}
+	}
+
+	/* Updates from separate requests, applied in one transaction */
+	class UpdateGroupTask : Task {
+		public GenericArray<UpdateTask> tasks = new GenericArray<UpdateTask> ();
+		public Priority priority;
 	}
 
 	class TurtleTask : Task {
 		public string path;
 	}
 
+	/* One step of rebuilding the FTS tokens */
+	class FtsReindexTask : Task {
+		public bool more;
+	}
+
 	static void sched () {
 		Task task = null;
 
@@ -89,7 +219,7 @@ public class Tracker.Store {
 			return;
 		}
 
-		while (n_queries_running < MAX_CONCURRENT_QUERIES) {
+		while (n_queries_running < max_queries) {
 			for (int i = 0; i < Priority.N_PRIORITIES; i++) {
 				task = query_queues[i].pop_head ();
 				if (task != null) {
@@ -100,33 +230,48 @@ public class Tracker.Store {
 				/* no pending query */
 				break;
 			}
-			running_tasks.add (task);
-
-			if (max_task_time != 0) {
-				var query_task = (QueryTask) task;
-				query_task.watchdog_id = Timeout.add_seconds (max_task_time, () => {
-					query_task.cancellable.cancel ();
-					query_task.watchdog_id = 0;
-					return false;
-				});
-			}
 
 			n_queries_running++;
-			try {
-				query_pool.add (task);
-			} catch (Error e) {
-				// ignore harmless thread creation error
+			run_query ((QueryTask) task, query_pool);
+		}
+
+		while (n_streams_running < MAX_CONCURRENT_STREAMS) {
+			task = stream_queue.pop_head ();
+			if (task == null) {
+				break;
 			}
+
+			n_streams_running++;
+			run_query ((QueryTask) task, stream_pool);
 		}
 
 		if (!update_running) {
 			for (int i = 0; i < Priority.N_PRIORITIES; i++) {
-				task = update_queues[i].pop_head ();
+				task = update_queues[i].peek_head ();
 				if (task != null) {
+					if (!claim_update (task)) {
+						/* still being parsed, sched () runs again
+						 * once done */
+						task = null;
+					} else {
+						update_queues[i].pop_head ();
+					}
 					break;
 				}
 			}
 			if (task != null) {
+				task = group_updates (task);
+				update_running = true;
+				try {
+					update_pool.add (task);
+				} catch (Error e) {
+					// ignore harmless thread creation error
+				}
+			} else if (fts_reindexing && update_queues_empty ()) {
+				/* rebuild FTS tokens while there is nothing else
+				 * to write, queries keep using the old ones */
+				task = new FtsReindexTask ();
+				task.type = TaskType.FTS_REINDEX;
 				update_running = true;
 				try {
 					update_pool.add (task);
@@ -137,10 +282,130 @@ public class Tracker.Store {
 		}
 	}
 
+	static void run_query (QueryTask query_task, ThreadPool<Task> pool) {
+		running_tasks.add (query_task);
+		query_task.start_time = get_monotonic_time ();
+
+		if (max_task_time != 0) {
+			query_task.watchdog_id = Timeout.add_seconds (max_task_time, () => {
+				query_task.watchdog_id = 0;
+
+				/* a stream sending results is only as fast as
+				 * its client reads them */
+				if (AtomicInt.get (ref query_task.stream_started) != 0) {
+					return false;
+				}
+
+				query_task.cancellable.cancel ();
+				query_task.timed_out = true;
+				return false;
+			});
+		}
+
+		try {
+			pool.add (query_task);
+		} catch (Error e) {
+			// ignore harmless thread creation error
+		}
+	}
+
+	static bool update_queues_empty () {
+		for (int i = 0; i < Priority.N_PRIORITIES; i++) {
+			if (update_queues[i].get_length () > 0) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static bool claim_update (Task task) {
+		var update_task = task as UpdateTask;
+
+		if (update_task == null) {
+			return true;
+		}
+
+		/* an update not picked up by the parse stage yet is
+		 * parsed by the update thread itself */
+		AtomicInt.compare_and_exchange (ref update_task.prepare_state, PREPARE_PENDING, PREPARE_DONE);
+
+		return AtomicInt.get (ref update_task.prepare_state) == PREPARE_DONE;
+	}
+
+	/* Group commit: plain updates of the same priority that queued up
+	 * while the previous transaction ran join @task, so they share its
+	 * SQLite transaction and journal commit. Each one still runs in its
+	 * own savepoint and gets its own result, the events of one that
+	 * fails are rolled back with it.
+	 */
+	static Task group_updates (Task task) {
+		UpdateGroupTask group = null;
+		Priority priority;
+		Task next;
+
+		if (task.type != TaskType.UPDATE) {
+			return task;
+		}
+
+		priority = ((UpdateTask) task).priority;
+
+		while ((next = update_queues[priority].peek_head ()) != null &&
+		       next.type == TaskType.UPDATE &&
+		       (group == null || group.tasks.length < MAX_UPDATE_GROUP_SIZE) &&
+		       claim_update (next)) {
+			update_queues[priority].pop_head ();
+
+			if (group == null) {
+				group = new UpdateGroupTask ();
+				group.type = TaskType.UPDATE_GROUP;
+				group.priority = priority;
+				group.tasks.add ((UpdateTask) task);
+			}
+
+			group.tasks.add ((UpdateTask) next);
+		}
+
+		if (group == null) {
+			return task;
+		}
+
+		debug ("Committing %d updates together", group.tasks.length);
+
+		return group;
+	}
+
+	static void prepare_dispatch_cb (owned UpdateTask task) {
+		if (!AtomicInt.compare_and_exchange (ref task.prepare_state, PREPARE_PENDING, PREPARE_RUNNING)) {
+			/* already claimed by the update thread */
+			return;
+		}
+
+		task.prepare ();
+
+		AtomicInt.set (ref task.prepare_state, PREPARE_DONE);
+
+		Idle.add (() => {
+			sched ();
+			return false;
+		});
+	}
+
+	static void queue_update (UpdateTask task) {
+		update_queues[task.priority].push_tail (task);
+
+		try {
+			prepare_pool.add (task);
+		} catch (Error e) {
+			// ignore harmless thread creation error
+		}
+	}
+
 	static Tracker.Data.CommitType commit_type (Task task) {
 		switch (task.type) {
 			case TaskType.UPDATE:
 			case TaskType.UPDATE_BLANK:
+			case TaskType.UPDATE_BATCH:
 				if (((UpdateTask) task).priority == Priority.HIGH) {
 					return Tracker.Data.CommitType.REGULAR;
 				} else if (update_queues[Priority.LOW].get_length () > 0) {
@@ -148,6 +413,14 @@ public class Tracker.Store {
 				} else {
 					return Tracker.Data.CommitType.BATCH_LAST;
 				}
+			case TaskType.UPDATE_GROUP:
+				if (((UpdateGroupTask) task).priority == Priority.HIGH) {
+					return Tracker.Data.CommitType.REGULAR;
+				} else if (update_queues[Priority.LOW].get_length () > 0) {
+					return Tracker.Data.CommitType.BATCH;
+				} else {
+					return Tracker.Data.CommitType.BATCH_LAST;
+				}
 			case TaskType.TURTLE:
 				if (update_queues[Priority.TURTLE].get_length () > 0) {
 					return Tracker.Data.CommitType.BATCH;
@@ -160,10 +433,50 @@ public class Tracker.Store {
 		}
 	}
 
+	static void adapt_concurrency (QueryTask task) {
+		int64 wait_time = task.start_time - task.queue_time;
+
+		query_stats[task.priority].n_finished++;
+		query_stats[task.priority].wait_time += wait_time;
+		query_stats[task.priority].run_time += get_monotonic_time () - task.start_time;
+
+		window_finished++;
+		window_wait_time += wait_time;
+
+		/* Queries running into the watchdog or failing inside SQLite
+		 * (busy/locked database) hint that the readers already
+		 * contend with each other.
+		 */
+		if (task.timed_out || task.error is DBInterfaceError.QUERY_ERROR) {
+			window_contended++;
+		}
+
+		if (window_finished < ADAPT_WINDOW) {
+			return;
+		}
+
+		if (window_contended * 16 > window_finished) {
+			max_queries = int.max (MIN_CONCURRENT_QUERIES, max_queries / 2);
+			debug ("Query concurrency decreased to %d", max_queries);
+		} else if (window_wait_time / window_finished > ADAPT_WAIT_THRESHOLD &&
+		           max_queries < max_queries_limit) {
+			max_queries++;
+			debug ("Query concurrency increased to %d", max_queries);
+		}
+
+		window_finished = 0;
+		window_contended = 0;
+		window_wait_time = 0;
+	}
+
 	static bool task_finish_cb (Task task) {
 		if (task.type == TaskType.QUERY) {
 			var query_task = (QueryTask) task;
 
+			if (query_task.stream_in_thread == null) {
+				adapt_concurrency (query_task);
+			}
+
 			if (task.error == null) {
 				try {
 					query_task.cancellable.set_error_if_cancelled ();
@@ -176,8 +489,13 @@ public class Tracker.Store {
 			task.error = null;
 
 			running_tasks.remove (task);
-			n_queries_running--;
-		} else if (task.type == TaskType.UPDATE || task.type == TaskType.UPDATE_BLANK) {
+
+			if (query_task.stream_in_thread != null) {
+				n_streams_running--;
+			} else {
+				n_queries_running--;
+			}
+		} else if (task.type == TaskType.UPDATE || task.type == TaskType.UPDATE_BLANK || task.type == TaskType.UPDATE_BATCH) {
 			if (task.error == null) {
 				Tracker.Data.notify_transaction (commit_type (task));
 			}
@@ -185,6 +503,28 @@ public class Tracker.Store {
 			task.callback ();
 			task.error = null;
 
+			update_running = false;
+		} else if (task.type == TaskType.UPDATE_GROUP) {
+			var group_task = (UpdateGroupTask) task;
+
+			if (task.error == null) {
+				Tracker.Data.notify_transaction (commit_type (task));
+			}
+
+			for (int i = 0; i < group_task.tasks.length; i++) {
+				var update_task = group_task.tasks[i];
+
+				if (task.error != null) {
+					/* the whole transaction failed */
+					update_task.error = task.error;
+				}
+
+				update_task.callback ();
+				update_task.error = null;
+			}
+
+			task.error = null;
+
 			update_running = false;
 		} else if (task.type == TaskType.TURTLE) {
 			if (task.error == null) {
@@ -194,10 +534,25 @@ public class Tracker.Store {
 			task.callback ();
 			task.error = null;
 
+			update_running = false;
+		} else if (task.type == TaskType.FTS_REINDEX) {
+			if (task.error != null) {
+				warning ("Could not rebuild FTS tokens: %s", task.error.message);
+				/* resumed on next startup */
+				fts_reindexing = false;
+			} else {
+				fts_reindexing = ((FtsReindexTask) task).more;
+			}
+
 			update_running = false;
 		}
 
-		if (n_queries_running == 0 && !update_running && active_callback != null) {
+		if (task.type != TaskType.QUERY && !update_running) {
+			schedule_idle_checkpoint ();
+		}
+
+		if (n_queries_running == 0 && n_streams_running == 0 &&
+		    !update_running && active_callback != null) {
 			active_callback ();
 		}
 
@@ -211,9 +566,22 @@ public class Tracker.Store {
 			if (task.type == TaskType.QUERY) {
 				var query_task = (QueryTask) task;
 
-				var cursor = Tracker.Data.query_sparql_cursor (query_task.query);
+				DBCursor cursor;
+				if (query_task.parameters != null) {
+					var query_object = new Sparql.Query (query_task.query);
+					query_object.set_parameters (query_task.parameters);
+					cursor = query_object.execute_cursor ();
+				} else {
+					cursor = Tracker.Data.query_sparql_cursor (query_task.query);
+				}
 
-				query_task.in_thread (cursor);
+				if (query_task.stream_in_thread != null) {
+					query_task.stream_in_thread (cursor, () => {
+						AtomicInt.set (ref query_task.stream_started, 1);
+					});
+				} else {
+					query_task.in_thread (cursor);
+				}
 			} else {
 				var iface = DBManager.get_db_interface ();
 				iface.sqlite_wal_hook (wal_hook);
@@ -221,11 +589,38 @@ public class Tracker.Store {
 				if (task.type == TaskType.UPDATE) {
 					var update_task = (UpdateTask) task;
 
-					Tracker.Data.update_sparql (update_task.query);
+					if (update_task.prepared != null) {
+						Tracker.Data.update_prepared (update_task.prepared);
+					} else {
+						Tracker.Data.update_sparql (update_task.query);
+					}
 				} else if (task.type == TaskType.UPDATE_BLANK) {
 					var update_task = (UpdateTask) task;
 
 					update_task.blank_nodes = Tracker.Data.update_sparql_blank (update_task.query);
+				} else if (task.type == TaskType.UPDATE_BATCH) {
+					var batch_task = (UpdateBatchTask) task;
+
+					batch_task.errors = Tracker.Data.update_sparql_batch (batch_task.queries, batch_task.prepared_queries);
+				} else if (task.type == TaskType.UPDATE_GROUP) {
+					var group_task = (UpdateGroupTask) task;
+					var queries = new string[group_task.tasks.length];
+					var prepared_queries = new Sparql.Query?[group_task.tasks.length];
+
+					for (int i = 0; i < group_task.tasks.length; i++) {
+						queries[i] = group_task.tasks[i].query;
+						prepared_queries[i] = group_task.tasks[i].prepared;
+					}
+
+					var errors = Tracker.Data.update_sparql_batch (queries, prepared_queries);
+
+					for (int i = 0; i < group_task.tasks.length; i++) {
+						group_task.tasks[i].error = errors[i];
+					}
+				} else if (task.type == TaskType.FTS_REINDEX) {
+					var reindex_task = (FtsReindexTask) task;
+
+					reindex_task.more = Tracker.Data.Manager.fts_reindex_step ();
 				} else if (task.type == TaskType.TURTLE) {
 					var turtle_task = (TurtleTask) task;
 
@@ -250,48 +645,187 @@ public class Tracker.Store {
 	}
 
 	public static void wal_checkpoint () {
+		run_checkpoint (CheckpointMode.PASSIVE);
+	}
+
+	/* Runs a checkpoint in the calling thread, returns true if the
+	 * whole WAL made it into the database. */
+	static bool run_checkpoint (CheckpointMode mode) {
+		int wal_size = AtomicInt.get (ref wal_pages);
+		int64 start_time = get_monotonic_time ();
+		bool complete = false;
+
 		try {
-			debug ("Checkpointing database...");
+			debug ("Checkpointing database (%s)...", CHECKPOINT_MODE_NAMES[mode]);
 			var iface = DBManager.get_db_interface ();
-			iface.execute_query ("PRAGMA wal_checkpoint");
+			var stmt = iface.create_statement (DBStatementCacheType.NONE, "PRAGMA wal_checkpoint(%s)", CHECKPOINT_MODE_NAMES[mode]);
+			var cursor = stmt.start_cursor ();
+
+			/* busy flag, frames in the WAL, frames checkpointed */
+			if (cursor.next ()) {
+				complete = (cursor.get_integer (0) == 0 &&
+				            cursor.get_integer (1) == cursor.get_integer (2));
+			}
+
+			if (complete && mode != CheckpointMode.PASSIVE) {
+				AtomicInt.set (ref wal_pages, 0);
+			}
+
 			debug ("Checkpointing complete...");
 		} catch (Error e) {
 			warning (e.message);
 		}
+
+		int64 duration = (get_monotonic_time () - start_time) / 1000;
+		int i;
+
+		AtomicInt.inc (ref checkpoint_counts[mode]);
+
+		i = 0;
+		while (i < CHECKPOINT_DURATION_BUCKETS.length && duration > CHECKPOINT_DURATION_BUCKETS[i]) {
+			i++;
+		}
+		AtomicInt.inc (ref checkpoint_durations[i]);
+
+		i = 0;
+		while (i < CHECKPOINT_WAL_SIZE_BUCKETS.length && wal_size > CHECKPOINT_WAL_SIZE_BUCKETS[i]) {
+			i++;
+		}
+		AtomicInt.inc (ref checkpoint_wal_sizes[i]);
+
+		return complete;
 	}
 
 	static int checkpointing;
+	static int requested_checkpoint_mode;
+	static int wal_pages;
+	/* only accessed in the update thread */
+	static int64 last_wal_hook_time;
+	static int last_wal_hook_pages;
+
+	static void request_checkpoint (CheckpointMode mode) {
+		if (AtomicInt.compare_and_exchange (ref checkpointing, 0, 1)) {
+			AtomicInt.set (ref requested_checkpoint_mode, mode);
+
+			try {
+				checkpoint_pool.push (true);
+			} catch (Error e) {
+				warning (e.message);
+				AtomicInt.set (ref checkpointing, 0);
+			}
+		}
+	}
 
 	static void wal_hook (int n_pages) {
 		// run in update thread
 
 		debug ("WAL: %d pages", n_pages);
 
-		if (n_pages >= 10000) {
-			// do immediate checkpointing (blocking updates)
-			// to prevent excessive wal file growth
-			wal_checkpoint ();
-		} else if (n_pages >= 1000) {
-			if (AtomicInt.compare_and_exchange (ref checkpointing, 0, 1)) {
-				// initiate asynchronous checkpointing (not blocking updates)
-				try {
-					checkpoint_pool.push (true);
-				} catch (Error e) {
-					warning (e.message);
-					AtomicInt.set (ref checkpointing, 0);
-				}
-			}
+		int64 now = get_monotonic_time ();
+		int64 elapsed = (last_wal_hook_time > 0 ? now - last_wal_hook_time : 0);
+
+		var trigger = wal_checkpoint_trigger (n_pages, last_wal_hook_pages, elapsed);
+
+		last_wal_hook_time = now;
+		last_wal_hook_pages = n_pages;
+		AtomicInt.set (ref wal_pages, n_pages);
+
+		switch (trigger) {
+		case WalCheckpoint.BLOCKING:
+			// hard cap: do immediate checkpointing (blocking updates)
+			// to prevent excessive wal file growth. RESTART would
+			// also wait for readers here, leave it to the
+			// checkpoint thread
+			run_checkpoint (CheckpointMode.PASSIVE);
+			request_checkpoint (CheckpointMode.RESTART);
+			break;
+		case WalCheckpoint.BACKGROUND:
+			// writes are not letting up, initiate asynchronous
+			// checkpointing (not blocking updates)
+			request_checkpoint (CheckpointMode.PASSIVE);
+			break;
+		default:
+			// wait for the store to go idle, see
+			// schedule_idle_checkpoint ()
+			break;
+		}
+	}
+
+	static void schedule_idle_checkpoint () {
+		if (AtomicInt.get (ref wal_pages) < WAL_CHECKPOINT_PAGES) {
+			return;
 		}
+
+		if (checkpoint_idle_id != 0) {
+			Source.remove (checkpoint_idle_id);
+		}
+
+		checkpoint_idle_id = Timeout.add (CHECKPOINT_IDLE_TIMEOUT, () => {
+			checkpoint_idle_id = 0;
+
+			if (!active || update_running) {
+				return false;
+			}
+
+			if (!update_queues_empty ()) {
+				// the next finished update schedules again
+				return false;
+			}
+
+			/* Without readers, also reset the WAL so it stops growing,
+			 * truncating it if it got large. */
+			if (n_queries_running > 0 || n_streams_running > 0) {
+				request_checkpoint (CheckpointMode.PASSIVE);
+			} else if (AtomicInt.get (ref wal_pages) >= WAL_BUSY_CHECKPOINT_PAGES) {
+				request_checkpoint (CheckpointMode.TRUNCATE);
+			} else {
+				request_checkpoint (CheckpointMode.RESTART);
+			}
+
+			return false;
+		});
 	}
 
 	static void checkpoint_dispatch_cb (bool task) {
 		// run in checkpoint thread
 
-		wal_checkpoint ();
+		var mode = (CheckpointMode) AtomicInt.get (ref requested_checkpoint_mode);
+
+		/* RESTART and TRUNCATE hold back writers until readers are
+		 * done with old snapshots, only try them once a PASSIVE
+		 * checkpoint emptied the WAL so they have nothing to wait for.
+		 */
+		if (run_checkpoint (CheckpointMode.PASSIVE) && mode != CheckpointMode.PASSIVE) {
+			run_checkpoint (mode);
+		}
+
 		AtomicInt.set (ref checkpointing, 0);
 	}
 
-	public static void init () {
+	public static CheckpointStats get_checkpoint_stats () {
+		var stats = CheckpointStats ();
+
+		stats.wal_pages = AtomicInt.get (ref wal_pages);
+		stats.n_checkpoints = new int[CheckpointMode.N_MODES];
+		stats.durations = new int[checkpoint_durations.length];
+		stats.wal_sizes = new int[checkpoint_wal_sizes.length];
+
+		for (int i = 0; i < CheckpointMode.N_MODES; i++) {
+			stats.n_checkpoints[i] = AtomicInt.get (ref checkpoint_counts[i]);
+		}
+
+		for (int i = 0; i < checkpoint_durations.length; i++) {
+			stats.durations[i] = AtomicInt.get (ref checkpoint_durations[i]);
+		}
+
+		for (int i = 0; i < checkpoint_wal_sizes.length; i++) {
+			stats.wal_sizes[i] = AtomicInt.get (ref checkpoint_wal_sizes[i]);
+		}
+
+		return stats;
+	}
+
+	public static void init (int max_concurrent_queries) {
 		string max_task_time_env = Environment.get_variable ("TRACKER_STORE_MAX_TASK_TIME");
 		if (max_task_time_env != null) {
 			max_task_time = int.parse (max_task_time_env);
@@ -299,6 +833,14 @@ public class Tracker.Store {
 			max_task_time = MAX_TASK_TIME;
 		}
 
+		/* 0 means as many queries as there are processors */
+		if (max_concurrent_queries <= 0) {
+			max_concurrent_queries = (int) get_num_processors ();
+		}
+
+		max_queries_limit = int.max (MIN_CONCURRENT_QUERIES, max_concurrent_queries);
+		max_queries = MIN_CONCURRENT_QUERIES;
+
 		running_tasks = new GenericArray<Task> ();
 
 		for (int i = 0; i < Priority.N_PRIORITIES; i++) {
@@ -306,9 +848,13 @@ public class Tracker.Store {
 			update_queues[i] = new Queue<Task> ();
 		}
 
+		stream_queue = new Queue<Task> ();
+
 		try {
 			update_pool = new ThreadPool<Task>.with_owned_data (pool_dispatch_cb, 1, true);
-			query_pool = new ThreadPool<Task>.with_owned_data (pool_dispatch_cb, MAX_CONCURRENT_QUERIES, true);
+			query_pool = new ThreadPool<Task>.with_owned_data (pool_dispatch_cb, max_queries_limit, true);
+			stream_pool = new ThreadPool<Task>.with_owned_data (pool_dispatch_cb, MAX_CONCURRENT_STREAMS, true);
+			prepare_pool = new ThreadPool<UpdateTask>.with_owned_data (prepare_dispatch_cb, (int) get_num_processors (), false);
 			checkpoint_pool = new ThreadPool<bool>.with_owned_data (checkpoint_dispatch_cb, 1, true);
 		} catch (Error e) {
 			warning (e.message);
@@ -322,7 +868,14 @@ public class Tracker.Store {
 	}
 
 	public static void shutdown () {
+		if (checkpoint_idle_id != 0) {
+			Source.remove (checkpoint_idle_id);
+			checkpoint_idle_id = 0;
+		}
+
 		query_pool = null;
+		stream_pool = null;
+		prepare_pool = null;
 		update_pool = null;
 		checkpoint_pool = null;
 
@@ -330,16 +883,21 @@ public class Tracker.Store {
 			query_queues[i] = null;
 			update_queues[i] = null;
 		}
+
+		stream_queue = null;
 	}
 
-	public static async void sparql_query (string sparql, Priority priority, SparqlQueryInThread in_thread, string client_id) throws Error {
+	public static async void sparql_query (string sparql, Variant? parameters, Priority priority, SparqlQueryInThread in_thread, string client_id) throws Error {
 		var task = new QueryTask ();
 		task.type = TaskType.QUERY;
 		task.query = sparql;
+		task.parameters = parameters;
 		task.cancellable = new Cancellable ();
 		task.in_thread = in_thread;
 		task.callback = sparql_query.callback;
 		task.client_id = client_id;
+		task.priority = priority;
+		task.queue_time = get_monotonic_time ();
 
 		query_queues[priority].push_tail (task);
 
@@ -352,6 +910,33 @@ public class Tracker.Store {
 		}
 	}
 
+	/* Like sparql_query (), for queries whose results are sent while
+	 * the client reads them, see Tracker.Steroids.PROTOCOL_STREAMING.
+	 * The watchdog stops applying once started () was called.
+	 */
+	public static async void sparql_query_stream (string sparql, Variant? parameters, Priority priority, SparqlStreamInThread in_thread, string client_id) throws Error {
+		var task = new QueryTask ();
+		task.type = TaskType.QUERY;
+		task.query = sparql;
+		task.parameters = parameters;
+		task.cancellable = new Cancellable ();
+		task.stream_in_thread = in_thread;
+		task.callback = sparql_query_stream.callback;
+		task.client_id = client_id;
+		task.priority = priority;
+		task.queue_time = get_monotonic_time ();
+
+		stream_queue.push_tail (task);
+
+		sched ();
+
+		yield;
+
+		if (task.error != null) {
+			throw task.error;
+		}
+	}
+
 	public static async void sparql_update (string sparql, Priority priority, string client_id) throws Error {
 		var task = new UpdateTask ();
 		task.type = TaskType.UPDATE;
@@ -360,7 +945,7 @@ public class Tracker.Store {
 		task.callback = sparql_update.callback;
 		task.client_id = client_id;
 
-		update_queues[priority].push_tail (task);
+		queue_update (task);
 
 		sched ();
 
@@ -392,6 +977,27 @@ public class Tracker.Store {
 		return task.blank_nodes;
 	}
 
+	public static async GenericArray<Error?> sparql_update_batch (string[] sparql, Priority priority, string client_id) throws Error {
+		var task = new UpdateBatchTask ();
+		task.type = TaskType.UPDATE_BATCH;
+		task.queries = sparql;
+		task.priority = priority;
+		task.callback = sparql_update_batch.callback;
+		task.client_id = client_id;
+
+		queue_update (task);
+
+		sched ();
+
+		yield;
+
+		if (task.error != null) {
+			throw task.error;
+		}
+
+		return task.errors;
+	}
+
 	public static async void queue_turtle_import (File file, string client_id) throws Error {
 		var task = new TurtleTask ();
 		task.type = TaskType.TURTLE;
@@ -417,13 +1023,39 @@ public class Tracker.Store {
 			result += query_queues[i].get_length ();
 			result += update_queues[i].get_length ();
 		}
+		result += stream_queue.get_length ();
 		return result;
 	}
 
-	public static void unreg_batches (string client_id) {
+	public static void get_query_stats (out int concurrency, out int max_concurrency) {
+		concurrency = max_queries;
+		max_concurrency = max_queries_limit;
+	}
+
+	public static QueueStats get_query_queue_stats (Priority priority, out uint n_queued) {
+		n_queued = query_queues[priority].get_length ();
+		return query_stats[priority];
+	}
+
+	static void unreg_queued_tasks (Queue<Task> queue, string client_id) {
 		unowned List<Task> list, cur;
-		unowned Queue<Task> queue;
 
+		list = queue.head;
+		while (list != null) {
+			cur = list;
+			list = list.next;
+			unowned Task task = cur.data;
+
+			if (task != null && task.client_id == client_id) {
+				queue.delete_link (cur);
+
+				task.error = new DBusError.FAILED ("Client disappeared");
+				task.callback ();
+			}
+		}
+	}
+
+	public static void unreg_batches (string client_id) {
 		for (int i = 0; i < running_tasks.length; i++) {
 			unowned QueryTask task = running_tasks[i] as QueryTask;
 			if (task != null && task.client_id == client_id && task.cancellable != null) {
@@ -432,44 +1064,19 @@ public class Tracker.Store {
 		}
 
 		for (int i = 0; i < Priority.N_PRIORITIES; i++) {
-			queue = query_queues[i];
-			list = queue.head;
-			while (list != null) {
-				cur = list;
-				list = list.next;
-				unowned Task task = cur.data;
-
-				if (task != null && task.client_id == client_id) {
-					queue.delete_link (cur);
-
-					task.error = new DBusError.FAILED ("Client disappeared");
-					task.callback ();
-				}
-			}
-
-			queue = update_queues[i];
-			list = queue.head;
-			while (list != null) {
-				cur = list;
-				list = list.next;
-				unowned Task task = cur.data;
-
-				if (task != null && task.client_id == client_id) {
-					queue.delete_link (cur);
-
-					task.error = new DBusError.FAILED ("Client disappeared");
-					task.callback ();
-				}
-			}
+			unreg_queued_tasks (query_queues[i], client_id);
+			unreg_queued_tasks (update_queues[i], client_id);
 		}
 
+		unreg_queued_tasks (stream_queue, client_id);
+
 		sched ();
 	}
 
 	public static async void pause () {
 		Tracker.Store.active = false;
 
-		if (n_queries_running > 0 || update_running) {
+		if (n_queries_running > 0 || n_streams_running > 0 || update_running) {
 			active_callback = pause.callback;
 			yield;
 			active_callback = null;
@@ -492,6 +1099,7 @@ public class Tracker.Store {
 
 	public static void resume () {
 		Tracker.Store.active = true;
+		fts_reindexing = Tracker.Data.Manager.fts_reindex_pending ();
 
 		sched ();
 	}
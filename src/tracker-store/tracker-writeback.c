@@ -29,6 +29,8 @@
 typedef struct {
 	GHashTable *allowances;
 	GHashTable *pending_events;
+	GHashTable *savepoint_events;
+	gboolean in_savepoint;
 	GHashTable *ready_events;
 } WritebackPrivate;
 
@@ -79,6 +81,13 @@ tracker_writeback_check (gint         graph_id,
 	g_return_if_fail (private != NULL);
 
 	if (g_hash_table_lookup (private->allowances, GINT_TO_POINTER (pred_id))) {
+		if (private->in_savepoint) {
+			g_hash_table_insert (private->savepoint_events,
+			                     GINT_TO_POINTER (subject_id),
+			                     rdf_types_to_array (rdf_types));
+			return;
+		}
+
 		if (!private->pending_events) {
 			private->pending_events = g_hash_table_new_full (g_direct_hash, g_direct_equal,
 			                                                 (GDestroyNotify) NULL,
@@ -99,6 +108,69 @@ tracker_writeback_reset_pending ()
 	if (private->pending_events) {
 		g_hash_table_remove_all (private->pending_events);
 	}
+
+	if (private->savepoint_events) {
+		g_hash_table_remove_all (private->savepoint_events);
+	}
+
+	private->in_savepoint = FALSE;
+}
+
+/* Subjects checked between a savepoint and its release are only
+ * moved to the pending ones on release, and dropped on rollback.
+ */
+void
+tracker_writeback_savepoint (void)
+{
+	g_return_if_fail (private != NULL);
+
+	if (!private->savepoint_events) {
+		private->savepoint_events = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+		                                                   (GDestroyNotify) NULL,
+		                                                   (GDestroyNotify) array_free);
+	}
+
+	private->in_savepoint = TRUE;
+}
+
+void
+tracker_writeback_release_savepoint (void)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	g_return_if_fail (private != NULL);
+
+	private->in_savepoint = FALSE;
+
+	if (!private->savepoint_events ||
+	    g_hash_table_size (private->savepoint_events) == 0)
+		return;
+
+	if (!private->pending_events) {
+		private->pending_events = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+		                                                 (GDestroyNotify) NULL,
+		                                                 (GDestroyNotify) NULL);
+	}
+
+	g_hash_table_iter_init (&iter, private->savepoint_events);
+
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_hash_table_insert (private->pending_events, key, value);
+		g_hash_table_iter_steal (&iter);
+	}
+}
+
+void
+tracker_writeback_rollback_to_savepoint (void)
+{
+	g_return_if_fail (private != NULL);
+
+	private->in_savepoint = FALSE;
+
+	if (private->savepoint_events) {
+		g_hash_table_remove_all (private->savepoint_events);
+	}
 }
 
 void
@@ -130,6 +202,8 @@ free_private (gpointer user_data)
 		g_hash_table_unref (private->ready_events);
 	if (private->pending_events)
 		g_hash_table_unref (private->pending_events);
+	if (private->savepoint_events)
+		g_hash_table_unref (private->savepoint_events);
 	g_hash_table_unref (private->allowances);
 	g_free (private);
 }
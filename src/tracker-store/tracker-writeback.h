@@ -43,6 +43,9 @@ GHashTable* tracker_writeback_get_ready     (void);
 void        tracker_writeback_reset_pending (void);
 void        tracker_writeback_reset_ready   (void);
 void        tracker_writeback_transact      (void);
+void        tracker_writeback_savepoint     (void);
+void        tracker_writeback_release_savepoint     (void);
+void        tracker_writeback_rollback_to_savepoint (void);
 
 G_END_DECLS
 
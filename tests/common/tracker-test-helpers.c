@@ -43,3 +43,36 @@ tracker_test_helpers_free_nonutf8 (void)
 		nonutf8_str = NULL;
 	}
 }
+
+/* Points the XDG data and cache dirs to a new random location below
+ * @tests_data_dir, and the ontologies dir to the source tree. Returns
+ * the location, to be passed to tracker_test_helpers_clean_up_data_dirs().
+ */
+gchar *
+tracker_test_helpers_set_up_data_dirs (const gchar *tests_data_dir)
+{
+	gchar *basename, *location;
+
+	/* NOTE: g_test_build_filename() doesn't work env vars G_TEST_* are not defined?? */
+	basename = g_strdup_printf ("%d", g_test_rand_int_range (0, G_MAXINT));
+	location = g_build_path (G_DIR_SEPARATOR_S, tests_data_dir, basename, NULL);
+	g_free (basename);
+
+	g_assert_true (g_setenv ("XDG_DATA_HOME", location, TRUE));
+	g_assert_true (g_setenv ("XDG_CACHE_HOME", location, TRUE));
+	g_assert_true (g_setenv ("TRACKER_DB_ONTOLOGIES_DIR", TOP_SRCDIR "/src/ontologies/", TRUE));
+
+	return location;
+}
+
+void
+tracker_test_helpers_clean_up_data_dirs (const gchar *location)
+{
+	gchar *cleanup_command;
+
+	g_print ("Removing temporary data (%s)\n", location);
+
+	cleanup_command = g_strdup_printf ("rm -Rf %s/", location);
+	g_spawn_command_line_sync (cleanup_command, NULL, NULL, NULL, NULL);
+	g_free (cleanup_command);
+}
@@ -26,6 +26,9 @@ G_BEGIN_DECLS
 const gchar *tracker_test_helpers_get_nonutf8  (void);
 void         tracker_test_helpers_free_nonutf8 (void);
 
+gchar *      tracker_test_helpers_set_up_data_dirs   (const gchar *tests_data_dir);
+void         tracker_test_helpers_clean_up_data_dirs (const gchar *location);
+
 G_END_DECLS
 
 #endif /* __TRACKER_TEST_HELPERS_H__ */
@@ -31,8 +31,11 @@ from gi.repository import Gio
 from gi.repository import GObject
 from gi.repository import GLib
 import time
+import os
+import struct
 
 GRAPH_UPDATED_SIGNAL = "GraphUpdated"
+GRAPH_UPDATED_ROWS_SIGNAL = "GraphUpdatedRows"
 
 SIGNALS_PATH = "/org/freedesktop/Tracker1/Resources"
 SIGNALS_IFACE = "org.freedesktop.Tracker1.Resources"
@@ -188,7 +191,169 @@ class TrackerStoreSignalsTests (CommonTrackerStoreTest):
 
         self.assertEquals (len (self.results_deletes), 1)
         self.assertEquals (len (self.results_inserts), 1)
-        
+
+    def test_05_grouped_update_failure (self):
+        """
+        Updates sent together are committed together, one of them
+        failing must not leave its events in the signal
+        """
+        UPDATE = "INSERT { <test://signals-contact-group-%d> a nco:PersonContact; nco:fullname 'group %d' }"
+        FAILING = "INSERT { <test://signals-contact-group-failed> a nco:PersonContact; nco:fullname 'one', 'two' }"
+
+        self.pending_replies = 0
+        self.failed_replies = 0
+        self.grouped_inserts = []
+
+        self.cb_id = self.bus.signal_subscribe(
+            sender=cfg.TRACKER_BUSNAME,
+            interface_name=SIGNALS_IFACE,
+            member=GRAPH_UPDATED_SIGNAL,
+            object_path=SIGNALS_PATH,
+            arg0=CONTACT_CLASS_URI,
+            flags=Gio.DBusSignalFlags.NONE,
+            callback=self.__grouped_signal_received_cb)
+
+        for i in range (0, 5):
+            self.clean_up_list.append ("test://signals-contact-group-%d" % i)
+            update = FAILING if i == 2 else UPDATE % (i, i)
+            self.pending_replies += 1
+            self.tracker.update (update,
+                                 result_handler=self.__grouped_reply_cb,
+                                 error_handler=self.__grouped_error_cb)
+
+        # Wait for the replies and the signal of the last commit
+        GLib.timeout_add_seconds (REASONABLE_TIMEOUT, self.__grouped_timeout_cb)
+        self.loop.run ()
+        self.bus.signal_unsubscribe(self.cb_id)
+
+        self.assertEquals (self.pending_replies, 0)
+        self.assertEquals (self.failed_replies, 1)
+
+        ids = [self.tracker.get_resource_id_by_uri ("<test://signals-contact-group-%d>" % i)
+               for i in (0, 1, 3, 4)]
+        subjects = set ([s for g, s, p, o in self.grouped_inserts])
+        self.assertEquals (subjects, set (ids))
+
+    def __grouped_signal_received_cb (self, connection, sender_name, object_path, interface_name, signal_name, parameters):
+        classname, deletes, inserts = parameters.unpack()
+        self.grouped_inserts += inserts
+
+    def __grouped_reply_cb (self, obj, result, data):
+        self.pending_replies -= 1
+
+    def __grouped_error_cb (self, obj, error, data):
+        self.pending_replies -= 1
+        self.failed_replies += 1
+
+    def __grouped_timeout_cb (self):
+        self.loop.quit ()
+        return False
+
+    def __subscribe (self, fields, rows):
+        reply = self.bus.call_sync (cfg.TRACKER_BUSNAME, SIGNALS_PATH, SIGNALS_IFACE,
+                                    "SubscribeGraphUpdated",
+                                    GLib.Variant ("(asasasasb)", ([CONTACT_CLASS_URI], [], [], fields, rows)),
+                                    GLib.VariantType ("(uai)"),
+                                    Gio.DBusCallFlags.NONE, -1, None)
+        subscription_id, ids = reply.unpack ()
+        return subscription_id
+
+    def __unsubscribe (self, subscription_id):
+        self.bus.call_sync (cfg.TRACKER_BUSNAME, SIGNALS_PATH, SIGNALS_IFACE,
+                            "UnsubscribeGraphUpdated",
+                            GLib.Variant ("(u)", (subscription_id,)),
+                            None, Gio.DBusCallFlags.NONE, -1, None)
+
+    def __read_rows (self, fd):
+        """
+        Parses the Steroids.Query row format of GraphUpdatedRows
+        """
+        f = os.fdopen (fd, "rb")
+        f.seek (0)
+        data = f.read ()
+        f.close ()
+
+        rows = []
+        pos = 0
+        while pos < len (data):
+            n_columns, = struct.unpack_from ("=i", data, pos)
+            pos += 4
+            pos += 4 * n_columns # value types
+            offsets = struct.unpack_from ("=%di" % n_columns, data, pos)
+            pos += 4 * n_columns
+            strings = data[pos:pos + offsets[-1] + 1]
+            pos += offsets[-1] + 1
+            rows.append (strings.split ("\0")[:n_columns])
+
+        return rows
+
+    def __rows_filter_cb (self, connection, message, incoming, *user_data):
+        # Runs in the GDBus worker thread
+        if incoming and message.get_member () == GRAPH_UPDATED_ROWS_SIGNAL:
+            subscription_id, classname, deletes, inserts, handle = message.get_body ().unpack ()
+            if subscription_id == self.rows_subscription_id:
+                fd = message.get_unix_fd_list ().get (handle)
+                GLib.idle_add (self.__rows_received_cb, fd)
+        return message
+
+    def __rows_received_cb (self, fd):
+        for row in self.__read_rows (fd):
+            self.received_rows[row[1]] = row
+
+        if len (self.received_rows) >= self.expected_rows:
+            self.loop.quit ()
+        return False
+
+    def __wait_for_rows (self, n_rows):
+        self.expected_rows = n_rows
+        timeout_id = GLib.timeout_add_seconds (REASONABLE_TIMEOUT, self.__grouped_timeout_cb)
+        self.loop.run ()
+        GLib.source_remove (timeout_id)
+
+    def test_06_subscribe_invalid_fields (self):
+        """
+        Fields are part of the rows query, anything but a single
+        expression is refused at subscription time
+        """
+        for field in ["", "?u } INSERT { <test://signals-injected> a rdfs:Resource",
+                      "nco:fullname(?u", "nco:fullname(?u))", "?u ?u",
+                      "'literal'", "?u # comment"]:
+            self.assertRaises (GLib.Error, self.__subscribe, [field], True)
+
+    def test_07_rows_for_many_subjects (self):
+        """
+        Changes to more subjects than fit in one query still get
+        a row each, for existing and deleted resources alike
+        """
+        N_CONTACTS = 1200
+
+        self.received_rows = {}
+        self.rows_subscription_id = self.__subscribe (["nco:fullname(?u)"], True)
+        filter_id = self.bus.add_filter (self.__rows_filter_cb)
+
+        uris = ["test://signals-rows-%d" % i for i in range (0, N_CONTACTS)]
+        self.tracker.update ("INSERT { %s }" %
+                             " ".join (["<%s> a nco:PersonContact; nco:fullname 'rows %d' ." % (uri, i)
+                                        for i, uri in enumerate (uris)]))
+        self.__wait_for_rows (N_CONTACTS)
+
+        self.assertEquals (set (self.received_rows.keys ()), set (uris))
+        for i, uri in enumerate (uris):
+            self.assertEquals (self.received_rows[uri][2], "rows %d" % i)
+
+        self.received_rows = {}
+        self.tracker.update ("DELETE { %s }" %
+                             " ".join (["<%s> a rdfs:Resource ." % uri for uri in uris]))
+        self.__wait_for_rows (N_CONTACTS)
+
+        self.bus.remove_filter (filter_id)
+        self.__unsubscribe (self.rows_subscription_id)
+
+        # Deleted resources only have their ID and URN
+        self.assertEquals (set (self.received_rows.keys ()), set (uris))
+        for uri in uris:
+            self.assertEquals (self.received_rows[uri][2], "")
+
 
 if __name__ == "__main__":
     ut.main()
@@ -223,6 +223,203 @@ test_backup_and_restore (TestInfo      *info,
 	backup_calls = 0;
 }
 
+#ifndef DISABLE_JOURNAL
+static gint
+count_plain_indexes (const gchar *table)
+{
+	TrackerDBInterface *iface;
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+	gint n_indexes;
+
+	iface = tracker_db_manager_get_db_interface ();
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, &error,
+	                                              "SELECT COUNT(*) FROM sqlite_master "
+	                                              "WHERE type = 'index' AND tbl_name = ? "
+	                                              "AND sql IS NOT NULL "
+	                                              "AND sql NOT LIKE 'CREATE UNIQUE %%'");
+	g_assert_no_error (error);
+
+	tracker_db_statement_bind_text (stmt, 0, table);
+	cursor = tracker_db_statement_start_cursor (stmt, &error);
+	g_assert_no_error (error);
+	g_object_unref (stmt);
+
+	g_assert_true (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	n_indexes = (gint) tracker_db_cursor_get_int (cursor, 0);
+	g_object_unref (cursor);
+
+	return n_indexes;
+}
+
+static void
+replay_busy_cb (const gchar *status,
+                gdouble      progress,
+                gpointer     user_data)
+{
+	gint *n_calls = user_data;
+
+	/* Class table indexes are only recreated once the journal
+	 * has been applied.
+	 */
+	g_assert_cmpint (count_plain_indexes ("nfo:FileDataObject"), ==, 0);
+	(*n_calls)++;
+}
+
+/*
+ * Write a resource with indexed properties to the journal
+ * Remove the DB, so the journal is replayed
+ * Check the indexes are dropped while replaying and back afterwards
+ */
+static void
+test_journal_replay_indexes (TestInfo      *info,
+                             gconstpointer  context)
+{
+	TrackerDBCursor *cursor;
+	gchar *db_location, *meta_db;
+	GError *error = NULL;
+	gint n_indexes, n_calls = 0;
+
+	db_location = g_build_path (G_DIR_SEPARATOR_S, xdg_location, "tracker", NULL);
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+
+	tracker_data_manager_init (TRACKER_DB_MANAGER_FORCE_REINDEX,
+	                           NULL, NULL, FALSE, FALSE,
+	                           100, 100, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	n_indexes = count_plain_indexes ("nfo:FileDataObject");
+	g_assert_cmpint (n_indexes, >, 0);
+
+	tracker_data_update_sparql ("INSERT { <urn:replay:1> a nfo:FileDataObject ; "
+	                            "nfo:fileName \"replay.txt\" ; "
+	                            "nfo:fileLastModified \"2016-01-01T00:00:00Z\" }",
+	                            &error);
+	g_assert_no_error (error);
+
+	tracker_data_manager_shutdown ();
+
+	meta_db = g_build_path (G_DIR_SEPARATOR_S, db_location, "meta.db", NULL);
+	g_unlink (meta_db);
+	g_free (meta_db);
+
+	meta_db = g_build_path (G_DIR_SEPARATOR_S, db_location, "data", ".meta.isrunning", NULL);
+	g_unlink (meta_db);
+	g_free (meta_db);
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+
+	tracker_data_manager_init (0, NULL, NULL, TRUE, FALSE,
+	                           100, 100, replay_busy_cb, &n_calls, "replay", &error);
+	g_assert_no_error (error);
+
+	g_assert_cmpint (n_calls, >, 0);
+	g_assert_cmpint (count_plain_indexes ("nfo:FileDataObject"), ==, n_indexes);
+
+	cursor = tracker_data_query_sparql_cursor ("SELECT ?u WHERE { ?u nfo:fileName \"replay.txt\" }", &error);
+	g_assert_no_error (error);
+	g_assert_true (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	g_assert_cmpstr (tracker_db_cursor_get_string (cursor, 0, NULL), ==, "urn:replay:1");
+	g_object_unref (cursor);
+
+	tracker_data_manager_shutdown ();
+
+	g_free (db_location);
+}
+
+/*
+ * Leave the database as a replay killed halfway would, with an index
+ * dropped and remembered in ReplayDeferredIndex
+ * Check the index is back after the next start
+ */
+static void
+test_journal_replay_indexes_interrupted (TestInfo      *info,
+                                         gconstpointer  context)
+{
+	TrackerDBInterface *iface;
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+	gchar *name, *sql;
+	gint n_indexes;
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+
+	tracker_data_manager_init (TRACKER_DB_MANAGER_FORCE_REINDEX,
+	                           NULL, NULL, FALSE, FALSE,
+	                           100, 100, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	n_indexes = count_plain_indexes ("nfo:FileDataObject");
+	g_assert_cmpint (n_indexes, >, 0);
+
+	iface = tracker_db_manager_get_db_interface ();
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, &error,
+	                                              "SELECT name, sql FROM sqlite_master "
+	                                              "WHERE type = 'index' AND tbl_name = 'nfo:FileDataObject' "
+	                                              "AND sql IS NOT NULL "
+	                                              "AND sql NOT LIKE 'CREATE UNIQUE %%'");
+	g_assert_no_error (error);
+	cursor = tracker_db_statement_start_cursor (stmt, &error);
+	g_assert_no_error (error);
+	g_object_unref (stmt);
+
+	g_assert_true (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	name = g_strdup (tracker_db_cursor_get_string (cursor, 0, NULL));
+	sql = g_strdup (tracker_db_cursor_get_string (cursor, 1, NULL));
+	g_object_unref (cursor);
+
+	tracker_db_interface_execute_query (iface, &error,
+	                                    "CREATE TABLE ReplayDeferredIndex "
+	                                    "(Name TEXT PRIMARY KEY, Sql TEXT NOT NULL)");
+	g_assert_no_error (error);
+
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, &error,
+	                                              "INSERT INTO ReplayDeferredIndex (Name, Sql) VALUES (?, ?)");
+	g_assert_no_error (error);
+	tracker_db_statement_bind_text (stmt, 0, name);
+	tracker_db_statement_bind_text (stmt, 1, sql);
+	tracker_db_statement_execute (stmt, &error);
+	g_assert_no_error (error);
+	g_object_unref (stmt);
+
+	tracker_db_interface_execute_query (iface, &error, "DROP INDEX \"%s\"", name);
+	g_assert_no_error (error);
+	g_assert_cmpint (count_plain_indexes ("nfo:FileDataObject"), ==, n_indexes - 1);
+
+	tracker_data_manager_shutdown ();
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+
+	tracker_data_manager_init (0, NULL, NULL, FALSE, FALSE,
+	                           100, 100, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	g_assert_cmpint (count_plain_indexes ("nfo:FileDataObject"), ==, n_indexes);
+
+	iface = tracker_db_manager_get_db_interface ();
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, &error,
+	                                              "SELECT 1 FROM sqlite_master WHERE name = 'ReplayDeferredIndex'");
+	g_assert_no_error (error);
+	cursor = tracker_db_statement_start_cursor (stmt, &error);
+	g_assert_no_error (error);
+	g_object_unref (stmt);
+	g_assert_false (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+	g_object_unref (cursor);
+
+	tracker_data_manager_shutdown ();
+
+	g_free (name);
+	g_free (sql);
+}
+#endif /* DISABLE_JOURNAL */
+
 static void
 setup (TestInfo      *info,
        gconstpointer  context)
@@ -283,6 +480,10 @@ main (int argc, char **argv)
 
 	g_test_add ("/libtracker-data/backup/journal_then_save_and_restore", TestInfo, GINT_TO_POINTER(0), setup, test_backup_and_restore, teardown);
 	g_test_add ("/libtracker-data/backup/save_and_restore", TestInfo, GINT_TO_POINTER(1), setup, test_backup_and_restore, teardown);
+#ifndef DISABLE_JOURNAL
+	g_test_add ("/libtracker-data/backup/journal_replay_indexes", TestInfo, GINT_TO_POINTER(0), setup, test_journal_replay_indexes, teardown);
+	g_test_add ("/libtracker-data/backup/journal_replay_indexes_interrupted", TestInfo, GINT_TO_POINTER(0), setup, test_journal_replay_indexes_interrupted, teardown);
+#endif /* DISABLE_JOURNAL */
 
 	result = g_test_run ();
 
@@ -35,6 +35,44 @@ test_crc32_calculate ()
         g_assert_cmpint (expected, ==, result);
 }
 
+static guint32
+crc32_bitwise (const guint8 *data, gsize len)
+{
+        guint32 crc = 0xFFFFFFFF;
+        gsize i;
+        gint bit;
+
+        for (i = 0; i < len; i++) {
+                crc ^= data[i];
+                for (bit = 0; bit < 8; bit++)
+                        crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+
+        return crc ^ 0xFFFFFFFF;
+}
+
+static void
+test_crc32_unaligned ()
+{
+        guint8 data[4099];
+        gsize offset, len;
+
+        for (len = 0; len < sizeof (data); len++)
+                data[len] = (guint8) g_test_rand_int ();
+
+        /* Journal entries start at arbitrary offsets in the chunk */
+        for (offset = 0; offset < 8; offset++) {
+                for (len = 0; len < 64; len++) {
+                        g_assert_cmpuint (tracker_crc32 (data + offset, len), ==,
+                                          crc32_bitwise (data + offset, len));
+                }
+
+                len = sizeof (data) - offset;
+                g_assert_cmpuint (tracker_crc32 (data + offset, len), ==,
+                                  crc32_bitwise (data + offset, len));
+        }
+}
+
 gint
 main (gint argc, gchar **argv)
 {
@@ -42,6 +80,8 @@ main (gint argc, gchar **argv)
 
         g_test_add_func ("/libtracker-common/crc32/calculate",
                          test_crc32_calculate);
+        g_test_add_func ("/libtracker-common/crc32/unaligned",
+                         test_crc32_unaligned);
 
         return g_test_run ();
 }
@@ -355,6 +355,124 @@ test_read_functions (void)
 	g_free (path);
 }
 
+static void
+write_compressible_transaction (gint first_id)
+{
+	GError *error = NULL;
+	gboolean result;
+	gint i;
+
+	result = tracker_db_journal_start_transaction (time (NULL));
+	g_assert_cmpint (result, ==, TRUE);
+
+	for (i = 0; i < 20; i++) {
+		gchar *uri;
+
+		uri = g_strdup_printf ("file:///home/user/Documents/Projects/report-%d.odt", first_id + i);
+		result = tracker_db_journal_append_resource (first_id + i, uri);
+		g_assert_cmpint (result, ==, TRUE);
+		result = tracker_db_journal_append_insert_statement (0, first_id + i, 5, uri);
+		g_assert_cmpint (result, ==, TRUE);
+		g_free (uri);
+	}
+
+	result = tracker_db_journal_commit_db_transaction (&error);
+	g_assert_no_error (error);
+	g_assert_cmpint (result, ==, TRUE);
+}
+
+static void
+test_compressed_journal (void)
+{
+	GError *error = NULL;
+	gchar *path;
+	gboolean result;
+	gint transaction, i, id, s_id, p_id;
+	const gchar *uri, *str;
+
+	path = g_build_filename (TOP_BUILDDIR, "tests", "libtracker-db", "tracker-store-compressed.journal", NULL);
+	g_unlink (path);
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+	tracker_db_journal_set_compression (TRUE);
+
+	tracker_db_journal_init (path, FALSE, &error);
+	g_assert_no_error (error);
+	write_compressible_transaction (100);
+	write_compressible_transaction (200);
+	tracker_db_journal_shutdown (&error);
+	g_assert_no_error (error);
+
+	/* Appending starts over with an empty dictionary */
+	tracker_db_journal_init (path, FALSE, &error);
+	g_assert_no_error (error);
+	write_compressible_transaction (300);
+	write_compressible_transaction (400);
+
+	/* 4 transactions of 20 * 2 entries with ~50 byte strings */
+	g_assert_cmpint (tracker_db_journal_get_size (), <, 4 * 20 * 100);
+
+	tracker_db_journal_shutdown (&error);
+	g_assert_no_error (error);
+
+	tracker_db_journal_set_compression (FALSE);
+
+	result = tracker_db_journal_reader_init (path, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (result, ==, TRUE);
+
+	for (transaction = 1; transaction <= 4; transaction++) {
+		result = tracker_db_journal_reader_next (&error);
+		g_assert_no_error (error);
+		g_assert_cmpint (result, ==, TRUE);
+		g_assert_cmpint (tracker_db_journal_reader_get_type (), ==, TRACKER_DB_JOURNAL_START_TRANSACTION);
+
+		for (i = 0; i < 20; i++) {
+			gchar *expected;
+
+			expected = g_strdup_printf ("file:///home/user/Documents/Projects/report-%d.odt",
+			                            transaction * 100 + i);
+
+			result = tracker_db_journal_reader_next (&error);
+			g_assert_no_error (error);
+			g_assert_cmpint (result, ==, TRUE);
+			g_assert_cmpint (tracker_db_journal_reader_get_type (), ==, TRACKER_DB_JOURNAL_RESOURCE);
+			tracker_db_journal_reader_get_resource (&id, &uri);
+			g_assert_cmpint (id, ==, transaction * 100 + i);
+			g_assert_cmpstr (uri, ==, expected);
+
+			result = tracker_db_journal_reader_next (&error);
+			g_assert_no_error (error);
+			g_assert_cmpint (result, ==, TRUE);
+			g_assert_cmpint (tracker_db_journal_reader_get_type (), ==, TRACKER_DB_JOURNAL_INSERT_STATEMENT);
+			tracker_db_journal_reader_get_statement (NULL, &s_id, &p_id, &str);
+			g_assert_cmpint (s_id, ==, transaction * 100 + i);
+			g_assert_cmpint (p_id, ==, 5);
+			g_assert_cmpstr (str, ==, expected);
+
+			g_free (expected);
+		}
+
+		result = tracker_db_journal_reader_next (&error);
+		g_assert_no_error (error);
+		g_assert_cmpint (result, ==, TRUE);
+		g_assert_cmpint (tracker_db_journal_reader_get_type (), ==, TRACKER_DB_JOURNAL_END_TRANSACTION);
+	}
+
+	result = tracker_db_journal_reader_next (&error);
+	g_assert_no_error (error);
+	g_assert_cmpint (result, ==, FALSE);
+
+	tracker_db_journal_reader_shutdown ();
+
+	result = tracker_db_journal_reader_verify_last (path, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (result, ==, TRUE);
+
+	g_unlink (path);
+	g_free (path);
+}
+
 #endif /* DISABLE_JOURNAL */
 
 int
@@ -373,6 +491,8 @@ main (int argc, char **argv)
 	                 test_write_functions);
 	g_test_add_func ("/libtracker-db/tracker-db-journal/read-functions",
 	                 test_read_functions);
+	g_test_add_func ("/libtracker-db/tracker-db-journal/compressed",
+	                 test_compressed_journal);
 #endif /* DISABLE_JOURNAL */
 
 	result = g_test_run ();
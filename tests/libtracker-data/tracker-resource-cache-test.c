@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include <libtracker-data/tracker-resource-cache.h>
+
+static void
+test_resource_cache_lookup (void)
+{
+	tracker_resource_cache_set_size (10);
+
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:a"), ==, 0);
+
+	tracker_resource_cache_insert ("urn:test:a", 100);
+	tracker_resource_cache_insert ("urn:test:b", 101);
+
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:a"), ==, 100);
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:b"), ==, 101);
+
+	tracker_resource_cache_clear ();
+
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:a"), ==, 0);
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:b"), ==, 0);
+}
+
+static void
+test_resource_cache_eviction (void)
+{
+	gchar *uri;
+	gint i;
+
+	tracker_resource_cache_set_size (4);
+
+	for (i = 1; i <= 4; i++) {
+		uri = g_strdup_printf ("urn:test:%d", i);
+		tracker_resource_cache_insert (uri, i);
+		g_free (uri);
+	}
+
+	/* Referenced entries survive one sweep of the hand */
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:1"), ==, 1);
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:3"), ==, 3);
+
+	tracker_resource_cache_insert ("urn:test:5", 5);
+	tracker_resource_cache_insert ("urn:test:6", 6);
+
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:1"), ==, 1);
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:2"), ==, 0);
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:3"), ==, 3);
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:4"), ==, 0);
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:5"), ==, 5);
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:6"), ==, 6);
+}
+
+static void
+test_resource_cache_disabled (void)
+{
+	tracker_resource_cache_set_size (0);
+
+	tracker_resource_cache_insert ("urn:test:a", 100);
+	g_assert_cmpint (tracker_resource_cache_lookup ("urn:test:a"), ==, 0);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/libtracker-data/resource-cache/lookup",
+	                 test_resource_cache_lookup);
+	g_test_add_func ("/libtracker-data/resource-cache/eviction",
+	                 test_resource_cache_eviction);
+	g_test_add_func ("/libtracker-data/resource-cache/disabled",
+	                 test_resource_cache_disabled);
+
+	return g_test_run ();
+}
@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <locale.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include <libtracker-data/tracker-data-manager.h>
+#include <libtracker-data/tracker-db-journal.h>
+#include <libtracker-data/tracker-data-query.h>
+#include <libtracker-data/tracker-data-update.h>
+#include <libtracker-data/tracker-data.h>
+#include <libtracker-data/tracker-sparql-query.h>
+
+#include <tracker-test-helpers.h>
+
+static gchar *tests_data_dir = NULL;
+static gchar *xdg_location = NULL;
+
+typedef struct {
+	void *user_data;
+} TestInfo;
+
+static void
+test_batch (TestInfo      *info,
+            gconstpointer  context)
+{
+	GError *error = NULL;
+	GPtrArray *errors;
+	TrackerDBCursor *cursor;
+	gchar *updates[] = {
+		"INSERT { <urn:batch:1> a nie:InformationElement ; nie:title 'one' }",
+		"INSERT { <urn:batch:2> a nie:InformationElement ; nie:nonExistingProperty 'two' }",
+		"INSERT { <urn:batch:3> a nie:InformationElement ; nie:title 'three' }",
+		"INSERT { <urn:batch:4> a nie:InformationElement ; nie:title 'for' }",
+		"DELETE { ?u nie:title 'for' } INSERT { ?u nie:title 'four' } "
+		"WHERE { ?u nie:title 'for' }",
+	};
+	TrackerSparqlQuery *prepared[2];
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+
+	/* initialization */
+	tracker_data_manager_init (TRACKER_DB_MANAGER_FORCE_REINDEX,
+	                           NULL,
+	                           NULL,
+	                           FALSE,
+	                           FALSE,
+	                           100,
+	                           100,
+	                           NULL,
+	                           NULL,
+	                           NULL,
+	                           &error);
+
+	g_assert_no_error (error);
+
+	/* the failing update does not affect the others */
+	errors = tracker_data_update_sparql_batch (updates, 3, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (errors != NULL);
+	g_assert_cmpint (errors->len, ==, 3);
+
+	g_assert (g_ptr_array_index (errors, 0) == NULL);
+	g_assert (g_ptr_array_index (errors, 1) != NULL);
+	g_assert (g_ptr_array_index (errors, 2) == NULL);
+
+	g_ptr_array_unref (errors);
+
+	cursor = tracker_data_query_sparql_cursor ("SELECT ?u { ?u a nie:InformationElement . "
+	                                           "FILTER (fn:starts-with (str (?u), 'urn:batch:')) } "
+	                                           "ORDER BY ?u",
+	                                           &error);
+	g_assert_no_error (error);
+
+	g_assert (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_cmpstr (tracker_db_cursor_get_string (cursor, 0, NULL), ==, "urn:batch:1");
+	g_assert (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_cmpstr (tracker_db_cursor_get_string (cursor, 0, NULL), ==, "urn:batch:3");
+	g_assert (!tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	g_object_unref (cursor);
+
+	/* updates parsed ahead of the transaction */
+	prepared[0] = tracker_sparql_query_new_update (updates[3]);
+	g_assert (tracker_sparql_query_prepare_update (prepared[0], &error));
+	g_assert_no_error (error);
+
+	/* WHERE clauses are only resolved in the transaction */
+	prepared[1] = tracker_sparql_query_new_update (updates[4]);
+	g_assert (!tracker_sparql_query_prepare_update (prepared[1], &error));
+	g_assert_no_error (error);
+	g_clear_object (&prepared[1]);
+
+	errors = tracker_data_update_sparql_batch (&updates[3], 2, prepared, &error);
+	g_assert_no_error (error);
+	g_assert (g_ptr_array_index (errors, 0) == NULL);
+	g_assert (g_ptr_array_index (errors, 1) == NULL);
+	g_ptr_array_unref (errors);
+	g_object_unref (prepared[0]);
+
+	cursor = tracker_data_query_sparql_cursor ("SELECT ?t { <urn:batch:4> nie:title ?t }",
+	                                           &error);
+	g_assert_no_error (error);
+
+	g_assert (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_cmpstr (tracker_db_cursor_get_string (cursor, 0, NULL), ==, "four");
+	g_assert (!tracker_db_cursor_iter_next (cursor, NULL, &error));
+
+	g_object_unref (cursor);
+
+	tracker_data_manager_shutdown ();
+}
+
+typedef struct {
+	gint failed_subject_id;
+	gint deleted_subject_id;
+	guint n_rollbacks;
+} EventsInfo;
+
+static void
+add_statement_events (gboolean   insert,
+                      gint       graph_id,
+                      gint       subject_id,
+                      gint       predicate_id,
+                      gint       object_id,
+                      GPtrArray *rdf_types)
+{
+	guint i;
+
+	for (i = 0; i < rdf_types->len; i++) {
+		if (insert)
+			tracker_class_add_insert_event (rdf_types->pdata[i], graph_id,
+			                                subject_id, predicate_id, object_id);
+		else
+			tracker_class_add_delete_event (rdf_types->pdata[i], graph_id,
+			                                subject_id, predicate_id, object_id);
+	}
+}
+
+/* Queues events on the classes the way tracker-store does */
+static void
+statement_inserted_cb (gint         graph_id,
+                       const gchar *graph,
+                       gint         subject_id,
+                       const gchar *subject,
+                       gint         predicate_id,
+                       gint         object_id,
+                       const gchar *object,
+                       GPtrArray   *rdf_types,
+                       gpointer     user_data)
+{
+	EventsInfo *events_info = user_data;
+
+	if (g_strcmp0 (subject, "urn:batch:5") == 0)
+		events_info->failed_subject_id = subject_id;
+
+	add_statement_events (TRUE, graph_id, subject_id,
+	                      predicate_id, object_id, rdf_types);
+}
+
+static void
+statement_deleted_cb (gint         graph_id,
+                      const gchar *graph,
+                      gint         subject_id,
+                      const gchar *subject,
+                      gint         predicate_id,
+                      gint         object_id,
+                      const gchar *object,
+                      GPtrArray   *rdf_types,
+                      gpointer     user_data)
+{
+	EventsInfo *events_info = user_data;
+
+	if (g_strcmp0 (subject, "urn:batch:1") == 0)
+		events_info->deleted_subject_id = subject_id;
+
+	add_statement_events (FALSE, graph_id, subject_id,
+	                      predicate_id, object_id, rdf_types);
+}
+
+static void
+savepoint_cb (TrackerDataSavepointAction action,
+              gpointer                   user_data)
+{
+	EventsInfo *events_info = user_data;
+	TrackerClass **classes;
+	guint i, n_classes;
+
+	classes = tracker_ontologies_get_classes (&n_classes);
+
+	for (i = 0; i < n_classes; i++) {
+		if (action == TRACKER_DATA_SAVEPOINT_BEGIN)
+			tracker_class_savepoint_events (classes[i]);
+		else if (action == TRACKER_DATA_SAVEPOINT_ROLLBACK)
+			tracker_class_rollback_events (classes[i]);
+	}
+
+	if (action == TRACKER_DATA_SAVEPOINT_ROLLBACK)
+		events_info->n_rollbacks++;
+}
+
+static void
+check_event (gint     graph_id,
+             gint     subject_id,
+             gint     pred_id,
+             gint     object_id,
+             gpointer user_data)
+{
+	gint *forbidden_subject_id = user_data;
+
+	g_assert_cmpint (subject_id, !=, *forbidden_subject_id);
+}
+
+static void
+count_event (gint     graph_id,
+             gint     subject_id,
+             gint     pred_id,
+             gint     object_id,
+             gpointer user_data)
+{
+	guint *n_events = user_data;
+
+	(*n_events)++;
+}
+
+static void
+test_batch_rollback_events (TestInfo      *info,
+                            gconstpointer  context)
+{
+	GError *error = NULL;
+	GPtrArray *errors;
+	EventsInfo events_info = { 0, };
+	TrackerClass **classes;
+	guint i, n_classes, n_inserts = 0;
+	gchar *journal_filename;
+	gchar *updates[] = {
+		"INSERT { <urn:batch:1> a nie:InformationElement ; nie:title 'one' }",
+		/* fails on the second title, after the other
+		 * statements were buffered and journaled */
+		"DELETE { <urn:batch:1> nie:title 'one' } "
+		"INSERT { <urn:batch:5> a nie:InformationElement ; nie:title 'five' . "
+		"         <urn:batch:1> nie:title 'uno' , 'eins' }",
+		"INSERT { <urn:batch:3> a nie:InformationElement ; nie:title 'three' }",
+	};
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+
+	tracker_data_manager_init (TRACKER_DB_MANAGER_FORCE_REINDEX,
+	                           NULL,
+	                           NULL,
+	                           FALSE,
+	                           FALSE,
+	                           100,
+	                           100,
+	                           NULL,
+	                           NULL,
+	                           NULL,
+	                           &error);
+
+	g_assert_no_error (error);
+
+	tracker_data_add_insert_statement_callback (statement_inserted_cb, &events_info);
+	tracker_data_add_delete_statement_callback (statement_deleted_cb, &events_info);
+	tracker_data_add_savepoint_callback (savepoint_cb, &events_info);
+
+	errors = tracker_data_update_sparql_batch (updates, G_N_ELEMENTS (updates), NULL, &error);
+	g_assert_no_error (error);
+	g_assert (g_ptr_array_index (errors, 0) == NULL);
+	g_assert_error (g_ptr_array_index (errors, 1), TRACKER_SPARQL_ERROR, TRACKER_SPARQL_ERROR_CONSTRAINT);
+	g_assert (g_ptr_array_index (errors, 2) == NULL);
+	g_ptr_array_unref (errors);
+
+	tracker_data_remove_insert_statement_callback (statement_inserted_cb, &events_info);
+	tracker_data_remove_delete_statement_callback (statement_deleted_cb, &events_info);
+	tracker_data_remove_savepoint_callback (savepoint_cb, &events_info);
+
+	/* the failed update queued events before failing */
+	g_assert_cmpint (events_info.failed_subject_id, !=, 0);
+	g_assert_cmpint (events_info.deleted_subject_id, !=, 0);
+	g_assert_cmpuint (events_info.n_rollbacks, ==, 1);
+
+	classes = tracker_ontologies_get_classes (&n_classes);
+
+	for (i = 0; i < n_classes; i++) {
+		tracker_class_transact_events (classes[i]);
+
+		tracker_class_foreach_insert_event (classes[i], check_event,
+		                                    &events_info.failed_subject_id);
+		tracker_class_foreach_insert_event (classes[i], count_event,
+		                                    &n_inserts);
+		tracker_class_foreach_delete_event (classes[i], check_event,
+		                                    &events_info.deleted_subject_id);
+		tracker_class_reset_ready_events (classes[i]);
+	}
+
+	/* those of the other updates are kept */
+	g_assert_cmpuint (n_inserts, >, 0);
+
+	journal_filename = g_strdup (tracker_db_journal_get_filename ());
+
+	tracker_data_manager_shutdown ();
+
+#ifndef DISABLE_JOURNAL
+	tracker_db_journal_reader_init (journal_filename, &error);
+	g_assert_no_error (error);
+
+	while (tracker_db_journal_reader_next (&error)) {
+		TrackerDBJournalEntryType type;
+		const gchar *str;
+		gint id, p_id;
+
+		type = tracker_db_journal_reader_get_type ();
+
+		if (type == TRACKER_DB_JOURNAL_RESOURCE) {
+			tracker_db_journal_reader_get_resource (&id, &str);
+			g_assert_cmpstr (str, !=, "urn:batch:5");
+		} else if (type == TRACKER_DB_JOURNAL_INSERT_STATEMENT ||
+		           type == TRACKER_DB_JOURNAL_DELETE_STATEMENT) {
+			tracker_db_journal_reader_get_statement (NULL, &id, &p_id, &str);
+			g_assert_cmpstr (str, !=, "five");
+			g_assert_cmpstr (str, !=, "uno");
+			g_assert (type != TRACKER_DB_JOURNAL_DELETE_STATEMENT ||
+			          id != events_info.deleted_subject_id);
+		}
+	}
+
+	g_assert_no_error (error);
+	tracker_db_journal_reader_shutdown ();
+#endif /* DISABLE_JOURNAL */
+
+	g_free (journal_filename);
+}
+
+static void
+setup (TestInfo      *info,
+       gconstpointer  context)
+{
+	/* Sadly, we can't use ONE location per test because GLib
+	 * caches XDG env vars, so g_get_*dir() will not change if we
+	 * update the environment, this sucks majorly.
+	 */
+	if (!xdg_location) {
+		xdg_location = tracker_test_helpers_set_up_data_dirs (tests_data_dir);
+	}
+}
+
+static void
+teardown (TestInfo      *info,
+          gconstpointer  context)
+{
+	tracker_test_helpers_clean_up_data_dirs (xdg_location);
+
+	g_free (xdg_location);
+	xdg_location = NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+	gchar *current_dir;
+	gint result;
+
+	setlocale (LC_COLLATE, "en_US.utf8");
+
+	current_dir = g_get_current_dir ();
+	tests_data_dir = g_build_path (G_DIR_SEPARATOR_S, current_dir, "test-data", NULL);
+	g_free (current_dir);
+
+	g_test_init (&argc, &argv, NULL);
+	g_test_add ("/libtracker-data/sparql-batch", TestInfo, GINT_TO_POINTER(0), setup, test_batch, teardown);
+	g_test_add ("/libtracker-data/sparql-batch/rollback-events", TestInfo, GINT_TO_POINTER(0), setup, test_batch_rollback_events, teardown);
+
+	/* run tests */
+	result = g_test_run ();
+
+	g_remove (tests_data_dir);
+	g_free (tests_data_dir);
+
+	return result;
+}
@@ -314,6 +314,14 @@ test_sparql_query (TestInfo      *test_info,
 
 	check_result (cursor, test_info, results_filename, error);
 
+	if (!test_info->expect_query_error) {
+		/* run it again, this time the SQL comes from the translation cache */
+		g_object_unref (cursor);
+		cursor = tracker_data_query_sparql_cursor (query, &error);
+
+		check_result (cursor, test_info, results_filename, error);
+	}
+
 	g_free (query_filename);
 	g_free (query);
 
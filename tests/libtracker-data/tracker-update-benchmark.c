@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <locale.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include <libtracker-data/tracker-data-manager.h>
+#include <libtracker-data/tracker-data-query.h>
+#include <libtracker-data/tracker-data-update.h>
+#include <libtracker-data/tracker-data.h>
+#include <libtracker-data/tracker-sparql-query.h>
+
+#include <tracker-test-helpers.h>
+
+static gchar *tests_data_dir = NULL;
+static gchar *xdg_location = NULL;
+
+typedef struct {
+	void *user_data;
+} TestInfo;
+
+/* Resources per update, flushing the update buffer every
+ * 1000 resources is part of what gets measured.
+ */
+#define BATCH_SIZE 500
+
+static void
+insert_resources (gint offset,
+                  gint n_resources)
+{
+	GError *error = NULL;
+	GString *sparql;
+	gint i, j;
+
+	for (i = 0; i < n_resources; i += BATCH_SIZE) {
+		sparql = g_string_new ("INSERT {");
+
+		for (j = i; j < MIN (i + BATCH_SIZE, n_resources); j++) {
+			g_string_append_printf (sparql,
+			                        " <urn:benchmark:%d> a nfo:Document ;"
+			                        " nie:title 'Document %d' ;"
+			                        " nie:keyword 'first', 'second %d' ;"
+			                        " nie:contentCreated '2016-01-01T%02d:%02d:00Z' .",
+			                        offset + j, offset + j, offset + j,
+			                        j % 24, j % 60);
+		}
+
+		g_string_append (sparql, " }");
+
+		tracker_data_update_sparql (sparql->str, &error);
+		g_assert_no_error (error);
+
+		g_string_free (sparql, TRUE);
+	}
+}
+
+static void
+test_update_benchmark (TestInfo      *info,
+                       gconstpointer  context)
+{
+	GError *error = NULL;
+	TrackerDBCursor *cursor;
+	gint n_resources;
+	gdouble elapsed;
+
+	n_resources = g_test_perf () ? 50000 : 2000;
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+
+	/* initialization */
+	tracker_data_manager_init (TRACKER_DB_MANAGER_FORCE_REINDEX,
+	                           NULL,
+	                           NULL,
+	                           FALSE,
+	                           FALSE,
+	                           100,
+	                           100,
+	                           NULL,
+	                           NULL,
+	                           NULL,
+	                           &error);
+
+	g_assert_no_error (error);
+
+	/* warm up statement caches */
+	insert_resources (-BATCH_SIZE, BATCH_SIZE);
+
+	g_test_timer_start ();
+	insert_resources (0, n_resources);
+	elapsed = g_test_timer_elapsed ();
+
+	g_test_maximized_result (n_resources / elapsed, "%.0f inserts/s (%d resources in %.3fs)",
+	                         n_resources / elapsed, n_resources, elapsed);
+
+	/* everything made it through the buffer */
+	cursor = tracker_data_query_sparql_cursor ("SELECT COUNT(?u) { ?u a nfo:Document ; "
+	                                           "nie:keyword 'first' }",
+	                                           &error);
+	g_assert_no_error (error);
+
+	g_assert (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_cmpint (tracker_db_cursor_get_int (cursor, 0), ==, n_resources + BATCH_SIZE);
+	g_object_unref (cursor);
+
+	cursor = tracker_data_query_sparql_cursor ("SELECT ?t ?d { <urn:benchmark:1234> nie:title ?t ; "
+	                                           "nie:contentCreated ?d }",
+	                                           &error);
+	g_assert_no_error (error);
+
+	g_assert (tracker_db_cursor_iter_next (cursor, NULL, &error));
+	g_assert_cmpstr (tracker_db_cursor_get_string (cursor, 0, NULL), ==, "Document 1234");
+	g_assert (tracker_db_cursor_get_string (cursor, 1, NULL) != NULL);
+	g_object_unref (cursor);
+
+	tracker_data_manager_shutdown ();
+}
+
+static void
+setup (TestInfo      *info,
+       gconstpointer  context)
+{
+	/* Sadly, we can't use ONE location per test because GLib
+	 * caches XDG env vars, so g_get_*dir() will not change if we
+	 * update the environment, this sucks majorly.
+	 */
+	if (!xdg_location) {
+		xdg_location = tracker_test_helpers_set_up_data_dirs (tests_data_dir);
+	}
+}
+
+static void
+teardown (TestInfo      *info,
+          gconstpointer  context)
+{
+	tracker_test_helpers_clean_up_data_dirs (xdg_location);
+
+	g_free (xdg_location);
+	xdg_location = NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+	gchar *current_dir;
+	gint result;
+
+	setlocale (LC_COLLATE, "en_US.utf8");
+
+	current_dir = g_get_current_dir ();
+	tests_data_dir = g_build_path (G_DIR_SEPARATOR_S, current_dir, "test-data", NULL);
+	g_free (current_dir);
+
+	g_test_init (&argc, &argv, NULL);
+	g_test_add ("/libtracker-data/update-benchmark", TestInfo, GINT_TO_POINTER(0), setup, test_update_benchmark, teardown);
+
+	/* run tests */
+	result = g_test_run ();
+
+	g_remove (tests_data_dir);
+	g_free (tests_data_dir);
+
+	return result;
+}
@@ -168,6 +168,245 @@ test_sparql_query (gconstpointer test_data)
 	tracker_data_manager_shutdown ();
 }
 
+static void
+init_fts_test_data (TrackerDBManagerFlags flags)
+{
+	const gchar *test_schemas[2] = { NULL, NULL };
+	GError *error = NULL;
+	gchar *data_prefix;
+
+	data_prefix = g_build_filename (TOP_SRCDIR, "tests", "libtracker-fts", "data", NULL);
+	test_schemas[0] = data_prefix;
+
+	tracker_db_journal_set_rotating (FALSE, G_MAXSIZE, NULL);
+	tracker_data_manager_init (flags, test_schemas,
+	                           NULL, FALSE, FALSE,
+	                           100, 100, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	g_free (data_prefix);
+}
+
+static gchar *
+query_fts_matches (const gchar *text)
+{
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+	GString *matches;
+	gchar *query;
+
+	query = g_strdup_printf ("SELECT ?u WHERE { ?u fts:match '%s' } ORDER BY ?u", text);
+	cursor = tracker_data_query_sparql_cursor (query, &error);
+	g_assert_no_error (error);
+	g_free (query);
+
+	matches = g_string_new (NULL);
+
+	while (tracker_db_cursor_iter_next (cursor, NULL, &error)) {
+		const gchar *uri;
+
+		uri = tracker_db_cursor_get_string (cursor, 0, NULL);
+		g_assert (g_str_has_prefix (uri, "http://www.example.org/test#"));
+
+		if (matches->len > 0)
+			g_string_append_c (matches, ' ');
+
+		g_string_append (matches, uri + strlen ("http://www.example.org/test#"));
+	}
+
+	g_assert_no_error (error);
+	g_object_unref (cursor);
+
+	return g_string_free (matches, FALSE);
+}
+
+#define assert_fts_matches(text, expected) G_STMT_START {	\
+	gchar *__matches = query_fts_matches (text);		\
+	g_assert_cmpstr (__matches, ==, expected);		\
+	g_free (__matches);					\
+} G_STMT_END
+
+static void
+update (const gchar *sparql)
+{
+	GError *error = NULL;
+
+	tracker_data_update_sparql (sparql, &error);
+	g_assert_no_error (error);
+}
+
+static gboolean
+has_table (const gchar *name)
+{
+	TrackerDBInterface *iface;
+	TrackerDBStatement *stmt;
+	TrackerDBCursor *cursor;
+	GError *error = NULL;
+	gboolean found;
+
+	iface = tracker_db_manager_get_db_interface ();
+	stmt = tracker_db_interface_create_statement (iface, TRACKER_DB_STATEMENT_CACHE_TYPE_NONE, &error,
+	                                              "SELECT 1 FROM sqlite_master WHERE name = ?");
+	g_assert_no_error (error);
+
+	tracker_db_statement_bind_text (stmt, 0, name);
+	cursor = tracker_db_statement_start_cursor (stmt, &error);
+	g_assert_no_error (error);
+	g_object_unref (stmt);
+
+	found = tracker_db_cursor_iter_next (cursor, NULL, &error);
+	g_assert_no_error (error);
+	g_object_unref (cursor);
+
+	return found;
+}
+
+static void
+test_fts_reindex (void)
+{
+	TrackerDBInterface *iface;
+	GError *error = NULL;
+	gchar *sha1_filename;
+	gint id;
+
+	init_fts_test_data (TRACKER_DB_MANAGER_FORCE_REINDEX);
+	update ("INSERT { test:r1 a test:A ; test:p 'one' . "
+	        "         test:r2 a test:A ; test:p 'two' . "
+	        "         test:r3 a test:A ; test:p 'one two' }");
+	tracker_data_manager_shutdown ();
+
+	/* pretend the tokenizer changed since the tokens were made */
+	sha1_filename = g_build_filename (g_get_user_cache_dir (), "tracker",
+	                                  "parser-sha1.txt", NULL);
+	g_file_set_contents (sha1_filename, "0", -1, &error);
+	g_assert_no_error (error);
+
+	/* start, queries keep using the current tokens */
+	init_fts_test_data (TRACKER_DB_MANAGER_FTS_REINDEX_IN_BACKGROUND);
+	g_assert (tracker_data_manager_fts_reindex_pending ());
+	g_assert (has_table ("fts5_reindex"));
+	assert_fts_matches ("one", "r1 r3");
+	tracker_data_manager_shutdown ();
+
+	/* the stamp only changes once, the progress is in the database */
+	g_assert (!tracker_db_manager_get_tokenizer_changed ());
+
+	/* resume */
+	init_fts_test_data (TRACKER_DB_MANAGER_FTS_REINDEX_IN_BACKGROUND);
+	g_assert (tracker_data_manager_fts_reindex_pending ());
+
+	/* the old tokens of changed resources are left out */
+	update ("DELETE { test:r1 test:p ?p } INSERT { test:r1 test:p 'uno' } "
+	        "WHERE { test:r1 test:p ?p }");
+	assert_fts_matches ("one", "r3");
+	assert_fts_matches ("uno", "");
+
+	/* step up to r2, not done yet */
+	iface = tracker_db_manager_get_db_interface ();
+	id = tracker_data_query_resource_id ("http://www.example.org/test#r2");
+	g_assert (!tracker_db_interface_sqlite_fts_reindex_step (iface, id, &error));
+	g_assert_no_error (error);
+	g_assert (tracker_data_manager_fts_reindex_pending ());
+
+	/* r2 is in both tables now */
+	update ("DELETE { test:r2 test:p ?p } INSERT { test:r2 test:p 'dos' } "
+	        "WHERE { test:r2 test:p ?p }");
+	assert_fts_matches ("two", "r3");
+
+	/* switch */
+	while (tracker_data_manager_fts_reindex_step (&error))
+		g_assert_no_error (error);
+	g_assert_no_error (error);
+
+	g_assert (!tracker_data_manager_fts_reindex_pending ());
+	g_assert (!has_table ("fts5_reindex"));
+	g_assert (!has_table ("FtsReindex"));
+	g_assert (!has_table ("FtsReindexStale"));
+
+	assert_fts_matches ("one", "r3");
+	assert_fts_matches ("uno", "r1");
+	assert_fts_matches ("two", "r3");
+	assert_fts_matches ("dos", "r2");
+
+	/* deletes during the reindex left the new tokens intact */
+	tracker_db_interface_execute_query (iface, &error,
+	                                    "INSERT INTO fts5(fts5) VALUES('integrity-check')");
+	g_assert_no_error (error);
+
+	g_free (sha1_filename);
+	tracker_data_manager_shutdown ();
+}
+
+/* Same as the FTS properties the data manager gives to the reindex */
+static GHashTable *
+get_fts_properties (void)
+{
+	TrackerProperty **properties;
+	GHashTable *fts_properties;
+	guint i, len;
+
+	fts_properties = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                        NULL, (GDestroyNotify) g_list_free);
+	properties = tracker_ontologies_get_properties (&len);
+
+	for (i = 0; i < len; i++) {
+		const gchar *table_name;
+		GList *list;
+
+		if (!tracker_property_get_fulltext_indexed (properties[i]))
+			continue;
+
+		table_name = tracker_property_get_table_name (properties[i]);
+		list = g_hash_table_lookup (fts_properties, table_name);
+		list = g_list_append (list, (gpointer) tracker_property_get_name (properties[i]));
+		g_hash_table_insert (fts_properties, (gpointer) table_name, list);
+	}
+
+	return fts_properties;
+}
+
+static void
+test_fts_reindex_cached_query (void)
+{
+	TrackerDBInterface *iface;
+	GHashTable *fts_properties;
+	GError *error = NULL;
+
+	init_fts_test_data (TRACKER_DB_MANAGER_FORCE_REINDEX);
+	update ("INSERT { test:r1 a test:A ; test:p 'one' . "
+	        "         test:r2 a test:A ; test:p 'two' . "
+	        "         test:r3 a test:A ; test:p 'one two' }");
+
+	/* before, the query ends up in the translation and statement caches */
+	assert_fts_matches ("one", "r1 r3");
+	assert_fts_matches ("one", "r1 r3");
+
+	iface = tracker_db_manager_get_db_interface ();
+	fts_properties = get_fts_properties ();
+	tracker_db_interface_sqlite_fts_reindex_start (iface, fts_properties, &error);
+	g_assert_no_error (error);
+	g_hash_table_unref (fts_properties);
+	g_assert (tracker_data_manager_fts_reindex_pending ());
+
+	/* during, the old tokens of r1 are left out of the same query */
+	update ("DELETE { test:r1 test:p ?p } INSERT { test:r1 test:p 'uno' } "
+	        "WHERE { test:r1 test:p ?p }");
+	assert_fts_matches ("one", "r3");
+	assert_fts_matches ("one", "r3");
+
+	/* after, FtsReindexStale is gone and the query still works */
+	while (tracker_data_manager_fts_reindex_step (&error))
+		g_assert_no_error (error);
+	g_assert_no_error (error);
+	g_assert (!has_table ("FtsReindexStale"));
+
+	assert_fts_matches ("one", "r3");
+	assert_fts_matches ("one", "r3");
+	assert_fts_matches ("uno", "r1");
+
+	tracker_data_manager_shutdown ();
+}
+
 int
 main (int argc, char **argv)
 {
@@ -196,6 +435,9 @@ main (int argc, char **argv)
 		g_free (testpath);
 	}
 
+	g_test_add_func ("/libtracker-fts/reindex", test_fts_reindex);
+	g_test_add_func ("/libtracker-fts/reindex-cached-query", test_fts_reindex_cached_query);
+
 	/* run tests */
 	result = g_test_run ();
 
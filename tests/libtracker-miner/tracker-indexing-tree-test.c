@@ -943,6 +943,127 @@ test_indexing_tree_030 (TestCommonContext *fixture,
 	ASSERT_INDEXABLE (fixture, TEST_DIRECTORY_ABA);
 }
 
+static void
+test_indexing_tree_filters (void)
+{
+	TrackerIndexingTree *tree;
+	const gchar *matching[] = {
+		"/home/user/core", "/home/user/foo.o", "/home/user/.o",
+		"/home/user/foobar", "/home/user/foo", "/home/user/abc",
+		"/A/B", "/A/B/C/file", NULL
+	};
+	const gchar *non_matching[] = {
+		"/home/user/cores", "/home/user/bar.oo", "/home/user/barfoo",
+		"/home/user/abbc", "/A/BB", "/home/user/B", NULL
+	};
+	gint i;
+
+	tree = tracker_indexing_tree_new ();
+
+	tracker_indexing_tree_add_filter (tree, TRACKER_FILTER_FILE, "core");
+	tracker_indexing_tree_add_filter (tree, TRACKER_FILTER_FILE, "*.o");
+	tracker_indexing_tree_add_filter (tree, TRACKER_FILTER_FILE, "foo*");
+	tracker_indexing_tree_add_filter (tree, TRACKER_FILTER_FILE, "a?c");
+	tracker_indexing_tree_add_filter (tree, TRACKER_FILTER_FILE, "/A/B");
+
+	for (i = 0; matching[i]; i++) {
+		GFile *file = g_file_new_for_path (matching[i]);
+
+		g_assert (tracker_indexing_tree_file_matches_filter (tree, TRACKER_FILTER_FILE, file));
+		g_assert (!tracker_indexing_tree_file_matches_filter (tree, TRACKER_FILTER_DIRECTORY, file));
+		g_object_unref (file);
+	}
+
+	for (i = 0; non_matching[i]; i++) {
+		GFile *file = g_file_new_for_path (non_matching[i]);
+
+		g_assert (!tracker_indexing_tree_file_matches_filter (tree, TRACKER_FILTER_FILE, file));
+		g_object_unref (file);
+	}
+
+	/* Filters added after a check are taken into account */
+	tracker_indexing_tree_add_filter (tree, TRACKER_FILTER_FILE, "*s");
+	{
+		GFile *file = g_file_new_for_path ("/home/user/cores");
+
+		g_assert (tracker_indexing_tree_file_matches_filter (tree, TRACKER_FILTER_FILE, file));
+		tracker_indexing_tree_clear_filters (tree, TRACKER_FILTER_FILE);
+		g_assert (!tracker_indexing_tree_file_matches_filter (tree, TRACKER_FILTER_FILE, file));
+		g_object_unref (file);
+	}
+
+	g_object_unref (tree);
+}
+
+#define PERF_N_FILTERS 500
+#define PERF_N_FILES 100000
+
+static void
+test_indexing_tree_filters_performance (void)
+{
+	TrackerIndexingTree *tree;
+	GPtrArray *files;
+	gdouble elapsed;
+	guint i, n_matches = 0;
+
+	if (!g_test_perf ()) {
+		return;
+	}
+
+	tree = tracker_indexing_tree_new ();
+	files = g_ptr_array_new_with_free_func (g_object_unref);
+
+	/* A mix of the glob shapes found in configurations */
+	for (i = 0; i < PERF_N_FILTERS; i++) {
+		gchar *glob;
+
+		switch (i % 4) {
+		case 0:
+			glob = g_strdup_printf ("*.ext%d", i);
+			break;
+		case 1:
+			glob = g_strdup_printf ("prefix%d*", i);
+			break;
+		case 2:
+			glob = g_strdup_printf ("name%d", i);
+			break;
+		default:
+			glob = g_strdup_printf ("a%d*b", i);
+			break;
+		}
+
+		tracker_indexing_tree_add_filter (tree, TRACKER_FILTER_FILE, glob);
+		g_free (glob);
+	}
+
+	for (i = 0; i < PERF_N_FILES; i++) {
+		gchar *path;
+
+		path = g_strdup_printf ("/home/user/dir%d/file%d.ext%d",
+		                        i % 100, i, i % (2 * PERF_N_FILTERS));
+		g_ptr_array_add (files, g_file_new_for_path (path));
+		g_free (path);
+	}
+
+	g_test_timer_start ();
+
+	for (i = 0; i < files->len; i++) {
+		if (tracker_indexing_tree_file_matches_filter (tree, TRACKER_FILTER_FILE,
+		                                               g_ptr_array_index (files, i))) {
+			n_matches++;
+		}
+	}
+
+	elapsed = g_test_timer_elapsed ();
+
+	g_assert_cmpuint (n_matches, >, 0);
+	g_test_minimized_result (elapsed, "%d files against %d filters: %.3fs",
+	                         PERF_N_FILES, PERF_N_FILTERS, elapsed);
+
+	g_ptr_array_unref (files);
+	g_object_unref (tree);
+}
+
 gint
 main (gint    argc,
       gchar **argv)
@@ -982,5 +1103,10 @@ main (gint    argc,
 	test_add ("/libtracker-miner/indexing-tree/029", test_indexing_tree_029);
 	test_add ("/libtracker-miner/indexing-tree/030", test_indexing_tree_030);
 
+	g_test_add_func ("/libtracker-miner/indexing-tree/filters",
+	                 test_indexing_tree_filters);
+	g_test_add_func ("/libtracker-miner/indexing-tree/filters-performance",
+	                 test_indexing_tree_filters_performance);
+
 	return g_test_run ();
 }
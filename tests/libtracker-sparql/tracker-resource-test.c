@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include <locale.h>
+#include <string.h>
 
 #include <libtracker-sparql/tracker-resource.h>
 
@@ -145,6 +146,84 @@ test_resource_get_set_pointer_validation (void)
 	g_test_trap_assert_stderr ("*tracker_resource_set_string: NULL is not a valid value.*");
 }
 
+static void
+test_resource_serialize (void)
+{
+	TrackerResource *resource, *album, *copy;
+	GVariant *variant;
+	gchar *sparql, *copy_sparql;
+
+	resource = tracker_resource_new ("http://example.com/resource");
+	album = tracker_resource_new (NULL);
+
+	tracker_resource_set_uri (resource, "rdf:type", "nmm:MusicPiece");
+	tracker_resource_set_string (resource, "nie:title", "Hello");
+	tracker_resource_set_int64 (resource, "nfo:duration", 123456789);
+	tracker_resource_set_double (resource, "nfo:averageBitrate", 0.6);
+	tracker_resource_add_string (resource, "nie:keyword", "a");
+	tracker_resource_add_string (resource, "nie:keyword", "b");
+	tracker_resource_set_string (album, "nmm:albumTitle", "Album");
+	tracker_resource_set_relation (resource, "nmm:musicAlbum", album);
+
+	variant = g_variant_ref_sink (tracker_resource_serialize (resource));
+	g_assert (variant != NULL);
+
+	copy = tracker_resource_deserialize (variant);
+	g_assert (copy != NULL);
+
+	g_assert_cmpstr (tracker_resource_get_identifier (copy), ==, "http://example.com/resource");
+	g_assert_cmpstr (tracker_resource_get_first_uri (copy, "rdf:type"), ==, "nmm:MusicPiece");
+	g_assert_cmpstr (tracker_resource_get_first_string (copy, "nie:title"), ==, "Hello");
+	g_assert (tracker_resource_get_first_int64 (copy, "nfo:duration") == 123456789);
+	g_assert (tracker_resource_get_first_double (copy, "nfo:averageBitrate") == 0.6);
+	g_assert_cmpint (g_list_length (tracker_resource_get_values (copy, "nie:keyword")), ==, 2);
+	g_assert_cmpstr (tracker_resource_get_first_string (tracker_resource_get_first_relation (copy, "nmm:musicAlbum"),
+	                                                    "nmm:albumTitle"), ==, "Album");
+
+	/* Blank nodes are given a new identifier */
+	g_assert_cmpstr (tracker_resource_get_identifier (tracker_resource_get_first_relation (copy, "nmm:musicAlbum")),
+	                 !=, tracker_resource_get_identifier (album));
+
+	/* Set and added properties stay apart */
+	tracker_resource_set_identifier (album, "http://example.com/album");
+	tracker_resource_set_identifier (tracker_resource_get_first_relation (copy, "nmm:musicAlbum"),
+	                                 "http://example.com/album");
+	sparql = tracker_resource_print_sparql_update (resource, NULL, NULL);
+	copy_sparql = tracker_resource_print_sparql_update (copy, NULL, NULL);
+	g_assert_cmpint (strlen (sparql), ==, strlen (copy_sparql));
+
+	g_free (sparql);
+	g_free (copy_sparql);
+	g_variant_unref (variant);
+	g_object_unref (copy);
+	g_object_unref (album);
+	g_object_unref (resource);
+}
+
+static void
+test_resource_serialize_invalid (void)
+{
+	TrackerResource *resource;
+	GVariant *variant;
+
+	variant = g_variant_ref_sink (g_variant_new ("(s)", "http://example.com/"));
+	g_assert (tracker_resource_deserialize (variant) == NULL);
+	g_variant_unref (variant);
+
+	variant = g_variant_ref_sink (g_variant_new_parsed ("{'nie:title': <byte 0x01>}"));
+	g_assert (tracker_resource_deserialize (variant) == NULL);
+	g_variant_unref (variant);
+
+	/* Cyclic relationships can't be serialized */
+	resource = tracker_resource_new ("http://example.com/resource");
+	tracker_resource_set_relation (resource, "nie:isPartOf", resource);
+	g_assert (tracker_resource_serialize (resource) == NULL);
+
+	/* Break the reference cycle */
+	tracker_resource_set_uri (resource, "nie:isPartOf", "http://example.com/");
+	g_object_unref (resource);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -163,6 +242,10 @@ main (int    argc,
 	                 test_resource_get_set_many);
 	g_test_add_func ("/libtracker-sparql/tracker-resource/get_set_pointer_validation",
 	                 test_resource_get_set_pointer_validation);
+	g_test_add_func ("/libtracker-sparql/tracker-resource/serialize",
+	                 test_resource_serialize);
+	g_test_add_func ("/libtracker-sparql/tracker-resource/serialize_invalid",
+	                 test_resource_serialize_invalid);
 
 	return g_test_run ();
 }
@@ -389,6 +389,169 @@ test_tracker_sparql_connection_interleaved (void)
 	g_object_unref(cursor1);
 }
 
+static void
+test_tracker_sparql_statement (void)
+{
+	GError *error = NULL;
+	TrackerSparqlConnection *connection;
+	TrackerSparqlStatement *stmt;
+	TrackerSparqlCursor *cursor;
+	const gchar *classes[] = {
+		"http://www.semanticdesktop.org/ontologies/2007/03/22/nfo#Document",
+		"http://www.tracker-project.org/temp/nmm#Photo",
+		NULL
+	};
+	gint i;
+
+	connection = tracker_sparql_connection_get (NULL, &error);
+	g_assert_no_error (error);
+
+	stmt = tracker_sparql_connection_query_statement (connection,
+	                                                  "SELECT ?c { ?c a rdfs:Class . "
+	                                                  "FILTER (str (?c) = ~class) }",
+	                                                  NULL, &error);
+	g_assert_no_error (error);
+	g_assert (stmt != NULL);
+
+	/* Unbound parameters are an error */
+	cursor = tracker_sparql_statement_execute (stmt, NULL, &error);
+	g_assert (cursor == NULL);
+	g_assert_error (error, TRACKER_SPARQL_ERROR, TRACKER_SPARQL_ERROR_TYPE);
+	g_clear_error (&error);
+
+	/* Run the same statement several times with different values */
+	for (i = 0; classes[i]; i++) {
+		tracker_sparql_statement_bind_string (stmt, "class", classes[i]);
+
+		cursor = tracker_sparql_statement_execute (stmt, NULL, &error);
+		g_assert_no_error (error);
+
+		g_assert (tracker_sparql_cursor_next (cursor, NULL, &error));
+		g_assert_no_error (error);
+		g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 0, NULL), ==, classes[i]);
+		g_assert (!tracker_sparql_cursor_next (cursor, NULL, &error));
+
+		g_object_unref (cursor);
+	}
+
+	g_object_unref (stmt);
+	g_object_unref (connection);
+}
+
+static void
+test_tracker_sparql_cursor_value_types (void)
+{
+	GError *error = NULL;
+	TrackerSparqlConnection *connection;
+	TrackerSparqlCursor *cursor;
+
+	connection = tracker_sparql_connection_get (NULL, &error);
+	g_assert_no_error (error);
+
+	cursor = tracker_sparql_connection_query (connection,
+	                                          "SELECT ?c (42 AS ?i) (2.5 AS ?d) "
+	                                          "{ ?c a rdfs:Class } LIMIT 1",
+	                                          NULL, &error);
+	g_assert_no_error (error);
+
+	g_assert (tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 0), ==, TRACKER_SPARQL_VALUE_TYPE_URI);
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 1), ==, TRACKER_SPARQL_VALUE_TYPE_INTEGER);
+	g_assert_cmpint (tracker_sparql_cursor_get_value_type (cursor, 2), ==, TRACKER_SPARQL_VALUE_TYPE_DOUBLE);
+
+	g_assert_cmpint (tracker_sparql_cursor_get_integer (cursor, 1), ==, 42);
+	g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 1, NULL), ==, "42");
+	g_assert_cmpfloat (tracker_sparql_cursor_get_double (cursor, 2), ==, 2.5);
+	g_assert_cmpstr (tracker_sparql_cursor_get_string (cursor, 2, NULL), ==, "2.5");
+
+	g_assert (!tracker_sparql_cursor_next (cursor, NULL, &error));
+	g_assert_no_error (error);
+
+	g_object_unref (cursor);
+	g_object_unref (connection);
+}
+
+static void
+test_tracker_sparql_cursor_value_types_bus (void)
+{
+	/* Connections are cached, so the bus backend, which reads
+	 * results through the columnar cursor, gets its own process.
+	 */
+	g_setenv ("TRACKER_SPARQL_BACKEND", "bus", TRUE);
+	g_test_trap_subprocess ("/libtracker-sparql/tracker-sparql/tracker_sparql_cursor_value_types/subprocess",
+	                        0, 0);
+	g_unsetenv ("TRACKER_SPARQL_BACKEND");
+
+	g_test_trap_assert_passed ();
+}
+
+static void
+query_stream_cb (GObject      *source,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+	TrackerSparqlCursor **cursor = user_data;
+	GError *error = NULL;
+
+	*cursor = tracker_sparql_connection_query_stream_finish (TRACKER_SPARQL_CONNECTION (source),
+	                                                         res, &error);
+	g_assert_no_error (error);
+}
+
+static void
+test_tracker_sparql_connection_query_stream (void)
+{
+	GError *error = NULL;
+	TrackerSparqlConnection *connection;
+	TrackerSparqlCursor *cursor, *stream = NULL;
+	const gchar *query = "SELECT ?c { ?c a rdfs:Class } ORDER BY ?c";
+
+	connection = tracker_sparql_connection_get (NULL, &error);
+	g_assert_no_error (error);
+
+	cursor = tracker_sparql_connection_query (connection, query, NULL, &error);
+	g_assert_no_error (error);
+
+	tracker_sparql_connection_query_stream_async (connection, query, NULL,
+	                                              query_stream_cb, &stream);
+
+	while (stream == NULL) {
+		g_main_context_iteration (NULL, TRUE);
+	}
+
+	/* The streamed results match the buffered ones */
+	while (tracker_sparql_cursor_next (cursor, NULL, &error)) {
+		g_assert (tracker_sparql_cursor_next (stream, NULL, &error));
+		g_assert_no_error (error);
+		g_assert_cmpstr (tracker_sparql_cursor_get_string (stream, 0, NULL), ==,
+		                 tracker_sparql_cursor_get_string (cursor, 0, NULL));
+	}
+
+	g_assert_no_error (error);
+	g_assert (!tracker_sparql_cursor_next (stream, NULL, &error));
+	g_assert_no_error (error);
+
+	g_object_unref (stream);
+	g_object_unref (cursor);
+	g_object_unref (connection);
+}
+
+static void
+test_tracker_sparql_connection_query_stream_bus (void)
+{
+	/* The direct backend hands out regular cursors, streaming
+	 * only happens with the store on the other end.
+	 */
+	g_setenv ("TRACKER_SPARQL_BACKEND", "bus", TRUE);
+	g_test_trap_subprocess ("/libtracker-sparql/tracker-sparql/tracker_sparql_connection_query_stream/subprocess",
+	                        0, 0);
+	g_unsetenv ("TRACKER_SPARQL_BACKEND");
+
+	g_test_trap_assert_passed ();
+}
+
 gint
 main (gint argc, gchar **argv)
 {
@@ -420,6 +583,20 @@ main (gint argc, gchar **argv)
 	                 test_tracker_sparql_connection_locking_sync);
 	g_test_add_func ("/libtracker-sparql/tracker-sparql/tracker_sparql_connection_locking_async",
 	                 test_tracker_sparql_connection_locking_async);
+	g_test_add_func ("/libtracker-sparql/tracker-sparql/tracker_sparql_statement",
+	                 test_tracker_sparql_statement);
+	g_test_add_func ("/libtracker-sparql/tracker-sparql/tracker_sparql_cursor_value_types",
+	                 test_tracker_sparql_cursor_value_types);
+	g_test_add_func ("/libtracker-sparql/tracker-sparql/tracker_sparql_cursor_value_types/bus",
+	                 test_tracker_sparql_cursor_value_types_bus);
+	g_test_add_func ("/libtracker-sparql/tracker-sparql/tracker_sparql_cursor_value_types/subprocess",
+	                 test_tracker_sparql_cursor_value_types);
+	g_test_add_func ("/libtracker-sparql/tracker-sparql/tracker_sparql_connection_query_stream",
+	                 test_tracker_sparql_connection_query_stream);
+	g_test_add_func ("/libtracker-sparql/tracker-sparql/tracker_sparql_connection_query_stream/bus",
+	                 test_tracker_sparql_connection_query_stream_bus);
+	g_test_add_func ("/libtracker-sparql/tracker-sparql/tracker_sparql_connection_query_stream/subprocess",
+	                 test_tracker_sparql_connection_query_stream);
 
 #if HAVE_TRACKER_FTS
 	g_test_add_func ("/libtracker-sparql/tracker-sparql/tracker_sparql_cursor_next_async",
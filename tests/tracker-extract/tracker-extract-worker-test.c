@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include <libtracker-extract/tracker-extract.h>
+
+#include <tracker-extract/tracker-extract.h>
+#include <tracker-extract/tracker-extract-worker.h>
+
+/* The test binary doubles as the worker, files are handled
+ * according to their URI.
+ */
+#define FAKE_WORKER_ARG  "--fake-worker"
+#define CRASH_URI        "file:///tracker-extract-worker-test/crash.txt"
+#define CRASH_ONCE_URI   "file:///tracker-extract-worker-test/crash-once.txt"
+#define HANG_URI         "file:///tracker-extract-worker-test/hang.txt"
+#define NO_MIMETYPE_URI  "file:///tracker-extract-worker-test/no-mimetype.txt"
+#define DOCUMENT_URI     "file:///tracker-extract-worker-test/document.txt"
+
+typedef struct {
+	gchar *dir;
+	gchar *marker;
+	TrackerExtractWorkerPool *pool;
+	TrackerExtractInfo *info;
+	GError *error;
+	gboolean done;
+} WorkerFixture;
+
+static TrackerExtractInfo *
+fake_extract (const gchar *uri,
+              const gchar *mimetype)
+{
+	TrackerExtractInfo *info;
+	TrackerResource *resource;
+	GFile *file;
+
+	file = g_file_new_for_uri (uri);
+	info = tracker_extract_info_new (file, mimetype ? mimetype : "text/plain");
+	g_object_unref (file);
+
+	resource = tracker_resource_new (uri);
+	tracker_resource_set_uri (resource, "rdf:type", "nfo:PaginatedTextDocument");
+	tracker_resource_set_string (resource, "nie:title", "Título");
+	tracker_resource_set_int (resource, "nfo:pageCount", 42);
+	tracker_extract_info_set_resource (info, resource);
+	g_object_unref (resource);
+
+	return info;
+}
+
+static gint
+run_fake_worker (const gchar *marker)
+{
+	gchar *uri, *mimetype;
+
+	while (tracker_extract_worker_read_request (TRACKER_EXTRACT_WORKER_FD,
+	                                            &uri, &mimetype)) {
+		TrackerExtractInfo *info;
+		GError *error = NULL;
+
+		if (g_strcmp0 (uri, CRASH_URI) == 0) {
+			_exit (EXIT_FAILURE);
+		} else if (g_strcmp0 (uri, CRASH_ONCE_URI) == 0 &&
+		           !g_file_test (marker, G_FILE_TEST_EXISTS)) {
+			g_file_set_contents (marker, "", 0, NULL);
+			_exit (EXIT_FAILURE);
+		} else if (g_strcmp0 (uri, HANG_URI) == 0) {
+			pause ();
+		}
+
+		if (g_strcmp0 (uri, NO_MIMETYPE_URI) == 0) {
+			GError *extract_error;
+
+			info = NULL;
+			extract_error = g_error_new_literal (TRACKER_EXTRACT_ERROR,
+			                                     TRACKER_EXTRACT_ERROR_NO_MIMETYPE,
+			                                     "No mimetype");
+			tracker_extract_worker_send_reply (TRACKER_EXTRACT_WORKER_FD,
+			                                   NULL, extract_error, &error);
+			g_error_free (extract_error);
+		} else {
+			info = fake_extract (uri, mimetype);
+			tracker_extract_worker_send_reply (TRACKER_EXTRACT_WORKER_FD,
+			                                   info, NULL, &error);
+		}
+
+		if (error) {
+			g_printerr ("Could not send reply: %s\n", error->message);
+			return EXIT_FAILURE;
+		}
+
+		g_clear_pointer (&info, tracker_extract_info_unref);
+		g_free (uri);
+		g_free (mimetype);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+static void
+worker_fixture_setup (WorkerFixture *fixture,
+                      gconstpointer  user_data)
+{
+	const gchar *argv[] = { "/proc/self/exe", FAKE_WORKER_ARG, NULL, NULL };
+	GError *error = NULL;
+
+	fixture->dir = g_dir_make_tmp ("tracker-extract-worker-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	fixture->marker = g_build_filename (fixture->dir, "crashed", NULL);
+
+	argv[2] = fixture->marker;
+	fixture->pool = tracker_extract_worker_pool_new_for_argv (argv, 1, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (fixture->pool);
+}
+
+static void
+worker_fixture_teardown (WorkerFixture *fixture,
+                         gconstpointer  user_data)
+{
+	g_object_unref (fixture->pool);
+	g_clear_pointer (&fixture->info, tracker_extract_info_unref);
+	g_clear_error (&fixture->error);
+
+	g_unlink (fixture->marker);
+	g_rmdir (fixture->dir);
+	g_free (fixture->marker);
+	g_free (fixture->dir);
+}
+
+static void
+extract_cb (GObject      *object,
+            GAsyncResult *res,
+            gpointer      user_data)
+{
+	WorkerFixture *fixture = user_data;
+
+	fixture->info = g_task_propagate_pointer (G_TASK (res), &fixture->error);
+	fixture->done = TRUE;
+}
+
+static void
+extract (WorkerFixture *fixture,
+         const gchar   *uri,
+         GCancellable  *cancellable)
+{
+	GTask *task;
+
+	task = g_task_new (NULL, cancellable, extract_cb, fixture);
+	tracker_extract_worker_pool_push (fixture->pool, uri, NULL, task);
+	g_object_unref (task);
+}
+
+static void
+wait_for_reply (WorkerFixture *fixture)
+{
+	while (!fixture->done)
+		g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+test_worker_roundtrip (WorkerFixture *fixture,
+                       gconstpointer  user_data)
+{
+	TrackerResource *resource;
+	GFile *file;
+	gchar *uri;
+
+	extract (fixture, DOCUMENT_URI, NULL);
+	wait_for_reply (fixture);
+
+	g_assert_no_error (fixture->error);
+	g_assert_nonnull (fixture->info);
+	g_assert_cmpstr (tracker_extract_info_get_mimetype (fixture->info), ==, "text/plain");
+
+	file = tracker_extract_info_get_file (fixture->info);
+	uri = g_file_get_uri (file);
+	g_assert_cmpstr (uri, ==, DOCUMENT_URI);
+	g_free (uri);
+
+	resource = tracker_extract_info_get_resource (fixture->info);
+	g_assert_nonnull (resource);
+	g_assert_cmpstr (tracker_resource_get_identifier (resource), ==, DOCUMENT_URI);
+	g_assert_cmpstr (tracker_resource_get_first_uri (resource, "rdf:type"), ==,
+	                 "nfo:PaginatedTextDocument");
+	g_assert_cmpstr (tracker_resource_get_first_string (resource, "nie:title"), ==,
+	                 "Título");
+	g_assert_cmpint (tracker_resource_get_first_int (resource, "nfo:pageCount"), ==, 42);
+}
+
+static void
+test_worker_crash_retry (WorkerFixture *fixture,
+                         gconstpointer  user_data)
+{
+	extract (fixture, CRASH_ONCE_URI, NULL);
+	wait_for_reply (fixture);
+
+	/* The first worker died, the second one handled the file */
+	g_assert_true (g_file_test (fixture->marker, G_FILE_TEST_EXISTS));
+	g_assert_no_error (fixture->error);
+	g_assert_nonnull (fixture->info);
+	g_assert_nonnull (tracker_extract_info_get_resource (fixture->info));
+}
+
+static void
+test_worker_crash_exhausted (WorkerFixture *fixture,
+                             gconstpointer  user_data)
+{
+	extract (fixture, CRASH_URI, NULL);
+	wait_for_reply (fixture);
+
+	g_assert_error (fixture->error, TRACKER_EXTRACT_ERROR,
+	                TRACKER_EXTRACT_ERROR_CRASHED);
+	g_assert_null (fixture->info);
+
+	/* The pool keeps serving files afterwards */
+	g_clear_error (&fixture->error);
+	fixture->done = FALSE;
+
+	extract (fixture, DOCUMENT_URI, NULL);
+	wait_for_reply (fixture);
+
+	g_assert_no_error (fixture->error);
+	g_assert_nonnull (fixture->info);
+}
+
+static void
+test_worker_error (WorkerFixture *fixture,
+                   gconstpointer  user_data)
+{
+	extract (fixture, NO_MIMETYPE_URI, NULL);
+	wait_for_reply (fixture);
+
+	/* The error reported by the worker is kept */
+	g_assert_error (fixture->error, TRACKER_EXTRACT_ERROR,
+	                TRACKER_EXTRACT_ERROR_NO_MIMETYPE);
+	g_assert_null (fixture->info);
+}
+
+static void
+test_worker_timeout (WorkerFixture *fixture,
+                     gconstpointer  user_data)
+{
+	tracker_extract_worker_pool_set_timeout (fixture->pool, 1);
+
+	extract (fixture, HANG_URI, NULL);
+	wait_for_reply (fixture);
+
+	/* Hung workers are killed, and the file given up on once
+	 * it ran out of attempts.
+	 */
+	g_assert_error (fixture->error, TRACKER_EXTRACT_ERROR,
+	                TRACKER_EXTRACT_ERROR_CRASHED);
+	g_assert_null (fixture->info);
+
+	g_clear_error (&fixture->error);
+	fixture->done = FALSE;
+
+	extract (fixture, DOCUMENT_URI, NULL);
+	wait_for_reply (fixture);
+
+	g_assert_no_error (fixture->error);
+	g_assert_nonnull (fixture->info);
+}
+
+static gpointer
+cancel_thread_func (gpointer user_data)
+{
+	g_cancellable_cancel (user_data);
+	return NULL;
+}
+
+static void
+test_worker_cancel (WorkerFixture *fixture,
+                    gconstpointer  user_data)
+{
+	GCancellable *cancellable;
+	GThread *thread;
+
+	cancellable = g_cancellable_new ();
+	extract (fixture, HANG_URI, cancellable);
+
+	/* Cancelled from another thread, while the worker is busy */
+	thread = g_thread_new ("cancel", cancel_thread_func, cancellable);
+	g_thread_join (thread);
+
+	wait_for_reply (fixture);
+
+	g_assert_error (fixture->error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_assert_null (fixture->info);
+	g_object_unref (cancellable);
+}
+
+int
+main (int argc, char **argv)
+{
+	if (argc == 3 && g_strcmp0 (argv[1], FAKE_WORKER_ARG) == 0)
+		return run_fake_worker (argv[2]);
+
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add ("/tracker-extract/worker/roundtrip",
+	            WorkerFixture, NULL,
+	            worker_fixture_setup,
+	            test_worker_roundtrip,
+	            worker_fixture_teardown);
+	g_test_add ("/tracker-extract/worker/crash-retry",
+	            WorkerFixture, NULL,
+	            worker_fixture_setup,
+	            test_worker_crash_retry,
+	            worker_fixture_teardown);
+	g_test_add ("/tracker-extract/worker/crash-exhausted",
+	            WorkerFixture, NULL,
+	            worker_fixture_setup,
+	            test_worker_crash_exhausted,
+	            worker_fixture_teardown);
+	g_test_add ("/tracker-extract/worker/error",
+	            WorkerFixture, NULL,
+	            worker_fixture_setup,
+	            test_worker_error,
+	            worker_fixture_teardown);
+	g_test_add ("/tracker-extract/worker/timeout",
+	            WorkerFixture, NULL,
+	            worker_fixture_setup,
+	            test_worker_timeout,
+	            worker_fixture_teardown);
+	g_test_add ("/tracker-extract/worker/cancel",
+	            WorkerFixture, NULL,
+	            worker_fixture_setup,
+	            test_worker_cancel,
+	            worker_fixture_teardown);
+
+	return g_test_run ();
+}
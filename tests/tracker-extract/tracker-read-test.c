@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <tracker-extract/tracker-read.h>
+
+/* Returns an FD to read @len bytes of @contents from a regular file */
+static gint
+open_contents (const gchar *contents,
+               gsize        len)
+{
+	GError *error = NULL;
+	gchar *path;
+	gint fd;
+
+	fd = g_file_open_tmp ("tracker-read-test-XXXXXX", &path, &error);
+	g_assert_no_error (error);
+	g_assert_true (write (fd, contents, len) == (gssize) len);
+	close (fd);
+
+	fd = open (path, O_RDONLY);
+	g_assert_cmpint (fd, >=, 0);
+	g_unlink (path);
+	g_free (path);
+
+	return fd;
+}
+
+static gint
+open_pipe (const gchar *contents,
+           gsize        len)
+{
+	gint fds[2];
+
+	g_assert_cmpint (pipe (fds), ==, 0);
+	g_assert_true (write (fds[1], contents, len) == (gssize) len);
+	close (fds[1]);
+
+	return fds[0];
+}
+
+/* Checks both tracker_read_text_from_fd() and
+ * tracker_read_text_bytes_from_fd() on @contents.
+ */
+static void
+assert_read_text (const gchar *contents,
+                  gsize        len,
+                  gsize        max_bytes,
+                  const gchar *expected,
+                  gsize        expected_len)
+{
+	const gchar *data;
+	GBytes *bytes;
+	gchar *text;
+	gsize size;
+
+	text = tracker_read_text_from_fd (open_contents (contents, len), max_bytes);
+	g_assert_nonnull (text);
+	g_assert_cmpuint (strlen (text), ==, expected_len);
+	g_assert_true (memcmp (text, expected, expected_len) == 0);
+	g_free (text);
+
+	bytes = tracker_read_text_bytes_from_fd (open_contents (contents, len), max_bytes);
+	g_assert_nonnull (bytes);
+	data = g_bytes_get_data (bytes, &size);
+	g_assert_cmpuint (size, ==, expected_len);
+	g_assert_true (memcmp (data, expected, expected_len) == 0);
+	/* Always NUL terminated */
+	g_assert_cmpint (data[size], ==, '\0');
+	g_bytes_unref (bytes);
+
+	text = tracker_read_text_from_fd (open_pipe (contents, len), max_bytes);
+	g_assert_nonnull (text);
+	g_assert_cmpuint (strlen (text), ==, expected_len);
+	g_assert_true (memcmp (text, expected, expected_len) == 0);
+	g_free (text);
+}
+
+static void
+test_read_utf8 (void)
+{
+	const gchar *text = "Some text\nover two lines\n";
+
+	assert_read_text (text, strlen (text), 1024, text, strlen (text));
+}
+
+static void
+test_read_utf8_cut (void)
+{
+	/* "é" is 0xC3 0xA9, ending up cut by max-bytes */
+	const gchar *text = "Some text\nwith caf\xC3\xA9\n";
+	const gchar *cut = strchr (text, '\xC3');
+
+	assert_read_text (text, strlen (text), cut - text + 1,
+	                  text, cut - text);
+	/* Or by the end of the file */
+	assert_read_text (text, cut - text + 1, 1024,
+	                  text, cut - text);
+}
+
+static void
+test_read_utf16_bom (void)
+{
+	const gchar le[] = "\xFF\xFE" "h\0i\0\n\0t\0h\0e\0r\0e\0";
+	const gchar be[] = "\xFE\xFF" "\0h\0i\0\n\0t\0h\0e\0r\0e";
+
+	assert_read_text (le, sizeof (le) - 1, 1024, "hi\nthere", 8);
+	assert_read_text (be, sizeof (be) - 1, 1024, "hi\nthere", 8);
+}
+
+static void
+test_read_page_boundary (void)
+{
+	gsize page_size = sysconf (_SC_PAGESIZE);
+	gchar *text;
+	gsize i;
+
+	/* Nothing past the file to hold the terminator */
+	text = g_malloc (page_size);
+
+	for (i = 0; i < page_size; i++)
+		text[i] = (i % 64 == 63) ? '\n' : 'a' + (i % 26);
+
+	assert_read_text (text, page_size, page_size, text, page_size);
+	assert_read_text (text, page_size, 2 * page_size, text, page_size);
+	assert_read_text (text, page_size, page_size - 1, text, page_size - 1);
+
+	g_free (text);
+}
+
+static void
+test_read_max_bytes (void)
+{
+	const gchar *text = "First line\nSecond line\nThird line\n";
+
+	assert_read_text (text, strlen (text), 10, text, 10);
+	assert_read_text (text, strlen (text), strlen (text) - 1, text, strlen (text) - 1);
+}
+
+static void
+test_read_too_short (void)
+{
+	g_assert_null (tracker_read_text_from_fd (open_contents ("abc", 3), 1024));
+	g_assert_null (tracker_read_text_bytes_from_fd (open_contents ("", 0), 1024));
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/tracker-extract/read/utf8",
+	                 test_read_utf8);
+	g_test_add_func ("/tracker-extract/read/utf8-cut",
+	                 test_read_utf8_cut);
+	g_test_add_func ("/tracker-extract/read/utf16-bom",
+	                 test_read_utf16_bom);
+	g_test_add_func ("/tracker-extract/read/page-boundary",
+	                 test_read_page_boundary);
+	g_test_add_func ("/tracker-extract/read/max-bytes",
+	                 test_read_max_bytes);
+	g_test_add_func ("/tracker-extract/read/too-short",
+	                 test_read_too_short);
+
+	return g_test_run ();
+}
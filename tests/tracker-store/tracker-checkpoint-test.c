@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <tracker-store/tracker-checkpoint.h>
+
+static void
+test_checkpoint_growth (void)
+{
+	/* the first commit has nothing to compare to */
+	g_assert_cmpint (tracker_wal_checkpoint_growth (2000, 0, 0), ==, 0);
+	/* shrinking WAL, after a checkpoint */
+	g_assert_cmpint (tracker_wal_checkpoint_growth (10, 3000, G_USEC_PER_SEC), ==, 0);
+
+	g_assert_cmpint (tracker_wal_checkpoint_growth (1100, 1000, TRACKER_WAL_CHECKPOINT_HORIZON * G_USEC_PER_SEC), ==, 100);
+	g_assert_cmpint (tracker_wal_checkpoint_growth (1100, 1000, G_USEC_PER_SEC), ==, 100 * TRACKER_WAL_CHECKPOINT_HORIZON);
+
+	/* page deltas times the horizon in microseconds are past G_MAXINT */
+	g_assert_cmpint (tracker_wal_checkpoint_growth (9999, 0, TRACKER_WAL_CHECKPOINT_HORIZON * G_USEC_PER_SEC), ==, 9999);
+	g_assert_cmpint (tracker_wal_checkpoint_growth (9999, 0, 10 * TRACKER_WAL_CHECKPOINT_HORIZON * G_USEC_PER_SEC), ==, 999);
+}
+
+static void
+test_checkpoint_trigger_idle (void)
+{
+	/* small WALs wait for idle, whatever the write rate */
+	g_assert_cmpint (tracker_wal_checkpoint_trigger (TRACKER_WAL_CHECKPOINT_PAGES - 1, 0, 1),
+	                 ==, TRACKER_WAL_CHECKPOINT_NONE);
+
+	/* so do larger ones that grow slowly */
+	g_assert_cmpint (tracker_wal_checkpoint_trigger (TRACKER_WAL_CHECKPOINT_PAGES, 0, 0),
+	                 ==, TRACKER_WAL_CHECKPOINT_NONE);
+	g_assert_cmpint (tracker_wal_checkpoint_trigger (TRACKER_WAL_BUSY_CHECKPOINT_PAGES - 1,
+	                                                 TRACKER_WAL_BUSY_CHECKPOINT_PAGES - 2,
+	                                                 G_USEC_PER_SEC),
+	                 ==, TRACKER_WAL_CHECKPOINT_NONE);
+}
+
+static void
+test_checkpoint_trigger_growth (void)
+{
+	gint n_pages = TRACKER_WAL_BUSY_CHECKPOINT_PAGES - 1;
+
+	/* reaching the maximum within the horizon */
+	g_assert_cmpint (tracker_wal_checkpoint_trigger (TRACKER_WAL_CHECKPOINT_PAGES,
+	                                                 TRACKER_WAL_CHECKPOINT_PAGES - 100,
+	                                                 G_USEC_PER_SEC / 100),
+	                 ==, TRACKER_WAL_CHECKPOINT_BACKGROUND);
+
+	/* just below and at the maximum, with a growth that overflows
+	 * 32 bit arithmetic */
+	g_assert_cmpint (tracker_wal_checkpoint_trigger (n_pages, 0,
+	                                                 (gint64) n_pages * TRACKER_WAL_CHECKPOINT_HORIZON * G_USEC_PER_SEC /
+	                                                 (TRACKER_WAL_MAX_PAGES - n_pages - 1)),
+	                 ==, TRACKER_WAL_CHECKPOINT_NONE);
+	g_assert_cmpint (tracker_wal_checkpoint_trigger (n_pages, 0,
+	                                                 (gint64) n_pages * TRACKER_WAL_CHECKPOINT_HORIZON * G_USEC_PER_SEC /
+	                                                 (TRACKER_WAL_MAX_PAGES - n_pages)),
+	                 ==, TRACKER_WAL_CHECKPOINT_BACKGROUND);
+}
+
+static void
+test_checkpoint_trigger_size (void)
+{
+	g_assert_cmpint (tracker_wal_checkpoint_trigger (TRACKER_WAL_BUSY_CHECKPOINT_PAGES,
+	                                                 TRACKER_WAL_BUSY_CHECKPOINT_PAGES, 0),
+	                 ==, TRACKER_WAL_CHECKPOINT_BACKGROUND);
+	g_assert_cmpint (tracker_wal_checkpoint_trigger (TRACKER_WAL_MAX_PAGES - 1, 0, 0),
+	                 ==, TRACKER_WAL_CHECKPOINT_BACKGROUND);
+
+	/* updates wait for a checkpoint once the maximum is reached */
+	g_assert_cmpint (tracker_wal_checkpoint_trigger (TRACKER_WAL_MAX_PAGES, 0, 0),
+	                 ==, TRACKER_WAL_CHECKPOINT_BLOCKING);
+	g_assert_cmpint (tracker_wal_checkpoint_trigger (TRACKER_WAL_MAX_PAGES * 2,
+	                                                 TRACKER_WAL_MAX_PAGES * 2,
+	                                                 G_USEC_PER_SEC),
+	                 ==, TRACKER_WAL_CHECKPOINT_BLOCKING);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/tracker-store/checkpoint/growth",
+	                 test_checkpoint_growth);
+	g_test_add_func ("/tracker-store/checkpoint/trigger/idle",
+	                 test_checkpoint_trigger_idle);
+	g_test_add_func ("/tracker-store/checkpoint/trigger/growth",
+	                 test_checkpoint_trigger_growth);
+	g_test_add_func ("/tracker-store/checkpoint/trigger/size",
+	                 test_checkpoint_trigger_size);
+
+	return g_test_run ();
+}
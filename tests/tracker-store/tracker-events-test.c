@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2026, The Tracker developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <libtracker-data/tracker-data.h>
+#include <libtracker-sparql/tracker-notifier-compact.h>
+#include <tracker-store/tracker-events.h>
+
+typedef struct {
+	guint32 subject;
+	guint32 predicate;
+	guint32 object;
+} Change;
+
+/* Values around the varint size boundaries, each taking
+ * one more byte than the previous one.
+ */
+static const gint boundaries[] = {
+	0, 1, 127, 128, 16383, 16384, 2097151, 2097152,
+	268435455, 268435456, G_MAXINT32
+};
+
+static void
+collect_change (guint32  subject,
+                guint32  predicate,
+                guint32  object,
+                gpointer user_data)
+{
+	GArray *changes = user_data;
+	Change change = { subject, predicate, object };
+
+	g_array_append_val (changes, change);
+}
+
+static GArray *
+decode (GVariant *payload,
+        gboolean  valid)
+{
+	GArray *changes;
+
+	changes = g_array_new (FALSE, FALSE, sizeof (Change));
+	g_assert_true (tracker_notifier_compact_foreach (payload, collect_change, changes) == valid);
+
+	return changes;
+}
+
+static void
+assert_changes (GArray       *changes,
+                const Change *expected,
+                guint         n_expected)
+{
+	guint i;
+
+	g_assert_cmpuint (changes->len, ==, n_expected);
+
+	for (i = 0; i < n_expected; i++) {
+		Change *change = &g_array_index (changes, Change, i);
+
+		g_assert_cmpuint (change->subject, ==, expected[i].subject);
+		g_assert_cmpuint (change->predicate, ==, expected[i].predicate);
+		g_assert_cmpuint (change->object, ==, expected[i].object);
+	}
+}
+
+static TrackerEventsBatch *
+create_batch (gboolean deletes)
+{
+	TrackerEventsBatch *batch;
+	TrackerClass *class;
+	guint i, j;
+
+	class = tracker_class_new (FALSE);
+
+	/* Reversed and twice, so sorting and deduplication
+	 * are exercised too.
+	 */
+	for (i = G_N_ELEMENTS (boundaries); i > 0; i--) {
+		for (j = 0; j < G_N_ELEMENTS (boundaries); j++) {
+			if (deletes) {
+				tracker_class_add_delete_event (class, 0, boundaries[i - 1],
+				                                boundaries[j], boundaries[i - 1]);
+				tracker_class_add_delete_event (class, 0, boundaries[i - 1],
+				                                boundaries[j], boundaries[i - 1]);
+			} else {
+				tracker_class_add_insert_event (class, 0, boundaries[i - 1],
+				                                boundaries[j], boundaries[j]);
+				tracker_class_add_insert_event (class, 0, boundaries[i - 1],
+				                                boundaries[j], boundaries[j]);
+			}
+		}
+	}
+
+	tracker_class_transact_events (class);
+	batch = tracker_events_batch_new (class);
+	g_object_unref (class);
+
+	return batch;
+}
+
+static void
+test_events_roundtrip (void)
+{
+	TrackerEventsBatch *batch;
+	GVariant *payload;
+	GArray *changes;
+	Change *expected;
+	guint i, j, n = 0;
+
+	expected = g_new0 (Change, G_N_ELEMENTS (boundaries) * G_N_ELEMENTS (boundaries));
+
+	for (i = 0; i < G_N_ELEMENTS (boundaries); i++) {
+		for (j = 0; j < G_N_ELEMENTS (boundaries); j++) {
+			expected[n].subject = boundaries[i];
+			expected[n].predicate = boundaries[j];
+			expected[n].object = boundaries[j];
+			n++;
+		}
+	}
+
+	batch = create_batch (FALSE);
+
+	payload = tracker_events_batch_encode (batch, FALSE, NULL, 0);
+	changes = decode (payload, TRUE);
+	assert_changes (changes, expected, n);
+	g_array_unref (changes);
+	g_variant_unref (payload);
+
+	/* No deletes were added */
+	payload = tracker_events_batch_encode (batch, TRUE, NULL, 0);
+	g_assert_cmpuint (g_variant_get_size (payload), ==, 0);
+	changes = decode (payload, TRUE);
+	g_assert_cmpuint (changes->len, ==, 0);
+	g_array_unref (changes);
+	g_variant_unref (payload);
+
+	tracker_events_batch_free (batch);
+
+	for (i = 0; i < n; i++)
+		expected[i].object = expected[i].subject;
+
+	batch = create_batch (TRUE);
+	payload = tracker_events_batch_encode (batch, TRUE, NULL, 0);
+	changes = decode (payload, TRUE);
+	assert_changes (changes, expected, n);
+	g_array_unref (changes);
+	g_variant_unref (payload);
+	tracker_events_batch_free (batch);
+
+	g_free (expected);
+}
+
+static void
+test_events_varint_sizes (void)
+{
+	TrackerEventsBatch *batch;
+	TrackerClass *class;
+	GVariant *payload;
+	GArray *changes;
+	guint i;
+
+	/* One change per batch, the subject delta, count, predicate
+	 * delta and object all take the same number of bytes.
+	 */
+	for (i = 1; i < G_N_ELEMENTS (boundaries); i++) {
+		Change expected = { boundaries[i], 1, boundaries[i] };
+		gsize size = (i + 1) / 2;
+
+		class = tracker_class_new (FALSE);
+		tracker_class_add_insert_event (class, 0, boundaries[i], 1, boundaries[i]);
+		tracker_class_transact_events (class);
+		batch = tracker_events_batch_new (class);
+
+		payload = tracker_events_batch_encode (batch, FALSE, NULL, 0);
+		/* subject delta + count (1) + predicate delta (1) + object */
+		g_assert_cmpuint (g_variant_get_size (payload), ==, 2 * size + 2);
+
+		changes = decode (payload, TRUE);
+		assert_changes (changes, &expected, 1);
+		g_array_unref (changes);
+
+		g_variant_unref (payload);
+		tracker_events_batch_free (batch);
+		g_object_unref (class);
+	}
+}
+
+static void
+test_events_predicates (void)
+{
+	const gint predicates[] = { 128, 16384 };
+	TrackerEventsBatch *batch;
+	GVariant *payload;
+	GArray *changes;
+	Change *expected;
+	guint i, j, n = 0;
+
+	expected = g_new0 (Change, G_N_ELEMENTS (boundaries) * G_N_ELEMENTS (predicates));
+
+	for (i = 0; i < G_N_ELEMENTS (boundaries); i++) {
+		for (j = 0; j < G_N_ELEMENTS (predicates); j++) {
+			expected[n].subject = boundaries[i];
+			expected[n].predicate = predicates[j];
+			expected[n].object = predicates[j];
+			n++;
+		}
+	}
+
+	batch = create_batch (FALSE);
+	payload = tracker_events_batch_encode (batch, FALSE, predicates,
+	                                       G_N_ELEMENTS (predicates));
+	changes = decode (payload, TRUE);
+	assert_changes (changes, expected, n);
+
+	g_array_unref (changes);
+	g_variant_unref (payload);
+	tracker_events_batch_free (batch);
+	g_free (expected);
+}
+
+static void
+test_events_truncated (void)
+{
+	TrackerEventsBatch *batch;
+	GVariant *payload, *truncated;
+	GArray *changes, *full;
+	const guint8 *data;
+	gsize len, i;
+
+	batch = create_batch (FALSE);
+	payload = tracker_events_batch_encode (batch, FALSE, NULL, 0);
+	full = decode (payload, TRUE);
+	data = g_variant_get_fixed_array (payload, &len, sizeof (guint8));
+
+	/* A cut payload never yields anything that wasn't sent */
+	for (i = 0; i < len; i++) {
+		truncated = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                       data, i, sizeof (guint8));
+		g_variant_ref_sink (truncated);
+
+		changes = g_array_new (FALSE, FALSE, sizeof (Change));
+		tracker_notifier_compact_foreach (truncated, collect_change, changes);
+
+		g_assert_cmpuint (changes->len, <=, full->len);
+		g_assert_true (changes->len == 0 ||
+		               memcmp (changes->data, full->data,
+		                       changes->len * sizeof (Change)) == 0);
+
+		g_array_unref (changes);
+		g_variant_unref (truncated);
+	}
+
+	g_array_unref (full);
+	g_variant_unref (payload);
+	tracker_events_batch_free (batch);
+}
+
+static void
+test_events_malformed (void)
+{
+	/* A varint missing its last byte */
+	const guint8 unterminated[] = { 0x01, 0x01, 0x01, 0x80 };
+	/* A varint longer than 32 bits */
+	const guint8 overlong[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0x00 };
+	/* A group announcing more changes than it has */
+	const guint8 short_group[] = { 0x01, 0x02, 0x01, 0x01 };
+	const Change first = { 1, 1, 1 };
+	GVariant *payload;
+	GArray *changes;
+
+	payload = g_variant_ref_sink (g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, unterminated,
+	                                                         sizeof (unterminated), sizeof (guint8)));
+	changes = decode (payload, FALSE);
+	g_assert_cmpuint (changes->len, ==, 0);
+	g_array_unref (changes);
+	g_variant_unref (payload);
+
+	payload = g_variant_ref_sink (g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, overlong,
+	                                                         sizeof (overlong), sizeof (guint8)));
+	changes = decode (payload, FALSE);
+	g_assert_cmpuint (changes->len, ==, 0);
+	g_array_unref (changes);
+	g_variant_unref (payload);
+
+	payload = g_variant_ref_sink (g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, short_group,
+	                                                         sizeof (short_group), sizeof (guint8)));
+	changes = decode (payload, FALSE);
+	assert_changes (changes, &first, 1);
+	g_array_unref (changes);
+	g_variant_unref (payload);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/tracker-store/events/roundtrip",
+	                 test_events_roundtrip);
+	g_test_add_func ("/tracker-store/events/varint-sizes",
+	                 test_events_varint_sizes);
+	g_test_add_func ("/tracker-store/events/predicates",
+	                 test_events_predicates);
+	g_test_add_func ("/tracker-store/events/truncated",
+	                 test_events_truncated);
+	g_test_add_func ("/tracker-store/events/malformed",
+	                 test_events_malformed);
+
+	return g_test_run ();
+}